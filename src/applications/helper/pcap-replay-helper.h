@@ -0,0 +1,87 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef PCAP_REPLAY_HELPER_H
+#define PCAP_REPLAY_HELPER_H
+
+#include <stdint.h>
+#include <string>
+#include "ns3/object-factory.h"
+#include "ns3/attribute.h"
+#include "ns3/net-device.h"
+#include "ns3/net-device-container.h"
+#include "ns3/application-container.h"
+
+namespace ns3 {
+
+/**
+ * \brief A helper to make it easier to instantiate an ns3::PcapReplay
+ * on a set of devices.
+ */
+class PcapReplayHelper
+{
+public:
+  /**
+   * Create a PcapReplayHelper to make it easier to work with PcapReplays
+   *
+   * \param filename the name of the pcap or pcapng capture replayed
+   */
+  PcapReplayHelper (std::string filename);
+
+  /**
+   * Helper function used to set the underlying application attributes.
+   *
+   * \param name the name of the application attribute to set
+   * \param value the value of the application attribute to set
+   */
+  void SetAttribute (std::string name, const AttributeValue &value);
+
+  /**
+   * Install an ns3::PcapReplay on the node of each device of the input
+   * container, sending through the device, configured with all the
+   * attributes set with SetAttribute.  The PacketSocketFactory the
+   * application needs is aggregated to the nodes which have none.
+   *
+   * \param c NetDeviceContainer of the set of devices the frames are sent
+   * through.
+   * \returns Container of Ptr to the applications installed.
+   */
+  ApplicationContainer Install (NetDeviceContainer c) const;
+
+  /**
+   * Install an ns3::PcapReplay on the node of the device, sending through
+   * the device, configured with all the attributes set with SetAttribute.
+   *
+   * \param device The device the frames are sent through.
+   * \returns Container of Ptr to the applications installed.
+   */
+  ApplicationContainer Install (Ptr<NetDevice> device) const;
+
+private:
+  /**
+   * \internal
+   * Install an ns3::PcapReplay on the node of the device, sending through
+   * the device, configured with all the attributes set with SetAttribute.
+   *
+   * \param device The device the frames are sent through.
+   * \returns Ptr to the application installed.
+   */
+  Ptr<Application> InstallPriv (Ptr<NetDevice> device) const;
+  ObjectFactory m_factory;
+};
+
+} // namespace ns3
+
+#endif /* PCAP_REPLAY_HELPER_H */
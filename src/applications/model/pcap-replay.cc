@@ -0,0 +1,253 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <limits>
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/node.h"
+#include "ns3/net-device.h"
+#include "ns3/nstime.h"
+#include "ns3/socket.h"
+#include "ns3/simulator.h"
+#include "ns3/packet.h"
+#include "ns3/packet-socket-address.h"
+#include "ns3/mac48-address.h"
+#include "ns3/string.h"
+#include "ns3/double.h"
+#include "ns3/uinteger.h"
+#include "ns3/trace-helper.h"
+#include "ns3/trace-source-accessor.h"
+#include "pcap-replay.h"
+
+NS_LOG_COMPONENT_DEFINE ("PcapReplay");
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED (PcapReplay);
+
+TypeId
+PcapReplay::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::PcapReplay")
+    .SetParent<Application> ()
+    .AddConstructor<PcapReplay> ()
+    .AddAttribute ("Filename", "The name of the pcap or pcapng capture replayed.",
+                   StringValue (""),
+                   MakeStringAccessor (&PcapReplay::m_filename),
+                   MakeStringChecker ())
+    .AddAttribute ("Interface",
+                   "The interface of a pcapng capture whose frames are replayed. "
+                   "The default value means that the frames of all the "
+                   "interfaces are replayed.",
+                   UintegerValue (std::numeric_limits<uint32_t>::max ()),
+                   MakeUintegerAccessor (&PcapReplay::m_interface),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("Offset",
+                   "The time skipped at the beginning of the capture, "
+                   "from its first frame.",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&PcapReplay::m_offset),
+                   MakeTimeChecker ())
+    .AddAttribute ("Speed",
+                   "The speed of the replay: the frames are sent at their "
+                   "distance in the capture divided by it.",
+                   DoubleValue (1.0),
+                   MakeDoubleAccessor (&PcapReplay::m_speed),
+                   MakeDoubleChecker<double> (std::numeric_limits<double>::min ()))
+    .AddTraceSource ("Tx", "A frame of the capture is sent",
+                     MakeTraceSourceAccessor (&PcapReplay::m_txTrace))
+  ;
+  return tid;
+}
+
+
+PcapReplay::PcapReplay ()
+  : m_base (0),
+    m_sent (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+PcapReplay::~PcapReplay ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+PcapReplay::SetDevice (Ptr<NetDevice> device)
+{
+  NS_LOG_FUNCTION (this << device);
+  m_device = device;
+}
+
+uint32_t
+PcapReplay::GetSent (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_sent;
+}
+
+void
+PcapReplay::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  m_socket = 0;
+  m_device = 0;
+  m_reader = 0;
+  // chain up
+  Application::DoDispose ();
+}
+
+// Application Methods
+void PcapReplay::StartApplication (void) // Called at time specified by Start
+{
+  NS_LOG_FUNCTION (this);
+  NS_ABORT_MSG_IF (m_device == 0 || m_device->GetNode () != GetNode (),
+                   "PcapReplay needs a device of its node");
+
+  // Create the socket if not already
+  if (!m_socket)
+    {
+      m_socket = Socket::CreateSocket (GetNode (), TypeId::LookupByName ("ns3::PacketSocketFactory"));
+    }
+
+  m_reader = Create<PcapReader> ();
+  m_reader->Open (m_filename);
+  NS_ABORT_MSG_IF (m_reader->Fail (), "Unable to read " << m_filename);
+
+  //
+  // The frame captured at m_base is sent now, and the others at the same
+  // distance from it as in the capture.
+  //
+  struct PcapReader::Record first;
+  if (!m_reader->Next (first))
+    {
+      NS_LOG_WARN ("No frame in " << m_filename);
+      return;
+    }
+  m_base = first.ns + m_offset.GetNanoSeconds ();
+  m_reader->Seek (m_base);
+  m_start = Simulator::Now ();
+  ScheduleNext ();
+}
+
+void PcapReplay::StopApplication (void) // Called at time specified by Stop
+{
+  NS_LOG_FUNCTION (this);
+
+  Simulator::Cancel (m_sendEvent);
+  if (m_socket != 0)
+    {
+      m_socket->Close ();
+      m_socket = 0;
+    }
+  else
+    {
+      NS_LOG_WARN ("PcapReplay found null socket to close in StopApplication");
+    }
+  // the pending frame points into the unmapped capture
+  m_reader = 0;
+}
+
+
+// Private helpers
+
+void PcapReplay::ScheduleNext (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  while (m_reader->Next (m_next))
+    {
+      if (m_interface != std::numeric_limits<uint32_t>::max () && m_next.interface != m_interface)
+        {
+          continue;
+        }
+      Time at = m_start;
+      if (m_next.ns > m_base)
+        {
+          at += NanoSeconds ((int64_t)((m_next.ns - m_base) / m_speed));
+        }
+      // a frame captured out of order is sent at once
+      Time delay = at > Simulator::Now () ? at - Simulator::Now () : Seconds (0);
+      m_sendEvent = Simulator::Schedule (delay, &PcapReplay::Send, this);
+      return;
+    }
+  if (m_reader->Fail ())
+    {
+      NS_LOG_WARN ("Malformed frame in " << m_filename);
+    }
+}
+
+void PcapReplay::Send (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  uint8_t const *data = m_next.data;
+  uint32_t length = m_next.inclLen;
+  PacketSocketAddress address;
+  address.SetSingleDevice (m_device->GetIfIndex ());
+  bool supported = false;
+
+  switch (m_reader->GetDataLinkType (m_next.interface))
+    {
+    case PcapHelper::DLT_EN10MB:
+      // Ethernet II frames, the 802.3 ones have a length instead of a type
+      if (length >= 14 && ((data[12] << 8) | data[13]) >= 0x0600)
+        {
+          Mac48Address destination;
+          destination.CopyFrom (data);
+          address.SetPhysicalAddress (destination);
+          address.SetProtocol ((data[12] << 8) | data[13]);
+          data += 14;
+          length -= 14;
+          supported = true;
+        }
+      break;
+    case PcapHelper::DLT_RAW:
+      if (length >= 1 && (data[0] >> 4 == 4 || data[0] >> 4 == 6))
+        {
+          address.SetPhysicalAddress (m_device->GetBroadcast ());
+          address.SetProtocol (data[0] >> 4 == 4 ? 0x0800 : 0x86dd);
+          supported = true;
+        }
+      break;
+    default:
+      break;
+    }
+
+  if (supported)
+    {
+      Ptr<Packet> packet = Create<Packet> (data, length);
+      if (m_next.origLen > m_next.inclLen)
+        {
+          packet->AddPaddingAtEnd (m_next.origLen - m_next.inclLen);
+        }
+      NS_LOG_LOGIC ("sending frame at " << Simulator::Now ());
+      m_txTrace (packet);
+      if (m_socket->SendTo (packet, 0, address) >= 0)
+        {
+          m_sent++;
+        }
+    }
+  else
+    {
+      NS_LOG_LOGIC ("frame of unsupported data link type not sent");
+    }
+  ScheduleNext ();
+}
+
+} // Namespace ns3
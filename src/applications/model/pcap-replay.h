@@ -0,0 +1,105 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PCAP_REPLAY_H
+#define PCAP_REPLAY_H
+
+#include <string>
+#include "ns3/application.h"
+#include "ns3/event-id.h"
+#include "ns3/ptr.h"
+#include "ns3/nstime.h"
+#include "ns3/traced-callback.h"
+#include "ns3/pcap-reader.h"
+
+namespace ns3 {
+
+class Socket;
+class NetDevice;
+class Packet;
+
+/**
+ * \ingroup applications
+ * \defgroup pcapreplay PcapReplay
+ *
+ * This traffic generator sends the frames of a pcap or pcapng capture
+ * through a device of its node, at the times they were captured: the
+ * first frame replayed is sent when the application starts.
+ *
+ * The capture is mapped in memory by a PcapReader and read one frame
+ * ahead, so that the largest captures can be replayed. The Offset
+ * attribute skips the beginning of the capture, found through the
+ * index of the reader, it is a time of the capture. The Speed attribute
+ * divides the distances between the frames: at 2, the capture is
+ * replayed twice as fast.
+ *
+ * The frames are sent through a packet socket, which needs the
+ * PacketSocketFactory of the node (see PacketSocketHelper). Ethernet
+ * frames are sent to their destination address, with their protocol,
+ * and raw IP packets to the broadcast address of the device; the source
+ * address is always the one of the device. The frames of other data
+ * link types are not sent. The frames truncated by the capture are
+ * padded with zeros to their original length.
+ */
+class PcapReplay : public Application
+{
+public:
+  static TypeId GetTypeId (void);
+
+  PcapReplay ();
+
+  virtual ~PcapReplay ();
+
+  /**
+   * \param device the device the frames are sent through, which must
+   *        belong to the node of the application
+   */
+  void SetDevice (Ptr<NetDevice> device);
+
+  /**
+   * \return the number of frames sent so far
+   */
+  uint32_t GetSent (void) const;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  // inherited from Application base class.
+  virtual void StartApplication (void);    // Called at time specified by Start
+  virtual void StopApplication (void);     // Called at time specified by Stop
+
+  void ScheduleNext (void);
+  void Send (void);
+
+  std::string     m_filename;     // Name of the capture
+  uint32_t        m_interface;    // Interface replayed of a pcapng capture
+  Time            m_offset;       // Time skipped at the beginning of the capture
+  double          m_speed;        // Speed of the replay
+  Ptr<NetDevice>  m_device;       // Device the frames are sent through
+  Ptr<Socket>     m_socket;       // Associated socket
+  Ptr<PcapReader> m_reader;       // Mapped capture
+  struct PcapReader::Record m_next; // Next frame sent
+  uint64_t        m_base;         // Capture time of the start of the application
+  Time            m_start;        // Simulation time of the start of the application
+  uint32_t        m_sent;         // Number of frames sent
+  EventId         m_sendEvent;    // Event of the next frame
+  TracedCallback<Ptr<const Packet> > m_txTrace;
+};
+
+} // namespace ns3
+
+#endif /* PCAP_REPLAY_H */
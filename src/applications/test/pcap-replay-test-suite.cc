@@ -0,0 +1,270 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <vector>
+
+#include "ns3/log.h"
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/nstime.h"
+#include "ns3/double.h"
+#include "ns3/node.h"
+#include "ns3/packet.h"
+#include "ns3/mac48-address.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/simple-channel.h"
+#include "ns3/pcap-file.h"
+#include "ns3/pcap-replay.h"
+#include "ns3/pcap-replay-helper.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("PcapReplayTestSuite");
+
+namespace {
+
+// the frames of the capture, written with a snap length of SNAP_LEN
+struct Frame
+{
+  uint32_t tsUsec;      // from 10 s
+  bool broadcast;       // else to the receiving device
+  uint16_t type;        // below 0x0600, an 802.3 length: not replayed
+  uint32_t payload;     // bytes after the Ethernet header
+};
+
+const uint32_t SNAP_LEN = 64;
+const Frame FRAMES[] = {
+  { 0, false, 0x0800, 20 },
+  { 500000, true, 0x86dd, 30 },
+  { 750000, false, 0x0020, 32 },
+  { 1250000, false, 0x0806, 86 },     // truncated to the snap length
+  { 2000000, false, 0x0800, 10 },
+};
+const uint32_t N_FRAMES = sizeof (FRAMES) / sizeof (FRAMES[0]);
+
+uint8_t
+PayloadByte (uint32_t frame, uint32_t i)
+{
+  return frame * 16 + i;
+}
+
+std::string
+CaseName (Time offset, double speed)
+{
+  std::ostringstream name;
+  name << "Check that PcapReplay sends the frames of a capture at their times, "
+       << "with an offset of " << offset << " and a speed of " << speed;
+  return name.str ();
+}
+
+} // anonymous namespace
+
+// ===========================================================================
+// Test case to make sure that PcapReplay sends the Ethernet frames of a
+// capture through a SimpleNetDevice at their captured times, given the
+// Offset and Speed attributes, and stops at the end of the capture.
+// ===========================================================================
+class PcapReplayTestCase : public TestCase
+{
+public:
+  /**
+   * \param offset the Offset attribute of the replay
+   * \param speed the Speed attribute of the replay
+   * \param first the first frame replayed
+   * \param times the times from the start of the application at which the
+   *        frames from the first one are expected, -1 for the frames not sent
+   */
+  PcapReplayTestCase (Time offset, double speed, uint32_t first, const int64_t *times);
+
+private:
+  virtual void DoSetup (void);
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+
+  void Receive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol,
+                const Address &from, const Address &to, NetDevice::PacketType packetType);
+
+  Time m_offset;
+  double m_speed;
+  uint32_t m_first;
+  std::vector<int64_t> m_times;
+  std::string m_testFilename;
+  Ptr<SimpleNetDevice> m_txDevice;
+  Ptr<SimpleNetDevice> m_rxDevice;
+  uint32_t m_frame;
+  uint32_t m_received;
+};
+
+// the application starts there
+static const Time START = Seconds (1);
+
+PcapReplayTestCase::PcapReplayTestCase (Time offset, double speed, uint32_t first, const int64_t *times)
+  : TestCase (CaseName (offset, speed)),
+    m_offset (offset),
+    m_speed (speed),
+    m_first (first),
+    m_times (times, times + N_FRAMES - first)
+{
+}
+
+void
+PcapReplayTestCase::DoSetup (void)
+{
+  std::stringstream filename;
+  uint32_t n = rand ();
+  filename << n;
+  m_testFilename = CreateTempDirFilename (filename.str () + ".pcap");
+}
+
+void
+PcapReplayTestCase::DoTeardown (void)
+{
+  if (remove (m_testFilename.c_str ()))
+    {
+      NS_LOG_ERROR ("Failed to delete file " << m_testFilename);
+    }
+}
+
+void
+PcapReplayTestCase::Receive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol,
+                             const Address &from, const Address &to, NetDevice::PacketType packetType)
+{
+  // the frames not sent are skipped
+  while (m_frame < N_FRAMES && m_times[m_frame - m_first] < 0)
+    {
+      m_frame++;
+    }
+  NS_TEST_ASSERT_MSG_LT (m_frame, N_FRAMES, "a frame received past the end of the capture");
+  const Frame &frame = FRAMES[m_frame];
+  NS_TEST_EXPECT_MSG_EQ (Simulator::Now (), START + MicroSeconds (m_times[m_frame - m_first]),
+                         "frame " << m_frame << " sent at the wrong time");
+  NS_TEST_EXPECT_MSG_EQ (protocol, frame.type, "wrong protocol of frame " << m_frame);
+  NS_TEST_EXPECT_MSG_EQ (Mac48Address::ConvertFrom (from), m_txDevice->GetAddress (),
+                         "frame " << m_frame << " not sent from the address of the device");
+  Address destination = frame.broadcast ? m_rxDevice->GetBroadcast () : m_rxDevice->GetAddress ();
+  NS_TEST_EXPECT_MSG_EQ (Mac48Address::ConvertFrom (to), Mac48Address::ConvertFrom (destination),
+                         "wrong destination of frame " << m_frame);
+  NS_TEST_ASSERT_MSG_EQ (packet->GetSize (), frame.payload, "wrong size of frame " << m_frame);
+
+  // the bytes cut by the capture are zeros
+  uint32_t captured = std::min (frame.payload, SNAP_LEN - 14);
+  std::vector<uint8_t> data (frame.payload);
+  packet->CopyData (&data[0], data.size ());
+  for (uint32_t i = 0; i < frame.payload; i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ ((uint32_t) data[i], (uint32_t)(i < captured ? PayloadByte (m_frame, i) : 0),
+                             "wrong byte " << i << " of frame " << m_frame);
+    }
+  m_frame++;
+  m_received++;
+}
+
+void
+PcapReplayTestCase::DoRun (void)
+{
+  PcapFile f;
+  f.Open (m_testFilename, std::ios::out);
+  NS_TEST_ASSERT_MSG_EQ (f.Fail (), false, "Open (" << m_testFilename << ", \"std::ios::out\") returns error");
+  f.Init (1, SNAP_LEN);
+
+  Ptr<Node> txNode = CreateObject<Node> ();
+  Ptr<Node> rxNode = CreateObject<Node> ();
+  m_txDevice = CreateObject<SimpleNetDevice> ();
+  m_rxDevice = CreateObject<SimpleNetDevice> ();
+  m_txDevice->SetAddress (Mac48Address::Allocate ());
+  m_rxDevice->SetAddress (Mac48Address::Allocate ());
+  txNode->AddDevice (m_txDevice);
+  rxNode->AddDevice (m_rxDevice);
+  Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+  m_txDevice->SetChannel (channel);
+  m_rxDevice->SetChannel (channel);
+
+  for (uint32_t i = 0; i < N_FRAMES; i++)
+    {
+      const Frame &frame = FRAMES[i];
+      std::vector<uint8_t> data (14 + frame.payload);
+      Address destination = frame.broadcast ? m_rxDevice->GetBroadcast () : m_rxDevice->GetAddress ();
+      Mac48Address::ConvertFrom (destination).CopyTo (&data[0]);
+      Mac48Address ("00:00:00:00:00:01").CopyTo (&data[6]);
+      data[12] = frame.type >> 8;
+      data[13] = frame.type & 0xff;
+      for (uint32_t j = 0; j < frame.payload; j++)
+        {
+          data[14 + j] = PayloadByte (i, j);
+        }
+      f.Write (10 + frame.tsUsec / 1000000, frame.tsUsec % 1000000, &data[0], data.size ());
+    }
+  f.Close ();
+
+  rxNode->RegisterProtocolHandler (MakeCallback (&PcapReplayTestCase::Receive, this), 0, m_rxDevice, true);
+  PcapReplayHelper helper (m_testFilename);
+  helper.SetAttribute ("Offset", TimeValue (m_offset));
+  helper.SetAttribute ("Speed", DoubleValue (m_speed));
+  ApplicationContainer apps = helper.Install (m_txDevice);
+  apps.Start (START);
+  apps.Stop (Seconds (10));
+
+  m_frame = m_first;
+  m_received = 0;
+  Simulator::Run ();
+
+  uint32_t expected = 0;
+  for (uint32_t i = 0; i < m_times.size (); i++)
+    {
+      if (m_times[i] >= 0)
+        {
+          expected++;
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (m_received, expected, "wrong number of frames received");
+  NS_TEST_EXPECT_MSG_EQ (DynamicCast<PcapReplay> (apps.Get (0))->GetSent (), expected,
+                         "wrong number of frames sent");
+  // the end of the capture leaves the stop of the application as the last event
+  NS_TEST_EXPECT_MSG_EQ (Simulator::Now (), Seconds (10), "the replay went on after the end of the capture");
+
+  Simulator::Destroy ();
+  m_txDevice = 0;
+  m_rxDevice = 0;
+}
+
+class PcapReplayTestSuite : public TestSuite
+{
+public:
+  PcapReplayTestSuite ();
+};
+
+PcapReplayTestSuite::PcapReplayTestSuite ()
+  : TestSuite ("pcap-replay", UNIT)
+{
+  // the 802.3 frame is never sent
+  static const int64_t all[] = { 0, 500000, -1, 1250000, 2000000 };
+  AddTestCase (new PcapReplayTestCase (Seconds (0), 1.0, 0, all), TestCase::QUICK);
+  // the offset is a time of the capture, the replay starts from the
+  // first frame at or after it
+  static const int64_t offset[] = { 0, -1, 750000, 1500000 };
+  AddTestCase (new PcapReplayTestCase (MilliSeconds (500), 1.0, 1, offset), TestCase::QUICK);
+  static const int64_t twice[] = { 0, 250000, -1, 625000, 1000000 };
+  AddTestCase (new PcapReplayTestCase (Seconds (0), 2.0, 0, twice), TestCase::QUICK);
+  static const int64_t both[] = { -1, 162500, 350000 };
+  AddTestCase (new PcapReplayTestCase (MilliSeconds (600), 4.0, 2, both), TestCase::QUICK);
+}
+
+static PcapReplayTestSuite pcapReplayTestSuite;
@@ -32,11 +32,19 @@ NS_LOG_COMPONENT_DEFINE ("ContikiNetDeviceHelper");
 namespace ns3 {
 
 ContikiNetDeviceHelper::ContikiNetDeviceHelper ()
+  : m_lookahead (false)
 {
   NS_LOG_FUNCTION_NOARGS ();
   m_deviceFactory.SetTypeId ("ns3::ContikiNetDevice");
 }
 
+void
+ContikiNetDeviceHelper::EnableLookahead (bool enable)
+{
+  NS_LOG_FUNCTION (enable);
+  m_lookahead = enable;
+}
+
 void 
 ContikiNetDeviceHelper::SetAttribute (std::string n1, const AttributeValue &v1)
 {
@@ -168,6 +176,11 @@ ContikiNetDeviceHelper::Install (NodeContainer nodes, Ptr<MobilityModel> pos,
     contikiChannelHelper.Install(channel, bridge[i]);
     phy[i]->SetMobility(pos);
   }
+
+  if (m_lookahead)
+    {
+      ContikiNetDevice::SetLookahead (channel->GetLookahead ());
+    }
 }
 
 
@@ -50,6 +50,16 @@ public:
    */
   void SetAttribute (std::string n1, const AttributeValue &v1);
 
+  /**
+   * Lets the nodes installed by the next Install call be released ahead of
+   * the simulation time within the channel lookahead, see
+   * ContikiNetDevice::SetLookahead.  Disabled by default, which keeps every
+   * node in lock-step with the simulator.
+   *
+   * \param enable whether to run the nodes ahead of the simulator
+   */
+  void EnableLookahead (bool enable);
+
   /**
    * This method installs a ContikiNetDevice on the specified Node and forms the
    * bridge with the NetDevice specified.  The Node is specified using
@@ -105,6 +115,7 @@ public:
 
 private:
   ObjectFactory m_deviceFactory;
+  bool m_lookahead;
 };
 
 } // namespace ns3
@@ -19,6 +19,12 @@
  */
 
 #include "contiki-channel.h"
+#include "ns3/double.h"
+#include "ns3/boolean.h"
+#include "ns3/constant-position-mobility-model.h"
+
+#include <algorithm>
+#include <cmath>
 
 NS_LOG_COMPONENT_DEFINE ("ContikiChannel");
 
@@ -40,11 +46,38 @@ ContikiChannel::GetTypeId (void)
                    PointerValue (),
                    MakePointerAccessor (&ContikiChannel::m_delay),
                    MakePointerChecker<PropagationDelayModel> ())
+    .AddAttribute ("MaxRange",
+                   "Distance beyond which frames are not delivered at all. Zero, the default, "
+                   "disables the culling unless DeriveRange is set.",
+                   DoubleValue (0.0),
+                   MakeDoubleAccessor (&ContikiChannel::m_maxRange),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("DeriveRange",
+                   "Derive the culling range, when MaxRange is zero, from the loss model and "
+                   "the lowest energy detection threshold of the PHYs. The loss model is probed, "
+                   "so this is only suitable for deterministic loss models decreasing with the "
+                   "distance: the probes would use up the draws of a random one.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&ContikiChannel::m_deriveRange),
+                   MakeBooleanChecker ())
+    .AddAttribute ("CacheLinks",
+                   "Cache the delay and rx power between PHYs that stand still instead of "
+                   "running the delay and loss models on every send. Only suitable for "
+                   "deterministic loss models.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&ContikiChannel::m_cacheLinks),
+                   MakeBooleanChecker ())
   ;
   return tid;
 }
 
 ContikiChannel::ContikiChannel ()
+  : m_maxRange (0.0),
+    m_deriveRange (false),
+    m_indexValid (false),
+    m_cellSize (-1.0),
+    m_cacheLinks (false),
+    m_linkEpoch (0)
 {
 }
 ContikiChannel::~ContikiChannel ()
@@ -53,55 +86,416 @@ ContikiChannel::~ContikiChannel ()
   m_phyList.clear ();
 }
 
+void
+ContikiChannel::DoDispose (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  // a model may have no PHY left in the index since it was connected
+  for (std::vector<Ptr<MobilityModel> >::iterator i = m_connectedMobility.begin ();
+       i != m_connectedMobility.end (); i++)
+    {
+      (*i)->TraceDisconnectWithoutContext ("CourseChange",
+                                           MakeCallback (&ContikiChannel::CourseChanged, this));
+    }
+  m_connectedMobility.clear ();
+  m_physByMobility.clear ();
+  m_mobility.clear ();
+  m_grid.clear ();
+  m_phyList.clear ();
+  m_loss = 0;
+  m_delay = 0;
+  m_rangeLoss = 0;
+  m_ranges.clear ();
+  Channel::DoDispose ();
+}
+
 void
 ContikiChannel::SetPropagationLossModel (Ptr<PropagationLossModel> loss)
 {
   m_loss = loss;
+  InvalidateRange ();
+}
+
+void
+ContikiChannel::InvalidateRange (void)
+{
+  m_ranges.clear ();
+  // the grid may now be too fine for the new ranges
+  m_cellSize = -1.0;
+  m_linkEpoch++;
+}
+
+double
+ContikiChannel::GetRange (double txPowerDbm)
+{
+  if (m_maxRange > 0.0)
+    {
+      return m_maxRange;
+    }
+  if (!m_deriveRange)
+    {
+      return -1.0;
+    }
+  if (m_rangeLoss != m_loss)
+    {
+      m_ranges.clear ();
+      m_rangeLoss = m_loss;
+    }
+  std::map<double, double>::const_iterator cached = m_ranges.find (txPowerDbm);
+  if (cached != m_ranges.end ())
+    {
+      return cached->second;
+    }
+
+  double &range = m_ranges[txPowerDbm];
+  range = -1.0;
+  if (m_phyList.empty ())
+    {
+      return range;
+    }
+
+  double thresholdDbm = m_phyList.front ()->GetEdThreshold ();
+  for (PhyList::const_iterator i = m_phyList.begin (); i != m_phyList.end (); i++)
+    {
+      thresholdDbm = std::min (thresholdDbm, (*i)->GetEdThreshold ());
+    }
+
+  // Probes the loss model between two fixed points: first doubles the
+  // distance until nobody could sync anymore, then bisects
+  Ptr<ConstantPositionMobilityModel> a = CreateObject<ConstantPositionMobilityModel> ();
+  Ptr<ConstantPositionMobilityModel> b = CreateObject<ConstantPositionMobilityModel> ();
+  double lo = 0.0;
+  double hi = 1.0;
+  for (;;)
+    {
+      b->SetPosition (Vector (hi, 0.0, 0.0));
+      if (m_loss->CalcRxPower (txPowerDbm, a, b) <= thresholdDbm)
+        {
+          break;
+        }
+      lo = hi;
+      hi *= 2;
+      if (hi > 1e7)
+        {
+          NS_LOG_DEBUG ("no culling range for txPower=" << txPowerDbm << "dbm");
+          return range;
+        }
+    }
+  for (uint32_t k = 0; k < 32; k++)
+    {
+      double mid = (lo + hi) / 2;
+      b->SetPosition (Vector (mid, 0.0, 0.0));
+      if (m_loss->CalcRxPower (txPowerDbm, a, b) <= thresholdDbm)
+        {
+          hi = mid;
+        }
+      else
+        {
+          lo = mid;
+        }
+    }
+  range = hi;
+  NS_LOG_DEBUG ("culling range for txPower=" << txPowerDbm << "dbm: " << range << "m");
+  return range;
+}
+
+ContikiChannel::Cell
+ContikiChannel::GetCell (const Vector &position) const
+{
+  return Cell ((int64_t) std::floor (position.x / m_cellSize),
+               (int64_t) std::floor (position.y / m_cellSize));
+}
+
+void
+ContikiChannel::Locate (uint32_t i)
+{
+  Ptr<MobilityModel> mobility = m_mobility[i];
+  Vector velocity = mobility->GetVelocity ();
+  bool moving = velocity.x != 0.0 || velocity.y != 0.0 || velocity.z != 0.0;
+
+  // leave the previous place
+  if (m_moving[i])
+    {
+      m_movingList.erase (std::find (m_movingList.begin (), m_movingList.end (), i));
+    }
+  else if (m_cellSize > 0)
+    {
+      Grid::iterator cell = m_grid.find (m_cells[i]);
+      if (cell != m_grid.end ())
+        {
+          std::vector<uint32_t>::iterator found = std::find (cell->second.begin (), cell->second.end (), i);
+          if (found != cell->second.end ())
+            {
+              cell->second.erase (found);
+            }
+        }
+    }
+
+  m_moving[i] = moving;
+  if (moving)
+    {
+      m_movingList.push_back (i);
+    }
+  else if (m_cellSize > 0)
+    {
+      m_cells[i] = GetCell (mobility->GetPosition ());
+      m_grid[m_cells[i]].push_back (i);
+    }
+}
+
+void
+ContikiChannel::CourseChanged (Ptr<const MobilityModel> mobility)
+{
+  if (!m_indexValid)
+    {
+      return;
+    }
+  std::map<const MobilityModel *, std::vector<uint32_t> >::iterator i =
+    m_physByMobility.find (PeekPointer (mobility));
+  if (i == m_physByMobility.end ())
+    {
+      return;
+    }
+  for (std::vector<uint32_t>::iterator j = i->second.begin (); j != i->second.end (); j++)
+    {
+      Locate (*j);
+    }
+  // the links of a moved PHY change, and so may the neighbors of the others
+  m_linkEpoch++;
+}
+
+void
+ContikiChannel::BuildIndex (double range)
+{
+  if (!m_indexValid)
+    {
+      // per PHY cache, mobility models are only set once the PHYs have been
+      // added so it is built on the first send
+      m_mobility.clear ();
+      m_context.clear ();
+      m_index.clear ();
+      // the mobility models stay connected, PHYs are never removed
+      for (std::map<const MobilityModel *, std::vector<uint32_t> >::iterator i = m_physByMobility.begin ();
+           i != m_physByMobility.end (); i++)
+        {
+          i->second.clear ();
+        }
+      for (PhyList::const_iterator i = m_phyList.begin (); i != m_phyList.end (); i++)
+        {
+          Ptr<MobilityModel> mobility = (*i)->GetMobility ()->GetObject<MobilityModel> ();
+          NS_ASSERT (mobility != 0);
+          m_index[PeekPointer (*i)] = m_mobility.size ();
+          m_mobility.push_back (mobility);
+          Ptr<Object> dstNetDevice = (*i)->GetDevice ();
+          if (dstNetDevice == 0)
+            {
+              m_context.push_back (0xffffffff);
+            }
+          else
+            {
+              m_context.push_back (dstNetDevice->GetObject<NetDevice> ()->GetNode ()->GetId ());
+            }
+          if (m_physByMobility.find (PeekPointer (mobility)) == m_physByMobility.end ())
+            {
+              mobility->TraceConnectWithoutContext ("CourseChange",
+                                                    MakeCallback (&ContikiChannel::CourseChanged, this));
+              m_connectedMobility.push_back (mobility);
+            }
+          m_physByMobility[PeekPointer (mobility)].push_back (m_mobility.size () - 1);
+        }
+      m_indexValid = true;
+      m_cellSize = -1.0;
+      m_links.assign (m_phyList.size (), std::vector<Link> ());
+      m_linkRows.assign (m_phyList.size (), LinkRow ());
+      m_linkEpoch++;
+    }
+
+  // Without range the grid is left empty and every PHY is a candidate.
+  // The cells only ever grow, to the largest range of the senders: the
+  // neighbors of a cell cover a shorter range too, so senders of different
+  // powers share the grid
+  double cellSize = range > 0 ? range : 0;
+  if (m_cellSize == 0 || (cellSize > 0 && cellSize <= m_cellSize))
+    {
+      return;
+    }
+
+  m_cellSize = cellSize;
+  m_grid.clear ();
+  m_movingList.clear ();
+  m_cells.assign (m_phyList.size (), Cell (0, 0));
+  m_moving.assign (m_phyList.size (), false);
+  for (uint32_t i = 0; i < m_phyList.size (); i++)
+    {
+      Locate (i);
+    }
+}
+
+void
+ContikiChannel::GetCandidates (Ptr<MobilityModel> sender, bool standingOnly)
+{
+  m_candidates.clear ();
+  if (m_cellSize <= 0)
+    {
+      for (uint32_t j = 0; j < m_phyList.size (); j++)
+        {
+          if (!standingOnly || !m_moving[j])
+            {
+              m_candidates.push_back (j);
+            }
+        }
+      return;
+    }
+
+  // Only the PHYs of the cells around the sender and the moving ones could
+  // be in range
+  Cell center = GetCell (sender->GetPosition ());
+  for (int64_t x = center.first - 1; x <= center.first + 1; x++)
+    {
+      for (int64_t y = center.second - 1; y <= center.second + 1; y++)
+        {
+          Grid::const_iterator cell = m_grid.find (Cell (x, y));
+          if (cell != m_grid.end ())
+            {
+              m_candidates.insert (m_candidates.end (), cell->second.begin (), cell->second.end ());
+            }
+        }
+    }
+  if (!standingOnly)
+    {
+      m_candidates.insert (m_candidates.end (), m_movingList.begin (), m_movingList.end ());
+    }
+  // keeps the receptions in the order of the PHYs, as without culling
+  std::sort (m_candidates.begin (), m_candidates.end ());
 }
+
 void
 ContikiChannel::SetPropagationDelayModel (Ptr<PropagationDelayModel> delay)
 {
   m_delay = delay;
+  m_linkEpoch++;
 }
 
 void
 ContikiChannel::Send (Ptr<ContikiPhy> sender, Ptr<const Packet> packet, double txPowerDbm)
 {
-  Ptr<MobilityModel> senderMobility = sender->GetMobility ()->GetObject<MobilityModel> ();
-  NS_ASSERT (senderMobility != 0);
-  uint32_t j = 0;
-  for (PhyList::const_iterator i = m_phyList.begin (); i != m_phyList.end (); i++, j++)
+  BuildIndex (GetRange (txPowerDbm));
+  std::map<ContikiPhy *, uint32_t>::const_iterator found = m_index.find (PeekPointer (sender));
+  NS_ASSERT (found != m_index.end ());
+  uint32_t s = found->second;
+
+  if (m_cacheLinks && !m_moving[s])
     {
-      if (sender != (*i))
+      SendCached (s, packet, txPowerDbm);
+      return;
+    }
+
+  Ptr<MobilityModel> senderMobility = m_mobility[s];
+  GetCandidates (senderMobility, false);
+  for (std::vector<uint32_t>::const_iterator i = m_candidates.begin (); i != m_candidates.end (); i++)
+    {
+      if (*i != s)
         {
+          SendTo (s, *i, packet, txPowerDbm);
+        }
+    }
+}
 
-          Ptr<MobilityModel> receiverMobility = (*i)->GetMobility()->GetObject<MobilityModel>();
-          Time delay = m_delay->GetDelay (senderMobility, receiverMobility);
-          double rxPowerDbm = m_loss->CalcRxPower (txPowerDbm, senderMobility, receiverMobility);
-          NS_LOG_DEBUG ("propagation: txPower=" << txPowerDbm << "dbm, rxPower=" << rxPowerDbm << "dbm, " <<
-                        "distance=" << senderMobility->GetDistanceFrom (receiverMobility) << "m, delay=" << delay);
-          Ptr<Packet> copy = packet->Copy ();
-          Ptr<Object> dstNetDevice = m_phyList[j]->GetDevice ();
-          uint32_t dstNode;
-          if (dstNetDevice == 0)
+void
+ContikiChannel::SendTo (uint32_t s, uint32_t j, Ptr<const Packet> packet, double txPowerDbm)
+{
+  Ptr<MobilityModel> senderMobility = m_mobility[s];
+  Ptr<MobilityModel> receiverMobility = m_mobility[j];
+  double rxPowerDbm = m_loss->CalcRxPower (txPowerDbm, senderMobility, receiverMobility);
+  if (!m_phyList[j]->CanSync (rxPowerDbm))
+    {
+      // would be dropped on arrival anyway, and is left out of the
+      // interference of the receiver
+      return;
+    }
+  Time delay = m_delay->GetDelay (senderMobility, receiverMobility);
+  NS_LOG_DEBUG ("propagation: txPower=" << txPowerDbm << "dbm, rxPower=" << rxPowerDbm << "dbm, " <<
+                "distance=" << senderMobility->GetDistanceFrom (receiverMobility) << "m, delay=" << delay);
+  m_phyList[j]->NotifyRxScheduled ();
+  Simulator::ScheduleWithContext (m_context[j],
+                                  delay, &ContikiChannel::Receive, this,
+                                  j, packet, rxPowerDbm);
+}
+
+void
+ContikiChannel::SendCached (uint32_t s, Ptr<const Packet> packet, double txPowerDbm)
+{
+  // The links of a sender that stands still towards the PHYs that stand
+  // still are computed once, only the moving PHYs are evaluated every time
+  LinkRow &row = m_linkRows[s];
+  std::vector<Link> &links = m_links[s];
+  if (row.epoch != m_linkEpoch || row.txPowerDbm != txPowerDbm || row.loss != PeekPointer (m_loss))
+    {
+      links.clear ();
+      Ptr<MobilityModel> senderMobility = m_mobility[s];
+      GetCandidates (senderMobility, true);
+      for (std::vector<uint32_t>::const_iterator i = m_candidates.begin (); i != m_candidates.end (); i++)
+        {
+          uint32_t j = *i;
+          if (j == s)
             {
-              dstNode = 0xffffffff;
+              continue;
             }
-          else
+          Ptr<MobilityModel> receiverMobility = m_mobility[j];
+          double rxPowerDbm = m_loss->CalcRxPower (txPowerDbm, senderMobility, receiverMobility);
+          if (!m_phyList[j]->CanSync (rxPowerDbm))
             {
-              dstNode = dstNetDevice->GetObject<NetDevice> ()->GetNode ()->GetId ();
+              continue;
             }
-          Simulator::ScheduleWithContext (dstNode,
-                                          delay, &ContikiChannel::Receive, this,
-                                          j, copy, rxPowerDbm);
+          Link link;
+          link.receiver = j;
+          link.rxPowerDbm = rxPowerDbm;
+          link.delay = m_delay->GetDelay (senderMobility, receiverMobility).GetTimeStep ();
+          links.push_back (link);
+        }
+      row.epoch = m_linkEpoch;
+      row.txPowerDbm = txPowerDbm;
+      row.loss = PeekPointer (m_loss);
+    }
 
-          // OR SET THE SCHEDULE HERE
+  // merges the cached links with the moving PHYs, in the order of the PHYs
+  m_candidates.assign (m_movingList.begin (), m_movingList.end ());
+  std::sort (m_candidates.begin (), m_candidates.end ());
+  std::vector<uint32_t>::const_iterator moving = m_candidates.begin ();
+  for (std::vector<Link>::const_iterator link = links.begin (); link != links.end (); link++)
+    {
+      for (; moving != m_candidates.end () && *moving < link->receiver; moving++)
+        {
+          SendTo (s, *moving, packet, txPowerDbm);
+        }
+      m_phyList[link->receiver]->NotifyRxScheduled ();
+      Simulator::ScheduleWithContext (m_context[link->receiver],
+                                      TimeStep (link->delay), &ContikiChannel::Receive, this,
+                                      link->receiver, packet, link->rxPowerDbm);
+    }
+  for (; moving != m_candidates.end (); moving++)
+    {
+      SendTo (s, *moving, packet, txPowerDbm);
+    }
+}
+
+Time
+ContikiChannel::GetLookahead (void) const
+{
+  Time lookahead;
+  for (PhyList::const_iterator i = m_phyList.begin (); i != m_phyList.end (); i++)
+    {
+      Time duration = (*i)->GetMinTxDuration ();
+      if (i == m_phyList.begin () || duration < lookahead)
+        {
+          lookahead = duration;
         }
     }
+  return lookahead;
 }
 
 void
-ContikiChannel::Receive (uint32_t i, Ptr<Packet> packet, double rxPowerDbm) const
+ContikiChannel::Receive (uint32_t i, Ptr<const Packet> packet, double rxPowerDbm) const
 {
   m_phyList[i]->StartReceivePacket (packet, rxPowerDbm);
 }
@@ -121,6 +515,8 @@ void
 ContikiChannel::Add (Ptr<ContikiPhy> phy)
 {
   m_phyList.push_back (phy);
+  m_indexValid = false;
+  InvalidateRange ();
 }
 
 } // namespace ns3
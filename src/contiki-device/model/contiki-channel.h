@@ -33,6 +33,7 @@
 #include "ns3/propagation-delay-model.h"
 
 #include <vector>
+#include <map>
 #include <stdint.h>
 
 #include "contiki-phy.h"
@@ -79,6 +80,16 @@ public:
    */
   void SetPropagationDelayModel (Ptr<PropagationDelayModel> delay);
 
+  /**
+   * \returns the smallest time between a PHY starting a transmission and
+   * another PHY of this channel handing the frame to its MAC.
+   *
+   * Propagation delay is not accounted for, as co-located nodes may have
+   * none, so this is the airtime of the smallest frame among the attached
+   * PHYs.
+   */
+  Time GetLookahead (void) const;
+
   /**
    * \param sender the device from which the packet is originating.
    * \param packet the packet to send
@@ -89,16 +100,109 @@ public:
    */
   void Send (Ptr<ContikiPhy> sender, Ptr<const Packet> packet, double txPowerDbm);
 
+  /**
+   * Forgets the culling range derived from the loss model and the energy
+   * detection thresholds of the PHYs, to be called when any of them changes.
+   */
+  void InvalidateRange (void);
+
 private:
   ContikiChannel& operator = (const ContikiChannel&);
   ContikiChannel (const ContikiChannel &);
 
   typedef std::vector<Ptr<ContikiPhy> > PhyList;
-  void Receive (uint32_t i, Ptr<Packet> packet, double rxPowerDbm) const;
+  typedef std::pair<int64_t, int64_t> Cell;
+  typedef std::map<Cell, std::vector<uint32_t> > Grid;
+
+  virtual void DoDispose (void);
+  void Receive (uint32_t i, Ptr<const Packet> packet, double rxPowerDbm) const;
+
+  /**
+   * \returns the distance beyond which no PHY can sync to a frame sent with
+   * the given power, or a negative value if there is none or the culling is
+   * disabled
+   */
+  double GetRange (double txPowerDbm);
+  /**
+   * Builds the per PHY cache (mobility, context) and the grid, on the
+   * first send after the PHYs or the range changed.
+   */
+  void BuildIndex (double range);
+  Cell GetCell (const Vector &position) const;
+  void Locate (uint32_t i);
+  void CourseChanged (Ptr<const MobilityModel> mobility);
+  /**
+   * Fills m_candidates with the indexes of the PHYs that could be in range
+   * of the sender, in increasing order.
+   *
+   * \param sender the mobility of the sender
+   * \param standingOnly whether to leave the moving PHYs out
+   */
+  void GetCandidates (Ptr<MobilityModel> sender, bool standingOnly);
+  void SendTo (uint32_t s, uint32_t j, Ptr<const Packet> packet, double txPowerDbm);
+  /**
+   * Send of a PHY that stands still, through its cached links.
+   */
+  void SendCached (uint32_t s, Ptr<const Packet> packet, double txPowerDbm);
 
   PhyList m_phyList;
   Ptr<PropagationLossModel> m_loss;
   Ptr<PropagationDelayModel> m_delay;
+
+  // culling range, see GetRange
+  double m_maxRange;
+  bool m_deriveRange;
+  // derived ranges by transmit power, for m_rangeLoss
+  Ptr<PropagationLossModel> m_rangeLoss;
+  std::map<double, double> m_ranges;
+
+  // per PHY cache, valid along with the grid
+  bool m_indexValid;
+  std::vector<Ptr<MobilityModel> > m_mobility;
+  std::vector<uint32_t> m_context;
+  std::map<ContikiPhy *, uint32_t> m_index;
+
+  // uniform grid of the PHYs that stand still, cells as wide as the
+  // largest range.
+  // Moving PHYs are checked on every send since their position changes
+  // without notification between course changes
+  double m_cellSize;
+  Grid m_grid;
+  std::vector<Cell> m_cells;
+  std::vector<bool> m_moving;
+  std::vector<uint32_t> m_movingList;
+  std::map<const MobilityModel *, std::vector<uint32_t> > m_physByMobility;
+  // the models whose course changes are connected, until disposal
+  std::vector<Ptr<MobilityModel> > m_connectedMobility;
+  std::vector<uint32_t> m_candidates;
+
+  /**
+   * A link towards a PHY that stands still, as seen by its sender
+   */
+  struct Link
+  {
+    uint32_t receiver;
+    double rxPowerDbm;
+    int64_t delay;
+  };
+  /**
+   * What the links of a sender were computed with
+   */
+  struct LinkRow
+  {
+    LinkRow () : epoch (0), txPowerDbm (0.0), loss (0) {}
+    uint64_t epoch;
+    double txPowerDbm;
+    PropagationLossModel *loss;
+  };
+
+  // link budget cache of the PHYs that stand still, one row of links
+  // sorted by receiver per sender. Any course change, new PHY or model
+  // change bumps the epoch, which invalidates every row
+  bool m_cacheLinks;
+  uint64_t m_linkEpoch;
+  std::vector<std::vector<Link> > m_links;
+  std::vector<LinkRow> m_linkRows;
 };
 
 } // namespace ns3
@@ -1,4 +1,3 @@
-#include <semaphore.h>
 #include <sys/mman.h>
 #include <fcntl.h>
 #include <signal.h>
@@ -6,14 +5,9 @@
 #include <sys/wait.h>
 #include <string>
 
-#include<sys/ipc.h>
-#include<sys/shm.h>
-#include <semaphore.h>
-
+#include "ns3/trace-source-accessor.h"
 #include "contiki-device.h"
-
-extern "C" void ContikiMain(char *node_id, int mode, const char *addr,
-		char *app, semaphores_t *sharedSemaphores);
+#include "contiki-channel.h"
 
 NS_LOG_COMPONENT_DEFINE("ContikiNetDevice");
 
@@ -21,6 +15,9 @@ namespace ns3 {
 //Values for Semaphores
 
 uint32_t ContikiNetDevice::m_nNodes;
+uint64_t ContikiNetDevice::m_lookahead = 0;
+std::vector<std::pair<uint32_t, uint64_t> > ContikiNetDevice::m_inFlight;
+std::vector<WakeupWheel::Entry> ContikiNetDevice::m_toWake;
 
 /**
  * semaphores for Contiki controll
@@ -40,13 +37,15 @@ TypeId ContikiNetDevice::GetTypeId(void) {
 					"The simulation time at which to tear down the socket device read thread.",
 					TimeValue(Seconds(0.)),
 					MakeTimeAccessor(&ContikiNetDevice::m_tStop),
-					MakeTimeChecker());
+					MakeTimeChecker()).AddTraceSource("Drop",
+					"A frame for contiki dropped as the ring to the node is full.",
+					MakeTraceSourceAccessor(&ContikiNetDevice::m_dropTrace));
 	return tid;
 }
 
 ContikiNetDevice::ContikiNetDevice() :
 		m_node(0), m_ifIndex(0), m_startEvent(), m_stopEvent(), m_ipcReader(
-				0) {
+				0), child(0) {
 	NS_LOG_FUNCTION_NOARGS ();
 
 	Start(m_tStart);
@@ -57,8 +56,6 @@ ContikiNetDevice::~ContikiNetDevice() {
 
 	StopContikiDevice();
 
-	delete[] m_packetBuffer;
-	m_packetBuffer = 0;
 	m_bridgedDevice = 0;
 }
 
@@ -105,11 +102,6 @@ void ContikiNetDevice::Stop(Time tStop) {
 	m_stopEvent = Simulator::Schedule(tStop,
 			&ContikiNetDevice::StopContikiDevice, this);
 
-	// Special case
-	sem_destroy(&sharedSemaphores->sem_time);
-	shmdt(&sharedSemaphores->shm_time);
-	shmctl(sharedSemaphores->shm_time_id, IPC_RMID, 0);
-	sharedSemaphores->shm_time_id = -1;
 }
 
 
@@ -135,156 +127,135 @@ void ContikiNetDevice::StartContikiDevice(void) {
 	m_ipcReader = Create<IpcReader>();
 	sharedSemaphores = m_ipcReader->Start(MakeCallback(&ContikiNetDevice::ReadCallback, this),
 			m_nodeId, child);
+	m_ipcReader->SetPendingInputCallback(
+			MakeCallback(&ContikiNetDevice::HasPendingInput, this));
 
-	if ((child = fork()) == -1)
-		NS_ABORT_MSG(
-				"ContikiNetDevice::CreateIpc(): Unix fork error, errno = " << strerror (errno));
-	else if (child) { /*  This is the parent. */
-		NS_LOG_DEBUG ("Parent process"); NS_LOG_LOGIC("Child PID: " << child);
-
-	} else {
-
-		Ptr<NetDevice> nd = GetBridgedNetDevice();
-		Ptr<Node> n = nd->GetNode();
-
-		/* Generate MAC address, assign to Node */
-		uint8_t address[8];
-
-		uint64_t id = (uint64_t) m_nodeId + 1;
-
-		address[0] = (id >> 56) & 0xff;
-		address[1] = (id >> 48) & 0xff;
-		address[2] = (id >> 40) & 0xff;
-		address[3] = (id >> 32) & 0xff;
-		address[4] = (id >> 24) & 0xff;
-		address[5] = (id >> 16) & 0xff;
-		address[6] = (id >> 8) & 0xff;
-		address[7] = (id >> 0) & 0xff;
-
-		Mac64Address mac64Address;
-		mac64Address.CopyFrom(address);
-
-		NS_LOG_LOGIC("Allocated Mac64Address " << mac64Address << "\n");
-
-		Address ndAddress = Address(mac64Address);
-		nd->SetAddress(ndAddress);
+	/* Generate MAC address, assign to Node */
+	uint8_t address[8];
 
-		std::stringstream ss;
-		ss << m_nodeId;
-		char c_nodeId[128];
-		strcpy(c_nodeId, ss.str().c_str());
-		char app[128] = "\0";
-		strcpy(app, m_application.c_str());
+	uint64_t id = (uint64_t) m_nodeId + 1;
 
-		//char path[128] = "/home/kentux/mercurial/contiki-original/examples/dummy/dummy.ns3";
+	address[0] = (id >> 56) & 0xff;
+	address[1] = (id >> 48) & 0xff;
+	address[2] = (id >> 40) & 0xff;
+	address[3] = (id >> 32) & 0xff;
+	address[4] = (id >> 24) & 0xff;
+	address[5] = (id >> 16) & 0xff;
+	address[6] = (id >> 8) & 0xff;
+	address[7] = (id >> 0) & 0xff;
 
-		//execlp(path,path,c_nodeId, "0","NULL", app, NULL);
-		NS_LOG_LOGIC("ContikiMain pid " << getpid() << " nodeId " << c_nodeId << " m_nodeId " << m_nodeId);
-		fflush (stdout);
+	Mac64Address mac64Address;
+	mac64Address.CopyFrom(address);
 
-		std::ostringstream nodeAddr;
-		nodeAddr << mac64Address;
+	NS_LOG_LOGIC("Allocated Mac64Address " << mac64Address << "\n");
 
-		ContikiMain(c_nodeId, 0, nodeAddr.str().c_str(), app, sharedSemaphores);
+	std::ostringstream nodeAddr;
+	nodeAddr << mac64Address;
 
-	}
+	// the zygote forks the contiki process, which maps the node block on its
+	// own
+	size_t arenaSize;
+	uint64_t offset;
+	int arenaFd = m_ipcReader->GetArenaFd(&arenaSize, &offset);
+	child = ContikiMoteSpawner::Spawn(m_nodeId, 0, nodeAddr.str(),
+			m_application, arenaFd, arenaSize, offset);
+	m_ipcReader->SetPid(child);
 
 }
-uint64_t now =0;
 void ContikiNetDevice::ContikiClockHandle(uint64_t oldValue,
 		uint64_t newValue) {
 
-	// This is because  Contiki's time granularity is Miliseconds and for ns-3
-	// it is in nanoseconds
-	now = newValue / 1000000;
-
-	/////// Writing new time //////////////
-
 	NS_LOG_LOGIC("Handling new time step " << newValue);
-	std::cout
-			<< " ---Wait Device  sharedSemaphores->sem_time ContikiClockHandle at "
-			<< now << " \n"; // << GetNodeId() << m_nodeId<< " \n";
-	if (sem_wait(&IpcReader::m_sem_time) == -1)
-		NS_FATAL_ERROR("sem_wait() failed: " << strerror(errno));
-	std::cout
-			<< " ---Wait Device  sharedSemaphores->sem_time ContikiClockHandle at "
-			<< now << " \n"; // << GetNodeId()m_nodeId<< " \n";
-
-	// sets time
-	memcpy(IpcReader::m_shm_time, (void *) &now, 8);
-
-	///////////////////////////////////////
-	std::cout
-			<< " ---Post Device  sharedSemaphores->sem_time ContikiClockHandle at "
-			<< now << " \n"; // << GetNodeId() << m_nodeId<< " \n";
-	if (sem_post(&IpcReader::m_sem_time) == -1)
-		perror("contiki sem_post(sem_time) error");
-	std::cout
-			<< " ---Post Device  sharedSemaphores->sem_time ContikiClockHandle at "
-			<< now << " \n"; // << GetNodeId() << m_nodeId<< " \n";
-
-	////// Waiting for contiki to live the moment /////////
-	NS_LOG_LOGIC("ns-3 waiting for contikis at " << newValue << " milliseconds"
-			<< std::endl);
+
+	// First collects the nodes released ahead of time whose clock has now
+	// been reached: whatever they produced must be scheduled before the
+	// simulator goes past their clock
+	WaitForNodes(newValue);
 
 	// Sinchronization mechanism:
-	// posts a sem go for each contiki node that has things to do now (post sem_go)
-	// waits for each one of these nodes to finnish their quantum of time (waits sem_done)
-	std::list < uint32_t > listToWake = IpcReader::getReleaseSchedule(
-			NanoSeconds(newValue));
-
-//    std::cout << " --- #@#@#@ Post Device  listOfGoSemaphores[0] ContikiClockHandle at "<<listOfGoSemaphores[0]<< " \n";// << GetNodeId() << m_nodeId<< " \n";
-//    std::cout << " --- #@#@#@ Post Device  listOfGoSemaphores[1] ContikiClockHandle at "<<listOfGoSemaphores[1]<< " \n";// << GetNodeId() << m_nodeId<< " \n";
-//    sem_post(listOfGoSemaphores[0]);
-//    sem_post(listOfGoSemaphores[1]);
-	// Awakes only the nodes that has things to do now
-	for (std::list<uint32_t>::iterator it = listToWake.begin();
-			it != listToWake.end(); it++) {
-		uint32_t index = *it;
-		NS_LOG_LOGIC("Handling new time step " << newValue);
-
-		// wakes up the specific nodestruct
-		std::cout
-				<< " ---Post Device  listOfGoSemaphores[index] ContikiClockHandle at "
-				<< index << " \n"; // << GetNodeId() << m_nodeId<< " \n";
-		if (sem_post(IpcReader::listOfGoSemaphores[index]) == -1)
-			NS_FATAL_ERROR("sem_wait() failed: " << strerror(errno));
-		std::cout
-				<< " ---Post Device  listOfGoSemaphores[index] ContikiClockHandle at "
-				<< *it << "  " << IpcReader::listOfGoSemaphores[index]
-				<< " Passed \n"; // << GetNodeId() << m_nodeId<< " \n";
-
-//
-//		int rtval;
-//		sem_getvalue(sharedSemaphores->sem_time, &rtval);
-//		NS_LOG_LOGIC("valor sem time" << rtval);
+	// hands the clock over to each contiki node that has things to do in the
+	// safe window [now, now + lookahead) and releases them all at once.
+	// Nothing sent after now can reach any node before the window ends, so
+	// the nodes due later in the window can run concurrently with the
+	// simulator, which only waits for them once it reaches their clock.
+	Time now = NanoSeconds(newValue);
+	Time horizon = now;
+	if (m_lookahead > 0)
+		horizon = now + TimeStep(m_lookahead) - NanoSeconds(1);
+
+	IpcReader::getReleaseSchedule(horizon, m_toWake);
+
+	for (std::vector<WakeupWheel::Entry>::iterator it = m_toWake.begin();
+			it != m_toWake.end(); it++) {
+		uint32_t index = it->node;
+		Time clock = TimeStep(it->ts) < now ? now : TimeStep(it->ts);
+
+		std::map<uint32_t, IpcReader*>::iterator reader =
+				IpcReader::listOfReaders.find(index);
+		if (reader == IpcReader::listOfReaders.end())
+			continue;
+
+		// A node still running can only take its next clock once done, and
+		// a frame already on its way to the node could reach it before its
+		// clock, so both have to wait for their turn
+		if (IsInFlight(index)
+				|| (clock > now && !reader->second->CanRunAhead())) {
+			reader->second->setSchedule(clock, index);
+			continue;
+		}
+
+		NS_LOG_LOGIC("Releasing node " << index << " until " << clock);
+		reader->second->Release(clock);
+		m_inFlight.push_back(std::make_pair(index, (uint64_t) clock.GetTimeStep()));
 	}
 
-	// Waits for the nodes to finnish their jobs
-	for (std::list<uint32_t>::iterator it = listToWake.begin();
-			it != listToWake.end(); it++) {
-		NS_LOG_LOGIC("Handling new time step " << newValue);
-
-		// Verify if the specific node has finnished
-		std::cout
-				<< " ---Wait Device  listOfDoneSemaphores[*it] ContikiClockHandle at "
-				<< *it << " \n"; // << GetNodeId() << m_nodeId<< " \n";
-		if (sem_wait(IpcReader::listOfDoneSemaphores[*it]) == -1)
-			NS_FATAL_ERROR("sem_wait() failed: " << strerror(errno));
-		std::cout
-				<< " ---Wait Device  listOfDoneSemaphores[*it] ContikiClockHandle at "
-				<< *it << " \n"; // << GetNodeId() << m_nodeId<< " \n";
+	// Waits for the nodes due now to finnish their jobs
+	WaitForNodes(newValue);
+}
+
+void ContikiNetDevice::WaitForNodes(uint64_t until) {
+	std::vector<std::pair<uint32_t, uint64_t> >::iterator kept =
+			m_inFlight.begin();
+	for (std::vector<std::pair<uint32_t, uint64_t> >::iterator it =
+			m_inFlight.begin(); it != m_inFlight.end(); it++) {
+		if (it->second > until) {
+			*kept++ = *it;
+			continue;
+		}
+		std::map<uint32_t, IpcReader*>::iterator reader =
+				IpcReader::listOfReaders.find(it->first);
+		if (reader != IpcReader::listOfReaders.end()) {
+			NS_LOG_LOGIC("Waiting for node " << it->first);
+			reader->second->WaitDone();
+		}
 	}
+	m_inFlight.erase(kept, m_inFlight.end());
+}
 
-	//////////////////////////////////////
+bool ContikiNetDevice::IsInFlight(uint32_t index) {
+	for (std::vector<std::pair<uint32_t, uint64_t> >::iterator it =
+			m_inFlight.begin(); it != m_inFlight.end(); it++) {
+		if (it->first == index)
+			return true;
+	}
+	return false;
+}
 
-	//XXX This trick is to force ns-3 to go in slow motion so that
-	//Contiki can follow
+void ContikiNetDevice::SetLookahead(Time lookahead) {
+	NS_LOG_FUNCTION (lookahead);
+	NS_ASSERT (!lookahead.IsStrictlyNegative());
+	m_lookahead = lookahead.GetTimeStep();
+}
 
-//	//ToDo: I don't think this is needed anymore, evaluate later
-//	void (*f)(void) = 0;
-//	Simulator::ScheduleWithContext(0, Seconds(1.0), f);
+Time ContikiNetDevice::GetLookahead(void) {
+	return TimeStep(m_lookahead);
+}
 
+bool ContikiNetDevice::HasPendingInput(void) {
+	// Only our own PHY tells when frames are on their way
+	if (m_phy == 0)
+		return true;
+	return m_phy->HasPendingRx();
 }
 
 uint32_t ContikiNetDevice::GetNodeId() {
@@ -299,8 +270,13 @@ void ContikiNetDevice::StopContikiDevice(void) {
 		m_ipcReader = 0;
 	}
 
+	// never started: there is no child, and kill(0) would hit our group
+	if (child <= 0)
+		return;
+
 	NS_LOG_LOGIC("Killing Child");
 	kill(child, SIGKILL);
+	child = 0;
 
 	usleep(100000);
 
@@ -315,20 +291,31 @@ void ContikiNetDevice::ReadCallback(uint8_t *buf, ssize_t len) {
 	NS_ASSERT_MSG(len > 0, "invalid len argument");
 
 	NS_LOG_INFO ("ContikiNetDevice::ReadCallback(): Received packet on node " << m_nodeId);NS_LOG_INFO ("ContikiNetDevice::ReadCallback(): Scheduling handler");
-	Simulator::ScheduleWithContext(m_nodeId, Seconds(0.0),
-			MakeEvent(&ContikiNetDevice::ForwardToBridgedDevice, this, buf,
-					len));
+	// contiki sent it at the clock it was released for
+	m_ipcReader->ScheduleAtClock(Seconds(0.0),
+			MakeEvent(&ContikiNetDevice::ForwardToBridgedDevice, this,
+					m_ipcReader, buf, len));
 }
 
-void ContikiNetDevice::ForwardToBridgedDevice(uint8_t *buf, ssize_t len) {
+void ContikiNetDevice::ForwardToBridgedDevice(Ptr<IpcReader> reader,
+		uint8_t *buf, ssize_t len) {
 	NS_LOG_FUNCTION (buf << len);
 
+	// the node may have been stopped or restarted meanwhile, along with
+	// its ring: the frame goes back to the ring it was read from
+	if (m_ipcReader != reader) {
+		reader->ReleaseFrame(buf);
+		return;
+	}
+
 	//
-	// First, create a packet out of the byte buffer we received and free that
-	// buffer.
+	// First, create a packet out of the byte buffer we received and give
+	// that buffer back to the ring.
 	//
 	Ptr<Packet> packet = Create<Packet>(reinterpret_cast<const uint8_t *>(buf),
 			len);
+	reader->ReleaseFrame(buf);
+	buf = 0;
 //	Time t = Simulator::Now();
 
 	Address src, dst;
@@ -349,9 +336,6 @@ void ContikiNetDevice::ForwardToBridgedDevice(uint8_t *buf, ssize_t len) {
 	NS_LOG_LOGIC ("Pkt LengthType is " << type);
 	NS_LOG_LOGIC ("Forwarding packet from external socket to simulated network");
 
-	free(buf);
-	buf = 0;
-
 	if (m_mode == MACPHYOVERLAY) {
 		if (m_ns3AddressRewritten == false) {
 			//
@@ -433,52 +417,24 @@ bool ContikiNetDevice::ReceiveFromBridgedDevice(Ptr<NetDevice> device,
 		Ptr<const Packet> packet, uint16_t protocol, Address const &src,
 		Address const &dst, PacketType packetType) {
 	NS_LOG_DEBUG ("Packet UID is " << packet->GetUid ());
-	/* Forward packet to socket */
-	Ptr<Packet> p = packet->Copy();
 	NS_LOG_LOGIC ("Writing packet to shared memory");
 
-	m_packetBuffer = new uint8_t[IpcReader::m_traffic_size];
-	p->CopyData(m_packetBuffer, p->GetSize());
-
 	NS_LOG_LOGIC("NS-3 is writing for node " << child << "\n");
 
-	NS_LOG_LOGIC( " ---Wait Device  sharedSemaphores->sem_out ReceiveFromBridgedDevice at "
-			<< m_nodeId << " \n");
-	if (sem_wait(&sharedSemaphores->sem_out) == -1)
-		NS_FATAL_ERROR("sem_wait() failed: " << strerror(errno));
-	NS_LOG_LOGIC(" ---Wait Device  sharedSemaphores->sem_out ReceiveFromBridgedDevice at "
-			<< m_nodeId << " \n");
-
-	//TODO: Maybe check if p->GetSize() doesn't exceed m_traffic_size
-
-	NS_LOG_LOGIC("NS-3 got sem_out for node " << child << "\n");
-
-	size_t output_size = (size_t) p->GetSize();
-	//writing traffic size first
-	memcpy(sharedSemaphores->traffic_out, &output_size, sizeof(size_t));
-	NS_LOG_LOGIC(" Send msg to contiki size:  " << output_size << "\n");
-
-	//Now writing actual traffic
-	void *retval = memcpy(sharedSemaphores->traffic_out + sizeof(size_t), m_packetBuffer,
-			p->GetSize());
-
-	std::cout
-			<< " ---Post Device  sharedSemaphores->sem_out ReceiveFromBridgedDevice at "
-			<< m_nodeId << " \n";
-	if (sem_post(&sharedSemaphores->sem_out) == -1)
-		NS_FATAL_ERROR("sem_wait() failed: " << strerror(errno));
-	std::cout
-			<< " ---Post Device  sharedSemaphores->sem_out ReceiveFromBridgedDevice at "
-			<< m_nodeId << " \n";
+	// The ring takes several frames, contiki picks them up all at once
+	// when released, so there is no need to wait for it here
+	NS_ABORT_MSG_IF(packet->GetSize() > IpcReader::m_traffic_size,
+			"ContikiNetDevice::ReceiveFromBridgedDevice(): frame larger than the IPC MTU");
+	// serialized straight into the ring
+	if (!m_ipcReader->Write(packet)) {
+		NS_LOG_WARN("ring to node " << m_node->GetId() << " is full, frame dropped");
+		m_dropTrace(packet);
+		return false;
+	}
 
 	NS_LOG_LOGIC("NS-3 wrote for node " << child << "\n");
-
-	NS_ABORT_MSG_IF(retval == (void * ) -1,
-			"ContikiNetDevice::ReceiveFromBridgedDevice(): memcpy() (AKA Write) error.");
 	NS_LOG_LOGIC ("End of receive packet handling on node " << m_node->GetId ());
 
-	delete[] m_packetBuffer;
-
 	// registers the receiving packet event
 //	Time t = Simulator::Now();
 	m_ipcReader->SetRelativeTimer(); //TODO: See the consideration of the channel delay
@@ -498,7 +454,9 @@ uint32_t ContikiNetDevice::GetIfIndex(void) const {
 
 Ptr<Channel> ContikiNetDevice::GetChannel(void) const {
 	NS_LOG_FUNCTION_NOARGS ();
-	return 0;
+	if (m_phy == 0)
+		return 0;
+	return m_phy->GetChannel();
 }
 
 void ContikiNetDevice::SetAddress(Address address) {
@@ -26,14 +26,13 @@
 #include <sys/stat.h>
 #include <sys/socket.h>
 #include <sys/un.h>
-#include <semaphore.h>
 #include <errno.h>
 #include <unistd.h>
 #include <signal.h>
 #include <sstream>
-#include <semaphore.h>
 
 #include "ipc-reader.h"
+#include "contiki-mote-spawner.h"
 #include "contiki-mac.h"
 #include "contiki-phy.h"
 
@@ -232,6 +231,23 @@ public:
 	 */
 	static void ContikiClockHandle(uint64_t oldValue, uint64_t newValue);
 
+	/**
+	 * Sets the conservative lookahead used to release contiki nodes ahead
+	 * of the simulation time: the smallest delay between a node sending a
+	 * frame and another node receiving it, see ContikiChannel::GetLookahead.
+	 * Nodes due within the lookahead are released together and run
+	 * concurrently with the simulator.  Zero (the default) keeps the nodes
+	 * in lock-step with the simulator.
+	 *
+	 * \param lookahead the lookahead
+	 */
+	static void SetLookahead(Time lookahead);
+
+	/**
+	 * \returns the conservative lookahead
+	 */
+	static Time GetLookahead(void);
+
 	/**
 	 * \internal
 	 *
@@ -239,6 +255,28 @@ public:
 	 */
 	static uint32_t m_nNodes;
 
+	/**
+	 * \internal
+	 *
+	 * Conservative lookahead in time steps, see SetLookahead.  Kept as a
+	 * plain integer since static Time objects outlive the time marking.
+	 */
+	static uint64_t m_lookahead;
+
+	/**
+	 * \internal
+	 *
+	 * Nodes released and not waited for yet, with their clock
+	 */
+	static std::vector<std::pair<uint32_t, uint64_t> > m_inFlight;
+
+	/**
+	 * \internal
+	 *
+	 * Nodes due on the current time step, reused across steps
+	 */
+	static std::vector<WakeupWheel::Entry> m_toWake;
+
 protected:
 	virtual void DoDispose(void);
 
@@ -276,6 +314,24 @@ private:
 	 * Tear down the device
 	 */
 	void StopContikiDevice(void);
+	/**
+	 * \internal
+	 *
+	 * Waits for the released nodes whose clock is not after the given time
+	 */
+	static void WaitForNodes(uint64_t until);
+	/**
+	 * \internal
+	 *
+	 * \returns true if the node has been released and not waited for yet
+	 */
+	static bool IsInFlight(uint32_t index);
+	/**
+	 * \internal
+	 *
+	 * \returns true if frames are on their way to this node
+	 */
+	bool HasPendingInput(void);
 
 	/**
 	 * \internal
@@ -294,7 +350,8 @@ private:
 	 *            received from the host.
 	 * \param buf The length of the buffer.
 	 */
-	void ForwardToBridgedDevice(uint8_t *buf, ssize_t len);
+	void ForwardToBridgedDevice(Ptr<IpcReader> reader, uint8_t *buf,
+			ssize_t len);
 
 	/**
 	 * \internal
@@ -383,6 +440,14 @@ private:
 	 */
 	Ptr<IpcReader> m_ipcReader;
 
+	/**
+	 * \internal
+	 *
+	 * Fired with the frames from the bridged device the ring to contiki has
+	 * no room for.
+	 */
+	TracedCallback<Ptr<const Packet> > m_dropTrace;
+
 	/**
 	 * \internal
 	 *
@@ -462,10 +527,6 @@ private:
 	 */
 	pid_t child;
 
-	/**
-	 * A 64K buffer to hold packet data while it is being sent.
-	 */
-	uint8_t *m_packetBuffer;
 	/*
 	 * a copy of the node id so the read thread doesn't have to GetNode() in
 	 * in order to find the node ID.  Thread unsafe reference counting in
@@ -0,0 +1,196 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "contiki-interference-helper.h"
+#include "ns3/assert.h"
+
+#include <math.h>
+
+namespace ns3 {
+
+// SINR span of the error rate tables, in dB
+static const double TABLE_MIN_DB = -20.0;
+static const double TABLE_MAX_DB = 20.0;
+static const double TABLE_STEP_DB = 0.1;
+
+ContikiErrorRateTable::ContikiErrorRateTable (BerFunction ber)
+{
+  uint32_t size = (uint32_t) lrint ((TABLE_MAX_DB - TABLE_MIN_DB) / TABLE_STEP_DB) + 1;
+  m_table.resize (size);
+  for (uint32_t i = 0; i < size; i++)
+    {
+      double sinr = pow (10.0, (TABLE_MIN_DB + i * TABLE_STEP_DB) / 10.0);
+      double b = ber (sinr);
+      b = b < 0.0 ? 0.0 : (b > 0.5 ? 0.5 : b);
+      m_table[i] = log1p (-b);
+    }
+}
+
+double
+ContikiErrorRateTable::GetLogSuccessRate (double sinr) const
+{
+  if (sinr <= 0.0)
+    {
+      return m_table.front ();
+    }
+  double x = (10.0 * log10 (sinr) - TABLE_MIN_DB) / TABLE_STEP_DB;
+  if (x <= 0.0)
+    {
+      return m_table.front ();
+    }
+  if (x >= m_table.size () - 1)
+    {
+      return m_table.back ();
+    }
+  uint32_t i = (uint32_t) x;
+  double frac = x - i;
+  return m_table[i] + frac * (m_table[i + 1] - m_table[i]);
+}
+
+double
+ContikiErrorRateTable::GetOqpskBer (double sinr)
+{
+  // BER = 8/15 * 1/16 * sum_{k=2}^{16} (-1)^k C(16,k) exp(20 SINR (1/k - 1))
+  double sum = 0.0;
+  double binomial = 16.0;
+  for (uint32_t k = 2; k <= 16; k++)
+    {
+      binomial = binomial * (16 - k + 1) / k;
+      double term = binomial * exp (20.0 * sinr * (1.0 / k - 1.0));
+      sum += (k % 2 == 0) ? term : -term;
+    }
+  return 8.0 / 15.0 / 16.0 * sum;
+}
+
+double
+ContikiErrorRateTable::GetBpskBer (double sinr)
+{
+  // 300 kchip/s for 20 kb/s
+  double ebN0 = sinr * 15.0;
+  return 0.5 * erfc (sqrt (ebN0));
+}
+
+double
+ContikiErrorRateTable::GetAskBer (double sinr)
+{
+  // 400 kchip/s for 250 kb/s
+  double ebN0 = sinr * 1.6;
+  return 0.5 * erfc (sqrt (ebN0 / 2.0));
+}
+
+ContikiInterferenceHelper::ContikiInterferenceHelper ()
+  : m_energyW (0.0),
+    m_now (0),
+    m_rx (false),
+    m_rxPowerW (0.0),
+    m_noiseW (0.0),
+    m_table (0),
+    m_bitsPerStep (0.0),
+    m_logSuccess (0.0)
+{
+}
+
+void
+ContikiInterferenceHelper::CloseChunk (int64_t until)
+{
+  if (until <= m_now)
+    {
+      return;
+    }
+  if (m_rx)
+    {
+      double interferenceW = m_energyW - m_rxPowerW;
+      if (interferenceW < 0.0)
+        {
+          // rounding errors of the running sum
+          interferenceW = 0.0;
+        }
+      double sinr = m_rxPowerW / (m_noiseW + interferenceW);
+      m_logSuccess += m_table->GetLogSuccessRate (sinr) * (until - m_now) * m_bitsPerStep;
+    }
+  m_now = until;
+}
+
+void
+ContikiInterferenceHelper::Advance (int64_t now)
+{
+  while (!m_signals.empty () && m_signals.top ().end <= now)
+    {
+      CloseChunk (m_signals.top ().end);
+      m_energyW -= m_signals.top ().powerW;
+      m_signals.pop ();
+    }
+  if (m_signals.empty ())
+    {
+      // drops the rounding errors accumulated by the running sum
+      m_energyW = 0.0;
+    }
+  CloseChunk (now);
+}
+
+void
+ContikiInterferenceHelper::AddSignal (int64_t end, double powerW)
+{
+  NS_ASSERT (end >= m_now);
+  Signal signal;
+  signal.end = end;
+  signal.powerW = powerW;
+  m_signals.push (signal);
+  m_energyW += powerW;
+}
+
+void
+ContikiInterferenceHelper::StartRx (double powerW, double noiseW, const ContikiErrorRateTable *table,
+                                    double bitsPerStep)
+{
+  m_rx = true;
+  m_rxPowerW = powerW;
+  m_noiseW = noiseW;
+  m_table = table;
+  m_bitsPerStep = bitsPerStep;
+  m_logSuccess = 0.0;
+}
+
+void
+ContikiInterferenceHelper::EndRx (void)
+{
+  m_rx = false;
+}
+
+bool
+ContikiInterferenceHelper::IsReceiving (void) const
+{
+  return m_rx;
+}
+
+double
+ContikiInterferenceHelper::GetRxPowerW (void) const
+{
+  return m_rxPowerW;
+}
+
+double
+ContikiInterferenceHelper::GetRxSuccessRate (void) const
+{
+  return exp (m_logSuccess);
+}
+
+double
+ContikiInterferenceHelper::GetEnergyW (void) const
+{
+  return m_energyW;
+}
+
+} // namespace ns3
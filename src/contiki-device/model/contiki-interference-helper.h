@@ -0,0 +1,162 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef CONTIKI_INTERFERENCE_HELPER_H
+#define CONTIKI_INTERFERENCE_HELPER_H
+
+#include <stdint.h>
+#include <vector>
+#include <queue>
+#include <functional>
+
+namespace ns3 {
+
+/**
+ * \brief Bit error rate of a modulation as a function of the SINR, tabulated.
+ *
+ * The table spans -20 dB to 20 dB of SINR in 0.1 dB steps and stores the log
+ * of the success rate of a bit, so that the success rate of a chunk of bits
+ * is a lookup, a multiplication and an addition away.
+ */
+class ContikiErrorRateTable
+{
+public:
+  typedef double (*BerFunction)(double sinr);
+
+  /**
+   * \param ber the bit error rate as a function of the (linear) SINR
+   */
+  ContikiErrorRateTable (BerFunction ber);
+
+  /**
+   * \param sinr the SINR, linear
+   * \returns the log of the probability that a bit is received without error
+   */
+  double GetLogSuccessRate (double sinr) const;
+
+  /**
+   * IEEE Std 802.15.4-2006 section E.4.1.8, 16-ary orthogonal O-QPSK as used
+   * at 2450 MHz. Also used for the 868/915 MHz O-QPSK PHY, which maps its
+   * symbols on the same kind of chip sequences.
+   */
+  static double GetOqpskBer (double sinr);
+  /**
+   * Coherent BPSK over the 15 chips of a bit of the 868/915 MHz BPSK PHY
+   */
+  static double GetBpskBer (double sinr);
+  /**
+   * Coherent ASK, an approximation of the 868/915 MHz PSSS PHY which only
+   * spreads a bit over 1.6 chips
+   */
+  static double GetAskBer (double sinr);
+
+private:
+  std::vector<double> m_table;
+};
+
+/**
+ * \brief Tracks the signals a ContikiPhy hears and the SINR of the frame it
+ * is receiving.
+ *
+ * Signals are kept in a heap ordered by end time along with the sum of their
+ * powers, which is updated as they come and go, so that adding a signal or
+ * expiring one costs O(log k) for k signals on the air. While a frame is
+ * being received, the time between two consecutive signal boundaries is a
+ * chunk of constant SINR: each chunk is accounted for as soon as it closes,
+ * nothing is kept around to be replayed at the end of the frame.
+ *
+ * Times are in time steps, the helper is driven by its PHY which advances it
+ * to the current time before every change.
+ *
+ * Only the signals the PHY could sync to reach it: ContikiChannel drops the
+ * ones below the energy detection threshold of the receiver before they are
+ * scheduled. The interference of many weak senders, each below the
+ * threshold, is thus not accounted for.
+ */
+class ContikiInterferenceHelper
+{
+public:
+  ContikiInterferenceHelper ();
+
+  /**
+   * Expires the signals that ended up to the given time.
+   *
+   * \param now the current time
+   */
+  void Advance (int64_t now);
+  /**
+   * Adds a signal starting at the time the helper was last advanced to.
+   *
+   * \param end the time at which the signal ends
+   * \param powerW the power of the signal
+   */
+  void AddSignal (int64_t end, double powerW);
+  /**
+   * Starts receiving one of the signals, the success rate of the reception
+   * is accounted for from the time the helper was last advanced to.
+   *
+   * \param powerW the power of the signal being received
+   * \param noiseW the noise power
+   * \param table the error rate of the modulation
+   * \param bitsPerStep the bit rate, in bits per time step
+   */
+  void StartRx (double powerW, double noiseW, const ContikiErrorRateTable *table,
+                double bitsPerStep);
+  void EndRx (void);
+  bool IsReceiving (void) const;
+  /**
+   * \returns the power of the signal being received
+   */
+  double GetRxPowerW (void) const;
+  /**
+   * \returns the probability that the frame being received has been
+   * received without error so far
+   */
+  double GetRxSuccessRate (void) const;
+  /**
+   * \returns the total power on the air
+   */
+  double GetEnergyW (void) const;
+
+private:
+  struct Signal
+  {
+    int64_t end;
+    double powerW;
+    bool operator > (const Signal &o) const
+    {
+      return end > o.end;
+    }
+  };
+  typedef std::priority_queue<Signal, std::vector<Signal>, std::greater<Signal> > Signals;
+
+  void CloseChunk (int64_t until);
+
+  Signals m_signals;
+  double m_energyW;
+  int64_t m_now;
+
+  // reception in progress
+  bool m_rx;
+  double m_rxPowerW;
+  double m_noiseW;
+  const ContikiErrorRateTable *m_table;
+  double m_bitsPerStep;
+  double m_logSuccess;
+};
+
+} // namespace ns3
+
+#endif /* CONTIKI_INTERFERENCE_HELPER_H */
@@ -0,0 +1,197 @@
+/*
+ * contiki-mote-spawner.cc
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#include "ns3/log.h"
+#include "ns3/fatal-error.h"
+#include "ns3/abort.h"
+#include "ns3/simulator.h"
+
+#include "contiki-mote-spawner.h"
+#include "ipc-reader.h"
+
+extern "C" void ContikiMain(char *node_id, int mode, const char *addr,
+		char *app, semaphores_t *sharedSemaphores);
+
+NS_LOG_COMPONENT_DEFINE("ContikiMoteSpawner");
+
+namespace ns3 {
+
+int ContikiMoteSpawner::m_sock = -1;
+pid_t ContikiMoteSpawner::m_zygote = 0;
+bool ContikiMoteSpawner::m_stopScheduled = false;
+
+void ContikiMoteSpawner::Start(void) {
+	NS_LOG_FUNCTION_NOARGS ();
+	if (IsRunning())
+		return;
+
+	int sv[2];
+	if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sv) == -1)
+		NS_FATAL_ERROR("socketpair() failed: " << strerror(errno));
+
+	pid_t pid = fork();
+	if (pid == -1)
+		NS_FATAL_ERROR("fork() of the zygote failed: " << strerror(errno));
+
+	if (pid == 0) {
+		close(sv[0]);
+		Serve(sv[1]);
+		_exit(0);
+	}
+
+	close(sv[1]);
+	m_sock = sv[0];
+	m_zygote = pid;
+	NS_LOG_LOGIC("Zygote pid " << pid);
+}
+
+void ContikiMoteSpawner::Stop(void) {
+	NS_LOG_FUNCTION_NOARGS ();
+	if (!IsRunning())
+		return;
+	// the zygote exits once it reads the end of the stream
+	close(m_sock);
+	waitpid(m_zygote, NULL, 0);
+	m_sock = -1;
+	m_zygote = 0;
+	m_stopScheduled = false;
+}
+
+bool ContikiMoteSpawner::IsRunning(void) {
+	return m_sock != -1;
+}
+
+pid_t ContikiMoteSpawner::Spawn(uint32_t nodeId, int mode,
+		std::string address, std::string application, int arenaFd,
+		size_t arenaSize, uint64_t offset) {
+	NS_LOG_FUNCTION (nodeId << mode << address << application);
+	Start();
+	if (!m_stopScheduled) {
+		// after the devices, which the node list disposes of earlier
+		Simulator::ScheduleDestroy(&ContikiMoteSpawner::Stop);
+		m_stopScheduled = true;
+	}
+
+	Request request;
+	memset(&request, 0, sizeof(request));
+	request.nodeId = nodeId;
+	request.mode = mode;
+	request.arenaSize = arenaSize;
+	request.offset = offset;
+	NS_ABORT_MSG_IF(address.size() >= sizeof(request.address),
+			"ContikiMoteSpawner::Spawn(): address too long");
+	NS_ABORT_MSG_IF(application.size() >= sizeof(request.application),
+			"ContikiMoteSpawner::Spawn(): application path too long");
+	strcpy(request.address, address.c_str());
+	strcpy(request.application, application.c_str());
+
+	struct iovec iov;
+	iov.iov_base = &request;
+	iov.iov_len = sizeof(request);
+
+	char control[CMSG_SPACE(sizeof(int))];
+	memset(control, 0, sizeof(control));
+
+	struct msghdr msg;
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control;
+	msg.msg_controllen = sizeof(control);
+
+	struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+	cmsg->cmsg_level = SOL_SOCKET;
+	cmsg->cmsg_type = SCM_RIGHTS;
+	cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+	memcpy(CMSG_DATA(cmsg), &arenaFd, sizeof(int));
+
+	if (sendmsg(m_sock, &msg, 0) != (ssize_t) sizeof(request))
+		NS_FATAL_ERROR("sendmsg() to the zygote failed: " << strerror(errno));
+
+	pid_t pid;
+	if (recv(m_sock, &pid, sizeof(pid), 0) != (ssize_t) sizeof(pid))
+		NS_FATAL_ERROR("recv() from the zygote failed: " << strerror(errno));
+	if (pid == -1)
+		NS_FATAL_ERROR("the zygote could not fork node " << nodeId);
+
+	NS_LOG_LOGIC("Node " << nodeId << " spawned with pid " << pid);
+	return pid;
+}
+
+void ContikiMoteSpawner::Serve(int sock) {
+	// the motes are reaped by the kernel, the zygote never waits for them
+	signal(SIGCHLD, SIG_IGN);
+
+	for (;;) {
+		Request request;
+		struct iovec iov;
+		iov.iov_base = &request;
+		iov.iov_len = sizeof(request);
+
+		char control[CMSG_SPACE(sizeof(int))];
+		struct msghdr msg;
+		memset(&msg, 0, sizeof(msg));
+		msg.msg_iov = &iov;
+		msg.msg_iovlen = 1;
+		msg.msg_control = control;
+		msg.msg_controllen = sizeof(control);
+
+		ssize_t n = recvmsg(sock, &msg, 0);
+		if (n <= 0) {
+			// the simulator is gone
+			return;
+		}
+
+		struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+		if (n != (ssize_t) sizeof(request) || cmsg == NULL
+				|| cmsg->cmsg_type != SCM_RIGHTS)
+			return;
+		int arenaFd;
+		memcpy(&arenaFd, CMSG_DATA(cmsg), sizeof(int));
+
+		pid_t pid = fork();
+		if (pid == 0) {
+			signal(SIGCHLD, SIG_DFL);
+			RunMote(sock, request, arenaFd);
+			_exit(0);
+		}
+		close(arenaFd);
+
+		if (send(sock, &pid, sizeof(pid), 0) != (ssize_t) sizeof(pid))
+			return;
+	}
+}
+
+void ContikiMoteSpawner::RunMote(int sock, const Request &request,
+		int arenaFd) {
+	close(sock);
+
+	void *base = mmap(NULL, request.arenaSize, PROT_READ | PROT_WRITE,
+			MAP_SHARED, arenaFd, 0);
+	if (base == MAP_FAILED)
+		_exit(1);
+	close(arenaFd);
+
+	semaphores_t *block = (semaphores_t *) ((unsigned char *) base
+			+ request.offset);
+
+	char nodeId[32];
+	snprintf(nodeId, sizeof(nodeId), "%u", request.nodeId);
+	char application[sizeof(request.application)];
+	strcpy(application, request.application);
+
+	ContikiMain(nodeId, request.mode, request.address, application, block);
+}
+
+} // namespace ns3
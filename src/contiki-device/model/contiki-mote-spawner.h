@@ -0,0 +1,85 @@
+/*
+ * contiki-mote-spawner.h
+ */
+
+#ifndef CONTIKI_MOTE_SPAWNER_H_
+#define CONTIKI_MOTE_SPAWNER_H_
+
+#include <stdint.h>
+#include <sys/types.h>
+#include <string>
+
+namespace ns3 {
+
+/**
+ * \brief Spawns the contiki processes from a small zygote process.
+ *
+ * Forking every mote straight from the simulator means copying the page
+ * tables of the whole ns-3 heap, built by then, once per node.  The zygote
+ * forks every mote on request instead: the node block is handed over as
+ * the descriptor of its shared memory arena, which the mote maps on its own
+ * before entering ContikiMain.
+ *
+ * The first Spawn() forks the zygote if it is not running yet, and has it
+ * stopped by Simulator::Destroy.  Calling Start() first thing in main(),
+ * while the simulator is still small, keeps the zygote itself small.
+ */
+class ContikiMoteSpawner {
+public:
+	/**
+	 * Forks the zygote, does nothing if it is already running.
+	 */
+	static void Start(void);
+
+	/**
+	 * Tells the zygote to exit, motes already spawned keep running.  Does
+	 * nothing if the zygote is not running.
+	 */
+	static void Stop(void);
+
+	/**
+	 * \returns true if the zygote is running
+	 */
+	static bool IsRunning(void);
+
+	/**
+	 * Spawns a contiki process, starting the zygote if needed.
+	 *
+	 * \param nodeId the contiki node id
+	 * \param mode the contiki mode
+	 * \param address the link layer address of the node
+	 * \param application the contiki application to run
+	 * \param arenaFd the descriptor of the arena holding the node block
+	 * \param arenaSize the size of the arena
+	 * \param offset the offset of the node block in the arena
+	 * \returns the pid of the contiki process
+	 */
+	static pid_t Spawn(uint32_t nodeId, int mode, std::string address,
+			std::string application, int arenaFd, size_t arenaSize,
+			uint64_t offset);
+
+private:
+	/**
+	 * \internal
+	 * A spawn request, the arena descriptor travels along as ancillary data
+	 */
+	struct Request {
+		uint32_t nodeId;
+		int32_t mode;
+		uint64_t arenaSize;
+		uint64_t offset;
+		char address[64];
+		char application[256];
+	};
+
+	static void Serve(int sock);
+	static void RunMote(int sock, const Request &request, int arenaFd);
+
+	static int m_sock;
+	static pid_t m_zygote;
+	static bool m_stopScheduled;
+};
+
+} // namespace ns3
+
+#endif /* CONTIKI_MOTE_SPAWNER_H_ */
@@ -32,6 +32,17 @@ ContikiPhy::GetTypeId (void)
   static TypeId tid = TypeId ("ns3::ContikiPhy")
     .SetParent<Object> ()
     .AddConstructor<ContikiPhy> ()
+    .AddAttribute ("RxNoiseFigure",
+                   "Loss (dB) in the Signal-to-Noise-Ratio due to non-idealities in the receiver.",
+                   DoubleValue (7),
+                   MakeDoubleAccessor (&ContikiPhy::m_noiseFigureDb),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("CaptureThreshold",
+                   "A frame received this much stronger (dB) than the frame being received "
+                   "captures the receiver, a weaker one is only interference.",
+                   DoubleValue (3),
+                   MakeDoubleAccessor (&ContikiPhy::m_captureThresholdDb),
+                   MakeDoubleChecker<double> ())
     .AddTraceSource ("MonitorSnifferRx",
                          "Trace source simulating a contiki device in monitor mode sniffing all received frames",
                          MakeTraceSourceAccessor (&ContikiPhy::m_phyMonitorSniffRxTrace))
@@ -43,6 +54,12 @@ ContikiPhy::GetTypeId (void)
 }
 
 ContikiPhy::ContikiPhy ()
+  : m_dataRate (250000),
+    m_mode (DSSS_O_QPSK_GHz),
+    m_edThresholdW (0),
+    m_pendingRx (0),
+    m_noiseFigureDb (7),
+    m_captureThresholdDb (3)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -56,6 +73,7 @@ void
 ContikiPhy::DoDispose (void)
 {
   NS_LOG_FUNCTION (this);
+  m_endRxEvent.Cancel ();
   m_device = 0;
   m_mobility = 0;
   m_channel = 0;
@@ -147,46 +165,140 @@ ContikiPhy::CalculateTxDuration (uint32_t size)
   return MicroSeconds(duration);
 }
 
+double
+ContikiPhy::GetChipRate (void) const
+{
+  switch (m_mode)
+  {
+    case DSSS_BPSK:
+      // IEEE Std 802.15.4-2006 section 6.6.1
+      return 300000;
+    case DSSS_O_QPSK_MHz:
+      // IEEE Std 802.15.4-2006 section 6.8.1
+      return 400000;
+    case PSSS_ASK:
+      // IEEE Std 802.15.4-2006 section 6.7.1
+      return 400000;
+    default:
+      // IEEE Std 802.15.4-2006 section 6.5.2.3
+      return 2000000;
+  }
+}
+
+const ContikiErrorRateTable *
+ContikiPhy::GetErrorRateTable (void) const
+{
+  static ContikiErrorRateTable bpsk (&ContikiErrorRateTable::GetBpskBer);
+  static ContikiErrorRateTable oqpsk (&ContikiErrorRateTable::GetOqpskBer);
+  static ContikiErrorRateTable ask (&ContikiErrorRateTable::GetAskBer);
+  switch (m_mode)
+  {
+    case DSSS_BPSK:
+      return &bpsk;
+    case PSSS_ASK:
+      return &ask;
+    default:
+      return &oqpsk;
+  }
+}
+
 void
-ContikiPhy::StartReceivePacket (Ptr<Packet> packet, double rxPowerDbm)
+ContikiPhy::StartReceivePacket (Ptr<const Packet> packet, double rxPowerDbm)
 {
   NS_LOG_FUNCTION (this << packet << rxPowerDbm);
   //rxPowerDbm += m_rxGainDb;
   double rxPowerW = DbmToW (rxPowerDbm);
   Time rxDuration = CalculateTxDuration (packet->GetSize ());
+  int64_t now = Simulator::Now ().GetTimeStep ();
 
-  if (rxPowerW > m_edThresholdW)
-  {
-    NS_LOG_DEBUG ("sync to signal (power=" << rxPowerW << "W)");
-    Simulator::Schedule (rxDuration, &ContikiPhy::EndReceive, this, packet);
-  }
-  else
+  // Every signal that arrives interferes, whether we sync to it or not.
+  // The channel does not schedule the ones below the energy detection
+  // threshold, so those never add up here; one still arrives below it if
+  // the threshold was raised while it was on the air
+  m_interference.Advance (now);
+  m_interference.AddSignal (now + rxDuration.GetTimeStep (), rxPowerW);
+
+  if (!CanSync (rxPowerDbm))
   {
     NS_LOG_DEBUG ("drop packet because signal power too Small (" <<
                   rxPowerW << "<" << m_edThresholdW << ")");
     //NotifyRxDrop (packet);
+    NS_ASSERT (m_pendingRx > 0);
+    m_pendingRx--;
+    return;
+  }
+
+  if (m_interference.IsReceiving ())
+  {
+    if (rxPowerW > m_interference.GetRxPowerW () * pow (10.0, m_captureThresholdDb / 10.0))
+    {
+      NS_LOG_DEBUG ("captured by signal (power=" << rxPowerW << "W), drop the frame being received");
+      m_endRxEvent.Cancel ();
+      m_interference.EndRx ();
+      NS_ASSERT (m_pendingRx > 0);
+      m_pendingRx--;
+    }
+    else
+    {
+      NS_LOG_DEBUG ("drop packet because already receiving (power=" << rxPowerW << "W)");
+      NS_ASSERT (m_pendingRx > 0);
+      m_pendingRx--;
+      return;
+    }
   }
+
+  NS_LOG_DEBUG ("sync to signal (power=" << rxPowerW << "W)");
+  // thermal noise (-174 dBm/Hz) over the bandwidth, raised by the noise figure
+  double noiseW = 1.3803e-23 * 290.0 * GetChipRate () * pow (10.0, m_noiseFigureDb / 10.0);
+  m_interference.StartRx (rxPowerW, noiseW, GetErrorRateTable (),
+                          m_dataRate * TimeStep (1).GetSeconds ());
+  m_endRxEvent = Simulator::Schedule (rxDuration, &ContikiPhy::EndReceive, this, packet);
 }
 
 void
-ContikiPhy::EndReceive (Ptr<Packet> packet)
+ContikiPhy::EndReceive (Ptr<const Packet> packet)
 {
   NS_LOG_FUNCTION (this << packet);
+  NS_ASSERT (m_pendingRx > 0);
+  m_pendingRx--;
+  m_interference.Advance (Simulator::Now ().GetTimeStep ());
+  double successRate = m_interference.GetRxSuccessRate ();
+  m_interference.EndRx ();
   /*  If SNR and Packet Error Rate are acceptable */
-  //if (m_random.GetValue (0, 1) > 0.1)
-  if (1)
+  if (m_random.GetValue (0, 1) < successRate)
     {
-      /* Pass packet up the stack to the MAC Layer */
+      /* Pass packet up the stack to the MAC Layer, the channel shares the
+         frame among all receivers so this is where it gets its own copy */
 	  NotifyMonitorSniffRx (packet);
-      m_rxOkCallback(packet);
+      m_rxOkCallback (packet->Copy ());
     }
   else
     {
       /*  failure. */
+      NS_LOG_DEBUG ("drop packet because of errors (success rate=" << successRate << ")");
       //NotifyRxDrop (packet);
     }
 }
 
+Time
+ContikiPhy::GetMinTxDuration (void)
+{
+  // An acknowledgment is the smallest frame: FCF, sequence number and FCS
+  return CalculateTxDuration (5);
+}
+
+void
+ContikiPhy::NotifyRxScheduled (void)
+{
+  m_pendingRx++;
+}
+
+bool
+ContikiPhy::HasPendingRx (void) const
+{
+  return m_pendingRx > 0;
+}
+
 void
 ContikiPhy::RegisterListener (ContikiMac *listener)
 {
@@ -225,7 +337,24 @@ ContikiPhy::SetChannel (Ptr<ContikiChannel> channel)
 void
 ContikiPhy::SetEdThreshold (double edThreshold)
 {
-  m_edThresholdW = edThreshold;
+  m_edThresholdW = DbmToW (edThreshold);
+  if (m_channel != 0)
+    {
+      // the channel derives its culling range from the thresholds
+      m_channel->InvalidateRange ();
+    }
+}
+
+double
+ContikiPhy::GetEdThreshold (void) const
+{
+  return 10.0 * log10 (m_edThresholdW * 1000.0);
+}
+
+bool
+ContikiPhy::CanSync (double rxPowerDbm) const
+{
+  return DbmToW (rxPowerDbm) > m_edThresholdW;
 }
 
 uint64_t
@@ -26,6 +26,7 @@
 
 #include "contiki-channel.h"
 #include "contiki-mac.h"
+#include "contiki-interference-helper.h"
 
 
 
@@ -54,10 +55,22 @@ public:
   ContikiPhy ();
   virtual ~ContikiPhy ();
 
-  void StartReceivePacket (Ptr<Packet> packet, double rxPowerDbm);
+  void StartReceivePacket (Ptr<const Packet> packet, double rxPowerDbm);
   void SetDevice (Ptr<Object> device);
   void SetMobility (Ptr<Object> mobility);
+  /**
+   * \param threshold the energy detection threshold, in dBm
+   */
   void SetEdThreshold (double threshold);
+  /**
+   * \returns the energy detection threshold, in dBm
+   */
+  double GetEdThreshold (void) const;
+  /**
+   * \param rxPowerDbm the power a frame would be received with
+   * \returns true if this PHY would sync to such a frame
+   */
+  bool CanSync (double rxPowerDbm) const;
   void SetDataRate (uint64_t dataRate);
   void SetMode (PhyMode mode);
   Ptr<Object> GetDevice (void) const;
@@ -92,12 +105,36 @@ public:
 
   void NotifyMonitorSniffRx (Ptr<const Packet> packet);
 
+  /**
+   * \returns the airtime of the smallest frame (an acknowledgment) in the
+   * current PHY mode
+   */
+  Time GetMinTxDuration (void);
+
+  /**
+   * Called by the channel for every frame it schedules towards this PHY.
+   * The frame stays pending until it is dropped or handed to the MAC.
+   */
+  void NotifyRxScheduled (void);
+
+  /**
+   * \returns true if frames scheduled towards this PHY have not been
+   * dropped or handed to the MAC yet
+   */
+  bool HasPendingRx (void) const;
+
 private:
   virtual void DoDispose (void);
-  virtual void EndReceive (Ptr<Packet> packet);
+  virtual void EndReceive (Ptr<const Packet> packet);
   double DbmToW (double dBm) const;
 
   Time CalculateTxDuration (uint32_t size);
+  /**
+   * \returns the chip rate of the current PHY mode, taken as the bandwidth
+   * of the noise
+   */
+  double GetChipRate (void) const;
+  const ContikiErrorRateTable *GetErrorRateTable (void) const;
 
   Ptr<Object> m_device;
   Ptr<Object> m_mobility;
@@ -106,6 +143,10 @@ private:
   uint64_t m_dataRate;
   PhyMode m_mode;
   double m_edThresholdW;
+  uint32_t m_pendingRx;
+  double m_noiseFigureDb;
+  double m_captureThresholdDb;
+  ContikiInterferenceHelper m_interference;
 
   RxOkCallback m_rxOkCallback;
   EventId m_endRxEvent;
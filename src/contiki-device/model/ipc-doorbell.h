@@ -0,0 +1,101 @@
+/*
+ * ipc-doorbell.h
+ *
+ * Futex based doorbells used to wake up the peer of an IPC ring.  Like
+ * ipc-ring.h this header is plain C so that the Contiki side of the bridge
+ * can include the very same definitions.
+ */
+
+#ifndef IPC_DOORBELL_H_
+#define IPC_DOORBELL_H_
+
+#include <stdint.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Number of polls before a waiter goes to sleep, on multi-core hosts */
+#define IPC_DOORBELL_SPINS 2000
+
+/**
+ * \brief A doorbell: one futex word per direction.
+ *
+ * The producer updates the shared state (typically commits ring records),
+ * then rings the bell, which bumps seq and only enters the kernel when the
+ * peer announced itself as sleeping in waiters.  The consumer samples seq,
+ * checks the shared state and, if there is nothing to do, waits for seq to
+ * move past its sample: first spinning for a while, then sleeping on the
+ * futex.  All accesses are sequentially consistent so that a ring can never
+ * miss a waiter that is about to sleep.
+ */
+typedef struct ipc_doorbell_t {
+	volatile uint32_t seq;
+	volatile uint32_t waiters;
+} ipc_doorbell_t;
+
+static inline void ipc_doorbell_init(ipc_doorbell_t *bell) {
+	bell->seq = 0;
+	bell->waiters = 0;
+}
+
+static inline void ipc_cpu_relax(void) {
+#if defined(__i386__) || defined(__x86_64__)
+	__asm__ __volatile__ ("pause");
+#else
+	__asm__ __volatile__ ("" ::: "memory");
+#endif
+}
+
+/**
+ * Spinning only pays off when the peer runs on another core.
+ */
+static inline int ipc_doorbell_spins(void) {
+	static int spins = -1;
+	if (spins < 0)
+		spins = sysconf(_SC_NPROCESSORS_ONLN) > 1 ? IPC_DOORBELL_SPINS : 0;
+	return spins;
+}
+
+/**
+ * Consumer side: sample to take before checking the shared state.
+ */
+static inline uint32_t ipc_doorbell_sample(ipc_doorbell_t *bell) {
+	return __atomic_load_n(&bell->seq, __ATOMIC_SEQ_CST);
+}
+
+/**
+ * Producer side: to be called once the shared state has been updated.
+ */
+static inline void ipc_doorbell_ring(ipc_doorbell_t *bell) {
+	__atomic_add_fetch(&bell->seq, 1, __ATOMIC_SEQ_CST);
+	if (__atomic_load_n(&bell->waiters, __ATOMIC_SEQ_CST) != 0)
+		syscall(SYS_futex, &bell->seq, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
+
+/**
+ * Consumer side: waits until the bell has been rung since the sample was
+ * taken.  Futexes are not private, the bell may live in shared memory.
+ */
+static inline void ipc_doorbell_wait(ipc_doorbell_t *bell, uint32_t sample) {
+	int i, spins = ipc_doorbell_spins();
+	for (i = 0; i < spins; i++) {
+		if (__atomic_load_n(&bell->seq, __ATOMIC_SEQ_CST) != sample)
+			return;
+		ipc_cpu_relax();
+	}
+	__atomic_add_fetch(&bell->waiters, 1, __ATOMIC_SEQ_CST);
+	while (__atomic_load_n(&bell->seq, __ATOMIC_SEQ_CST) == sample)
+		syscall(SYS_futex, &bell->seq, FUTEX_WAIT, sample, NULL, NULL, 0);
+	__atomic_sub_fetch(&bell->waiters, 1, __ATOMIC_SEQ_CST);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* IPC_DOORBELL_H_ */
@@ -5,8 +5,8 @@
 #include <signal.h>
 #include <sys/types.h>
 #include <sys/mman.h>
-#include <semaphore.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 #include <sstream>
 
@@ -33,20 +33,19 @@ const uint8_t TIMER_TYPE = 1;
 //#define TIMER_TYPE 1
 //#endif
 
-std::map<uint32_t, sem_t*> IpcReader::listOfGoSemaphores;
-std::map<uint32_t, sem_t*> IpcReader::listOfDoneSemaphores;
-std::map<Time, std::list<uint32_t> > IpcReader::nodesToWakeUp;
-SystemMutex IpcReader::m_controlNodesToWakeUp;
-sem_t IpcReader::m_sem_time;
-int IpcReader::m_time_Memory_Id;
+std::map<uint32_t, IpcReader*> IpcReader::listOfReaders;
+WakeupWheel IpcReader::m_wakeups;
 
-size_t IpcReader::m_traffic_size = 1500;
-size_t IpcReader::m_time_size = 8;
-int* IpcReader::m_shm_time = NULL;
+std::vector<IpcReader::Arena> IpcReader::m_arenas;
+
+size_t IpcReader::m_traffic_size = IPC_RING_MTU;
 
 IpcReader::IpcReader() :
 		m_nodeId(0), m_pid(0), m_readCallback(0), m_readThread(0), m_stop(
-				false), m_destroyEvent() {
+				false), m_destroyEvent(), m_clock(0), m_released(0), m_done(
+				0), m_cursor(0), sharedSemaphores(0), m_inSlots(0), m_inSlotsEnd(
+				0) {
+	ipc_doorbell_init(&m_doneBell);
 
 }
 
@@ -54,110 +53,144 @@ IpcReader::~IpcReader() {
 	Stop();
 }
 
-void* alocateSharedMemory(int uniqueKey, int sizeOfMemory, int *id) {
-	//NS_ASSERT_MSG (m_writeThread == 0, "ipc write thread already exists");
-	int shMemSegID; // shared memory segment id
-	void* shMemSeg; //ptr to shared memory segment
-
-	// gets the memory segment
-	if ((shMemSegID = shmget((key_t)(uniqueKey), sizeOfMemory,
-			IPC_CREAT | SHM_R | SHM_W)) < 0) {
-		perror("shmget error \n");
-	}
-	if ((shMemSeg = shmat(shMemSegID, NULL, 0)) == (void*) ((-1))) {
-		perror("shmat error \n");
-		exit (EXIT_FAILURE);
-	}
-	*id = shMemSegID;
-	return shMemSeg;
+size_t IpcReader::GetNodeBlockSize(void) {
+	// keeps the rings cache line aligned
+	size_t header = (sizeof(semaphores_t) + IPC_CACHE_LINE - 1)
+			& ~((size_t) IPC_CACHE_LINE - 1);
+	return header + 2 * sizeof(ipc_ring_t);
 }
 
-void IpcReader::initIpc() {
-	// Allocates structure space to share among processes
-	int id = 0;
-	void* shMemSeg = alocateSharedMemory(
-			(START_CONST + (m_nodeId * 10) + MAIN_SH_SRTUCTURE),
-			sizeof(semaphores_t), &id);
-	sharedSemaphores = (semaphores_t*) ((shMemSeg));
-	sharedSemaphores->id = id;
-
-	// ****************
-	// Alocate shared memory segments
-	// ****************
-	shMemSeg = alocateSharedMemory((START_CONST + (m_nodeId * 10) + TRAFFIC_IN),
-			m_traffic_size + sizeof(size_t), &sharedSemaphores->traffic_in_id);
-	sharedSemaphores->traffic_in = (unsigned char*) ((shMemSeg));
-
-	shMemSeg = alocateSharedMemory((START_CONST + (m_nodeId * 10) + TIMER_IN),
-			m_time_size + 1, &sharedSemaphores->traffic_timer_id);
-	sharedSemaphores->traffic_timer = (unsigned char*) ((shMemSeg));
-
-	shMemSeg = alocateSharedMemory(
-			(START_CONST + (m_nodeId * 10) + TRAFFIC_OUT),
-			sizeof(size_t) + m_traffic_size + sizeof(size_t),
-			&sharedSemaphores->traffic_out_id);
-	sharedSemaphores->traffic_out = (unsigned char*) ((shMemSeg));
-
-	// Special case the time, that is unique!
-	// Instantiates only once, it is a shared memory
-	if (m_shm_time == NULL) {
-		shMemSeg = alocateSharedMemory((START_CONST + (m_nodeId * 10) + TIME),
-				m_time_size, &m_time_Memory_Id);
-		m_shm_time = (int *) (shMemSeg);
-
-		if (sem_init(&m_sem_time, 1, 1))
-			NS_FATAL_ERROR(
-					"ns -3 sem_init(sharedSemaphores->sem_time) failed: " << strerror(errno));
-	}
-
-	// saves the static values of the semaphores on the specific node register
-	sharedSemaphores->sem_time = m_sem_time;
-	sharedSemaphores->shm_time = m_shm_time;
-	sharedSemaphores->shm_time_id = m_time_Memory_Id;
-
-	if (sem_init(&sharedSemaphores->sem_in, 1, 0))
-		NS_FATAL_ERROR(
-				"ns -3 sem_init(sharedSemaphores->sem_in) failed: " << strerror(errno));
-
-	if (sem_init(&sharedSemaphores->sem_out, 1, 1))
-		NS_FATAL_ERROR(
-				"ns -3 sem_init(sharedSemaphores->sem_out) failed: " << strerror(errno));
-
-	if (sem_init(&sharedSemaphores->sem_timer, 1, 0))
-		NS_FATAL_ERROR(
-				"ns -3 sem_init(sharedSemaphores->sem_timer) failed: " << strerror(errno));
+void IpcReader::MapArena(Arena &arena) {
+	// The name only lives until shm_unlink below, the mapping is inherited
+	// by the contiki processes through fork, so nothing is left behind if
+	// the simulation crashes and concurrent simulations never collide.
+	// The descriptor is kept for the mote spawner, whose processes were
+	// forked before the arena existed and map it on their own.
+	std::ostringstream name;
+	name << "/ns3-contiki-" << getpid() << "-" << arena.m_firstNode;
+	int fd = shm_open(name.str().c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+	if (fd == -1)
+		NS_FATAL_ERROR("shm_open() failed: " << strerror(errno));
+	shm_unlink(name.str().c_str());
+
+	if (ftruncate(fd, arena.m_size) == -1)
+		NS_FATAL_ERROR("ftruncate() of the IPC arena failed: " << strerror(errno));
+
+	void *base = mmap(NULL, arena.m_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+			fd, 0);
+	if (base == MAP_FAILED)
+		NS_FATAL_ERROR("mmap() of the IPC arena failed: " << strerror(errno));
+
+	arena.m_base = (unsigned char *) base;
+	arena.m_fd = fd;
+
+	NS_LOG_LOGIC("Mapped IPC arena for nodes " << arena.m_firstNode << " to "
+			<< arena.m_firstNode + arena.m_nNodes - 1 << " (" << arena.m_size
+			<< " bytes)");
+}
 
-	if (sem_init(&sharedSemaphores->sem_timer_done, 1, 0))
-		NS_FATAL_ERROR(
-				"ns -3 sem_init(sharedSemaphores->sem_timer_done) failed: " << strerror(errno));
+void IpcReader::ReserveArena(uint32_t nNodes) {
+	Arena arena;
+	arena.m_firstNode = 0;
+	if (!m_arenas.empty())
+		arena.m_firstNode = m_arenas.back().m_firstNode
+				+ m_arenas.back().m_nNodes;
+	arena.m_nNodes = nNodes;
+	arena.m_size = GetNodeBlockSize() * nNodes;
+	arena.m_users = 0;
+	arena.m_fd = -1;
+	MapArena(arena);
+	m_arenas.push_back(arena);
+}
 
-	if (sem_init(&sharedSemaphores->sem_timer_go, 1, 0))
-		NS_FATAL_ERROR(
-				"ns -3 sem_init(sharedSemaphores->sem_timer_go) failed: " << strerror(errno));
+semaphores_t *IpcReader::AttachNode(uint32_t nodeId) {
+	std::vector<Arena>::iterator it;
+	for (it = m_arenas.begin(); it != m_arenas.end(); it++) {
+		if (nodeId >= it->m_firstNode
+				&& nodeId < it->m_firstNode + it->m_nNodes)
+			break;
+	}
 
-	if (sem_init(&sharedSemaphores->sem_traffic_go, 1, 0))
-		NS_FATAL_ERROR(
-				"ns -3 sem_init(sharedSemaphores->sem_traffic_go) failed: " << strerror(errno));
+	if (it == m_arenas.end()) {
+		// Sizes the arena for every node we know about at once, nodes created
+		// after it get a new arena of their own
+		uint32_t firstNode = 0;
+		if (!m_arenas.empty())
+			firstNode = m_arenas.back().m_firstNode + m_arenas.back().m_nNodes;
+		uint32_t nNodes = ContikiNetDevice::GetNNodes();
+		if (firstNode + nNodes <= nodeId)
+			nNodes = nodeId - firstNode + 1;
+		ReserveArena(nNodes);
+		it = m_arenas.end() - 1;
+	} else if (it->m_base == 0) {
+		// all the nodes of this arena were stopped before
+		MapArena(*it);
+	}
 
-	if (sem_init(&sharedSemaphores->sem_traffic_done, 1, 0))
-		NS_FATAL_ERROR(
-				"ns -3 sem_init(sharedSemaphores->sem_traffic_done) failed: " << strerror(errno));
+	it->m_users++;
+	size_t block = GetNodeBlockSize();
+	return (semaphores_t *) (it->m_base + (nodeId - it->m_firstNode) * block);
+}
 
-	if (sem_init(&sharedSemaphores->sem_go, 1, 0))
-		NS_FATAL_ERROR(
-				"ns -3 sem_init(sharedSemaphores->sem_go) failed: " << strerror(errno));
+void IpcReader::SetPid(pid_t pid) {
+	m_pid = pid;
+}
 
-	// saves the value into the global list of go semaphores
-	listOfGoSemaphores.insert(
-			std::pair<uint32_t, sem_t*>(m_nodeId, &sharedSemaphores->sem_go));
+int IpcReader::GetArenaFd(size_t *size, uint64_t *offset) const {
+	NS_ASSERT(sharedSemaphores != 0);
+	for (std::vector<Arena>::const_iterator it = m_arenas.begin();
+			it != m_arenas.end(); it++) {
+		if (m_nodeId >= it->m_firstNode
+				&& m_nodeId < it->m_firstNode + it->m_nNodes) {
+			*size = it->m_size;
+			*offset = (unsigned char *) sharedSemaphores - it->m_base;
+			return it->m_fd;
+		}
+	}
+	return -1;
+}
 
-	if (sem_init(&sharedSemaphores->sem_done, 1, 0))
-		NS_FATAL_ERROR(
-				"ns -3 sem_init(sharedSemaphores->sem_done) failed: " << strerror(errno));
+void IpcReader::DetachNode(uint32_t nodeId) {
+	for (std::vector<Arena>::iterator it = m_arenas.begin();
+			it != m_arenas.end(); it++) {
+		if (nodeId >= it->m_firstNode
+				&& nodeId < it->m_firstNode + it->m_nNodes) {
+			if (it->m_users > 0 && --it->m_users == 0) {
+				munmap(it->m_base, it->m_size);
+				close(it->m_fd);
+				it->m_base = 0;
+				it->m_fd = -1;
+			}
+			return;
+		}
+	}
+}
 
-	// saves the value into the global  list of done semaphores
-	listOfDoneSemaphores.insert(
-			std::pair<uint32_t, sem_t*>(m_nodeId, &sharedSemaphores->sem_done));
+void IpcReader::initIpc() {
+	// Every node has a fixed block in the shared arena: its doorbells
+	// followed by the incoming and the outgoing rings
+	sharedSemaphores = AttachNode(m_nodeId);
+	memset(sharedSemaphores, 0, sizeof(semaphores_t));
+	sharedSemaphores->node_id = m_nodeId;
+
+	size_t header = GetNodeBlockSize() - 2 * sizeof(ipc_ring_t);
+	sharedSemaphores->ring_in_offset = header;
+	sharedSemaphores->ring_out_offset = header + sizeof(ipc_ring_t);
+	ipc_ring_init(ipc_ring_in(sharedSemaphores));
+	ipc_ring_init(ipc_ring_out(sharedSemaphores));
+	m_inSlots = (uint8_t *) ipc_ring_in(sharedSemaphores)->slots;
+	m_inSlotsEnd = (uint8_t *) (ipc_ring_in(sharedSemaphores)->slots
+			+ IPC_RING_SLOTS);
+
+	ipc_doorbell_init(&sharedSemaphores->bell_in);
+	ipc_doorbell_init(&sharedSemaphores->bell_out);
+	m_released = 0;
+	m_done = 0;
+	m_cursor = 0;
+
+	// saves the reader into the global list so that the clock handler
+	// can release this node
+	listOfReaders[m_nodeId] = this;
 }
 
 semaphores_t * IpcReader::Start(Callback<void, uint8_t*, ssize_t> readCallback,
@@ -201,162 +234,227 @@ void IpcReader::DestroyEvent(void) {
 }
 
 void IpcReader::Stop(void) {
-	m_stop = true;
+	__atomic_store_n(&m_stop, true, __ATOMIC_SEQ_CST);
 	// join the read thread
 	if (m_readThread != 0) {
-		if (sem_post(&sharedSemaphores->sem_traffic_done) == -1)
-			NS_FATAL_ERROR("sem_wait(): error" << strerror (errno));
-		else
-			m_readThread->Join();
+		ipc_doorbell_ring(&sharedSemaphores->bell_in);
+		m_readThread->Join();
 		m_readThread = 0;
 
 	}
 
-	// Cleans the sem_time, a special case
-	// Free alocated Shared memory
-	if(m_shm_time != NULL){
-		sem_destroy(&sharedSemaphores->sem_time);
-		shmdt(&m_shm_time);
-		shmdt(&sharedSemaphores->shm_time);
-		shmctl(sharedSemaphores->shm_time_id, IPC_RMID, 0);
-		sharedSemaphores->shm_time_id = -1;
+	// already stopped
+	if (sharedSemaphores == 0) {
+		m_stop = false;
+		return;
 	}
 
-	// Free semaphores
-	sem_destroy(&sharedSemaphores->sem_in);
-	sem_destroy(&sharedSemaphores->sem_out);
-	sem_destroy(&sharedSemaphores->sem_timer);
-	sem_destroy(&sharedSemaphores->sem_timer_go);
-	sem_destroy(&sharedSemaphores->sem_timer_done);
-	sem_destroy(&sharedSemaphores->sem_traffic_go);
-	sem_destroy(&sharedSemaphores->sem_traffic_done);
-	sem_destroy(&sharedSemaphores->sem_go);
-	sem_destroy(&sharedSemaphores->sem_done);
-
-
-	shmdt(&sharedSemaphores->traffic_in);
-	shmctl(sharedSemaphores->traffic_in_id, IPC_RMID, 0);
-
-	shmdt(&sharedSemaphores->traffic_timer);
-	shmctl(sharedSemaphores->traffic_timer_id, IPC_RMID, 0);
-
-	shmdt(&sharedSemaphores->traffic_out);
-	shmctl(sharedSemaphores->traffic_out_id, IPC_RMID, 0);
-
-	int id = sharedSemaphores->id;
-	shmdt(&sharedSemaphores);
-	shmctl(id, IPC_RMID, 0);
+	listOfReaders.erase(m_nodeId);
 
+	DetachNode(m_nodeId);
+	sharedSemaphores = 0;
 
 	// reset everything else
 	m_readCallback.Nullify();
 	m_stop = false;
 
 
-	NS_LOG_LOGIC("Cleared semaphores and Shared memories\n");
+	NS_LOG_LOGIC("Cleared shared memories\n");
 }
 
 
 // This runs in a separate thread
 void IpcReader::Run(void) {
 
+	ipc_ring_t *ring = ipc_ring_in(sharedSemaphores);
+
 	// Never ending loop to wait for Contiki requests for new packets and timers
 	for (;;) {
 
-		/////////////////////////////////////////////////////////
-		// Checking if contiki requested to schedule a timer
-		uint8_t typeOfInfo = 0;
-		uint64_t timerval = 0;
-		uint8_t timertype = 0;
-
-		sem_post(&sharedSemaphores->sem_in);
-
-		if (sem_wait(&sharedSemaphores->sem_traffic_done) == -1)
-			NS_FATAL_ERROR("sem_wait(): error" << strerror (errno));
+		// Samples the doorbell before looking at the ring, so that a record
+		// committed after the check rings it past the sample
+		uint32_t sample = ipc_doorbell_sample(&sharedSemaphores->bell_in);
 
-		if (m_stop) {
+		if (__atomic_load_n(&m_stop, __ATOMIC_SEQ_CST)) {
 			// this thread is done
 			break;
 		}
 
-		// Finds out what is in the pipe (Data or timer request)
-		memcpy(&typeOfInfo, sharedSemaphores->traffic_in, 1);
+		if (ipc_ring_peek_at(ring, m_cursor) == NULL) {
+			ipc_doorbell_wait(&sharedSemaphores->bell_in, sample);
+			continue;
+		}
 
-		// 0 = Data transfer
-		// 1 = Timer
-		if (typeOfInfo == TIMER_TYPE) {
+		// Drains everything contiki queued so far, so that a burst of frames
+		// costs a single wake up
+		ipc_record_t *rec;
+		while ((rec = ipc_ring_peek_at(ring, m_cursor)) != NULL) {
+			m_cursor++;
 
-			NS_LOG_LOGIC("contiki requested a timer\n" << m_nodeId);
+			if (rec->type == IPC_RECORD_TIMER) {
 
-			NS_LOG_LOGIC(" ---Wait ipcReader  sharedSemaphores->sem_timer Run at "
-					<< m_nodeId << " \n");
+				NS_LOG_LOGIC("contiki requested a timer " << m_nodeId);
 
-			memcpy(&timertype, sharedSemaphores->traffic_in + 1, 1);
-			memcpy(&timerval, sharedSemaphores->traffic_in + 2, 8);
+				uint8_t timertype = rec->subtype;
+				uint64_t timerval = rec->value;
+				ipc_ring_retire(ring, rec);
 
-			memset(sharedSemaphores->traffic_in, 0, 10);
+				if (timertype != 0 && timertype != 1)
+					NS_FATAL_ERROR("wrong timertype " << timertype);
 
-			NS_LOG_LOGIC("contiki's timer handled " << m_nodeId);
-			NS_LOG_LOGIC("releasing contiki after timer request " << m_nodeId);
+				if (timerval > 0) {
+					SetTimer(timerval, timertype);
+				}
 
-			if (timertype != 0 && timertype != 1)
-				NS_FATAL_ERROR("wrong timertype " << timertype);
+			} else if (rec->type == IPC_RECORD_DATA) {
 
-			if (timerval > 0) {
-				SetTimer(timerval, timertype);
-			}
+				size_t input_size = rec->len;
 
-		} else {
+				if (input_size == 0 || input_size > m_traffic_size) {
+					NS_LOG_INFO("read data of size " << input_size);
+					ipc_ring_retire(ring, rec);
+					continue;
+				}
 
-			//////////////////////////////////////////////////////////
+				// Processing traffic sent by contiki: the frame is handed
+				// over in place and its slot retired by ReleaseFrame(), unless
+				// the simulator already holds so many slots that contiki could
+				// run out of room before it is done, which would never happen
+				// as the simulator waits for it
+				uint8_t* buf = rec->data;
+				if (ipc_ring_held(ring, m_cursor) > IPC_RING_SLOTS / 2) {
+					buf = (uint8_t*) ((malloc(input_size)));
+					NS_ABORT_MSG_IF(buf == 0, "malloc() failed");
+					memcpy(buf, rec->data, input_size);
+					ipc_ring_retire(ring, rec);
+				}
 
-			// Processing traffic sent by contiki
-			uint8_t* buf = (uint8_t*) ((malloc(m_traffic_size)));
-			memset(buf, 0, m_traffic_size);
-			NS_ABORT_MSG_IF(buf == 0, "malloc() failed");
-			size_t input_size = 0;
+				NS_LOG_LOGIC("read data of length " << input_size);
+				m_readCallback(buf, input_size);
 
-			NS_LOG_LOGIC("ns3 reading " << m_nodeId);
-			// First read input size
-			memcpy(&input_size, sharedSemaphores->traffic_in + 1,
-					sizeof(size_t));
+			} else if (rec->type == IPC_RECORD_DONE) {
 
-			// Now read input
-			memcpy(buf, sharedSemaphores->traffic_in + sizeof(size_t) + 1,
-					input_size);
-			memset(sharedSemaphores->traffic_in, 0,
-					m_traffic_size + sizeof(size_t));
+				// Everything contiki produced for its last release has been
+				// gone through, the simulator can move on
+				ipc_ring_retire(ring, rec);
+				__atomic_add_fetch(&m_done, 1, __ATOMIC_SEQ_CST);
+				ipc_doorbell_ring(&m_doneBell);
 
-			if (input_size == 0) {
-				//NS_LOG_LOGIC ("ContikiNetDeviceFdReader::DoRead(): done" << m_nodeId);
-				free(buf);
-				buf = 0;
-				//len = 0;
+			} else {
+				NS_LOG_ERROR("unknown record type " << (int) rec->type);
+				ipc_ring_retire(ring, rec);
 			}
+		}
 
-			// the callback is only called when m_len is positive (data
-			// is ignored if m_len is negative)
-			if (input_size > 0) {
-				NS_LOG_LOGIC("read data of length " << input_size);
-				m_readCallback(buf, input_size);
-			} else
-				NS_LOG_INFO("read data of size 0");
+		// Contiki may be waiting for room in the ring
+		ipc_doorbell_ring(&sharedSemaphores->bell_out);
+	}
+}
 
-		}
+bool IpcReader::Write(const uint8_t *buf, uint32_t len) {
+	// The last slot is kept for the clock update that releases contiki
+	if (ipc_ring_space(ipc_ring_out(sharedSemaphores)) <= 1
+			|| ipc_ring_push(ipc_ring_out(sharedSemaphores), IPC_RECORD_DATA, 0, 0,
+					buf, len) == -1) {
+		NS_LOG_WARN("outgoing ring of node " << m_nodeId << " is full, dropping frame");
+		return false;
+	}
+	return true;
+}
 
-		// Remove this step could increase performance, but could happen that the contiki
-		// machine would be released BEFORE the ns-3 thread have the time to
-		// process the message, what could cause problems afterwards with missing
-		// messages
-		std::cout
-				<< " ---Post ipcReader  sharedSemaphores->sem_traffic_go Run at "
-				<< m_nodeId << " \n";
-		sem_post(&sharedSemaphores->sem_traffic_go);
-		std::cout
-				<< " ---Post ipcReader  sharedSemaphores->sem_traffic_go Run at "
-				<< m_nodeId << " \n";
+bool IpcReader::Write(Ptr<const Packet> packet) {
+	ipc_ring_t *ring = ipc_ring_out(sharedSemaphores);
+	uint32_t len = packet->GetSize();
+	// The last slot is kept for the clock update that releases contiki
+	ipc_record_t *rec = ipc_ring_space(ring) <= 1 ? NULL : ipc_ring_reserve(ring);
+	if (rec == NULL || len > IPC_RING_MTU) {
+		NS_LOG_WARN("outgoing ring of node " << m_nodeId << " is full, dropping frame");
+		return false;
+	}
+	rec->type = IPC_RECORD_DATA;
+	rec->subtype = 0;
+	rec->len = packet->CopyData(rec->data, len);
+	rec->value = 0;
+	ipc_ring_commit(ring);
+	return true;
+}
 
+void IpcReader::ReleaseFrame(uint8_t *buf) {
+	// the bounds are only compared: the copy was allocated while the ring
+	// was mapped, it cannot lie where the ring was
+	if (buf < m_inSlots || buf >= m_inSlotsEnd) {
+		// copied out of the ring by the read thread
+		free(buf);
+		return;
 	}
+	// the node was stopped, its slots went away with the ring
+	if (sharedSemaphores == 0)
+		return;
+	ipc_ring_t *ring = ipc_ring_in(sharedSemaphores);
+	ipc_record_t *rec = ring->slots + (buf - m_inSlots) / sizeof(ipc_record_t);
+	NS_ASSERT(rec->data == buf);
+	ipc_ring_retire(ring, rec);
+	// Contiki may be waiting for room in the ring
+	ipc_doorbell_ring(&sharedSemaphores->bell_out);
+}
+
+void IpcReader::Release(Time clock) {
+	m_clock = clock.GetTimeStep();
+	// Write() always leaves room for this record, contiki time granularity
+	// is milliseconds
+	if (ipc_ring_push(ipc_ring_out(sharedSemaphores), IPC_RECORD_CLOCK, 0,
+			m_clock / 1000000, NULL, 0) == -1)
+		NS_LOG_WARN("outgoing ring of node " << m_nodeId << " is full, clock update dropped");
+
+	m_released++;
+	ipc_doorbell_ring(&sharedSemaphores->bell_out);
+}
+
+void IpcReader::WaitDone(void) {
+	for (;;) {
+		uint32_t sample = ipc_doorbell_sample(&m_doneBell);
+		if (__atomic_load_n(&m_done, __ATOMIC_SEQ_CST) == m_released)
+			break;
+		ipc_doorbell_wait(&m_doneBell, sample);
+	}
+
+	// contiki is done, so is the read thread with the timers it asked for
+	for (std::vector<uint64_t>::iterator it = m_timerWakeups.begin();
+			it != m_timerWakeups.end(); it++)
+		m_wakeups.Insert(*it, m_nodeId);
+	m_timerWakeups.clear();
+}
+
+Time IpcReader::GetClock(void) const {
+	return TimeStep(m_clock);
+}
+
+void IpcReader::InsertAt(uint32_t context, uint64_t ts, EventImpl *event) {
+	// Runs in the simulator thread at or before ts, the simulator never
+	// goes past the clock of a node before that node is done
+	NS_ASSERT(TimeStep(ts) >= Simulator::Now());
+	Simulator::ScheduleWithContext(context, TimeStep(ts) - Simulator::Now(),
+			event);
+}
+
+void IpcReader::ScheduleAtClock(Time delay, EventImpl *event) {
+	// Events coming from another thread are inserted relative to whatever
+	// time the simulator has reached when it picks them up, which may lie
+	// before the clock contiki was released for. Going through InsertAt
+	// pins them to the contiki clock.
+	uint64_t ts = m_clock + delay.GetTimeStep();
+	Simulator::ScheduleWithContext(m_nodeId, Seconds(0),
+			MakeEvent(&IpcReader::InsertAt, m_nodeId, ts, event));
+}
+
+void IpcReader::SetPendingInputCallback(Callback<bool> pendingInput) {
+	m_pendingInput = pendingInput;
+}
+
+bool IpcReader::CanRunAhead(void) {
+	if (m_pendingInput.IsNull())
+		return false;
+	return !m_pendingInput();
 }
 
 void IpcReader::CheckTimer(void) {
@@ -375,18 +473,18 @@ void IpcReader::SetRelativeTimer() {
 }
 
 void IpcReader::SetTimer(Time time, int type) {
+	// contiki asks for intervals relative to its own clock
 	if (type == 0) {
 		void (*f)(void) = 0;
-		//XXX schedule 1 millisecond after the requested time
-		// so that contiki timers can expire
-		Simulator::ScheduleWithContext(m_nodeId, time, f);
+		// an empty event at exactly the requested time: the wake up
+		// registered below releases the node then, and its timers expire
+		ScheduleAtClock(time, MakeEvent(f));
 	} else {
-		Simulator::ScheduleWithContext(m_nodeId, time, &IpcReader::SendAlarm,
-				this);
+		ScheduleAtClock(time, MakeEvent(&IpcReader::SendAlarm, this));
 	};
-	// registers the event
-//	Time timeToShedule = (time + Simulator::Now());
-	setSchedule(time, m_nodeId);
+	// registers the event, the simulator thread picks it up once contiki
+	// is done
+	m_timerWakeups.push_back(m_clock + time.GetTimeStep());
 }
 
 void IpcReader::SetTimer(uint64_t time, int type) {
@@ -394,53 +492,13 @@ void IpcReader::SetTimer(uint64_t time, int type) {
 }
 
 void IpcReader::setSchedule(Time time, uint32_t nodeId) {
-	CriticalSection cs(m_controlNodesToWakeUp);
-	// adds the node id to the specific time scheduling list
-	std::cout << " --- #### To schedule: " << time << " : " << nodeId << "\n";
-	if (nodesToWakeUp.find(time) != nodesToWakeUp.end()) {
-		nodesToWakeUp[time].push_back(nodeId);
-		nodesToWakeUp[time].unique();
-	} else {
-		// it is the first node to be added to this time schedule
-		std::list < uint32_t > scheduledNodes;
-		scheduledNodes.push_back(nodeId);
-		std::pair<std::map<Time, std::list<uint32_t> >::iterator, bool> ret;
-		ret = nodesToWakeUp.insert(
-				std::pair<Time, std::list<uint32_t> >(time, scheduledNodes));
-		if (ret.second == false) {
-			NS_LOG_ERROR("Could not register scheduled event");
-		}
-
-	}
-
+	NS_LOG_LOGIC("Node " << nodeId << " to wake up at " << time);
+	m_wakeups.Insert(time.GetTimeStep(), nodeId);
 }
 
-std::list<uint32_t> IpcReader::getReleaseSchedule(Time time) {
-
-	CriticalSection cs(m_controlNodesToWakeUp);
-	std::list < uint32_t > returnValue;
-
-	std::map<Time, std::list<uint32_t> >::iterator it;
-
-	// Return all that should have been awaken prior than the present time
-	// Waits for the nodes to finnish their jobs
-	for (it = nodesToWakeUp.begin();
-			it != nodesToWakeUp.end() && it->first <= time; it++) {
-		if (it->first <= time) {
-			(it->second).sort();
-			returnValue.merge(it->second);
-		}
-	}
-
-	// Clean the lists
-	if (returnValue.size() > 0) {
-		nodesToWakeUp.erase(nodesToWakeUp.begin(), it);
-
-		// Remove the possible duplicated node Ids from the list
-		returnValue.unique();
-	}
-
-	return returnValue;
+void IpcReader::getReleaseSchedule(Time time,
+		std::vector<WakeupWheel::Entry> &due) {
+	m_wakeups.Collect(time.GetTimeStep(), due);
 }
 
 } // namespace ns3
@@ -11,91 +11,72 @@
 #include <stdint.h>
 #include <string.h>
 #include <map>
+#include <list>
 
 #include "ns3/callback.h"
 #include "ns3/event-id.h"
 #include "ns3/system-thread.h"
 #include "ns3/system-mutex.h"
+#include "ns3/nstime.h"
+#include "ns3/event-impl.h"
+#include "ns3/packet.h"
 
 #include <sstream>
-#include <sys/ipc.h>
-#include <sys/shm.h>
+#include <vector>
 
 
-#define START_CONST 1092
-#define MAIN_SH_SRTUCTURE  0
-#define TRAFFIC_IN  1
-#define TRAFFIC_OUT  2
-#define TIMER_IN  3
-#define TIME  4
-#define IN  5
+#include "ipc-ring.h"
+#include "ipc-doorbell.h"
+#include "wakeup-wheel.h"
 
 /**
- * \brief Union to store the shared semaphores.
+ * \brief Shared control block of a node.
  *
- * Shared semaphores storage type
+ * One of these heads every node block of the shared arena and is followed
+ * by the node's two rings.  The rings are addressed relative to the
+ * structure itself, so the block can be mapped at any address.  The type
+ * keeps its historical name as Contiki's entry point takes it.
+ *
+ * Each direction has a single doorbell (see ipc-doorbell.h):
+ *  - contiki commits frames, timer requests and finally a DONE record to
+ *    ring_in, ringing bell_in;
+ *  - ns-3 commits frames and a CLOCK record, which releases contiki, to
+ *    ring_out and rings bell_out.  It also rings bell_out after draining
+ *    ring_in, in case contiki waits for room.
  */
 
 typedef struct semaphores_t {
-	int id;
-
-	sem_t sem_time;
-	sem_t sem_timer;
-
-	sem_t sem_timer_go;
-	sem_t sem_timer_done;
+	uint32_t node_id;
+	char pad_node[IPC_CACHE_LINE - sizeof(uint32_t)];
 
-	sem_t sem_in;
-	sem_t sem_out;
+	ipc_doorbell_t bell_in;
+	char pad_in[IPC_CACHE_LINE - sizeof(ipc_doorbell_t)];
 
-	sem_t sem_traffic_go;
-	sem_t sem_traffic_done;
+	ipc_doorbell_t bell_out;
+	char pad_out[IPC_CACHE_LINE - sizeof(ipc_doorbell_t)];
 
-	sem_t sem_go;
-	sem_t sem_done;
-
-	/**
-	 * \internal
-	 * The pointer to a shared memory address where to receive traffic from.
-	 */
-	unsigned char *traffic_in;
-	int traffic_in_id;
 	/**
 	 * \internal
-	 * The pointer to a shared memory address where to send traffic to.
+	 * Offset of the ring of records written by contiki and read by ns-3
+	 * (frames, timer requests and DONE records).
 	 */
-	unsigned char *traffic_out;
-	int traffic_out_id;
+	uint64_t ring_in_offset;
 	/**
 	 * \internal
-	 * The pointer to a shared memory address where to store the timers.
+	 * Offset of the ring of records written by ns-3 and read by contiki
+	 * (frames and clock updates).
 	 */
-	unsigned char *traffic_timer;
-	int traffic_timer_id;
+	uint64_t ring_out_offset;
 
+} semaphores_t;
 
-	/**
-	 * \internal
-	 * The pointer to a shared memory address where to store the time.
-	 */
-	int *shm_time;
-	int shm_time_id;
-//	unsigned char *traffic_time;
-//	int traffic_time_id;
-//	/**
-//	 * \internal
-//	 * Shared Memory Object for input traffic
-//	 */
-//	int *shm_in;
-//	int shm_in_id;
-//	/**
-//	 * \internal
-//	 * Shared Memory Object for output traffic
-//	 */
-//	int *shm_out;
-//	int shm_out_id;
+static inline ipc_ring_t *ipc_ring_in(semaphores_t *s) {
+	return (ipc_ring_t *) ((unsigned char *) s + s->ring_in_offset);
+}
 
-} semaphores_t;
+static inline ipc_ring_t *ipc_ring_out(semaphores_t *s) {
+	return (ipc_ring_t *) ((unsigned char *) s + s->ring_out_offset);
+}
 
 namespace ns3 {
 class ContikiNetDevice;
@@ -164,57 +145,125 @@ public:
 	void SendAlarm(void);
 
 	/**
-	 * Sets a new scheduled event.
+	 * Sets a new scheduled event. Only to be called from the simulator
+	 * thread, the read thread hands its timers over through WaitDone().
 	 */
 	void setSchedule(Time time, uint32_t nodeId);
 
 	/**
-	 * Returns the Map with the nodes that should wake up now and release the
-	 * time from the scheduling map
+	 * Collects the nodes that should wake up up to the given time, each one
+	 * with its earliest wake up time, and releases them from the scheduling
+	 * wheel.  Later wake ups of a returned node stay scheduled.
+	 *
+	 * \param time the time to collect up to
+	 * \param due cleared and filled with the nodes to wake up
 	 */
-	static std::list<uint32_t> getReleaseSchedule(Time time);
+	static void getReleaseSchedule(Time time,
+			std::vector<WakeupWheel::Entry> &due);
 
 	/*
-	 * Map to store the Go semaphores of all nodes.
+	 * Map to find the reader of every node.
 	 */
-	static std::map<uint32_t, sem_t*> listOfGoSemaphores;
-	/*
-	 * Map to store the Done semaophores of all nodes.
+	static std::map<uint32_t, IpcReader*> listOfReaders;
+
+	/**
+	 * Queues a frame for contiki on the outgoing ring of this node.
+	 *
+	 * \param buf the frame
+	 * \param len the length of the frame
+	 * \returns false if the ring is full and the frame was dropped
 	 */
-	static std::map<uint32_t, sem_t*> listOfDoneSemaphores;
+	bool Write(const uint8_t *buf, uint32_t len);
 
-//	ContikiNetDevice *contikiNetDevice;
 	/**
-	 * \internal
-	 * The pointer to a shared memory address where to synchronize
-	 * current simulation time value.
+	 * Serializes a frame straight into the outgoing ring of this node.
+	 *
+	 * \param packet the frame
+	 * \returns false if the ring is full and the frame has been dropped
 	 */
-	static int *m_shm_time;
-//	static unsigned char *m_traffic_time;
+	bool Write(Ptr<const Packet> packet);
 
 	/**
-	 * \internal
-	 * semaphore for time update operations
+	 * Gives back a frame handed to the read callback, once its content has
+	 * been consumed.  Frames usually point into the incoming ring and their
+	 * slot is only reused after this call.  Once the node is stopped, the
+	 * frames copied out of the ring are still freed, the others went away
+	 * with the ring.
 	 */
-	static sem_t m_sem_time;
+	void ReleaseFrame(uint8_t *buf);
 
 	/**
-	 * \internal
-	 * The size of the packets transfer area
+	 * Gives access to the shared memory arena holding the block of this
+	 * node, for processes that did not inherit its mapping.
+	 *
+	 * \param size filled with the size of the arena
+	 * \param offset filled with the offset of the node block in the arena
+	 * \returns the descriptor of the arena, owned by the reader
 	 */
-	static size_t m_traffic_size;
+	int GetArenaFd(size_t *size, uint64_t *offset) const;
 
 	/**
-	 * \internal
-	 * The size of the time transfer area
+	 * Sets the pid of the contiki process, once it has been forked.
+	 */
+	void SetPid(pid_t pid);
+
+	/**
+	 * Hands a clock update over to contiki and lets it run until it has
+	 * caught up with it.  The clock may lie ahead of the simulation time,
+	 * whatever contiki produces is then scheduled at that clock.
+	 *
+	 * \param clock the time contiki has to advance to
+	 */
+	void Release(Time clock);
+
+	/**
+	 * Blocks until contiki is done with its last release and the read
+	 * thread went through everything it produced, then registers the timers
+	 * it asked for meanwhile.
+	 */
+	void WaitDone(void);
+
+	/**
+	 * \returns the time contiki was last released for
+	 */
+	Time GetClock(void) const;
+
+	/**
+	 * Schedules an event on behalf of contiki at its clock plus a delay.
+	 * Safe to call from the read thread.
+	 *
+	 * \param delay the delay relative to the contiki clock
+	 * \param event the event to schedule
 	 */
-	static size_t m_time_size;
+	void ScheduleAtClock(Time delay, EventImpl *event);
+
+	/**
+	 * Sets the callback telling whether frames are still on their way to
+	 * this node, in which case it must not be released ahead of time.
+	 */
+	void SetPendingInputCallback(Callback<bool> pendingInput);
+
+	/**
+	 * \returns true if this node may be released ahead of the simulation
+	 * time, that is if no frame is on its way to it.
+	 */
+	bool CanRunAhead(void);
 
 	/**
 	 * \internal
-	 * Id of the memory location where the time is stored
+	 * The size of the packets transfer area
 	 */
-	static int m_time_Memory_Id;
+	static size_t m_traffic_size;
+
+	/**
+	 * Maps one shared arena large enough for the next nNodes nodes.  Every
+	 * node gets a fixed block in it, so this only costs a handful of system
+	 * calls.  It is called on demand by the first node that does not fit in
+	 * the arenas mapped so far, sized after ContikiNetDevice::GetNNodes.
+	 *
+	 * \param nNodes number of nodes the arena must hold
+	 */
+	static void ReserveArena(uint32_t nNodes);
 
 
 protected:
@@ -281,11 +330,33 @@ protected:
 
 private:
 
-	// waked up nodes list to improve performance
-//	static std::list<int> nodesToWakeUp;
-//	nodesToWakeUp.insert(std::make_pair(5,"Hello"));
-	static std::map<Time, std::list<uint32_t> > nodesToWakeUp;
-	static SystemMutex m_controlNodesToWakeUp;
+	// wake ups of all nodes, indexed by millisecond
+	static WakeupWheel m_wakeups;
+
+	static void InsertAt(uint32_t context, uint64_t ts, EventImpl *event);
+
+	/**
+	 * \internal
+	 * \brief A shared memory arena holding the blocks of a range of nodes.
+	 */
+	struct Arena {
+		unsigned char *m_base;
+		size_t m_size;
+		uint32_t m_firstNode;
+		uint32_t m_nNodes;
+		uint32_t m_users;
+		int m_fd;
+	};
+	static std::vector<Arena> m_arenas;
+
+	/**
+	 * \internal
+	 * Size of the block of one node: its semaphores_t plus both rings.
+	 */
+	static size_t GetNodeBlockSize(void);
+	static void MapArena(Arena &arena);
+	static semaphores_t *AttachNode(uint32_t nodeId);
+	static void DetachNode(uint32_t nodeId);
 
 //	static std::mutex controlWakeUpList;
 
@@ -297,7 +368,40 @@ private:
 	int m_evpipe[2]; // pipe used to signal events between threads
 	bool m_stop; // true means the read thread should stop
 	EventId m_destroyEvent;
+	/**
+	 * \internal
+	 * The clock of the last release, read back by the read thread
+	 */
+	uint64_t m_clock;
+	Callback<bool> m_pendingInput;
+	/**
+	 * \internal
+	 * Wake ups requested by contiki through the read thread since the last
+	 * release
+	 */
+	std::vector<uint64_t> m_timerWakeups;
+	/**
+	 * \internal
+	 * Releases handed to contiki and DONE records seen by the read thread,
+	 * the read thread rings m_doneBell on each of the latter
+	 */
+	uint32_t m_released;
+	uint32_t m_done;
+	ipc_doorbell_t m_doneBell;
+	/**
+	 * \internal
+	 * Read cursor of the read thread in the incoming ring, frames before it
+	 * may still be held by the simulator thread
+	 */
+	uint32_t m_cursor;
 	semaphores_t *sharedSemaphores;
+	/**
+	 * \internal
+	 * Bounds of the slots of the incoming ring, kept once the node is
+	 * stopped to tell the frames copied out of the ring from the others
+	 */
+	uint8_t *m_inSlots;
+	uint8_t *m_inSlotsEnd;
 
 };
 
@@ -0,0 +1,184 @@
+/*
+ * ipc-ring.h
+ *
+ * Single-producer/single-consumer record rings shared between ns-3 and a
+ * Contiki process.  This header is deliberately plain C so that the Contiki
+ * side of the bridge can include the very same definitions.
+ */
+
+#ifndef IPC_RING_H_
+#define IPC_RING_H_
+
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define IPC_CACHE_LINE 64
+
+/* Number of records per direction, must be a power of two */
+#define IPC_RING_SLOTS 32
+
+/* Largest frame a record can carry */
+#define IPC_RING_MTU 1500
+
+/* Record types */
+#define IPC_RECORD_DATA  0
+#define IPC_RECORD_TIMER 1
+#define IPC_RECORD_CLOCK 2
+#define IPC_RECORD_DONE  3
+
+/**
+ * \brief One entry of an IPC ring.
+ *
+ * DATA records carry a frame in data[0..len-1].  TIMER records carry the
+ * timer type in subtype and the interval (in milliseconds) in value.  CLOCK
+ * records carry the current simulation time (in milliseconds) in value and
+ * release contiki until that time.  DONE records are written by contiki
+ * once it has caught up with the last CLOCK record.
+ *
+ * retired is only used by the consumer, see ipc_ring_retire().
+ */
+typedef struct ipc_record_t {
+	uint8_t type;
+	uint8_t subtype;
+	uint16_t retired;
+	uint32_t len;
+	uint64_t value;
+	unsigned char data[IPC_RING_MTU];
+} ipc_record_t;
+
+/**
+ * \brief Lock-free single-producer/single-consumer ring.
+ *
+ * head is only written by the producer and tail only by the consumer; both
+ * live on their own cache line so that the two sides do not bounce the same
+ * line while streaming records.  Indices are free running and wrap with
+ * IPC_RING_SLOTS - 1.
+ */
+typedef struct ipc_ring_t {
+	volatile uint32_t head;
+	char pad_head[IPC_CACHE_LINE - sizeof(uint32_t)];
+	volatile uint32_t tail;
+	char pad_tail[IPC_CACHE_LINE - sizeof(uint32_t)];
+	ipc_record_t slots[IPC_RING_SLOTS];
+} ipc_ring_t;
+
+static inline void ipc_ring_init(ipc_ring_t *ring) {
+	memset(ring, 0, sizeof(ipc_ring_t));
+}
+
+static inline int ipc_ring_empty(ipc_ring_t *ring) {
+	return __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE)
+			== __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * Producer side: number of records that can still be reserved.
+ */
+static inline uint32_t ipc_ring_space(ipc_ring_t *ring) {
+	return IPC_RING_SLOTS
+			- (ring->head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE));
+}
+
+/**
+ * Producer side: returns the next free record or NULL when the ring is full.
+ * The record becomes visible to the consumer on ipc_ring_commit().
+ */
+static inline ipc_record_t *ipc_ring_reserve(ipc_ring_t *ring) {
+	uint32_t head = ring->head;
+	uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+	if (head - tail >= IPC_RING_SLOTS)
+		return NULL;
+	return &ring->slots[head & (IPC_RING_SLOTS - 1)];
+}
+
+static inline void ipc_ring_commit(ipc_ring_t *ring) {
+	ring->slots[ring->head & (IPC_RING_SLOTS - 1)].retired = 0;
+	__atomic_store_n(&ring->head, ring->head + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * Consumer side: returns the oldest record or NULL when the ring is empty.
+ * The slot stays owned by the consumer until ipc_ring_release().
+ */
+static inline ipc_record_t *ipc_ring_peek(ipc_ring_t *ring) {
+	uint32_t tail = ring->tail;
+	if (__atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) == tail)
+		return NULL;
+	return &ring->slots[tail & (IPC_RING_SLOTS - 1)];
+}
+
+static inline void ipc_ring_release(ipc_ring_t *ring) {
+	__atomic_store_n(&ring->tail, ring->tail + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * Consumer side, out of order release: returns the record at a private read
+ * cursor or NULL when the producer has not gone that far.  Records read this
+ * way stay owned by the consumer until ipc_ring_retire(), which may happen
+ * in any order and from any thread of the consuming process.  Do not mix
+ * with ipc_ring_release().
+ */
+static inline ipc_record_t *ipc_ring_peek_at(ipc_ring_t *ring,
+		uint32_t cursor) {
+	if (__atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) == cursor)
+		return NULL;
+	return &ring->slots[cursor & (IPC_RING_SLOTS - 1)];
+}
+
+/**
+ * Consumer side: hands a record read with ipc_ring_peek_at() back.  The
+ * tail only moves over the oldest records once they are all retired.
+ */
+static inline void ipc_ring_retire(ipc_ring_t *ring, ipc_record_t *rec) {
+	uint32_t tail;
+	__atomic_store_n(&rec->retired, 1, __ATOMIC_RELEASE);
+	tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+	while (tail != __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE)) {
+		ipc_record_t *oldest = &ring->slots[tail & (IPC_RING_SLOTS - 1)];
+		if (!__atomic_load_n(&oldest->retired, __ATOMIC_ACQUIRE))
+			break;
+		/* on failure another thread moved the tail, tail is reloaded */
+		if (__atomic_compare_exchange_n(&ring->tail, &tail, tail + 1, 0,
+				__ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+			tail++;
+	}
+}
+
+/**
+ * Consumer side: number of records read but not released yet.
+ */
+static inline uint32_t ipc_ring_held(ipc_ring_t *ring, uint32_t cursor) {
+	return cursor - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * Convenience producer for small records.  Returns 0 on success and -1 when
+ * the ring is full or the payload does not fit.
+ */
+static inline int ipc_ring_push(ipc_ring_t *ring, uint8_t type,
+		uint8_t subtype, uint64_t value, const void *data, uint32_t len) {
+	ipc_record_t *rec;
+	if (len > IPC_RING_MTU)
+		return -1;
+	rec = ipc_ring_reserve(ring);
+	if (rec == NULL)
+		return -1;
+	rec->type = type;
+	rec->subtype = subtype;
+	rec->len = len;
+	rec->value = value;
+	if (len > 0)
+		memcpy(rec->data, data, len);
+	ipc_ring_commit(ring);
+	return 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* IPC_RING_H_ */
@@ -0,0 +1,147 @@
+/*
+ * wakeup-wheel.cc
+ */
+
+#include "wakeup-wheel.h"
+
+#include "ns3/assert.h"
+
+#include <algorithm>
+
+namespace ns3 {
+
+WakeupWheel::WakeupWheel(uint32_t nBuckets, uint64_t granularity) :
+		m_mask(0), m_granularity(granularity), m_current(0), m_overflowMin(
+				~(uint64_t) 0), m_size(0), m_generation(1) {
+	NS_ASSERT(nBuckets > 0 && granularity > 0);
+	uint32_t size = 1;
+	while (size < nBuckets)
+		size <<= 1;
+	m_buckets.resize(size);
+	m_mask = size - 1;
+}
+
+uint64_t WakeupWheel::GetBucket(uint64_t ts) const {
+	return ts / m_granularity;
+}
+
+void WakeupWheel::Insert(uint64_t ts, uint32_t node) {
+	uint64_t bucket = GetBucket(ts);
+	// late wake ups are due right away
+	if (bucket < m_current)
+		bucket = m_current;
+
+	Entry entry;
+	entry.node = node;
+	entry.ts = ts;
+	if (bucket - m_current < m_buckets.size()) {
+		m_buckets[bucket & m_mask].push_back(entry);
+	} else {
+		m_overflow.push_back(entry);
+		if (ts < m_overflowMin)
+			m_overflowMin = ts;
+	}
+	m_size++;
+}
+
+void WakeupWheel::Collect(std::vector<Entry> &bucket, uint64_t until,
+		std::vector<Entry> &due) {
+	std::vector<Entry>::iterator kept = bucket.begin();
+	for (std::vector<Entry>::iterator it = bucket.begin(); it != bucket.end();
+			it++) {
+		if (it->ts > until) {
+			*kept++ = *it;
+			continue;
+		}
+		m_size--;
+
+		uint32_t node = it->node;
+		if (node >= m_stamp.size()) {
+			m_stamp.resize(node + 1, 0);
+			m_position.resize(node + 1, 0);
+		}
+		if (m_stamp[node] != m_generation) {
+			m_stamp[node] = m_generation;
+			m_position[node] = due.size();
+			due.push_back(*it);
+			continue;
+		}
+
+		// the node is already due, only its earliest time is returned
+		Entry &first = due[m_position[node]];
+		if (first.ts == it->ts)
+			continue;
+		if (it->ts < first.ts) {
+			m_later.push_back(first);
+			first = *it;
+		} else {
+			m_later.push_back(*it);
+		}
+	}
+	bucket.erase(kept, bucket.end());
+}
+
+void WakeupWheel::Refill(void) {
+	uint64_t end = m_current + m_buckets.size();
+	if (m_overflowMin == ~(uint64_t) 0 || GetBucket(m_overflowMin) >= end)
+		return;
+
+	m_overflowMin = ~(uint64_t) 0;
+	std::vector<Entry>::iterator kept = m_overflow.begin();
+	for (std::vector<Entry>::iterator it = m_overflow.begin();
+			it != m_overflow.end(); it++) {
+		uint64_t bucket = GetBucket(it->ts);
+		if (bucket < end) {
+			m_buckets[bucket & m_mask].push_back(*it);
+		} else {
+			if (it->ts < m_overflowMin)
+				m_overflowMin = it->ts;
+			*kept++ = *it;
+		}
+	}
+	m_overflow.erase(kept, m_overflow.end());
+}
+
+void WakeupWheel::Collect(uint64_t until, std::vector<Entry> &due) {
+	due.clear();
+	if (++m_generation == 0) {
+		std::fill(m_stamp.begin(), m_stamp.end(), 0);
+		m_generation = 1;
+	}
+
+	uint64_t last = GetBucket(until);
+	if (last < m_current)
+		last = m_current;
+
+	// a jump over the whole wheel visits every bucket once
+	uint64_t end = last + 1;
+	if (end - m_current > m_buckets.size())
+		end = m_current + m_buckets.size();
+	for (uint64_t bucket = m_current; bucket != end; bucket++)
+		Collect(m_buckets[bucket & m_mask], until, due);
+
+	if (m_overflowMin <= until) {
+		Collect(m_overflow, until, due);
+		m_overflowMin = ~(uint64_t) 0;
+		for (std::vector<Entry>::iterator it = m_overflow.begin();
+				it != m_overflow.end(); it++) {
+			if (it->ts < m_overflowMin)
+				m_overflowMin = it->ts;
+		}
+	}
+
+	m_current = last;
+	Refill();
+
+	// later wake ups of the due nodes end up in the current bucket
+	for (std::vector<Entry>::iterator it = m_later.begin(); it != m_later.end();
+			it++)
+		Insert(it->ts, it->node);
+	m_later.clear();
+}
+
+uint32_t WakeupWheel::GetSize(void) const {
+	return m_size;
+}
+
+} // namespace ns3
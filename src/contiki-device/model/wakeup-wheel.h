@@ -0,0 +1,91 @@
+/*
+ * wakeup-wheel.h
+ *
+ * Bucketed timing wheel indexing the times at which Contiki nodes have to be
+ * released by the clock handler.
+ */
+
+#ifndef WAKEUP_WHEEL_H_
+#define WAKEUP_WHEEL_H_
+
+#include <stdint.h>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \brief Timing wheel of node wake ups.
+ *
+ * Wake ups are kept in buckets one granule (a millisecond by default) wide,
+ * as flat vectors of (node, time) entries. The wheel spans a fixed number of
+ * buckets from the last collected time; wake ups further away go to an
+ * overflow vector and are moved into the wheel as it turns. Buckets and
+ * result vectors keep their capacity, so once warmed up neither inserting
+ * nor collecting allocates.
+ *
+ * The wheel is not thread safe, it is only meant to be used from the
+ * simulator thread.
+ */
+class WakeupWheel {
+public:
+	struct Entry {
+		uint32_t node;
+		uint64_t ts;
+	};
+
+	/**
+	 * \param nBuckets number of buckets, rounded up to a power of two
+	 * \param granularity width of a bucket in time steps
+	 */
+	WakeupWheel(uint32_t nBuckets = 1024, uint64_t granularity = 1000000);
+
+	/**
+	 * Registers a wake up of a node. Wake ups in the past are due on the
+	 * next Collect().
+	 *
+	 * \param ts the time of the wake up, in time steps
+	 * \param node the node to wake up
+	 */
+	void Insert(uint64_t ts, uint32_t node);
+
+	/**
+	 * Removes every wake up due up to the given time. A node woken up more
+	 * than once in that window is only returned once with its earliest time,
+	 * its later wake ups stay registered.
+	 *
+	 * \param until the time to collect up to, inclusive, in time steps
+	 * \param due cleared and filled with the due wake ups
+	 */
+	void Collect(uint64_t until, std::vector<Entry> &due);
+
+	/**
+	 * \returns the number of registered wake ups
+	 */
+	uint32_t GetSize(void) const;
+
+private:
+	uint64_t GetBucket(uint64_t ts) const;
+	void Collect(std::vector<Entry> &bucket, uint64_t until,
+			std::vector<Entry> &due);
+	void Refill(void);
+
+	std::vector<std::vector<Entry> > m_buckets;
+	uint64_t m_mask;
+	uint64_t m_granularity;
+	// bucket number of the last collected time, the wheel covers the
+	// buckets [m_current, m_current + m_buckets.size())
+	uint64_t m_current;
+	std::vector<Entry> m_overflow;
+	uint64_t m_overflowMin;
+	uint32_t m_size;
+	// position of each node in the due vector, valid when the node is
+	// stamped with the current generation
+	std::vector<uint32_t> m_position;
+	std::vector<uint32_t> m_stamp;
+	uint32_t m_generation;
+	std::vector<Entry> m_later;
+};
+
+} // namespace ns3
+
+#endif /* WAKEUP_WHEEL_H_ */
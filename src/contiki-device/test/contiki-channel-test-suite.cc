@@ -0,0 +1,307 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include <vector>
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/packet.h"
+#include "ns3/double.h"
+#include "ns3/boolean.h"
+#include "ns3/vector.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/constant-velocity-mobility-model.h"
+#include "ns3/propagation-loss-model.h"
+#include "ns3/propagation-delay-model.h"
+#include "ns3/contiki-channel.h"
+#include "ns3/contiki-phy.h"
+
+using namespace ns3;
+
+/**
+ * Counts the links evaluated by a channel
+ */
+class CountingLossModel : public PropagationLossModel
+{
+public:
+  CountingLossModel ()
+    : m_loss (CreateObject<LogDistancePropagationLossModel> ()),
+      m_count (0)
+  {
+  }
+  Ptr<PropagationLossModel> m_loss;
+  uint32_t m_count;
+
+private:
+  virtual double DoCalcRxPower (double txPowerDbm, Ptr<MobilityModel> a, Ptr<MobilityModel> b) const
+  {
+    const_cast<CountingLossModel *> (this)->m_count++;
+    return m_loss->CalcRxPower (txPowerDbm, a, b);
+  }
+  virtual int64_t DoAssignStreams (int64_t stream)
+  {
+    return 0;
+  }
+};
+
+// ===========================================================================
+// Test case to make sure that culling the receivers out of range leaves the
+// frames a channel delivers unchanged, for senders of different powers and
+// for moving PHYs.
+// ===========================================================================
+class ContikiChannelCullingTestCase : public TestCase
+{
+public:
+  ContikiChannelCullingTestCase (bool cacheLinks);
+
+private:
+  virtual void DoRun (void);
+  void Receive (Ptr<Packet> packet);
+  Ptr<ContikiChannel> CreateChannel (bool cull, std::vector<Ptr<ContikiPhy> > &phys,
+                                     Ptr<CountingLossModel> loss);
+  uint32_t Random (uint32_t max);
+
+  bool m_cacheLinks;
+  uint32_t m_seed;
+};
+
+ContikiChannelCullingTestCase::ContikiChannelCullingTestCase (bool cacheLinks)
+  : TestCase (cacheLinks ? "Check the culled receivers of a Contiki channel caching its links"
+              : "Check the culled receivers of a Contiki channel"),
+    m_cacheLinks (cacheLinks),
+    m_seed (1)
+{
+}
+
+uint32_t
+ContikiChannelCullingTestCase::Random (uint32_t max)
+{
+  m_seed = m_seed * 1103515245 + 12345;
+  return (m_seed >> 16) % max;
+}
+
+void
+ContikiChannelCullingTestCase::Receive (Ptr<Packet> packet)
+{
+}
+
+Ptr<ContikiChannel>
+ContikiChannelCullingTestCase::CreateChannel (bool cull, std::vector<Ptr<ContikiPhy> > &phys,
+                                              Ptr<CountingLossModel> loss)
+{
+  Ptr<ContikiChannel> channel = CreateObject<ContikiChannel> ();
+  channel->SetAttribute ("DeriveRange", BooleanValue (cull));
+  channel->SetAttribute ("CacheLinks", BooleanValue (m_cacheLinks));
+  channel->SetPropagationLossModel (loss);
+  channel->SetPropagationDelayModel (CreateObject<ConstantSpeedPropagationDelayModel> ());
+
+  // both channels get the same PHYs at the same places
+  m_seed = 1;
+  for (uint32_t i = 0; i < 40; i++)
+    {
+      Vector position (Random (600), Random (600), 0.0);
+      Ptr<MobilityModel> mobility;
+      if (i % 8 == 0)
+        {
+          Ptr<ConstantVelocityMobilityModel> moving = CreateObject<ConstantVelocityMobilityModel> ();
+          moving->SetPosition (position);
+          moving->SetVelocity (Vector (20.0, -10.0, 0.0));
+          mobility = moving;
+        }
+      else
+        {
+          mobility = CreateObject<ConstantPositionMobilityModel> ();
+          mobility->SetPosition (position);
+        }
+      Ptr<ContikiPhy> phy = CreateObject<ContikiPhy> ();
+      phy->SetMobility (mobility);
+      phy->SetMode (ContikiPhy::DSSS_O_QPSK_GHz);
+      phy->SetReceiveOkCallback (MakeCallback (&ContikiChannelCullingTestCase::Receive, this));
+      phy->SetChannel (channel);
+      phys.push_back (phy);
+    }
+  // the range is the one of the PHYs that hear the farthest
+  phys[3]->SetEdThreshold (-70);
+  return channel;
+}
+
+void
+ContikiChannelCullingTestCase::DoRun (void)
+{
+  std::vector<Ptr<ContikiPhy> > culledPhys;
+  std::vector<Ptr<ContikiPhy> > referencePhys;
+  Ptr<CountingLossModel> culledLoss = CreateObject<CountingLossModel> ();
+  Ptr<CountingLossModel> referenceLoss = CreateObject<CountingLossModel> ();
+  Ptr<ContikiChannel> culled = CreateChannel (true, culledPhys, culledLoss);
+  Ptr<ContikiChannel> reference = CreateChannel (false, referencePhys, referenceLoss);
+  Ptr<Packet> packet = Create<Packet> (20);
+
+  // from 20 m to more than the side of the area
+  double txPowers[] = { 0.0, 20.0, 40.0, 20.0 };
+  uint32_t delivered = 0;
+  uint32_t culledOut = 0;
+  for (uint32_t round = 0; round < 3; round++)
+    {
+      for (uint32_t s = 0; s < culledPhys.size (); s++)
+        {
+          double txPowerDbm = txPowers[(s + round) % 4];
+          culled->Send (culledPhys[s], packet, txPowerDbm);
+          reference->Send (referencePhys[s], packet, txPowerDbm);
+          for (uint32_t j = 0; j < culledPhys.size (); j++)
+            {
+              NS_TEST_ASSERT_MSG_EQ (culledPhys[j]->HasPendingRx (), referencePhys[j]->HasPendingRx (),
+                                     "PHY " << j << " culled differently from PHY " << s <<
+                                     " at " << txPowerDbm << "dBm");
+              delivered += referencePhys[j]->HasPendingRx () ? 1 : 0;
+              culledOut += referencePhys[j]->HasPendingRx () ? 0 : 1;
+            }
+          // the moving PHYs move on between the sends
+          Simulator::Stop (Seconds (0.5));
+          Simulator::Run ();
+        }
+    }
+  // some frames have to be delivered and some culled for the test to matter
+  NS_TEST_ASSERT_MSG_GT (delivered, 0, "no frame delivered");
+  NS_TEST_ASSERT_MSG_GT (culledOut, 0, "every frame delivered");
+  // probing the range included
+  NS_TEST_ASSERT_MSG_LT (culledLoss->m_count, referenceLoss->m_count, "no receiver culled");
+
+  culled->Dispose ();
+  reference->Dispose ();
+  Simulator::Destroy ();
+}
+
+// ===========================================================================
+// Test case to make sure that a fixed range culls the receivers beyond it,
+// even those that could hear the sender.
+// ===========================================================================
+class ContikiChannelMaxRangeTestCase : public TestCase
+{
+public:
+  ContikiChannelMaxRangeTestCase ();
+
+private:
+  virtual void DoRun (void);
+  void Receive (Ptr<Packet> packet);
+};
+
+ContikiChannelMaxRangeTestCase::ContikiChannelMaxRangeTestCase ()
+  : TestCase ("Check the fixed range of a Contiki channel")
+{
+}
+
+void
+ContikiChannelMaxRangeTestCase::Receive (Ptr<Packet> packet)
+{
+}
+
+void
+ContikiChannelMaxRangeTestCase::DoRun (void)
+{
+  Ptr<ContikiChannel> channel = CreateObject<ContikiChannel> ();
+  channel->SetAttribute ("MaxRange", DoubleValue (100.0));
+  channel->SetPropagationLossModel (CreateObject<LogDistancePropagationLossModel> ());
+  channel->SetPropagationDelayModel (CreateObject<ConstantSpeedPropagationDelayModel> ());
+
+  // a sender, a receiver close by and one far beyond the range, both of
+  // them able to hear the sender at 40 dBm
+  double xs[] = { 0.0, 50.0, 350.0 };
+  std::vector<Ptr<ContikiPhy> > phys;
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      Ptr<MobilityModel> mobility = CreateObject<ConstantPositionMobilityModel> ();
+      mobility->SetPosition (Vector (xs[i], 0.0, 0.0));
+      Ptr<ContikiPhy> phy = CreateObject<ContikiPhy> ();
+      phy->SetMobility (mobility);
+      phy->SetMode (ContikiPhy::DSSS_O_QPSK_GHz);
+      phy->SetReceiveOkCallback (MakeCallback (&ContikiChannelMaxRangeTestCase::Receive, this));
+      phy->SetChannel (channel);
+      phys.push_back (phy);
+    }
+
+  channel->Send (phys[0], Create<Packet> (20), 40.0);
+  NS_TEST_ASSERT_MSG_EQ (phys[1]->HasPendingRx (), true, "receiver in range culled");
+  NS_TEST_ASSERT_MSG_EQ (phys[2]->HasPendingRx (), false, "receiver out of range not culled");
+  Simulator::Run ();
+
+  channel->Dispose ();
+  Simulator::Destroy ();
+}
+
+// ===========================================================================
+// Test case to make sure that a channel lets go of the mobility models it
+// followed when it is disposed, those left without PHY included.
+// ===========================================================================
+class ContikiChannelDisposeTestCase : public TestCase
+{
+public:
+  ContikiChannelDisposeTestCase ();
+
+private:
+  virtual void DoRun (void);
+  void Receive (Ptr<Packet> packet);
+  Ptr<ContikiPhy> CreatePhy (Ptr<ContikiChannel> channel, Ptr<MobilityModel> mobility);
+};
+
+ContikiChannelDisposeTestCase::ContikiChannelDisposeTestCase ()
+  : TestCase ("Check the disposal of a Contiki channel after a PHY changed mobility model")
+{
+}
+
+void
+ContikiChannelDisposeTestCase::Receive (Ptr<Packet> packet)
+{
+}
+
+Ptr<ContikiPhy>
+ContikiChannelDisposeTestCase::CreatePhy (Ptr<ContikiChannel> channel, Ptr<MobilityModel> mobility)
+{
+  Ptr<ContikiPhy> phy = CreateObject<ContikiPhy> ();
+  phy->SetMobility (mobility);
+  phy->SetMode (ContikiPhy::DSSS_O_QPSK_GHz);
+  phy->SetReceiveOkCallback (MakeCallback (&ContikiChannelDisposeTestCase::Receive, this));
+  phy->SetChannel (channel);
+  return phy;
+}
+
+void
+ContikiChannelDisposeTestCase::DoRun (void)
+{
+  Ptr<ContikiChannel> channel = CreateObject<ContikiChannel> ();
+  channel->SetPropagationLossModel (CreateObject<LogDistancePropagationLossModel> ());
+  channel->SetPropagationDelayModel (CreateObject<ConstantSpeedPropagationDelayModel> ());
+  Ptr<ConstantVelocityMobilityModel> old = CreateObject<ConstantVelocityMobilityModel> ();
+  Ptr<ContikiPhy> a = CreatePhy (channel, old);
+  Ptr<ContikiPhy> b = CreatePhy (channel, CreateObject<ConstantPositionMobilityModel> ());
+  channel->Send (a, Create<Packet> (20), 0.0);
+  NS_TEST_ASSERT_MSG_EQ (b->HasPendingRx (), true, "frame not sent");
+  Simulator::Run ();
+
+  // the old model is still followed, without PHY once the index is rebuilt
+  a->SetMobility (CreateObject<ConstantPositionMobilityModel> ());
+  Ptr<ContikiPhy> c = CreatePhy (channel, CreateObject<ConstantPositionMobilityModel> ());
+  channel->Send (a, Create<Packet> (20), 0.0);
+  NS_TEST_ASSERT_MSG_EQ (c->HasPendingRx (), true, "frame not sent to the new PHY");
+  Simulator::Run ();
+
+  channel->Dispose ();
+  // no longer followed
+  old->SetVelocity (Vector (1.0, 0.0, 0.0));
+  Simulator::Destroy ();
+}
+
+class ContikiChannelTestSuite : public TestSuite
+{
+public:
+  ContikiChannelTestSuite ();
+};
+
+ContikiChannelTestSuite::ContikiChannelTestSuite ()
+  : TestSuite ("contiki-channel", UNIT)
+{
+  AddTestCase (new ContikiChannelCullingTestCase (false));
+  AddTestCase (new ContikiChannelCullingTestCase (true));
+  AddTestCase (new ContikiChannelMaxRangeTestCase);
+  AddTestCase (new ContikiChannelDisposeTestCase);
+}
+
+static ContikiChannelTestSuite contikiChannelTestSuite;
@@ -0,0 +1,187 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include <cmath>
+
+#include "ns3/test.h"
+#include "ns3/contiki-interference-helper.h"
+
+using namespace ns3;
+
+// ===========================================================================
+// Test case to make sure that the power on the air follows the signals as
+// they come and go.
+// ===========================================================================
+class ContikiInterferenceEnergyTestCase : public TestCase
+{
+public:
+  ContikiInterferenceEnergyTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+ContikiInterferenceEnergyTestCase::ContikiInterferenceEnergyTestCase ()
+  : TestCase ("Check the power on the air of the Contiki interference helper")
+{
+}
+
+void
+ContikiInterferenceEnergyTestCase::DoRun (void)
+{
+  ContikiInterferenceHelper helper;
+  NS_TEST_ASSERT_MSG_EQ (helper.GetEnergyW (), 0.0, "power on a silent channel");
+
+  // added in any order, they expire by end time
+  helper.Advance (0);
+  helper.AddSignal (300, 4e-9);
+  helper.AddSignal (100, 1e-9);
+  helper.AddSignal (200, 2e-9);
+  NS_TEST_ASSERT_MSG_EQ_TOL (helper.GetEnergyW (), 7e-9, 1e-21, "wrong power of three signals");
+
+  helper.Advance (99);
+  NS_TEST_ASSERT_MSG_EQ_TOL (helper.GetEnergyW (), 7e-9, 1e-21, "signal expired early");
+  helper.Advance (100);
+  NS_TEST_ASSERT_MSG_EQ_TOL (helper.GetEnergyW (), 6e-9, 1e-21, "signal did not expire at its end");
+
+  helper.AddSignal (250, 8e-9);
+  helper.Advance (260);
+  NS_TEST_ASSERT_MSG_EQ_TOL (helper.GetEnergyW (), 4e-9, 1e-21, "wrong power after two ends");
+  helper.Advance (1000);
+  NS_TEST_ASSERT_MSG_EQ (helper.GetEnergyW (), 0.0, "power left on a silent channel");
+}
+
+// ===========================================================================
+// Test case to make sure that the success rate of a frame accounts for each
+// chunk of constant SINR, and for those only.
+// ===========================================================================
+class ContikiInterferenceChunkTestCase : public TestCase
+{
+public:
+  ContikiInterferenceChunkTestCase ();
+
+private:
+  virtual void DoRun (void);
+  static double GetBer (double sinr);
+};
+
+ContikiInterferenceChunkTestCase::ContikiInterferenceChunkTestCase ()
+  : TestCase ("Check the success rate of a frame with interference")
+{
+}
+
+double
+ContikiInterferenceChunkTestCase::GetBer (double sinr)
+{
+  // decreasing, and far from 0 to keep the success rates measurable
+  return 0.01 / (1.0 + sinr);
+}
+
+void
+ContikiInterferenceChunkTestCase::DoRun (void)
+{
+  ContikiErrorRateTable table (&ContikiInterferenceChunkTestCase::GetBer);
+  double rxW = 1e-9;
+  double noiseW = 1e-10;
+  double interferenceW = 5e-10;
+  double bitsPerStep = 0.01;
+
+  // the frame from 0 to 1000, interfered with from 400 to 700 by a signal
+  // that started before the frame
+  ContikiInterferenceHelper helper;
+  helper.Advance (0);
+  helper.AddSignal (700, interferenceW);
+  helper.Advance (400);
+  helper.AddSignal (1000, rxW);
+  NS_TEST_ASSERT_MSG_EQ (helper.IsReceiving (), false, "receiving before StartRx");
+  helper.StartRx (rxW, noiseW, &table, bitsPerStep);
+  NS_TEST_ASSERT_MSG_EQ (helper.IsReceiving (), true, "not receiving after StartRx");
+  NS_TEST_ASSERT_MSG_EQ (helper.GetRxPowerW (), rxW, "wrong power of the frame");
+
+  // a signal after the frame was synced to is interference as well
+  helper.Advance (800);
+  helper.AddSignal (900, interferenceW);
+  helper.Advance (1000);
+
+  double expected = table.GetLogSuccessRate (rxW / (noiseW + interferenceW)) * 300 * bitsPerStep
+    + table.GetLogSuccessRate (rxW / noiseW) * 100 * bitsPerStep
+    + table.GetLogSuccessRate (rxW / (noiseW + interferenceW)) * 100 * bitsPerStep
+    + table.GetLogSuccessRate (rxW / noiseW) * 100 * bitsPerStep;
+  NS_TEST_ASSERT_MSG_EQ_TOL (helper.GetRxSuccessRate (), std::exp (expected), 1e-12,
+                             "wrong success rate of an interfered frame");
+  NS_TEST_ASSERT_MSG_EQ ((helper.GetRxSuccessRate () < std::exp (table.GetLogSuccessRate (rxW / noiseW) * 600 * bitsPerStep)),
+                         true, "interference did not lower the success rate");
+
+  // nothing is accounted for outside of a reception
+  helper.EndRx ();
+  double rate = helper.GetRxSuccessRate ();
+  helper.AddSignal (1500, interferenceW);
+  helper.Advance (1500);
+  NS_TEST_ASSERT_MSG_EQ (helper.GetRxSuccessRate (), rate, "accounted for a chunk out of a reception");
+
+  // a new reception starts from scratch
+  helper.AddSignal (1600, rxW);
+  helper.StartRx (rxW, noiseW, &table, bitsPerStep);
+  helper.Advance (1600);
+  NS_TEST_ASSERT_MSG_EQ_TOL (helper.GetRxSuccessRate (),
+                             std::exp (table.GetLogSuccessRate (rxW / noiseW) * 100 * bitsPerStep), 1e-12,
+                             "wrong success rate of a clear frame");
+}
+
+// ===========================================================================
+// Test case to make sure that the bit error rates of the modulations fall
+// with the SINR, as a receiver would expect.
+// ===========================================================================
+class ContikiErrorRateTableTestCase : public TestCase
+{
+public:
+  ContikiErrorRateTableTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+ContikiErrorRateTableTestCase::ContikiErrorRateTableTestCase ()
+  : TestCase ("Check the error rate tables of the Contiki PHYs")
+{
+}
+
+void
+ContikiErrorRateTableTestCase::DoRun (void)
+{
+  ContikiErrorRateTable::BerFunction bers[] = {
+    &ContikiErrorRateTable::GetOqpskBer,
+    &ContikiErrorRateTable::GetBpskBer,
+    &ContikiErrorRateTable::GetAskBer
+  };
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      ContikiErrorRateTable table (bers[i]);
+      double previous = table.GetLogSuccessRate (0.0);
+      NS_TEST_ASSERT_MSG_EQ ((previous <= 0.0), true, "success rate above 1");
+      for (double db = -20.0; db <= 20.0; db += 0.5)
+        {
+          double rate = table.GetLogSuccessRate (std::pow (10.0, db / 10.0));
+          NS_TEST_ASSERT_MSG_EQ ((rate >= previous), true, "success rate falls at " << db << "dB");
+          previous = rate;
+        }
+      // a 127 bytes frame at 15 dB goes through
+      NS_TEST_ASSERT_MSG_EQ ((std::exp (table.GetLogSuccessRate (std::pow (10.0, 1.5)) * 127 * 8) > 0.99), true,
+                             "frame lost at 15 dB");
+    }
+}
+
+class ContikiInterferenceHelperTestSuite : public TestSuite
+{
+public:
+  ContikiInterferenceHelperTestSuite ();
+};
+
+ContikiInterferenceHelperTestSuite::ContikiInterferenceHelperTestSuite ()
+  : TestSuite ("contiki-interference-helper", UNIT)
+{
+  AddTestCase (new ContikiInterferenceEnergyTestCase);
+  AddTestCase (new ContikiInterferenceChunkTestCase);
+  AddTestCase (new ContikiErrorRateTableTestCase);
+}
+
+static ContikiInterferenceHelperTestSuite contikiInterferenceHelperTestSuite;
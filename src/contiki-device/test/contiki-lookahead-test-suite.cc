@@ -0,0 +1,178 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/nstime.h"
+#include "ns3/ipc-reader.h"
+#include "ns3/contiki-device.h"
+
+using namespace ns3;
+
+namespace {
+
+void
+Discard (unsigned char *buf, ssize_t len)
+{
+}
+
+} // anonymous namespace
+
+// ===========================================================================
+// Test case to make sure that the clock handler releases the nodes due
+// within the lookahead ahead of time, unless frames are on their way to
+// them or they still run, and only waits for the nodes whose clock the
+// simulator reached.  The test plays the part of the contiki processes:
+// it reads the clock updates and writes the DONE records.  A node waited
+// for without its DONE record hangs the test.
+// ===========================================================================
+class ContikiLookaheadTestCase : public TestCase
+{
+public:
+  ContikiLookaheadTestCase ();
+
+private:
+  virtual void DoRun (void);
+  bool HasPendingInput (uint32_t node);
+  // contiki is done with its last clock update
+  void Done (uint32_t node);
+  // the clock update to the node in ms, -1 if none
+  int64_t TakeClock (uint32_t node);
+  void Step (Time now);
+
+  Ptr<IpcReader> m_readers[4];
+  semaphores_t *m_blocks[4];
+  bool m_pending[4];
+  // a time step, Time members outlive the time marking
+  uint64_t m_now;
+};
+
+// the nodes
+static const uint32_t A = 0;
+static const uint32_t B = 1;
+static const uint32_t C = 2;
+static const uint32_t D = 3;
+
+ContikiLookaheadTestCase::ContikiLookaheadTestCase ()
+  : TestCase ("Check the releases of the Contiki nodes within the lookahead")
+{
+}
+
+bool
+ContikiLookaheadTestCase::HasPendingInput (uint32_t node)
+{
+  return m_pending[node];
+}
+
+void
+ContikiLookaheadTestCase::Done (uint32_t node)
+{
+  ipc_ring_push (ipc_ring_in (m_blocks[node]), IPC_RECORD_DONE, 0, 0, 0, 0);
+  ipc_doorbell_ring (&m_blocks[node]->bell_in);
+}
+
+int64_t
+ContikiLookaheadTestCase::TakeClock (uint32_t node)
+{
+  ipc_ring_t *ring = ipc_ring_out (m_blocks[node]);
+  ipc_record_t *rec = ipc_ring_peek (ring);
+  if (rec == 0 || rec->type != IPC_RECORD_CLOCK)
+    {
+      return -1;
+    }
+  int64_t clock = rec->value;
+  ipc_ring_release (ring);
+  return clock;
+}
+
+void
+ContikiLookaheadTestCase::Step (Time now)
+{
+  ContikiNetDevice::ContikiClockHandle (m_now, now.GetTimeStep ());
+  m_now = now.GetTimeStep ();
+}
+
+void
+ContikiLookaheadTestCase::DoRun (void)
+{
+  ContikiNetDevice::SetLookahead (MilliSeconds (5));
+  m_now = 0;
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      m_readers[i] = Create<IpcReader> ();
+      m_blocks[i] = m_readers[i]->Start (MakeCallback (&Discard), i, 0);
+      m_readers[i]->SetPendingInputCallback (MakeCallback (&ContikiLookaheadTestCase::HasPendingInput, this)
+                                             .Bind (i));
+      m_pending[i] = false;
+    }
+
+  // the nodes boot at 0
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      Done (i);
+    }
+  Step (Seconds (0));
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (TakeClock (i), 0, "node " << i << " not booted");
+    }
+
+  // within the window [10 ms, 15 ms): A is due now, B ahead of time, D
+  // has a frame on its way and has to wait for it, C lies past the window
+  m_readers[A]->setSchedule (MilliSeconds (10), A);
+  m_readers[B]->setSchedule (MilliSeconds (12), B);
+  m_readers[C]->setSchedule (MilliSeconds (16), C);
+  m_readers[D]->setSchedule (MilliSeconds (13), D);
+  m_pending[D] = true;
+  Done (A);
+  Step (MilliSeconds (10));
+  NS_TEST_ASSERT_MSG_EQ (TakeClock (A), 10, "node due now not released");
+  NS_TEST_ASSERT_MSG_EQ (TakeClock (B), 12, "node within the lookahead not released ahead");
+  NS_TEST_ASSERT_MSG_EQ (TakeClock (C), -1, "node past the lookahead released");
+  NS_TEST_ASSERT_MSG_EQ (TakeClock (D), -1, "node with pending input released ahead");
+
+  // B is only waited for now, C comes into the window
+  Done (B);
+  Step (MilliSeconds (12));
+  NS_TEST_ASSERT_MSG_EQ (TakeClock (C), 16, "node within the lookahead not released ahead");
+  NS_TEST_ASSERT_MSG_EQ (TakeClock (D), -1, "node with pending input released ahead");
+  NS_TEST_ASSERT_MSG_EQ (TakeClock (B), -1, "node released twice");
+
+  // D got its frame and is due now, C asked for a wake up while it still
+  // runs for 16 ms and has to wait for it
+  m_readers[C]->setSchedule (MilliSeconds (17), C);
+  m_pending[D] = false;
+  Done (D);
+  Step (MilliSeconds (13));
+  NS_TEST_ASSERT_MSG_EQ (TakeClock (D), 13, "node due now not released");
+  NS_TEST_ASSERT_MSG_EQ (TakeClock (C), -1, "running node released again");
+
+  Done (C);
+  Step (MilliSeconds (16));
+  NS_TEST_ASSERT_MSG_EQ (TakeClock (C), 17, "node done not released for its next wake up");
+  Done (C);
+  Step (MilliSeconds (17));
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (TakeClock (i), -1, "node " << i << " released past its wake ups");
+    }
+
+  ContikiNetDevice::SetLookahead (Seconds (0));
+  // drops the wake ups left, if any
+  std::vector<WakeupWheel::Entry> due;
+  IpcReader::getReleaseSchedule (Seconds (1), due);
+  Simulator::Destroy ();
+}
+
+class ContikiLookaheadTestSuite : public TestSuite
+{
+public:
+  ContikiLookaheadTestSuite ();
+};
+
+ContikiLookaheadTestSuite::ContikiLookaheadTestSuite ()
+  : TestSuite ("contiki-lookahead", UNIT)
+{
+  AddTestCase (new ContikiLookaheadTestCase);
+}
+
+static ContikiLookaheadTestSuite contikiLookaheadTestSuite;
@@ -0,0 +1,104 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include <errno.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/ipc-reader.h"
+#include "ns3/contiki-mote-spawner.h"
+
+using namespace ns3;
+
+namespace {
+
+void
+Discard (unsigned char *buf, ssize_t len)
+{
+}
+
+// true if pid is a child of the calling process
+bool
+IsChild (pid_t pid)
+{
+  return waitpid (pid, NULL, WNOHANG) != -1 || errno != ECHILD;
+}
+
+} // anonymous namespace
+
+// ===========================================================================
+// Test case to make sure that the zygote starts and stops on demand, that
+// it forks the motes itself rather than the simulator, and that the first
+// spawn has it stopped along with the simulator.  What the motes run is
+// up to contiki, they are killed right away.
+// ===========================================================================
+class ContikiMoteSpawnerTestCase : public TestCase
+{
+public:
+  ContikiMoteSpawnerTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+ContikiMoteSpawnerTestCase::ContikiMoteSpawnerTestCase ()
+  : TestCase ("Check the life cycle of the zygote and the motes it spawns")
+{
+}
+
+void
+ContikiMoteSpawnerTestCase::DoRun (void)
+{
+  NS_TEST_ASSERT_MSG_EQ (ContikiMoteSpawner::IsRunning (), false, "zygote running before its start");
+  ContikiMoteSpawner::Start ();
+  NS_TEST_ASSERT_MSG_EQ (ContikiMoteSpawner::IsRunning (), true, "zygote not started");
+  // does nothing the second time
+  ContikiMoteSpawner::Start ();
+  ContikiMoteSpawner::Stop ();
+  NS_TEST_ASSERT_MSG_EQ (ContikiMoteSpawner::IsRunning (), false, "zygote not stopped");
+  ContikiMoteSpawner::Stop ();
+
+  Ptr<IpcReader> reader = Create<IpcReader> ();
+  reader->Start (MakeCallback (&Discard), 0, 0);
+  size_t size;
+  uint64_t offset;
+  int fd = reader->GetArenaFd (&size, &offset);
+
+  // the first spawn starts the zygote again
+  pid_t motes[2];
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      motes[i] = ContikiMoteSpawner::Spawn (0, 0, "0.0.0.0.0.0.0.1", "test", fd, size, offset);
+    }
+  bool running = ContikiMoteSpawner::IsRunning ();
+  bool children = IsChild (motes[0]) || IsChild (motes[1]);
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      kill (motes[i], SIGKILL);
+    }
+  NS_TEST_ASSERT_MSG_EQ (running, true, "zygote not started by a spawn");
+  NS_TEST_ASSERT_MSG_EQ ((motes[0] > 0 && motes[1] > 0), true, "no mote spawned");
+  NS_TEST_ASSERT_MSG_NE (motes[0], motes[1], "both spawns returned the same mote");
+  NS_TEST_ASSERT_MSG_EQ (children, false, "motes forked by the simulator");
+
+  Simulator::Destroy ();
+  NS_TEST_ASSERT_MSG_EQ (ContikiMoteSpawner::IsRunning (), false, "zygote not stopped with the simulator");
+  std::vector<WakeupWheel::Entry> due;
+  IpcReader::getReleaseSchedule (Seconds (1), due);
+}
+
+class ContikiMoteSpawnerTestSuite : public TestSuite
+{
+public:
+  ContikiMoteSpawnerTestSuite ();
+};
+
+ContikiMoteSpawnerTestSuite::ContikiMoteSpawnerTestSuite ()
+  : TestSuite ("contiki-mote-spawner", UNIT)
+{
+  AddTestCase (new ContikiMoteSpawnerTestCase);
+}
+
+static ContikiMoteSpawnerTestSuite contikiMoteSpawnerTestSuite;
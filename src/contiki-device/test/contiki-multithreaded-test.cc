@@ -0,0 +1,163 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include <sstream>
+#include <vector>
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/default-simulator-impl.h"
+#include "ns3/multithreaded-simulator-impl.h"
+#include "ns3/uinteger.h"
+#include "ns3/node.h"
+#include "ns3/packet.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/propagation-loss-model.h"
+#include "ns3/propagation-delay-model.h"
+#include "ns3/contiki-channel.h"
+#include "ns3/contiki-device.h"
+#include "ns3/contiki-mac.h"
+#include "ns3/contiki-phy.h"
+
+using namespace ns3;
+
+// ===========================================================================
+// Test case to make sure that the motes of a radio channel stay in one
+// partition of the multithreaded simulator, and see the frames they would
+// see with the default simulator.
+// ===========================================================================
+class ContikiMultithreadedTestCase : public TestCase
+{
+public:
+  ContikiMultithreadedTestCase ();
+
+private:
+  virtual void DoRun (void);
+  std::vector<std::string> RunChannels (Ptr<SimulatorImpl> impl);
+  void Send (Ptr<ContikiPhy> phy, uint8_t origin, uint32_t n);
+  void Receive (uint32_t node, Ptr<Packet> packet);
+
+  // only written by the partition of the node
+  std::vector<std::ostringstream *> m_traces;
+  std::vector<uint32_t> m_systemIds;
+};
+
+// motes on every channel
+static const uint32_t N_MOTES = 3;
+static const uint32_t N_CHANNELS = 2;
+
+ContikiMultithreadedTestCase::ContikiMultithreadedTestCase ()
+  : TestCase ("Check the frames of the Contiki motes of two channels against the default simulator")
+{
+}
+
+void
+ContikiMultithreadedTestCase::Send (Ptr<ContikiPhy> phy, uint8_t origin, uint32_t n)
+{
+  uint8_t data[1] = { origin };
+  Ptr<Packet> packet = Create<Packet> (data, 1);
+  packet->AddPaddingAtEnd (20 + n);
+  phy->SendPacket (packet);
+  if (n > 0)
+    {
+      // the frames of the motes of a channel do not overlap
+      Simulator::Schedule (MilliSeconds (10), &ContikiMultithreadedTestCase::Send, this, phy, origin, n - 1);
+    }
+}
+
+void
+ContikiMultithreadedTestCase::Receive (uint32_t node, Ptr<Packet> packet)
+{
+  uint8_t data[1];
+  packet->CopyData (data, 1);
+  *m_traces[node] << Simulator::Now ().GetTimeStep () << " rx from " << (uint32_t) data[0] <<
+    " size " << packet->GetSize () << " context " << Simulator::GetContext () << std::endl;
+  m_systemIds[node] = Simulator::GetSystemId ();
+}
+
+std::vector<std::string>
+ContikiMultithreadedTestCase::RunChannels (Ptr<SimulatorImpl> impl)
+{
+  Simulator::SetImplementation (impl);
+
+  for (uint32_t c = 0; c < N_CHANNELS; c++)
+    {
+      Ptr<ContikiChannel> channel = CreateObject<ContikiChannel> ();
+      channel->SetPropagationLossModel (CreateObject<LogDistancePropagationLossModel> ());
+      channel->SetPropagationDelayModel (CreateObject<ConstantSpeedPropagationDelayModel> ());
+      for (uint32_t i = 0; i < N_MOTES; i++)
+        {
+          Ptr<Node> node = CreateObject<Node> ();
+          m_traces.push_back (new std::ostringstream ());
+          m_systemIds.push_back (0);
+
+          Ptr<ContikiNetDevice> device = CreateObject<ContikiNetDevice> ();
+          // the motes are never started: the simulation stops before
+          device->Start (Seconds (10));
+          device->SetMac (CreateObject<ContikiMac> ());
+          node->AddDevice (device);
+
+          Ptr<MobilityModel> mobility = CreateObject<ConstantPositionMobilityModel> ();
+          mobility->SetPosition (Vector (5.0 * i, 0.0, 0.0));
+          Ptr<ContikiPhy> phy = CreateObject<ContikiPhy> ();
+          phy->SetMobility (mobility);
+          phy->SetMode (ContikiPhy::DSSS_O_QPSK_GHz);
+          phy->SetDevice (device);
+          phy->SetReceiveOkCallback (MakeCallback (&ContikiMultithreadedTestCase::Receive, this)
+                                     .Bind (node->GetId ()));
+          phy->SetChannel (channel);
+          device->SetPhy (phy);
+
+          Simulator::ScheduleWithContext (node->GetId (), MilliSeconds (1 + 3 * i),
+                                          &ContikiMultithreadedTestCase::Send, this, phy,
+                                          (uint8_t) node->GetId (), 20);
+        }
+    }
+  Simulator::Stop (Seconds (1));
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  std::vector<std::string> traces;
+  for (uint32_t i = 0; i < m_traces.size (); i++)
+    {
+      traces.push_back (m_traces[i]->str ());
+      delete m_traces[i];
+    }
+  m_traces.clear ();
+  return traces;
+}
+
+void
+ContikiMultithreadedTestCase::DoRun (void)
+{
+  std::vector<std::string> reference = RunChannels (CreateObject<DefaultSimulatorImpl> ());
+  m_systemIds.clear ();
+
+  Ptr<MultithreadedSimulatorImpl> impl = CreateObject<MultithreadedSimulatorImpl> ();
+  impl->SetAttribute ("PartitionCount", UintegerValue (N_CHANNELS));
+  std::vector<std::string> traces = RunChannels (impl);
+
+  NS_TEST_EXPECT_MSG_EQ (impl->GetPartitionCount (), N_CHANNELS, "the channels are not in partitions of their own");
+  NS_TEST_ASSERT_MSG_EQ (traces.size (), reference.size (), "wrong number of motes");
+  for (uint32_t i = 0; i < traces.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_NE (reference[i].size (), 0, "nothing received by mote " << i);
+      NS_TEST_EXPECT_MSG_EQ (traces[i], reference[i], "different frames received by mote " << i);
+      // the motes of a channel share its partition
+      NS_TEST_EXPECT_MSG_EQ (m_systemIds[i], m_systemIds[i - i % N_MOTES], "mote " << i << " split from its channel");
+    }
+  NS_TEST_EXPECT_MSG_NE (m_systemIds[0], m_systemIds[N_MOTES], "both channels in one partition");
+}
+
+class ContikiMultithreadedTestSuite : public TestSuite
+{
+public:
+  ContikiMultithreadedTestSuite ();
+};
+
+ContikiMultithreadedTestSuite::ContikiMultithreadedTestSuite ()
+  : TestSuite ("contiki-multithreaded-simulator", SYSTEM)
+{
+  AddTestCase (new ContikiMultithreadedTestCase);
+}
+
+static ContikiMultithreadedTestSuite contikiMultithreadedTestSuite;
@@ -0,0 +1,243 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include <unistd.h>
+
+#include "ns3/test.h"
+#include "ns3/system-thread.h"
+#include "ns3/ipc-doorbell.h"
+
+using namespace ns3;
+
+// the longest a test waits for a thread before it gives up on it
+static const uint32_t TIMEOUT_MS = 10000;
+
+// wakes up the waiters of a bell whose ring was lost, so that the test can
+// report it instead of hanging
+static void
+ForceWake (ipc_doorbell_t *bell)
+{
+  syscall (SYS_futex, &bell->seq, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
+
+// ===========================================================================
+// Test case to make sure that a wait returns at once when the bell has been
+// rung since the sample, without announcing a waiter.
+// ===========================================================================
+class IpcDoorbellRingThenWaitTestCase : public TestCase
+{
+public:
+  IpcDoorbellRingThenWaitTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+IpcDoorbellRingThenWaitTestCase::IpcDoorbellRingThenWaitTestCase ()
+  : TestCase ("Check that a doorbell rung before the wait does not block")
+{
+}
+
+void
+IpcDoorbellRingThenWaitTestCase::DoRun (void)
+{
+  ipc_doorbell_t bell;
+  ipc_doorbell_init (&bell);
+
+  uint32_t sample = ipc_doorbell_sample (&bell);
+  ipc_doorbell_ring (&bell);
+  ipc_doorbell_wait (&bell, sample);
+  NS_TEST_ASSERT_MSG_EQ (bell.seq, sample + 1, "ring not counted");
+  NS_TEST_ASSERT_MSG_EQ (bell.waiters, 0, "waiter left behind");
+
+  // an old sample is as good: the bell moved past it
+  ipc_doorbell_ring (&bell);
+  ipc_doorbell_wait (&bell, sample);
+  NS_TEST_ASSERT_MSG_EQ (bell.seq, sample + 2, "ring not counted");
+  NS_TEST_ASSERT_MSG_EQ (bell.waiters, 0, "waiter left behind");
+}
+
+// ===========================================================================
+// Test case to make sure that a waiter that stopped spinning sleeps on the
+// futex until the bell is rung, and is then woken up.
+// ===========================================================================
+class IpcDoorbellSpinThenBlockTestCase : public TestCase
+{
+public:
+  IpcDoorbellSpinThenBlockTestCase ();
+
+private:
+  virtual void DoRun (void);
+  void Wait (void);
+
+  ipc_doorbell_t m_bell;
+  uint32_t m_sample;
+  volatile uint32_t m_woken;
+};
+
+IpcDoorbellSpinThenBlockTestCase::IpcDoorbellSpinThenBlockTestCase ()
+  : TestCase ("Check that a doorbell wakes up a waiter asleep on it")
+{
+}
+
+void
+IpcDoorbellSpinThenBlockTestCase::Wait (void)
+{
+  ipc_doorbell_wait (&m_bell, m_sample);
+  __atomic_store_n (&m_woken, 1, __ATOMIC_SEQ_CST);
+}
+
+void
+IpcDoorbellSpinThenBlockTestCase::DoRun (void)
+{
+  ipc_doorbell_init (&m_bell);
+  m_sample = ipc_doorbell_sample (&m_bell);
+  m_woken = 0;
+
+  Ptr<SystemThread> waiter = Create<SystemThread> (MakeCallback (&IpcDoorbellSpinThenBlockTestCase::Wait, this));
+  waiter->Start ();
+
+  // the waiter only announces itself once it is done spinning
+  uint32_t ms = 0;
+  while (__atomic_load_n (&m_bell.waiters, __ATOMIC_SEQ_CST) == 0 && ms < TIMEOUT_MS)
+    {
+      usleep (1000);
+      ms++;
+    }
+  bool blocked = (__atomic_load_n (&m_bell.waiters, __ATOMIC_SEQ_CST) == 1);
+  // still asleep a while later
+  usleep (50000);
+  uint32_t early = __atomic_load_n (&m_woken, __ATOMIC_SEQ_CST);
+
+  ipc_doorbell_ring (&m_bell);
+  ms = 0;
+  while (__atomic_load_n (&m_woken, __ATOMIC_SEQ_CST) == 0 && ms < TIMEOUT_MS)
+    {
+      usleep (1000);
+      ms++;
+    }
+  bool woken = (__atomic_load_n (&m_woken, __ATOMIC_SEQ_CST) == 1);
+  if (!woken)
+    {
+      ForceWake (&m_bell);
+    }
+  waiter->Join ();
+
+  NS_TEST_ASSERT_MSG_EQ (blocked, true, "the waiter never went to sleep");
+  NS_TEST_ASSERT_MSG_EQ (early, 0, "the waiter returned before the ring");
+  NS_TEST_ASSERT_MSG_EQ (woken, true, "the waiter was not woken up");
+  NS_TEST_ASSERT_MSG_EQ (m_bell.waiters, 0, "waiter left behind");
+}
+
+// ===========================================================================
+// Test case to make sure that no ring is lost when it races with a peer
+// going to sleep: two threads play ping-pong through a pair of doorbells,
+// each one only going on once the other rang, so that a single lost wake-up
+// stalls them for good.  The test thread watches their progress and rings
+// them loose if they stall.
+// ===========================================================================
+class IpcDoorbellRaceTestCase : public TestCase
+{
+public:
+  IpcDoorbellRaceTestCase ();
+
+private:
+  virtual void DoRun (void);
+  void Play (uint32_t player);
+
+  ipc_doorbell_t m_bells[2];
+  // even when it is the turn of player 0, odd for player 1
+  volatile uint32_t m_ball;
+  volatile uint32_t m_stalled;
+};
+
+// exchanges of the ball
+static const uint32_t N_ROUNDS = 20000;
+
+IpcDoorbellRaceTestCase::IpcDoorbellRaceTestCase ()
+  : TestCase ("Check that a doorbell never loses a ring racing with a wait")
+{
+}
+
+void
+IpcDoorbellRaceTestCase::Play (uint32_t player)
+{
+  ipc_doorbell_t *in = &m_bells[player];
+  ipc_doorbell_t *out = &m_bells[1 - player];
+  for (uint32_t turn = player; turn < 2 * N_ROUNDS; turn += 2)
+    {
+      for (;;)
+        {
+          uint32_t sample = ipc_doorbell_sample (in);
+          if (__atomic_load_n (&m_ball, __ATOMIC_SEQ_CST) == turn
+              || __atomic_load_n (&m_stalled, __ATOMIC_SEQ_CST))
+            {
+              break;
+            }
+          ipc_doorbell_wait (in, sample);
+        }
+      if (__atomic_load_n (&m_stalled, __ATOMIC_SEQ_CST))
+        {
+          return;
+        }
+      __atomic_store_n (&m_ball, turn + 1, __ATOMIC_SEQ_CST);
+      ipc_doorbell_ring (out);
+    }
+}
+
+void
+IpcDoorbellRaceTestCase::DoRun (void)
+{
+  ipc_doorbell_init (&m_bells[0]);
+  ipc_doorbell_init (&m_bells[1]);
+  m_ball = 0;
+  m_stalled = 0;
+
+  Ptr<SystemThread> players[2];
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      players[i] = Create<SystemThread> (MakeCallback (&IpcDoorbellRaceTestCase::Play, this).Bind (i));
+      players[i]->Start ();
+    }
+
+  uint32_t last = 0;
+  uint32_t idle = 0;
+  while (__atomic_load_n (&m_ball, __ATOMIC_SEQ_CST) < 2 * N_ROUNDS && idle < TIMEOUT_MS)
+    {
+      usleep (1000);
+      uint32_t ball = __atomic_load_n (&m_ball, __ATOMIC_SEQ_CST);
+      idle = (ball == last) ? idle + 1 : 0;
+      last = ball;
+    }
+  uint32_t ball = __atomic_load_n (&m_ball, __ATOMIC_SEQ_CST);
+  if (ball < 2 * N_ROUNDS)
+    {
+      __atomic_store_n (&m_stalled, 1, __ATOMIC_SEQ_CST);
+      for (uint32_t i = 0; i < 2; i++)
+        {
+          ipc_doorbell_ring (&m_bells[i]);
+          ForceWake (&m_bells[i]);
+        }
+    }
+  players[0]->Join ();
+  players[1]->Join ();
+
+  NS_TEST_ASSERT_MSG_EQ (ball, 2 * N_ROUNDS, "ring lost after " << ball << " exchanges");
+  NS_TEST_ASSERT_MSG_EQ (m_bells[0].waiters, 0, "waiter left behind");
+  NS_TEST_ASSERT_MSG_EQ (m_bells[1].waiters, 0, "waiter left behind");
+}
+
+class IpcDoorbellTestSuite : public TestSuite
+{
+public:
+  IpcDoorbellTestSuite ();
+};
+
+IpcDoorbellTestSuite::IpcDoorbellTestSuite ()
+  : TestSuite ("contiki-ipc-doorbell", UNIT)
+{
+  AddTestCase (new IpcDoorbellRingThenWaitTestCase);
+  AddTestCase (new IpcDoorbellSpinThenBlockTestCase);
+  AddTestCase (new IpcDoorbellRaceTestCase);
+}
+
+static IpcDoorbellTestSuite ipcDoorbellTestSuite;
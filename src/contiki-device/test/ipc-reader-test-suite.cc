@@ -0,0 +1,154 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include <stdint.h>
+#include <sys/mman.h>
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/ipc-reader.h"
+#include "ns3/contiki-device.h"
+
+using namespace ns3;
+
+namespace {
+
+void
+Discard (unsigned char *buf, ssize_t len)
+{
+}
+
+bool
+IsAligned (const void *p)
+{
+  return ((uintptr_t) p) % IPC_CACHE_LINE == 0;
+}
+
+} // anonymous namespace
+
+// ===========================================================================
+// Test case to make sure that the nodes get cache line aligned blocks of
+// their own in the shared arenas, that a node past the end of the arenas
+// gets a new one, and that an arena left by all its nodes is mapped again
+// for the next one.  The arenas are process-wide, the test expects to be
+// the first to map one.
+// ===========================================================================
+class IpcReaderArenaTestCase : public TestCase
+{
+public:
+  IpcReaderArenaTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+IpcReaderArenaTestCase::IpcReaderArenaTestCase ()
+  : TestCase ("Check the allocation of the node blocks in the shared arenas")
+{
+}
+
+void
+IpcReaderArenaTestCase::DoRun (void)
+{
+  uint32_t nNodes = ContikiNetDevice::GetNNodes ();
+  // the first arena is sized for two nodes
+  ContikiNetDevice::SetNNodes (2);
+
+  Ptr<IpcReader> readers[5];
+  semaphores_t *blocks[5];
+  int fds[5];
+  size_t sizes[5];
+  uint64_t offsets[5];
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      readers[i] = Create<IpcReader> ();
+      blocks[i] = readers[i]->Start (MakeCallback (&Discard), i, 0);
+      fds[i] = readers[i]->GetArenaFd (&sizes[i], &offsets[i]);
+    }
+  // later nodes only get arenas as large as they need
+  ContikiNetDevice::SetNNodes (0);
+
+  NS_TEST_ASSERT_MSG_EQ ((fds[0] != -1), true, "no arena for node 0");
+  NS_TEST_ASSERT_MSG_EQ (fds[1], fds[0], "nodes 0 and 1 in different arenas");
+  NS_TEST_ASSERT_MSG_EQ (offsets[0], 0, "node 0 not first in the arena, was an arena mapped before?");
+  size_t block = offsets[1];
+  NS_TEST_ASSERT_MSG_EQ (sizes[0], 2 * block, "arena not sized for two nodes");
+  NS_TEST_ASSERT_MSG_EQ (block % IPC_CACHE_LINE, 0, "blocks not cache line aligned");
+  NS_TEST_ASSERT_MSG_EQ ((block >= sizeof (semaphores_t) + 2 * sizeof (ipc_ring_t)), true,
+                         "block smaller than its content");
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      semaphores_t *s = blocks[i];
+      NS_TEST_ASSERT_MSG_EQ (s->node_id, i, "wrong node id in block " << i);
+      NS_TEST_ASSERT_MSG_EQ (IsAligned (ipc_ring_in (s)), true, "incoming ring of node " << i << " not aligned");
+      NS_TEST_ASSERT_MSG_EQ (IsAligned (ipc_ring_out (s)), true, "outgoing ring of node " << i << " not aligned");
+      NS_TEST_ASSERT_MSG_EQ ((s->ring_in_offset >= sizeof (semaphores_t)), true, "ring over the control block");
+      NS_TEST_ASSERT_MSG_EQ ((s->ring_out_offset >= s->ring_in_offset + sizeof (ipc_ring_t)), true,
+                             "rings of node " << i << " overlap");
+      NS_TEST_ASSERT_MSG_EQ ((s->ring_out_offset + sizeof (ipc_ring_t) <= block), true,
+                             "ring of node " << i << " past its block");
+      NS_TEST_ASSERT_MSG_EQ (ipc_ring_empty (ipc_ring_out (s)), 1, "new ring not empty");
+    }
+
+  // the first arena is full: node 2 gets one of its own, node 4 one that
+  // also holds node 3
+  readers[2] = Create<IpcReader> ();
+  blocks[2] = readers[2]->Start (MakeCallback (&Discard), 2, 0);
+  fds[2] = readers[2]->GetArenaFd (&sizes[2], &offsets[2]);
+  readers[4] = Create<IpcReader> ();
+  blocks[4] = readers[4]->Start (MakeCallback (&Discard), 4, 0);
+  fds[4] = readers[4]->GetArenaFd (&sizes[4], &offsets[4]);
+  NS_TEST_ASSERT_MSG_EQ ((fds[2] != -1 && fds[2] != fds[0]), true, "node 2 not in an arena of its own");
+  NS_TEST_ASSERT_MSG_EQ (offsets[2], 0, "node 2 not first in its arena");
+  NS_TEST_ASSERT_MSG_EQ (sizes[2], block, "arena of node 2 not sized for one node");
+  NS_TEST_ASSERT_MSG_EQ ((fds[4] != -1 && fds[4] != fds[2]), true, "node 4 not in an arena of its own");
+  NS_TEST_ASSERT_MSG_EQ (offsets[4], block, "node 4 not after node 3 in its arena");
+  NS_TEST_ASSERT_MSG_EQ (sizes[4], 2 * block, "arena of node 4 not sized for two nodes");
+  NS_TEST_ASSERT_MSG_EQ (blocks[4]->node_id, 4, "wrong node id in block 4");
+
+  // a frame only shows up in the ring of its node, and in the mapping of
+  // the arena a mote gets from its descriptor
+  uint8_t frame[3] = { 1, 2, 3 };
+  NS_TEST_ASSERT_MSG_EQ (readers[0]->Write (frame, sizeof (frame)), true, "write to an empty ring failed");
+  NS_TEST_ASSERT_MSG_EQ (ipc_ring_empty (ipc_ring_out (blocks[1])), 1, "frame of node 0 in the ring of node 1");
+  void *base = mmap (NULL, sizes[0], PROT_READ | PROT_WRITE, MAP_SHARED, fds[0], 0);
+  NS_TEST_ASSERT_MSG_EQ ((base != MAP_FAILED), true, "arena descriptor cannot be mapped");
+  ipc_record_t *rec = ipc_ring_peek (ipc_ring_out ((semaphores_t *) base));
+  bool seen = rec != 0 && rec->len == sizeof (frame) && rec->data[2] == 3;
+  munmap (base, sizes[0]);
+  NS_TEST_ASSERT_MSG_EQ (seen, true, "frame not seen through another mapping of the arena");
+  ipc_ring_release (ipc_ring_out (blocks[0]));
+
+  // once nodes 0 and 1 are stopped, node 1 gets its block back in a new
+  // mapping of the first arena
+  readers[0]->Stop ();
+  readers[1]->Stop ();
+  readers[1] = Create<IpcReader> ();
+  blocks[1] = readers[1]->Start (MakeCallback (&Discard), 1, 0);
+  fds[1] = readers[1]->GetArenaFd (&sizes[1], &offsets[1]);
+  NS_TEST_ASSERT_MSG_EQ ((fds[1] != -1), true, "first arena not mapped again");
+  NS_TEST_ASSERT_MSG_EQ (offsets[1], block, "node 1 moved in the first arena");
+  NS_TEST_ASSERT_MSG_EQ (sizes[1], 2 * block, "first arena resized");
+  NS_TEST_ASSERT_MSG_EQ (blocks[1]->node_id, 1, "wrong node id in block 1");
+  NS_TEST_ASSERT_MSG_EQ (readers[1]->Write (frame, sizeof (frame)), true, "write to the mapped again arena failed");
+  NS_TEST_ASSERT_MSG_EQ ((uint32_t) ipc_ring_peek (ipc_ring_out (blocks[1]))->data[0], 1, "frame lost");
+
+  // drops the wake ups of the readers
+  std::vector<WakeupWheel::Entry> due;
+  IpcReader::getReleaseSchedule (Seconds (1), due);
+  ContikiNetDevice::SetNNodes (nNodes);
+  Simulator::Destroy ();
+}
+
+class IpcReaderTestSuite : public TestSuite
+{
+public:
+  IpcReaderTestSuite ();
+};
+
+IpcReaderTestSuite::IpcReaderTestSuite ()
+  : TestSuite ("contiki-ipc-reader", UNIT)
+{
+  AddTestCase (new IpcReaderArenaTestCase);
+}
+
+static IpcReaderTestSuite ipcReaderTestSuite;
@@ -0,0 +1,165 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include <cstdlib>
+
+#include "ns3/test.h"
+#include "ns3/ipc-ring.h"
+
+using namespace ns3;
+
+// ===========================================================================
+// Test case to make sure that the records come out of the ring in the order
+// they went in, and that the producer stops at a full ring.
+// ===========================================================================
+class IpcRingFifoTestCase : public TestCase
+{
+public:
+  IpcRingFifoTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+IpcRingFifoTestCase::IpcRingFifoTestCase ()
+  : TestCase ("Check the order and the capacity of an IPC ring")
+{
+}
+
+void
+IpcRingFifoTestCase::DoRun (void)
+{
+  ipc_ring_t *ring = (ipc_ring_t *) malloc (sizeof (ipc_ring_t));
+  ipc_ring_init (ring);
+  NS_TEST_ASSERT_MSG_EQ (ipc_ring_empty (ring), 1, "new ring is not empty");
+  NS_TEST_ASSERT_MSG_EQ (ipc_ring_space (ring), IPC_RING_SLOTS, "new ring is not free");
+
+  // three turns of the ring, so that the indexes wrap
+  uint64_t next = 0;
+  uint64_t expected = 0;
+  for (uint32_t turn = 0; turn < 3; turn++)
+    {
+      while (ipc_ring_space (ring) > 0)
+        {
+          uint32_t len = next % 8;
+          uint8_t data[8] = { (uint8_t) next };
+          NS_TEST_ASSERT_MSG_EQ (ipc_ring_push (ring, IPC_RECORD_DATA, 0, next, data, len), 0,
+                                 "push to a ring with space failed");
+          next++;
+        }
+      NS_TEST_ASSERT_MSG_EQ (ipc_ring_push (ring, IPC_RECORD_DATA, 0, next, 0, 0), -1,
+                             "push to a full ring succeeded");
+      NS_TEST_ASSERT_MSG_EQ ((ipc_ring_reserve (ring) == 0), true, "reserved a record of a full ring");
+
+      // only drains part of the ring, the rest is read on the next turn
+      for (uint32_t i = 0; i < IPC_RING_SLOTS / 2 + turn; i++)
+        {
+          ipc_record_t *rec = ipc_ring_peek (ring);
+          NS_TEST_ASSERT_MSG_EQ ((rec == 0), false, "nothing to read from a non empty ring");
+          NS_TEST_ASSERT_MSG_EQ (rec->value, expected, "records out of order");
+          NS_TEST_ASSERT_MSG_EQ (rec->len, expected % 8, "wrong record length");
+          if (rec->len > 0)
+            {
+              NS_TEST_ASSERT_MSG_EQ ((uint32_t) rec->data[0], (uint32_t) (uint8_t) expected,
+                                     "wrong record data");
+            }
+          ipc_ring_release (ring);
+          expected++;
+        }
+    }
+
+  while (ipc_ring_peek (ring) != 0)
+    {
+      NS_TEST_ASSERT_MSG_EQ (ipc_ring_peek (ring)->value, expected, "records out of order");
+      ipc_ring_release (ring);
+      expected++;
+    }
+  NS_TEST_ASSERT_MSG_EQ (expected, next, "records lost");
+  NS_TEST_ASSERT_MSG_EQ (ipc_ring_empty (ring), 1, "drained ring is not empty");
+  NS_TEST_ASSERT_MSG_EQ (ipc_ring_push (ring, IPC_RECORD_DATA, 0, 0, 0, IPC_RING_MTU + 1), -1,
+                         "pushed a record larger than the MTU");
+  free (ring);
+}
+
+// ===========================================================================
+// Test case to make sure that records retired out of order only give their
+// slots back once all the older ones are retired.
+// ===========================================================================
+class IpcRingRetireTestCase : public TestCase
+{
+public:
+  IpcRingRetireTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+IpcRingRetireTestCase::IpcRingRetireTestCase ()
+  : TestCase ("Check the out of order retirement of IPC ring records")
+{
+}
+
+void
+IpcRingRetireTestCase::DoRun (void)
+{
+  ipc_ring_t *ring = (ipc_ring_t *) malloc (sizeof (ipc_ring_t));
+  ipc_ring_init (ring);
+
+  // starts close to the end of the slots, so that the records held wrap
+  uint32_t cursor = 0;
+  for (uint32_t i = 0; i < IPC_RING_SLOTS - 2; i++)
+    {
+      ipc_ring_push (ring, IPC_RECORD_DATA, 0, i, 0, 0);
+      ipc_ring_retire (ring, ipc_ring_peek_at (ring, cursor++));
+    }
+  NS_TEST_ASSERT_MSG_EQ (ipc_ring_held (ring, cursor), 0, "retired records still held");
+
+  ipc_record_t *rec[4];
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (ipc_ring_push (ring, IPC_RECORD_DATA, 0, cursor, 0, 0), 0,
+                             "push to a ring with space failed");
+      rec[i] = ipc_ring_peek_at (ring, cursor);
+      NS_TEST_ASSERT_MSG_EQ (rec[i]->value, cursor, "records out of order");
+      cursor++;
+    }
+  NS_TEST_ASSERT_MSG_EQ ((ipc_ring_peek_at (ring, cursor) == 0), true, "read past the producer");
+  NS_TEST_ASSERT_MSG_EQ (ipc_ring_held (ring, cursor), 4, "wrong number of records held");
+
+  // the newest ones first: the oldest record pins the tail
+  ipc_ring_retire (ring, rec[2]);
+  ipc_ring_retire (ring, rec[3]);
+  NS_TEST_ASSERT_MSG_EQ (ipc_ring_held (ring, cursor), 4, "tail moved over a record held");
+  NS_TEST_ASSERT_MSG_EQ (ipc_ring_space (ring), IPC_RING_SLOTS - 4, "slot of a record held freed");
+
+  ipc_ring_retire (ring, rec[0]);
+  NS_TEST_ASSERT_MSG_EQ (ipc_ring_held (ring, cursor), 3, "tail did not move over the oldest record");
+
+  // retiring the last one held releases it along with the newer ones
+  ipc_ring_retire (ring, rec[1]);
+  NS_TEST_ASSERT_MSG_EQ (ipc_ring_held (ring, cursor), 0, "tail did not catch up");
+  NS_TEST_ASSERT_MSG_EQ (ipc_ring_space (ring), IPC_RING_SLOTS, "slots not given back");
+
+  // a committed record is no longer retired, even in a reused slot
+  ipc_ring_push (ring, IPC_RECORD_DATA, 0, cursor, 0, 0);
+  ipc_ring_push (ring, IPC_RECORD_DATA, 0, cursor + 1, 0, 0);
+  ipc_ring_retire (ring, ipc_ring_peek_at (ring, cursor + 1));
+  NS_TEST_ASSERT_MSG_EQ (ipc_ring_held (ring, cursor + 2), 2, "tail moved over a reused slot");
+  ipc_ring_retire (ring, ipc_ring_peek_at (ring, cursor));
+  NS_TEST_ASSERT_MSG_EQ (ipc_ring_held (ring, cursor + 2), 0, "tail did not catch up");
+  free (ring);
+}
+
+class IpcRingTestSuite : public TestSuite
+{
+public:
+  IpcRingTestSuite ();
+};
+
+IpcRingTestSuite::IpcRingTestSuite ()
+  : TestSuite ("contiki-ipc-ring", UNIT)
+{
+  AddTestCase (new IpcRingFifoTestCase);
+  AddTestCase (new IpcRingRetireTestCase);
+}
+
+static IpcRingTestSuite ipcRingTestSuite;
@@ -0,0 +1,134 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <vector>
+
+#include "ns3/test.h"
+#include "ns3/wakeup-wheel.h"
+
+using namespace ns3;
+
+static bool
+CompareNode (const WakeupWheel::Entry &a, const WakeupWheel::Entry &b)
+{
+  return a.node < b.node;
+}
+
+// ===========================================================================
+// Test case to make sure that the wheel returns the wake ups a sorted set
+// of every registered wake up would, whether they land in a bucket, in
+// the overflow or in the past.
+// ===========================================================================
+class WakeupWheelTestCase : public TestCase
+{
+public:
+  WakeupWheelTestCase ();
+
+private:
+  virtual void DoRun (void);
+  uint32_t Random (uint32_t max);
+
+  uint32_t m_seed;
+};
+
+WakeupWheelTestCase::WakeupWheelTestCase ()
+  : TestCase ("Check the wake ups of a timing wheel against a sorted set"),
+    m_seed (1)
+{
+}
+
+uint32_t
+WakeupWheelTestCase::Random (uint32_t max)
+{
+  // the same sequence on every run, whatever the seed of the simulator
+  m_seed = m_seed * 1103515245 + 12345;
+  return (m_seed >> 16) % max;
+}
+
+void
+WakeupWheelTestCase::DoRun (void)
+{
+  // 5 buckets rounded up to 8, of 10 time steps, to go round the wheel and
+  // to the overflow a lot
+  WakeupWheel wheel (5, 10);
+  std::map<uint32_t, std::set<uint64_t> > reference;
+  uint32_t size = 0;
+  uint64_t now = 0;
+  std::vector<WakeupWheel::Entry> due;
+
+  for (uint32_t step = 0; step < 2000; step++)
+    {
+      for (uint32_t i = Random (4); i > 0; i--)
+        {
+          uint32_t node = Random (16);
+          uint64_t ts;
+          switch (Random (4))
+            {
+            case 0:
+              // late
+              ts = now > 20 ? now - Random (20) : now;
+              break;
+            case 1:
+              // beyond the wheel
+              ts = now + 80 + Random (400);
+              break;
+            default:
+              ts = now + Random (80);
+              break;
+            }
+          // a node woken up twice at the same time is only woken up once,
+          // whether the wheel keeps both or not
+          if (reference[node].insert (ts).second)
+            {
+              wheel.Insert (ts, node);
+              size++;
+            }
+        }
+      NS_TEST_ASSERT_MSG_EQ (wheel.GetSize (), size, "wrong number of wake ups");
+
+      // mostly small steps, sometimes over the whole wheel
+      now += Random (10) == 0 ? Random (300) : Random (15);
+      wheel.Collect (now, due);
+
+      std::vector<WakeupWheel::Entry> expected;
+      for (std::map<uint32_t, std::set<uint64_t> >::iterator i = reference.begin ();
+           i != reference.end (); i++)
+        {
+          if (i->second.empty () || *i->second.begin () > now)
+            {
+              continue;
+            }
+          WakeupWheel::Entry entry;
+          entry.node = i->first;
+          entry.ts = *i->second.begin ();
+          expected.push_back (entry);
+          i->second.erase (i->second.begin ());
+          size--;
+        }
+
+      std::sort (due.begin (), due.end (), CompareNode);
+      NS_TEST_ASSERT_MSG_EQ (due.size (), expected.size (), "wrong number of due nodes at " << now);
+      for (uint32_t i = 0; i < due.size (); i++)
+        {
+          NS_TEST_ASSERT_MSG_EQ (due[i].node, expected[i].node, "wrong node due at " << now);
+          NS_TEST_ASSERT_MSG_EQ (due[i].ts, expected[i].ts, "wrong wake up of node " << due[i].node);
+        }
+      NS_TEST_ASSERT_MSG_EQ (wheel.GetSize (), size, "wrong number of wake ups left");
+    }
+}
+
+class WakeupWheelTestSuite : public TestSuite
+{
+public:
+  WakeupWheelTestSuite ();
+};
+
+WakeupWheelTestSuite::WakeupWheelTestSuite ()
+  : TestSuite ("contiki-wakeup-wheel", UNIT)
+{
+  AddTestCase (new WakeupWheelTestCase);
+}
+
+static WakeupWheelTestSuite wakeupWheelTestSuite;
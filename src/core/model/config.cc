@@ -26,6 +26,8 @@
 #include "pointer.h"
 #include "log.h"
 
+#include <algorithm>
+#include <map>
 #include <sstream>
 
 NS_LOG_COMPONENT_DEFINE ("Config");
@@ -147,78 +149,92 @@ class ArrayMatcher
 public:
   ArrayMatcher (std::string element);
   bool Matches (uint32_t i) const;
+  /**
+   * \param i where to store the index
+   * \returns true if the element matches a single index
+   */
+  bool IsIndex (uint32_t *i) const;
 private:
+  void Parse (std::string element);
   bool StringToUint32 (std::string str, uint32_t *value) const;
-  std::string m_element;
+  // the intervals of the indexes which match, bounds included
+  std::vector<std::pair<uint32_t, uint32_t> > m_ranges;
 };
 
 
 ArrayMatcher::ArrayMatcher (std::string element)
-  : m_element (element)
 {
   NS_LOG_FUNCTION (this << element);
+  Parse (element);
 }
-bool
-ArrayMatcher::Matches (uint32_t i) const
+void
+ArrayMatcher::Parse (std::string element)
 {
-  NS_LOG_FUNCTION (this << i);
-  if (m_element == "*")
+  NS_LOG_FUNCTION (this << element);
+  if (element == "*")
     {
-      NS_LOG_DEBUG ("Array "<<i<<" matches *");
-      return true;
+      m_ranges.push_back (std::make_pair (0U, 0xffffffffU));
+      return;
     }
   std::string::size_type tmp;
-  tmp = m_element.find ("|");
+  tmp = element.find ("|");
   if (tmp != std::string::npos)
     {
-      std::string left = m_element.substr (0, tmp-0);
-      std::string right = m_element.substr (tmp+1, m_element.size () - (tmp + 1));
-      ArrayMatcher matcher = ArrayMatcher (left);
-      if (matcher.Matches (i))
-        {
-          NS_LOG_DEBUG ("Array "<<i<<" matches "<<left);
-          return true;
-        }
-      matcher = ArrayMatcher (right);
-      if (matcher.Matches (i))
-        {
-          NS_LOG_DEBUG ("Array "<<i<<" matches "<<right);
-          return true;
-        }
-      NS_LOG_DEBUG ("Array "<<i<<" does not match "<<m_element);
-      return false;
+      std::string left = element.substr (0, tmp-0);
+      std::string right = element.substr (tmp+1, element.size () - (tmp + 1));
+      Parse (left);
+      Parse (right);
+      return;
     }
-  std::string::size_type leftBracket = m_element.find ("[");
-  std::string::size_type rightBracket = m_element.find ("]");
-  std::string::size_type dash = m_element.find ("-");
-  if (leftBracket == 0 && rightBracket == m_element.size () - 1 &&
+  std::string::size_type leftBracket = element.find ("[");
+  std::string::size_type rightBracket = element.find ("]");
+  std::string::size_type dash = element.find ("-");
+  if (leftBracket == 0 && rightBracket == element.size () - 1 &&
       dash > leftBracket && dash < rightBracket)
     {
-      std::string lowerBound = m_element.substr (leftBracket + 1, dash - (leftBracket + 1));
-      std::string upperBound = m_element.substr (dash + 1, rightBracket - (dash + 1));
+      std::string lowerBound = element.substr (leftBracket + 1, dash - (leftBracket + 1));
+      std::string upperBound = element.substr (dash + 1, rightBracket - (dash + 1));
       uint32_t min;
       uint32_t max;
       if (StringToUint32 (lowerBound, &min) && 
           StringToUint32 (upperBound, &max) &&
-          i >= min && i <= max)
+          min <= max)
         {
-          NS_LOG_DEBUG ("Array "<<i<<" matches "<<m_element);
-          return true;
+          m_ranges.push_back (std::make_pair (min, max));
         }
-      else
+      return;
+    }
+  uint32_t value;
+  if (StringToUint32 (element, &value))
+    {
+      m_ranges.push_back (std::make_pair (value, value));
+    }
+}
+bool
+ArrayMatcher::Matches (uint32_t i) const
+{
+  NS_LOG_FUNCTION (this << i);
+  for (std::vector<std::pair<uint32_t, uint32_t> >::const_iterator j = m_ranges.begin ();
+       j != m_ranges.end (); j++)
+    {
+      if (i >= j->first && i <= j->second)
         {
-          NS_LOG_DEBUG ("Array "<<i<<" does not "<<m_element);
-          return false;
+          NS_LOG_DEBUG ("Array "<<i<<" matches ["<<j->first<<"-"<<j->second<<"]");
+          return true;
         }
     }
-  uint32_t value;
-  if (StringToUint32 (m_element, &value) &&
-      i == value)
+  NS_LOG_DEBUG ("Array "<<i<<" does not match");
+  return false;
+}
+bool
+ArrayMatcher::IsIndex (uint32_t *i) const
+{
+  NS_LOG_FUNCTION (this << i);
+  if (m_ranges.size () == 1 && m_ranges[0].first == m_ranges[0].second)
     {
-      NS_LOG_DEBUG ("Array "<<i<<" matches "<<m_element);
+      *i = m_ranges[0].first;
       return true;
     }
-  NS_LOG_DEBUG ("Array "<<i<<" does not match "<<m_element);
   return false;
 }
 
@@ -233,52 +249,223 @@ ArrayMatcher::StringToUint32 (std::string str, uint32_t *value) const
 }
 
 
+/**
+ * The attributes of every TypeId which a path can go through: pointers
+ * and containers of objects. Looking them up once avoids copying the
+ * attribute information and testing the type of the checkers on every
+ * object reached by every path.
+ */
+class PathAttributes
+{
+public:
+  enum Kind
+  {
+    OTHER,
+    POINTER,
+    CONTAINER
+  };
+  struct Attribute
+  {
+    std::string name;
+    Kind kind;
+    // 0 if the attribute can only be read through ObjectBase::GetAttribute
+    const ObjectPtrContainerAccessor *container;
+  };
+
+  static const std::vector<Attribute> &Get (TypeId tid);
+private:
+  static std::vector<std::vector<Attribute> > *Peek (void);
+};
+
+const std::vector<PathAttributes::Attribute> &
+PathAttributes::Get (TypeId tid)
+{
+  std::vector<std::vector<Attribute> > &all = *Peek ();
+  uint16_t uid = tid.GetUid ();
+  if (uid >= all.size ())
+    {
+      all.resize (uid + 1);
+    }
+  std::vector<Attribute> &attributes = all[uid];
+  if (attributes.size () != tid.GetAttributeN ())
+    {
+      attributes.clear ();
+      for (uint32_t i = 0; i < tid.GetAttributeN (); i++)
+        {
+          struct TypeId::AttributeInformation info = tid.GetAttribute (i);
+          Attribute attribute;
+          attribute.name = info.name;
+          attribute.kind = OTHER;
+          attribute.container = 0;
+          if (dynamic_cast<const PointerChecker *> (PeekPointer (info.checker)) != 0)
+            {
+              attribute.kind = POINTER;
+            }
+          else if (dynamic_cast<const ObjectPtrContainerChecker *> (PeekPointer (info.checker)) != 0)
+            {
+              attribute.kind = CONTAINER;
+              if ((info.flags & TypeId::ATTR_GET) != 0)
+                {
+                  attribute.container = dynamic_cast<const ObjectPtrContainerAccessor *> (PeekPointer (info.accessor));
+                }
+            }
+          attributes.push_back (attribute);
+        }
+    }
+  return attributes;
+}
+
+std::vector<std::vector<PathAttributes::Attribute> > *
+PathAttributes::Peek (void)
+{
+  static std::vector<std::vector<Attribute> > attributes;
+  return &attributes;
+}
+
+
+struct IndexLess
+{
+  bool operator () (const std::pair<uint32_t, Ptr<Object> > &a,
+                    const std::pair<uint32_t, Ptr<Object> > &b) const
+  {
+    return a.first < b.first;
+  }
+};
+
+/**
+ * Resolves a set of paths together. The paths are split once into a tree
+ * of their items, shared by the paths which start the same way, and the
+ * tree is walked from every root: an object reached by the common
+ * beginning of several paths is only visited once.
+ */
 class Resolver
 {
 public:
-  Resolver (std::string path);
+  Resolver (const std::vector<std::string> &paths);
   virtual ~Resolver ();
 
   void Resolve (Ptr<Object> root);
 private:
-  void Canonicalize (void);
-  void DoResolve (std::string path, Ptr<Object> root);
-  void DoArrayResolve (std::string path, const ObjectPtrContainerValue &vector);
-  void DoResolveOne (Ptr<Object> object);
+  struct Item
+  {
+    std::string name;
+    // to match the indexes of a container
+    ArrayMatcher matcher;
+    // for a $TypeId item
+    bool isGetObject;
+    bool hasTid;
+    TypeId tid;
+    // the items which follow this one, in the order of the paths
+    std::vector<Item *> children;
+    // to find the children by name
+    std::map<std::string, Item *> names;
+    // the paths which end with this item
+    std::vector<uint32_t> paths;
+
+    Item (std::string name);
+  };
+
+  static std::string Canonicalize (std::string path);
+  void Add (std::string path, uint32_t index);
+  void DoResolve (const Item *item, Ptr<Object> root);
+  void DoResolveItem (const Item *item, Ptr<Object> root);
+  void DoArrayResolve (const Item *item, Ptr<Object> root, const PathAttributes::Attribute &attribute);
+  void DoResolveOne (const Item *item, Ptr<Object> object);
+  void Delete (Item *item);
   std::string GetResolvedPath (void) const;
-  virtual void DoOne (Ptr<Object> object, std::string path) = 0;
+  virtual void DoOne (Ptr<Object> object, std::string path, uint32_t index) = 0;
+  // the items are owned by the tree
+  Resolver (const Resolver &);
+  Resolver &operator = (const Resolver &);
   std::vector<std::string> m_workStack;
-  std::string m_path;
+  Item m_root;
 };
 
-Resolver::Resolver (std::string path)
-  : m_path (path)
+Resolver::Item::Item (std::string name)
+  : name (name),
+    matcher (name),
+    isGetObject (false),
+    hasTid (false)
 {
-  NS_LOG_FUNCTION (this << path);
-  Canonicalize ();
+  if (name.find ("$") == 0)
+    {
+      isGetObject = true;
+      hasTid = TypeId::LookupByNameFailSafe (name.substr (1, name.size () - 1), &tid);
+    }
+}
+
+Resolver::Resolver (const std::vector<std::string> &paths)
+  : m_root ("")
+{
+  NS_LOG_FUNCTION (this << &paths);
+  for (uint32_t i = 0; i < paths.size (); i++)
+    {
+      Add (Canonicalize (paths[i]), i);
+    }
 }
 Resolver::~Resolver ()
 {
   NS_LOG_FUNCTION (this);
+  for (std::vector<Item *>::iterator i = m_root.children.begin (); i != m_root.children.end (); i++)
+    {
+      Delete (*i);
+    }
 }
 void
-Resolver::Canonicalize (void)
+Resolver::Delete (Item *item)
 {
-  NS_LOG_FUNCTION (this);
+  for (std::vector<Item *>::iterator i = item->children.begin (); i != item->children.end (); i++)
+    {
+      Delete (*i);
+    }
+  delete item;
+}
+std::string
+Resolver::Canonicalize (std::string path)
+{
+  NS_LOG_FUNCTION (path);
 
   // ensure that we start and end with a '/'
-  std::string::size_type tmp = m_path.find ("/");
+  std::string::size_type tmp = path.find ("/");
   if (tmp != 0)
     {
       // no slash at start
-      m_path = "/" + m_path;
+      path = "/" + path;
     }
-  tmp = m_path.find_last_of ("/");
-  if (tmp != (m_path.size () - 1))
+  tmp = path.find_last_of ("/");
+  if (tmp != (path.size () - 1))
     {
       // no slash at end
-      m_path = m_path + "/";
+      path = path + "/";
+    }
+  return path;
+}
+
+void
+Resolver::Add (std::string path, uint32_t index)
+{
+  NS_LOG_FUNCTION (this << path << index);
+  Item *item = &m_root;
+  std::string::size_type start = 1;
+  for (std::string::size_type next = path.find ("/", start);
+       next != std::string::npos; next = path.find ("/", start))
+    {
+      std::string name = path.substr (start, next - start);
+      std::map<std::string, Item *>::const_iterator i = item->names.find (name);
+      if (i != item->names.end ())
+        {
+          item = i->second;
+        }
+      else
+        {
+          Item *child = new Item (name);
+          item->children.push_back (child);
+          item->names[name] = child;
+          item = child;
+        }
+      start = next + 1;
     }
+  item->paths.push_back (index);
 }
 
 void 
@@ -286,7 +473,7 @@ Resolver::Resolve (Ptr<Object> root)
 {
   NS_LOG_FUNCTION (this << root);
 
-  DoResolve (m_path, root);
+  DoResolve (&m_root, root);
 }
 
 std::string
@@ -303,39 +490,45 @@ Resolver::GetResolvedPath (void) const
 }
 
 void 
-Resolver::DoResolveOne (Ptr<Object> object)
+Resolver::DoResolveOne (const Item *item, Ptr<Object> object)
 {
   NS_LOG_FUNCTION (this << object);
 
-  NS_LOG_DEBUG ("resolved="<<GetResolvedPath ());
-  DoOne (object, GetResolvedPath ());
+  std::string path = GetResolvedPath ();
+  NS_LOG_DEBUG ("resolved="<<path);
+  for (std::vector<uint32_t>::const_iterator i = item->paths.begin (); i != item->paths.end (); i++)
+    {
+      DoOne (object, path, *i);
+    }
 }
 
 void
-Resolver::DoResolve (std::string path, Ptr<Object> root)
-{
-  NS_LOG_FUNCTION (this << path << root);
-  NS_ASSERT ((path.find ("/")) == 0);
-  std::string::size_type next = path.find ("/", 1);
-
-  if (next == std::string::npos)
-    {
-      //
-      // If root is zero, we're beginning to see if we can use the object name 
-      // service to resolve this path.  It is impossible to have a object name 
-      // associated with the root of the object name service since that root
-      // is not an object.  This path must be referring to something in another
-      // namespace and it will have been found already since the name service
-      // is always consulted last.
-      // 
-      if (root)
-        {
-          DoResolveOne (root);
-        }
-      return;
+Resolver::DoResolve (const Item *item, Ptr<Object> root)
+{
+  NS_LOG_FUNCTION (this << item->name << root);
+
+  //
+  // If root is zero, we're beginning to see if we can use the object name 
+  // service to resolve this path.  It is impossible to have a object name 
+  // associated with the root of the object name service since that root
+  // is not an object.  This path must be referring to something in another
+  // namespace and it will have been found already since the name service
+  // is always consulted last.
+  // 
+  if (root && !item->paths.empty ())
+    {
+      DoResolveOne (item, root);
+    }
+  for (std::vector<Item *>::const_iterator i = item->children.begin (); i != item->children.end (); i++)
+    {
+      DoResolveItem (*i, root);
     }
-  std::string item = path.substr (1, next-1);
-  std::string pathLeft = path.substr (next, path.size ()-next);
+}
+
+void
+Resolver::DoResolveItem (const Item *item, Ptr<Object> root)
+{
+  NS_LOG_FUNCTION (this << item->name << root);
 
   //
   // If root is zero, we're beginning to see if we can use the object name 
@@ -344,16 +537,12 @@ Resolver::DoResolve (std::string path, Ptr<Object> root)
   // the root of the "/Names" namespace, so we just ignore it and move on to 
   // the next segment.
   //
-  if (root == 0)
+  if (root == 0 && item->name == "Names")
     {
-      std::string::size_type offset = path.find ("/Names");
-      if (offset == 0)
-        {
-          m_workStack.push_back (item);
-          DoResolve (pathLeft, root);
-          m_workStack.pop_back ();
-          return;
-        }
+      m_workStack.push_back (item->name);
+      DoResolve (item, root);
+      m_workStack.pop_back ();
+      return;
     }
 
   //
@@ -362,12 +551,12 @@ Resolver::DoResolve (std::string path, Ptr<Object> root)
   // zero, this means to look in the root of the "/Names" name space, otherwise
   // it refers to a name space context (level).
   //
-  Ptr<Object> namedObject = Names::Find<Object> (root, item);
+  Ptr<Object> namedObject = Names::Find<Object> (root, item->name);
   if (namedObject)
     {
-      NS_LOG_DEBUG ("Name system resolved item = " << item << " to " << namedObject);
-      m_workStack.push_back (item);
-      DoResolve (pathLeft, namedObject);
+      NS_LOG_DEBUG ("Name system resolved item = " << item->name << " to " << namedObject);
+      m_workStack.push_back (item->name);
+      DoResolve (item, namedObject);
       m_workStack.pop_back ();
       return;
     }
@@ -383,67 +572,61 @@ Resolver::DoResolve (std::string path, Ptr<Object> root)
     {
       return;
     }
-  std::string::size_type dollarPos = item.find ("$");
-  if (dollarPos == 0)
+  if (item->isGetObject)
     {
       // This is a call to GetObject
-      std::string tidString = item.substr (1, item.size () - 1);
-      NS_LOG_DEBUG ("GetObject="<<tidString<<" on path="<<GetResolvedPath ());
-      TypeId tid = TypeId::LookupByName (tidString);
-      Ptr<Object> object = root->GetObject<Object> (tid);
+      NS_LOG_DEBUG ("GetObject="<<item->name<<" on path="<<GetResolvedPath ());
+      if (!item->hasTid)
+        {
+          // fails as it always did
+          TypeId::LookupByName (item->name.substr (1, item->name.size () - 1));
+        }
+      Ptr<Object> object = root->GetObject<Object> (item->tid);
       if (object == 0)
         {
-          NS_LOG_DEBUG ("GetObject ("<<tidString<<") failed on path="<<GetResolvedPath ());
+          NS_LOG_DEBUG ("GetObject ("<<item->name<<") failed on path="<<GetResolvedPath ());
           return;
         }
-      m_workStack.push_back (item);
-      DoResolve (pathLeft, object);
+      m_workStack.push_back (item->name);
+      DoResolve (item, object);
       m_workStack.pop_back ();
     }
   else 
     {
       // this is a normal attribute.
-      TypeId tid = root->GetInstanceTypeId ();
+      const std::vector<PathAttributes::Attribute> &attributes = PathAttributes::Get (root->GetInstanceTypeId ());
       bool foundMatch = false;
-      for (uint32_t i = 0; i < tid.GetAttributeN(); i++)
+      for (std::vector<PathAttributes::Attribute>::const_iterator i = attributes.begin ();
+           i != attributes.end (); i++)
         {
-          struct TypeId::AttributeInformation info;
-          info = tid.GetAttribute(i);
-          if (info.name != item && item != "*")
+          if (i->name != item->name && item->name != "*")
             {
               continue;
             }
-          // attempt to cast to a pointer checker.
-          const PointerChecker *ptr = dynamic_cast<const PointerChecker *> (PeekPointer (info.checker));
-          if (ptr != 0)
+          if (i->kind == PathAttributes::POINTER)
             {
-              NS_LOG_DEBUG ("GetAttribute(ptr)="<<info.name<<" on path="<<GetResolvedPath ());
+              NS_LOG_DEBUG ("GetAttribute(ptr)="<<i->name<<" on path="<<GetResolvedPath ());
               PointerValue ptr;
-              root->GetAttribute (info.name, ptr);
+              root->GetAttribute (i->name, ptr);
               Ptr<Object> object = ptr.Get<Object> ();
               if (object == 0)
                 {
-                  NS_LOG_ERROR ("Requested object name=\""<<item<<
+                  NS_LOG_ERROR ("Requested object name=\""<<item->name<<
                                 "\" exists on path=\""<<GetResolvedPath ()<<"\""
                                 " but is null.");
                   continue;
                 }
               foundMatch = true;
-              m_workStack.push_back (info.name);
-              DoResolve (pathLeft, object);
+              m_workStack.push_back (i->name);
+              DoResolve (item, object);
               m_workStack.pop_back ();
             }
-          // attempt to cast to an object vector.
-          const ObjectPtrContainerChecker *vectorChecker = 
-            dynamic_cast<const ObjectPtrContainerChecker *> (PeekPointer (info.checker));
-          if (vectorChecker != 0)
+          else if (i->kind == PathAttributes::CONTAINER)
             {
-              NS_LOG_DEBUG ("GetAttribute(vector)="<<info.name<<" on path="<<GetResolvedPath () << pathLeft);
+              NS_LOG_DEBUG ("GetAttribute(vector)="<<i->name<<" on path="<<GetResolvedPath ());
               foundMatch = true;
-              ObjectPtrContainerValue vector;
-              root->GetAttribute (info.name, vector);
-              m_workStack.push_back (info.name);
-              DoArrayResolve (pathLeft, vector);
+              m_workStack.push_back (i->name);
+              DoArrayResolve (item, root, *i);
               m_workStack.pop_back ();
             }
           // this could be anything else and we don't know what to do with it.
@@ -451,36 +634,94 @@ Resolver::DoResolve (std::string path, Ptr<Object> root)
         }
       if (!foundMatch)
         {
-          NS_LOG_DEBUG ("Requested item="<<item<<" does not exist on path="<<GetResolvedPath ());
+          NS_LOG_DEBUG ("Requested item="<<item->name<<" does not exist on path="<<GetResolvedPath ());
           return;
         }
     }
 }
 
 void 
-Resolver::DoArrayResolve (std::string path, const ObjectPtrContainerValue &container)
+Resolver::DoArrayResolve (const Item *item, Ptr<Object> root, const PathAttributes::Attribute &attribute)
 {
-  NS_LOG_FUNCTION(this << path << &container);
-  NS_ASSERT (path != "");
-  NS_ASSERT ((path.find ("/")) == 0);
-  std::string::size_type next = path.find ("/", 1);
-  if (next == std::string::npos)
+  NS_LOG_FUNCTION (this << item->name << root << attribute.name);
+
+  // the items of the container are only needed if a path goes on
+  if (item->children.empty ())
+    {
+      return;
+    }
+
+  if (attribute.container == 0)
     {
+      ObjectPtrContainerValue container;
+      root->GetAttribute (attribute.name, container);
+      for (std::vector<Item *>::const_iterator i = item->children.begin (); i != item->children.end (); i++)
+        {
+          for (ObjectPtrContainerValue::Iterator it = container.Begin (); it != container.End (); ++it)
+            {
+              if ((*i)->matcher.Matches ((*it).first))
+                {
+                  std::ostringstream oss;
+                  oss << (*it).first;
+                  m_workStack.push_back (oss.str ());
+                  DoResolve (*i, (*it).second);
+                  m_workStack.pop_back ();
+                }
+            }
+        }
       return;
     }
-  std::string item = path.substr (1, next-1);
-  std::string pathLeft = path.substr (next, path.size ()-next);
 
-  ArrayMatcher matcher = ArrayMatcher (item);
-  ObjectPtrContainerValue::Iterator it;
-  for (it = container.Begin (); it != container.End (); ++it)
+  uint32_t n;
+  if (!attribute.container->GetN (PeekPointer (root), &n))
+    {
+      return;
+    }
+  for (std::vector<Item *>::const_iterator i = item->children.begin (); i != item->children.end (); i++)
     {
-      if (matcher.Matches ((*it).first))
+      const ArrayMatcher &matcher = (*i)->matcher;
+      uint32_t index;
+      if (matcher.IsIndex (&index) && index < n)
+        {
+          // the containers are usually indexed by position, there is no
+          // need to walk them
+          uint32_t found;
+          Ptr<Object> object = attribute.container->Get (PeekPointer (root), index, &found);
+          if (found == index)
+            {
+              m_workStack.push_back ((*i)->name);
+              DoResolve (*i, object);
+              m_workStack.pop_back ();
+              continue;
+            }
+        }
+      std::vector<std::pair<uint32_t, Ptr<Object> > > objects;
+      bool sorted = true;
+      for (uint32_t j = 0; j < n; j++)
         {
+          uint32_t found;
+          Ptr<Object> object = attribute.container->Get (PeekPointer (root), j, &found);
+          if (matcher.Matches (found))
+            {
+              sorted = sorted && (objects.empty () || objects.back ().first < found);
+              objects.push_back (std::make_pair (found, object));
+            }
+        }
+      if (!sorted)
+        {
+          // visited by index, as in an ObjectPtrContainerValue
+          std::stable_sort (objects.begin (), objects.end (), IndexLess ());
+        }
+      for (uint32_t j = 0; j < objects.size (); j++)
+        {
+          if (j > 0 && objects[j].first == objects[j - 1].first)
+            {
+              continue;
+            }
           std::ostringstream oss;
-          oss << (*it).first;
+          oss << objects[j].first;
           m_workStack.push_back (oss.str ());
-          DoResolve (pathLeft, (*it).second);
+          DoResolve (*i, objects[j].second);
           m_workStack.pop_back ();
         }
     }
@@ -496,6 +737,8 @@ public:
   void DisconnectWithoutContext (std::string path, const CallbackBase &cb);
   void Disconnect (std::string path, const CallbackBase &cb);
   Config::MatchContainer LookupMatches (std::string path);
+  std::vector<Config::MatchContainer> LookupMatches (const std::vector<std::string> &paths);
+  void Apply (const std::vector<Config::Batch::Operation> &operations);
 
   void RegisterRootNamespaceObject (Ptr<Object> obj);
   void UnregisterRootNamespaceObject (Ptr<Object> obj);
@@ -574,19 +817,28 @@ Config::MatchContainer
 ConfigImpl::LookupMatches (std::string path)
 {
   NS_LOG_FUNCTION (this << path);
+  return LookupMatches (std::vector<std::string> (1, path))[0];
+}
+
+std::vector<Config::MatchContainer>
+ConfigImpl::LookupMatches (const std::vector<std::string> &paths)
+{
+  NS_LOG_FUNCTION (this << &paths);
   class LookupMatchesResolver : public Resolver 
   {
   public:
-    LookupMatchesResolver (std::string path)
-      : Resolver (path)
+    LookupMatchesResolver (const std::vector<std::string> &paths)
+      : Resolver (paths),
+        m_objects (paths.size ()),
+        m_contexts (paths.size ())
     {}
-    virtual void DoOne (Ptr<Object> object, std::string path) {
-      m_objects.push_back (object);
-      m_contexts.push_back (path);
+    virtual void DoOne (Ptr<Object> object, std::string path, uint32_t index) {
+      m_objects[index].push_back (object);
+      m_contexts[index].push_back (path);
     }
-    std::vector<Ptr<Object> > m_objects;
-    std::vector<std::string> m_contexts;
-  } resolver = LookupMatchesResolver (path);
+    std::vector<std::vector<Ptr<Object> > > m_objects;
+    std::vector<std::vector<std::string> > m_contexts;
+  } resolver (paths);
   for (Roots::const_iterator i = m_roots.begin (); i != m_roots.end (); i++)
     {
       resolver.Resolve (*i);
@@ -599,7 +851,46 @@ ConfigImpl::LookupMatches (std::string path)
   //
   resolver.Resolve (0);
 
-  return Config::MatchContainer (resolver.m_objects, resolver.m_contexts, path);
+  std::vector<Config::MatchContainer> containers;
+  containers.reserve (paths.size ());
+  for (uint32_t i = 0; i < paths.size (); i++)
+    {
+      containers.push_back (Config::MatchContainer (resolver.m_objects[i], resolver.m_contexts[i], paths[i]));
+    }
+  return containers;
+}
+
+void
+ConfigImpl::Apply (const std::vector<Config::Batch::Operation> &operations)
+{
+  NS_LOG_FUNCTION (this << &operations);
+  std::vector<std::string> roots;
+  std::vector<std::string> leaves;
+  for (std::vector<Config::Batch::Operation>::const_iterator i = operations.begin ();
+       i != operations.end (); i++)
+    {
+      std::string root, leaf;
+      ParsePath (i->path, &root, &leaf);
+      roots.push_back (root);
+      leaves.push_back (leaf);
+    }
+  std::vector<Config::MatchContainer> containers = LookupMatches (roots);
+  for (uint32_t i = 0; i < operations.size (); i++)
+    {
+      const Config::Batch::Operation &operation = operations[i];
+      switch (operation.type)
+        {
+        case Config::Batch::SET:
+          containers[i].Set (leaves[i], *operation.value);
+          break;
+        case Config::Batch::CONNECT:
+          containers[i].Connect (leaves[i], operation.cb);
+          break;
+        case Config::Batch::CONNECT_WITHOUT_CONTEXT:
+          containers[i].ConnectWithoutContext (leaves[i], operation.cb);
+          break;
+        }
+    }
 }
 
 void 
@@ -741,6 +1032,57 @@ Config::MatchContainer LookupMatches (std::string path)
   NS_LOG_FUNCTION (path);
   return Singleton<ConfigImpl>::Get ()->LookupMatches (path);
 }
+std::vector<Config::MatchContainer> LookupMatches (const std::vector<std::string> &paths)
+{
+  NS_LOG_FUNCTION (&paths);
+  return Singleton<ConfigImpl>::Get ()->LookupMatches (paths);
+}
+
+void
+Batch::Set (std::string path, const AttributeValue &value)
+{
+  NS_LOG_FUNCTION (this << path << &value);
+  Operation operation;
+  operation.type = SET;
+  operation.path = path;
+  operation.value = value.Copy ();
+  m_operations.push_back (operation);
+}
+void
+Batch::Connect (std::string path, const CallbackBase &cb)
+{
+  NS_LOG_FUNCTION (this << path << &cb);
+  Operation operation;
+  operation.type = CONNECT;
+  operation.path = path;
+  operation.cb = cb;
+  m_operations.push_back (operation);
+}
+void
+Batch::ConnectWithoutContext (std::string path, const CallbackBase &cb)
+{
+  NS_LOG_FUNCTION (this << path << &cb);
+  Operation operation;
+  operation.type = CONNECT_WITHOUT_CONTEXT;
+  operation.path = path;
+  operation.cb = cb;
+  m_operations.push_back (operation);
+}
+uint32_t
+Batch::GetN (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_operations.size ();
+}
+void
+Batch::Apply (void)
+{
+  NS_LOG_FUNCTION (this);
+  std::vector<Operation> operations;
+  operations.swap (m_operations);
+  Singleton<ConfigImpl>::Get ()->Apply (operations);
+}
+
 
 void RegisterRootNamespaceObject (Ptr<Object> obj)
 {
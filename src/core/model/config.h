@@ -21,14 +21,15 @@
 #define CONFIG_H
 
 #include "ptr.h"
+#include "attribute.h"
+#include "callback.h"
 #include <string>
 #include <vector>
 
 namespace ns3 {
 
-class AttributeValue;
 class Object;
-class CallbackBase;
+class ConfigImpl;
 
 /**
  * \brief Configuration of simulation parameters and tracing
@@ -221,6 +222,88 @@ private:
  *          path.
  */
 MatchContainer LookupMatches (std::string path);
+/**
+ * \param paths the paths to perform a match against
+ * \returns a container for every path, which contains all the objects
+ *          which match it
+ *
+ * The paths are resolved together, in a single walk of the objects:
+ * the objects reached by the common beginning of several paths, such as
+ * /NodeList/x/DeviceList/y, are only visited once. This is much faster
+ * than looking the paths up one after the other on large topologies.
+ */
+std::vector<MatchContainer> LookupMatches (const std::vector<std::string> &paths);
+
+/**
+ * \brief a set of Config::Set and Config::Connect operations resolved together
+ *
+ * Every call to Config::Set or Config::Connect walks the objects from the
+ * root of the path. The operations of a Batch are only recorded until
+ * Apply is called, which resolves all their paths in a single walk of the
+ * objects (see LookupMatches), then performs the operations in the order
+ * they were added:
+ * \code
+ * Config::Batch batch;
+ * batch.Connect ("/NodeList/0/DeviceList/0/$ns3::WifiNetDevice/Phy/State/RxOk", MakeCallback (&RxOk));
+ * batch.Connect ("/NodeList/0/DeviceList/0/$ns3::WifiNetDevice/Phy/State/Tx", MakeCallback (&Tx));
+ * batch.Set ("/NodeList/0/DeviceList/0/Mtu", UintegerValue (1000));
+ * batch.Apply ();
+ * \endcode
+ *
+ * As all the paths are resolved first, an operation never sees the
+ * objects changed by the ones before it, such as the new object of a
+ * pointer attribute.
+ */
+class Batch
+{
+public:
+  /**
+   * \param path a path to match attributes.
+   * \param value the value to set in all matching attributes.
+   *
+   * \sa Config::Set
+   */
+  void Set (std::string path, const AttributeValue &value);
+  /**
+   * \param path a path to match trace sources.
+   * \param cb the callback to connect to the matching trace sources.
+   *
+   * \sa Config::Connect
+   */
+  void Connect (std::string path, const CallbackBase &cb);
+  /**
+   * \param path a path to match trace sources.
+   * \param cb the callback to connect to the matching trace sources.
+   *
+   * \sa Config::ConnectWithoutContext
+   */
+  void ConnectWithoutContext (std::string path, const CallbackBase &cb);
+  /**
+   * \returns the number of operations waiting for Apply
+   */
+  uint32_t GetN (void) const;
+  /**
+   * Performs the operations added so far, and removes them from the batch.
+   */
+  void Apply (void);
+
+private:
+  friend class ns3::ConfigImpl;
+  enum Type
+  {
+    SET,
+    CONNECT,
+    CONNECT_WITHOUT_CONTEXT
+  };
+  struct Operation
+  {
+    Type type;
+    std::string path;
+    Ptr<const AttributeValue> value;
+    CallbackBase cb;
+  };
+  std::vector<Operation> m_operations;
+};
 
 /**
  * \param obj a new root object
@@ -26,9 +26,14 @@
 #include "ptr.h"
 #include "pointer.h"
 #include "assert.h"
+#include "fatal-error.h"
 #include "log.h"
+#include "boolean.h"
+#include "string.h"
 
 #include <cmath>
+#include <fstream>
+#include <iostream>
 
 // Note:  Logging in this file is largely avoided due to the
 // number of calls that are made to these functions and the possibility
@@ -49,6 +54,17 @@ DefaultSimulatorImpl::GetTypeId (void)
     .AddTraceSource("CurrentTs", 
                     "Current Simulator Time", 
                     MakeTraceSourceAccessor(&DefaultSimulatorImpl::m_currentTsTrace))
+    .AddAttribute ("Profile",
+                   "Whether to profile the time spent in every kind of event.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&DefaultSimulatorImpl::m_profile),
+                   MakeBooleanChecker ())
+    .AddAttribute ("ProfileFile",
+                   "The file the profile is written to by Simulator::Destroy, "
+                   "the standard error if empty.",
+                   StringValue (""),
+                   MakeStringAccessor (&DefaultSimulatorImpl::m_profileFile),
+                   MakeStringChecker ())
   ;
   return tid;
 }
@@ -68,8 +84,8 @@ DefaultSimulatorImpl::DefaultSimulatorImpl ()
   m_currentTsTrace = 0;
   m_currentContext = 0xffffffff;
   m_unscheduledEvents = 0;
-  m_eventsWithContextEmpty = true;
   m_main = SystemThread::Self();
+  m_profiler = 0;
 }
 
 DefaultSimulatorImpl::~DefaultSimulatorImpl ()
@@ -86,7 +102,17 @@ DefaultSimulatorImpl::DoDispose (void)
       Scheduler::Event next = m_events->RemoveNext ();
       next.impl->Unref ();
     }
+  EventWithContext *event = m_eventsWithContext.PopAll ();
+  while (event != 0)
+    {
+      event->event->Unref ();
+      EventWithContext *next = event->next;
+      delete event;
+      event = next;
+    }
   m_events = 0;
+  delete m_profiler;
+  m_profiler = 0;
   SimulatorImpl::DoDispose ();
 }
 void
@@ -103,6 +129,24 @@ DefaultSimulatorImpl::Destroy ()
           ev->Invoke ();
         }
     }
+  if (m_profiler != 0)
+    {
+      if (m_profileFile.empty ())
+        {
+          m_profiler->Print (std::cerr);
+        }
+      else
+        {
+          std::ofstream os (m_profileFile.c_str ());
+          if (!os.is_open ())
+            {
+              NS_FATAL_ERROR ("Could not open " << m_profileFile);
+            }
+          m_profiler->Print (os);
+        }
+      delete m_profiler;
+      m_profiler = 0;
+    }
 }
 
 void
@@ -143,7 +187,16 @@ DefaultSimulatorImpl::ProcessOneEvent (void)
   m_currentTsTrace = m_currentTs;
   m_currentContext = next.key.m_context;
   m_currentUid = next.key.m_uid;
-  next.impl->Invoke ();
+  if (m_profiler == 0)
+    {
+      next.impl->Invoke ();
+    }
+  else
+    {
+      uint64_t start = EventProfiler::GetTicks ();
+      next.impl->Invoke ();
+      m_profiler->Record (next.impl, next.key.m_context, start);
+    }
   next.impl->Unref ();
 
   ProcessEventsWithContext ();
@@ -158,30 +211,25 @@ DefaultSimulatorImpl::IsFinished (void) const
 void
 DefaultSimulatorImpl::ProcessEventsWithContext (void)
 {
-  if (m_eventsWithContextEmpty)
+  if (m_eventsWithContext.IsEmpty ())
     {
       return;
     }
 
-  // swap queues
-  EventsWithContext eventsWithContext;
-  {
-    CriticalSection cs (m_eventsWithContextMutex);
-    m_eventsWithContext.swap(eventsWithContext);
-    m_eventsWithContextEmpty = true;
-  }
-  while (!eventsWithContext.empty ())
+  EventWithContext *event = m_eventsWithContext.PopAll ();
+  while (event != 0)
     {
-       EventWithContext event = eventsWithContext.front ();
-       eventsWithContext.pop_front ();
        Scheduler::Event ev;
-       ev.impl = event.event;
-       ev.key.m_ts = m_currentTs + event.timestamp;
-       ev.key.m_context = event.context;
+       ev.impl = event->event;
+       ev.key.m_ts = m_currentTs + event->timestamp;
+       ev.key.m_context = event->context;
        ev.key.m_uid = m_uid;
        m_uid++;
        m_unscheduledEvents++;
        m_events->Insert (ev);
+       EventWithContext *next = event->next;
+       delete event;
+       event = next;
     }
 }
 
@@ -193,6 +241,10 @@ DefaultSimulatorImpl::Run (void)
   m_main = SystemThread::Self();
   ProcessEventsWithContext ();
   m_stop = false;
+  if (m_profile && m_profiler == 0)
+    {
+      m_profiler = new EventProfiler ();
+    }
 
   while (!m_events->IsEmpty () && !m_stop) 
     {
@@ -261,15 +313,11 @@ DefaultSimulatorImpl::ScheduleWithContext (uint32_t context, Time const &time, E
     }
   else
     {
-      EventWithContext ev;
-      ev.context = context;
-      ev.timestamp = time.GetTimeStep ();
-      ev.event = event;
-      {
-        CriticalSection cs (m_eventsWithContextMutex);
-        m_eventsWithContext.push_back(ev);
-        m_eventsWithContextEmpty = false;
-      }
+      EventWithContext *ev = new EventWithContext;
+      ev->context = context;
+      ev->timestamp = time.GetTimeStep ();
+      ev->event = event;
+      m_eventsWithContext.Push (ev);
     }
 }
 
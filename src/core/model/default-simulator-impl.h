@@ -25,7 +25,8 @@
 #include "scheduler.h"
 #include "event-impl.h"
 #include "system-thread.h"
-#include "ns3/system-mutex.h"
+#include "mpsc-queue.h"
+#include "event-profiler.h"
 
 #include "ptr.h"
 #include "traced-value.h"
@@ -36,6 +37,11 @@ namespace ns3 {
 
 /**
  * \ingroup simulator
+ *
+ * When the Profile attribute is set, the wall clock time spent in every
+ * event is accounted for by an EventProfiler, and the profile is written
+ * by Simulator::Destroy. Otherwise, events only pay for the test of a
+ * null pointer.
  */
 class DefaultSimulatorImpl : public SimulatorImpl
 {
@@ -70,14 +76,13 @@ private:
   void ProcessEventsWithContext (void);
  
   struct EventWithContext {
+    EventWithContext *next;
     uint32_t context;
     uint64_t timestamp;
     EventImpl *event;
   };
-  typedef std::list<struct EventWithContext> EventsWithContext;
-  EventsWithContext m_eventsWithContext;
-  bool m_eventsWithContextEmpty;
-  SystemMutex m_eventsWithContextMutex;
+  // events scheduled from other threads
+  MpscQueue<EventWithContext> m_eventsWithContext;
 
   typedef std::list<EventId> DestroyEvents;
   DestroyEvents m_destroyEvents;
@@ -94,6 +99,11 @@ private:
   int m_unscheduledEvents;
 
   SystemThread::ThreadId m_main;
+
+  bool m_profile;
+  std::string m_profileFile;
+  // 0 unless profiling
+  EventProfiler *m_profiler;
 };
 
 } // namespace ns3
@@ -19,12 +19,29 @@
  */
 
 #include "event-impl.h"
+#include "slab-allocator.h"
 #include "log.h"
 
 NS_LOG_COMPONENT_DEFINE ("EventImpl");
 
 namespace ns3 {
 
+void *
+EventImpl::operator new (size_t size)
+{
+  return SlabAllocator::Allocate (size);
+}
+
+void
+EventImpl::operator delete (void *p, size_t size)
+{
+  if (p == 0)
+    {
+      return;
+    }
+  SlabAllocator::Deallocate (p, size);
+}
+
 EventImpl::~EventImpl ()
 {
   NS_LOG_FUNCTION (this);
@@ -60,4 +77,10 @@ EventImpl::IsCancelled (void)
   return m_cancel;
 }
 
+const void *
+EventImpl::GetFunction (void) const
+{
+  return 0;
+}
+
 } // namespace ns3
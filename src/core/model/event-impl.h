@@ -21,6 +21,8 @@
 #define EVENT_IMPL_H
 
 #include <stdint.h>
+#include <cstddef>
+#include <cstring>
 #include "simple-ref-count.h"
 
 namespace ns3 {
@@ -35,6 +37,10 @@ namespace ns3 {
  * obviously (there are Ref and Unref methods) reference-counted and
  * most subclasses are usually created by one of the many Simulator::Schedule
  * methods.
+ *
+ * Events are allocated by the SlabAllocator, from per-thread free lists
+ * of size-classed blocks, so that the threads which create and delete
+ * events do not contend for the global allocator.
  */
 class EventImpl : public SimpleRefCount<EventImpl>
 {
@@ -57,14 +63,52 @@ public:
    * Invoked by the simulation engine before calling Invoke.
    */
   bool IsCancelled (void);
+  /**
+   * \returns the address of the function called by this event, 0 if it
+   * is not known
+   *
+   * Only used to name the events in profiles, see EventProfiler.
+   */
+  virtual const void *GetFunction (void) const;
+
+  /**
+   * \param size the size of the event
+   * \returns a block of the SlabAllocator for that size
+   */
+  static void *operator new (size_t size);
+  /**
+   * \param p the event to free
+   * \param size the size of the event, which selects its size class
+   */
+  static void operator delete (void *p, size_t size);
 
 protected:
   virtual void Notify (void) = 0;
+  /**
+   * \param function a pointer to a function or to a member function
+   * \returns the first word of \p function: the address of its code, or
+   * the offset of its entry in the virtual table for a virtual member
+   * function with the Itanium C++ ABI
+   */
+  template <typename T>
+  static const void *GetAddress (T function);
 
 private:
   bool m_cancel;
 };
 
+template <typename T>
+const void *
+EventImpl::GetAddress (T function)
+{
+  const void *address = 0;
+  if (sizeof (function) >= sizeof (address))
+    {
+      std::memcpy (&address, &function, sizeof (address));
+    }
+  return address;
+}
+
 } // namespace ns3
 
 #endif /* EVENT_IMPL_H */
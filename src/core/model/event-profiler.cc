@@ -0,0 +1,285 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "event-profiler.h"
+#include "event-impl.h"
+#include "log.h"
+#include "ns3/core-config.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#ifdef HAVE_DLADDR
+#include <dlfcn.h>
+#endif
+#ifdef __GNUC__
+#include <cxxabi.h>
+#endif
+
+NS_LOG_COMPONENT_DEFINE ("EventProfiler");
+
+namespace ns3 {
+
+namespace {
+
+struct MoreTicks
+{
+  template <typename T>
+  bool operator () (const T &a, const T &b) const
+  {
+    return a.ticks > b.ticks;
+  }
+};
+
+std::string
+Demangle (const char *name)
+{
+#ifdef __GNUC__
+  int status;
+  char *demangled = abi::__cxa_demangle (name, 0, 0, &status);
+  if (status == 0 && demangled != 0)
+    {
+      std::string result = demangled;
+      std::free (demangled);
+      return result;
+    }
+#endif
+  return name;
+}
+
+} // anonymous namespace
+
+EventProfiler::EventProfiler ()
+  : m_entries (1024),
+    m_nEntries (0)
+{
+  NS_LOG_FUNCTION (this);
+  for (uint32_t i = 0; i < m_entries.size (); i++)
+    {
+      m_entries[i].type = 0;
+    }
+  m_startTicks = GetTicks ();
+  gettimeofday (&m_startTime, 0);
+}
+
+EventProfiler::~EventProfiler ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+uint32_t
+EventProfiler::Hash (const std::type_info *type, const void *function, uint32_t context)
+{
+  uint64_t h = (uint64_t)(uintptr_t)type ^ ((uint64_t)(uintptr_t)function << 7) ^ context;
+  h *= 0x9e3779b97f4a7c15ULL;
+  return h >> 32;
+}
+
+void
+EventProfiler::Record (const EventImpl *event, uint32_t context, uint64_t start)
+{
+  uint64_t ticks = GetTicks () - start;
+  const std::type_info *type = &typeid (*event);
+  const void *function = event->GetFunction ();
+  uint32_t mask = m_entries.size () - 1;
+  for (uint32_t i = Hash (type, function, context) & mask;; i = (i + 1) & mask)
+    {
+      Entry &entry = m_entries[i];
+      if (entry.type == type && entry.function == function && entry.context == context)
+        {
+          entry.count++;
+          entry.ticks += ticks;
+          return;
+        }
+      if (entry.type == 0)
+        {
+          entry.type = type;
+          entry.function = function;
+          entry.context = context;
+          entry.count = 1;
+          entry.ticks = ticks;
+          m_nEntries++;
+          if (m_nEntries * 2 > m_entries.size ())
+            {
+              Grow ();
+            }
+          return;
+        }
+    }
+}
+
+void
+EventProfiler::Grow (void)
+{
+  NS_LOG_FUNCTION (this << m_entries.size ());
+  std::vector<Entry> entries (m_entries.size () * 2);
+  for (uint32_t i = 0; i < entries.size (); i++)
+    {
+      entries[i].type = 0;
+    }
+  uint32_t mask = entries.size () - 1;
+  for (uint32_t i = 0; i < m_entries.size (); i++)
+    {
+      const Entry &entry = m_entries[i];
+      if (entry.type == 0)
+        {
+          continue;
+        }
+      uint32_t j = Hash (entry.type, entry.function, entry.context) & mask;
+      while (entries[j].type != 0)
+        {
+          j = (j + 1) & mask;
+        }
+      entries[j] = entry;
+    }
+  m_entries.swap (entries);
+}
+
+std::string
+EventProfiler::GetName (const std::type_info *type, const void *function)
+{
+#ifdef HAVE_DLADDR
+  // odd values are offsets in the virtual table
+  if (function != 0 && ((uintptr_t)function & 1) == 0)
+    {
+      Dl_info info;
+      if (dladdr (function, &info) != 0 && info.dli_sname != 0)
+        {
+          return Demangle (info.dli_sname);
+        }
+    }
+#endif
+  std::string name = Demangle (type->name ());
+  if (((uintptr_t)function & 1) != 0)
+    {
+      // the closure only tells the class and the signature, the slot tells
+      // apart the virtual functions that share them
+      std::ostringstream slot;
+      slot << " [virtual " << ((uintptr_t)function - 1) / sizeof (void *) << "]";
+      name += slot.str ();
+    }
+  return name;
+}
+
+void
+EventProfiler::PrintLines (std::ostream &os, std::vector<Line> &lines, uint64_t total, double nsPerTick) const
+{
+  std::sort (lines.begin (), lines.end (), MoreTicks ());
+  for (std::vector<Line>::const_iterator i = lines.begin (); i != lines.end (); i++)
+    {
+      os << std::setw (6) << std::fixed << std::setprecision (2)
+         << (total == 0 ? 0.0 : 100.0 * i->ticks / total) << "% "
+         << std::setw (12) << std::setprecision (3) << i->ticks * nsPerTick / 1e9 << "s "
+         << std::setw (12) << i->count << " "
+         << std::setw (10) << std::setprecision (0) << i->ticks * nsPerTick / i->count << "ns  "
+         << i->name << std::endl;
+    }
+}
+
+void
+EventProfiler::Print (std::ostream &os) const
+{
+  NS_LOG_FUNCTION (this);
+  struct timeval now;
+  gettimeofday (&now, 0);
+  uint64_t ticks = GetTicks () - m_startTicks;
+  double elapsedNs = (now.tv_sec - m_startTime.tv_sec) * 1e9 + (now.tv_usec - m_startTime.tv_usec) * 1e3;
+  double nsPerTick = ticks == 0 ? 0 : elapsedNs / ticks;
+
+  // the same function may be called by events of several classes
+  std::map<std::pair<const std::type_info *, const void *>, std::string> names;
+  std::map<std::string, Line> flat;
+  std::map<uint32_t, std::vector<Line> > nodes;
+  std::map<uint32_t, Line> nodeTotals;
+  uint64_t total = 0;
+  for (uint32_t i = 0; i < m_entries.size (); i++)
+    {
+      const Entry &entry = m_entries[i];
+      if (entry.type == 0)
+        {
+          continue;
+        }
+      std::pair<const std::type_info *, const void *> key (entry.type, entry.function);
+      if (names.find (key) == names.end ())
+        {
+          names[key] = GetName (entry.type, entry.function);
+        }
+      Line line;
+      line.name = names[key];
+      line.context = entry.context;
+      line.count = entry.count;
+      line.ticks = entry.ticks;
+      total += entry.ticks;
+
+      std::map<std::string, Line>::iterator f = flat.find (line.name);
+      if (f == flat.end ())
+        {
+          flat[line.name] = line;
+        }
+      else
+        {
+          f->second.count += line.count;
+          f->second.ticks += line.ticks;
+        }
+      nodes[entry.context].push_back (line);
+      std::map<uint32_t, Line>::iterator n = nodeTotals.find (entry.context);
+      if (n == nodeTotals.end ())
+        {
+          nodeTotals[entry.context] = line;
+        }
+      else
+        {
+          n->second.count += line.count;
+          n->second.ticks += line.ticks;
+        }
+    }
+
+  os << "Flat profile:" << std::endl
+     << "  time    seconds        calls   per call  function" << std::endl;
+  std::vector<Line> lines;
+  for (std::map<std::string, Line>::const_iterator i = flat.begin (); i != flat.end (); i++)
+    {
+      lines.push_back (i->second);
+    }
+  PrintLines (os, lines, total, nsPerTick);
+
+  lines.clear ();
+  for (std::map<uint32_t, Line>::iterator i = nodeTotals.begin (); i != nodeTotals.end (); i++)
+    {
+      i->second.context = i->first;
+      lines.push_back (i->second);
+    }
+  std::sort (lines.begin (), lines.end (), MoreTicks ());
+  for (std::vector<Line>::const_iterator i = lines.begin (); i != lines.end (); i++)
+    {
+      os << std::endl;
+      if (i->context == 0xffffffff)
+        {
+          os << "No node:";
+        }
+      else
+        {
+          os << "Node " << i->context << ":";
+        }
+      os << " " << std::fixed << std::setprecision (3) << i->ticks * nsPerTick / 1e9
+         << "s, " << i->count << " events" << std::endl;
+      PrintLines (os, nodes[i->context], total, nsPerTick);
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,130 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef EVENT_PROFILER_H
+#define EVENT_PROFILER_H
+
+#include <stdint.h>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <typeinfo>
+#include <sys/time.h>
+
+namespace ns3 {
+
+class EventImpl;
+
+/**
+ * \ingroup simulator
+ * \brief Accumulates the wall clock time spent in every kind of event
+ *
+ * The time and the number of calls of the events are accumulated for
+ * every (event class, function, context) triple: the event class is the
+ * closure created by MakeEvent, the function is the one it calls (see
+ * EventImpl::GetFunction) and the context is the node the event runs
+ * on.  Print writes a flat profile, one line per function over all the
+ * nodes, followed by the profile of every node.
+ *
+ * The functions are named from the dynamic symbol table when it exports
+ * them (built with -rdynamic for the functions of the main program),
+ * and from the name of the event class otherwise.  An event bound to a
+ * virtual member function only knows the slot of the function in the
+ * virtual table, not its address: it is named after its event class,
+ * which tells the class and the signature of the function, followed by
+ * the slot, e.g. "[virtual 2]".  The override actually called is not
+ * known, the events of all the overrides of a function share a line.
+ *
+ * The time is measured with the time stamp counter on x86, and with
+ * gettimeofday elsewhere.
+ */
+class EventProfiler
+{
+public:
+  EventProfiler ();
+  ~EventProfiler ();
+
+  /**
+   * \returns the current value of the clock, in an unspecified unit
+   */
+  static inline uint64_t GetTicks (void);
+
+  /**
+   * Accounts for an event which has just run
+   *
+   * \param event the event
+   * \param context the context the event ran in
+   * \param start the value of GetTicks before the event ran
+   */
+  void Record (const EventImpl *event, uint32_t context, uint64_t start);
+
+  /**
+   * Writes the profile accumulated so far
+   *
+   * \param os the output stream
+   */
+  void Print (std::ostream &os) const;
+
+private:
+  struct Entry
+  {
+    // 0 if the entry is free
+    const std::type_info *type;
+    const void *function;
+    uint32_t context;
+    uint64_t count;
+    uint64_t ticks;
+  };
+  struct Line
+  {
+    std::string name;
+    uint32_t context;
+    uint64_t count;
+    uint64_t ticks;
+  };
+
+  static uint32_t Hash (const std::type_info *type, const void *function, uint32_t context);
+  static std::string GetName (const std::type_info *type, const void *function);
+  void Grow (void);
+  void PrintLines (std::ostream &os, std::vector<Line> &lines, uint64_t total, double nsPerTick) const;
+
+  // open addressing hash table, the size is a power of two
+  std::vector<Entry> m_entries;
+  uint32_t m_nEntries;
+  // to convert ticks to seconds
+  uint64_t m_startTicks;
+  struct timeval m_startTime;
+};
+
+} // namespace ns3
+
+namespace ns3 {
+
+uint64_t
+EventProfiler::GetTicks (void)
+{
+#if defined (__i386__) || defined (__x86_64__)
+  return __builtin_ia32_rdtsc ();
+#else
+  struct timeval tv;
+  gettimeofday (&tv, 0);
+  return tv.tv_sec * 1000000ULL + tv.tv_usec;
+#endif
+}
+
+} // namespace ns3
+
+#endif /* EVENT_PROFILER_H */
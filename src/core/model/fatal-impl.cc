@@ -64,6 +64,12 @@ std::list<std::ostream*> *GetStreamList (void)
     }
   return *pstreams;
 }
+std::list<void (*)(void)> **PeekFlushList (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  static std::list<void (*)(void)> *flushes = 0;
+  return &flushes;
+}
 struct destructor
 {
   ~destructor ()
@@ -83,6 +89,18 @@ RegisterStream (std::ostream* stream)
   GetStreamList ()->push_back (stream);
 }
 
+void
+RegisterFlush (void (*flush)(void))
+{
+  NS_LOG_FUNCTION (flush);
+  std::list<void (*)(void)> **pl = PeekFlushList ();
+  if (*pl == 0)
+    {
+      *pl = new std::list<void (*)(void)> ();
+    }
+  (*pl)->push_back (flush);
+}
+
 void
 UnregisterStream (std::ostream* stream)
 {
@@ -102,18 +120,39 @@ UnregisterStream (std::ostream* stream)
 
 
 namespace {
+void FlushStreamList (void);
+
 /* Overrides normal SIGSEGV handler once the
  * HandleTerminate function is run. */
 void sigHandler (int sig)
 {
   NS_LOG_FUNCTION (sig);
-  FlushStreams ();
+  // the binary log is not written from here, it needs to allocate
+  FlushStreamList ();
   std::abort ();
 }
 }
 
 void 
 FlushStreams (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  // the recorded messages tell what led to the error
+  LogDisableBinary ();
+  std::list<void (*)(void)> **pl = PeekFlushList ();
+  if (*pl != 0)
+    {
+      for (std::list<void (*)(void)>::iterator i = (*pl)->begin (); i != (*pl)->end (); ++i)
+        {
+          (*i)();
+        }
+    }
+  FlushStreamList ();
+}
+
+namespace {
+void
+FlushStreamList (void)
 {
   NS_LOG_FUNCTION_NOARGS ();
   std::list<std::ostream*> **pl = PeekStreamList ();
@@ -156,6 +195,7 @@ FlushStreams (void)
   delete l;
   *pl = 0;
 }
+}
 
 } //FatalImpl
 } //ns3
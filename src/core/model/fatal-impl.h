@@ -73,6 +73,20 @@ void RegisterStream (std::ostream* stream);
  */
 void UnregisterStream (std::ostream* stream);
 
+/**
+ * \ingroup fatalHandler
+ * \param flush The function to be called on abnormal exit.
+ *
+ * \brief Register a function to hand buffered data over to the
+ * streams on abnormal exit.
+ *
+ * FlushStreams calls the functions registered, in the order they were
+ * registered, before it flushes the streams, so that data kept away
+ * from a stream, like the records queued for a background writer,
+ * reaches it.  A function stays registered until the program exits.
+ */
+void RegisterFlush (void (*flush)(void));
+
 /**
  * \ingroup fatalHandler
  *
@@ -89,6 +103,10 @@ void UnregisterStream (std::ostream* stream);
  * skip the bad ostream* and continue to flush the next stram.
  * The function will then terminate raising SIGIOT (aka SIGABRT)
  *
+ * The messages recorded by ns3::LogEnableBinary are written first,
+ * then the functions registered with RegisterFlush are called, but
+ * neither from the SIGSEGV handler, which only flushes the streams.
+ *
  * DO NOT call this function until the program is ready to crash.
  */
 void FlushStreams (void);
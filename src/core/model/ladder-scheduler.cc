@@ -0,0 +1,391 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ladder-scheduler.h"
+#include "event-impl.h"
+#include "assert.h"
+#include "log.h"
+#include <algorithm>
+
+NS_LOG_COMPONENT_DEFINE ("LadderScheduler");
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED (LadderScheduler);
+
+// end of a list of nodes
+static const uint32_t NIL = 0xffffffff;
+
+TypeId
+LadderScheduler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::LadderScheduler")
+    .SetParent<Scheduler> ()
+    .AddConstructor<LadderScheduler> ()
+  ;
+  return tid;
+}
+
+LadderScheduler::LadderScheduler ()
+  : m_freeNodes (NIL),
+    m_top (NIL),
+    m_topCount (0),
+    m_topMin (~(uint64_t)0),
+    m_topMax (0),
+    m_topStart (0),
+    m_topShift (32),
+    m_nRungs (0),
+    m_bottomHead (0),
+    m_size (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+LadderScheduler::~LadderScheduler ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+uint32_t
+LadderScheduler::AllocateNode (const Event &ev)
+{
+  uint32_t node = m_freeNodes;
+  if (node != NIL)
+    {
+      m_freeNodes = m_nodes[node].next;
+    }
+  else
+    {
+      node = m_nodes.size ();
+      m_nodes.push_back (Node ());
+    }
+  m_nodes[node].ev = ev;
+  m_nodes[node].removed = false;
+  return node;
+}
+
+void
+LadderScheduler::FreeNode (uint32_t node)
+{
+  m_nodes[node].next = m_freeNodes;
+  m_freeNodes = node;
+}
+
+uint64_t
+LadderScheduler::GetCurrentStart (const Rung &rung) const
+{
+  return rung.start + rung.current * rung.width;
+}
+
+void
+LadderScheduler::InitRung (Rung &rung, uint64_t start, uint64_t span, uint32_t count)
+{
+  NS_LOG_FUNCTION (this << start << span << count);
+  NS_ASSERT (span > 0 && count > 0);
+  // about one event per bucket, the buckets must cover the whole span
+  uint64_t nBuckets = std::min (span, (uint64_t)count);
+  rung.width = (span + nBuckets - 1) / nBuckets;
+  nBuckets = (span + rung.width - 1) / rung.width;
+  rung.buckets.assign (nBuckets, NIL);
+  rung.start = start;
+  rung.current = 0;
+  rung.count = 0;
+}
+
+void
+LadderScheduler::InsertInRung (Rung &rung, uint32_t node)
+{
+  uint64_t bucket = (m_nodes[node].ev.key.m_ts - rung.start) / rung.width;
+  NS_ASSERT (bucket >= rung.current && bucket < rung.buckets.size ());
+  m_nodes[node].next = rung.buckets[bucket];
+  rung.buckets[bucket] = node;
+  rung.count++;
+}
+
+void
+LadderScheduler::InsertInBottom (const Event &ev)
+{
+  std::vector<Event>::iterator i = std::upper_bound (m_bottom.begin () + m_bottomHead,
+                                                     m_bottom.end (), ev);
+  m_bottom.insert (i, ev);
+}
+
+uint32_t
+LadderScheduler::GetTopBucket (uint32_t uid) const
+{
+  // the uids of a partition of a parallel simulator share their low bits
+  return (uid * 2654435761U) >> m_topShift;
+}
+
+void
+LadderScheduler::GrowTopIndex (void)
+{
+  NS_LOG_FUNCTION (this << m_topCount);
+  if (m_topIndex.empty ())
+    {
+      m_topIndex.assign (64, NIL);
+      m_topShift = 32 - 6;
+    }
+  else
+    {
+      m_topIndex.assign (2 * m_topIndex.size (), NIL);
+      m_topShift--;
+    }
+  for (uint32_t node = m_top; node != NIL; node = m_nodes[node].next)
+    {
+      uint32_t &bucket = m_topIndex[GetTopBucket (m_nodes[node].ev.key.m_uid)];
+      m_nodes[node].hashNext = bucket;
+      bucket = node;
+    }
+}
+
+void
+LadderScheduler::Insert (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.key.m_ts << ev.key.m_uid);
+  m_size++;
+  uint64_t ts = ev.key.m_ts;
+  if (ts >= m_topStart)
+    {
+      if (m_topCount >= m_topIndex.size ())
+        {
+          GrowTopIndex ();
+        }
+      uint32_t node = AllocateNode (ev);
+      m_nodes[node].next = m_top;
+      m_top = node;
+      m_topCount++;
+      uint32_t &bucket = m_topIndex[GetTopBucket (ev.key.m_uid)];
+      m_nodes[node].hashNext = bucket;
+      bucket = node;
+      m_topMin = std::min (m_topMin, ts);
+      m_topMax = std::max (m_topMax, ts);
+      return;
+    }
+  for (uint32_t i = 0; i < m_nRungs; i++)
+    {
+      if (ts >= GetCurrentStart (m_rungs[i]))
+        {
+          InsertInRung (m_rungs[i], AllocateNode (ev));
+          return;
+        }
+    }
+  InsertInBottom (ev);
+  if (m_bottom.size () - m_bottomHead > THRESHOLD && m_nRungs < MAX_RUNGS)
+    {
+      SpawnFromBottom ();
+    }
+}
+
+void
+LadderScheduler::TransferTop (void)
+{
+  NS_LOG_FUNCTION (this << m_topCount << m_topMin << m_topMax);
+  NS_ASSERT (m_nRungs == 0 && m_topCount > 0);
+  Rung &rung = m_rungs[0];
+  InitRung (rung, m_topMin, m_topMax - m_topMin + 1, m_topCount);
+  m_nRungs = 1;
+  m_topStart = rung.start + rung.buckets.size () * rung.width;
+
+  uint32_t node = m_top;
+  while (node != NIL)
+    {
+      uint32_t next = m_nodes[node].next;
+      m_topIndex[GetTopBucket (m_nodes[node].ev.key.m_uid)] = NIL;
+      if (m_nodes[node].removed)
+        {
+          FreeNode (node);
+        }
+      else
+        {
+          InsertInRung (rung, node);
+        }
+      node = next;
+    }
+  m_top = NIL;
+  m_topCount = 0;
+  m_topMin = ~(uint64_t)0;
+  m_topMax = 0;
+}
+
+void
+LadderScheduler::SpawnFromBottom (void)
+{
+  NS_LOG_FUNCTION (this);
+  uint64_t first = m_bottom[m_bottomHead].key.m_ts;
+  if (first == m_bottom.back ().key.m_ts)
+    {
+      // the events cannot be spread
+      return;
+    }
+  // the new rung covers everything up to the lowest rung
+  uint64_t end = m_nRungs == 0 ? m_topStart : GetCurrentStart (m_rungs[m_nRungs - 1]);
+  NS_ASSERT (m_bottom.back ().key.m_ts < end);
+  Rung &rung = m_rungs[m_nRungs];
+  InitRung (rung, first, end - first, m_bottom.size () - m_bottomHead);
+  m_nRungs++;
+  for (uint32_t i = m_bottomHead; i < m_bottom.size (); i++)
+    {
+      InsertInRung (rung, AllocateNode (m_bottom[i]));
+    }
+  m_bottom.clear ();
+  m_bottomHead = 0;
+}
+
+void
+LadderScheduler::FillBottom (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (m_size > 0);
+  while (m_bottomHead == m_bottom.size ())
+    {
+      m_bottom.clear ();
+      m_bottomHead = 0;
+      if (m_nRungs == 0)
+        {
+          TransferTop ();
+          continue;
+        }
+      Rung &rung = m_rungs[m_nRungs - 1];
+      if (rung.count == 0)
+        {
+          m_nRungs--;
+          continue;
+        }
+      while (rung.buckets[rung.current] == NIL)
+        {
+          rung.current++;
+        }
+      uint64_t bucketStart = GetCurrentStart (rung);
+      uint32_t head = rung.buckets[rung.current];
+      uint32_t count = 0;
+      for (uint32_t node = head; node != NIL; node = m_nodes[node].next)
+        {
+          count++;
+        }
+      rung.buckets[rung.current] = NIL;
+      rung.current++;
+      rung.count -= count;
+
+      if (count > THRESHOLD && rung.width > 1 && m_nRungs < MAX_RUNGS)
+        {
+          // too many events to sort, spread them over a finer rung
+          Rung &child = m_rungs[m_nRungs];
+          InitRung (child, bucketStart, rung.width, count);
+          m_nRungs++;
+          uint32_t node = head;
+          while (node != NIL)
+            {
+              uint32_t next = m_nodes[node].next;
+              InsertInRung (child, node);
+              node = next;
+            }
+          continue;
+        }
+
+      uint32_t node = head;
+      while (node != NIL)
+        {
+          m_bottom.push_back (m_nodes[node].ev);
+          uint32_t next = m_nodes[node].next;
+          FreeNode (node);
+          node = next;
+        }
+      std::sort (m_bottom.begin (), m_bottom.end ());
+    }
+}
+
+bool
+LadderScheduler::IsEmpty (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_size == 0;
+}
+
+Scheduler::Event
+LadderScheduler::PeekNext (void) const
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!IsEmpty ());
+  // refilling bottom moves events between the tiers but does not change
+  // the set of events held by the scheduler
+  const_cast<LadderScheduler *> (this)->FillBottom ();
+  return m_bottom[m_bottomHead];
+}
+
+Scheduler::Event
+LadderScheduler::RemoveNext (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!IsEmpty ());
+  FillBottom ();
+  Event ev = m_bottom[m_bottomHead];
+  m_bottomHead++;
+  m_size--;
+  NS_LOG_LOGIC ("remove ts=" << ev.key.m_ts << ", uid=" << ev.key.m_uid);
+  return ev;
+}
+
+void
+LadderScheduler::Remove (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.key.m_ts << ev.key.m_uid);
+  NS_ASSERT (!IsEmpty ());
+  m_size--;
+  uint64_t ts = ev.key.m_ts;
+  if (ts >= m_topStart)
+    {
+      // dropped when top is transferred to the ladder
+      NS_ASSERT (m_topCount > 0);
+      uint32_t node = m_topIndex[GetTopBucket (ev.key.m_uid)];
+      while (m_nodes[node].ev.key.m_uid != ev.key.m_uid || m_nodes[node].removed)
+        {
+          node = m_nodes[node].hashNext;
+          NS_ASSERT (node != NIL);
+        }
+      NS_ASSERT (m_nodes[node].ev.impl == ev.impl);
+      m_nodes[node].removed = true;
+      return;
+    }
+  for (uint32_t i = 0; i < m_nRungs; i++)
+    {
+      Rung &rung = m_rungs[i];
+      if (ts >= GetCurrentStart (rung))
+        {
+          uint32_t *prev = &rung.buckets[(ts - rung.start) / rung.width];
+          while (*prev != NIL)
+            {
+              uint32_t node = *prev;
+              if (m_nodes[node].ev.key.m_uid == ev.key.m_uid)
+                {
+                  NS_ASSERT (m_nodes[node].ev.impl == ev.impl);
+                  *prev = m_nodes[node].next;
+                  FreeNode (node);
+                  rung.count--;
+                  return;
+                }
+              prev = &m_nodes[node].next;
+            }
+          NS_ASSERT (false);
+        }
+    }
+  std::vector<Event>::iterator i = std::lower_bound (m_bottom.begin () + m_bottomHead,
+                                                     m_bottom.end (), ev);
+  NS_ASSERT (i != m_bottom.end () && i->key.m_uid == ev.key.m_uid);
+  m_bottom.erase (i);
+}
+
+} // namespace ns3
@@ -0,0 +1,143 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LADDER_SCHEDULER_H
+#define LADDER_SCHEDULER_H
+
+#include "scheduler.h"
+#include <stdint.h>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup scheduler
+ * \brief a ladder queue event scheduler
+ *
+ * This event scheduler implements the ladder queue described in "Ladder
+ * Queue: An O(1) Priority Queue Structure for Large-Scale Discrete Event
+ * Simulation" by Wee Tang, Rick Goh and Ian Thng (ACM TOMACS, 2005).
+ *
+ * Events are kept in three tiers:
+ *  - Top: an unsorted list of the events of the far future, every event at
+ *    or after a threshold is appended to it in constant time.
+ *  - Ladder: up to 8 rungs of buckets. When everything below Top has been
+ *    consumed, Top is spread over the buckets of the first rung, whose
+ *    width is chosen from the span and the number of events. A bucket
+ *    holding too many events to be sorted cheaply is spread in turn over a
+ *    finer rung, instead of resizing the whole structure as the calendar
+ *    queue does.
+ *  - Bottom: the events of the current bucket, sorted. Events are removed
+ *    from there.
+ *
+ * Events are only sorted once they reach Bottom, in small batches, which
+ * makes insertion and removal O(1) amortized for the usual distributions.
+ * Events sharing a timestamp are always sorted together and ordered by
+ * uid, as required by Scheduler::EventKey.
+ *
+ * The events of every tier are nodes of a single pool linked by index, so
+ * that moving events between tiers never allocates. Removing an event of
+ * the Ladder or of Bottom locates its bucket from its timestamp; removing
+ * an event of Top finds its node through a hash of the uids of Top and
+ * only marks it, the node is dropped when Top is spread over the first
+ * rung.
+ */
+class LadderScheduler : public Scheduler
+{
+public:
+  static TypeId GetTypeId (void);
+
+  LadderScheduler ();
+  virtual ~LadderScheduler ();
+
+  virtual void Insert (const Event &ev);
+  virtual bool IsEmpty (void) const;
+  virtual Event PeekNext (void) const;
+  virtual Event RemoveNext (void);
+  virtual void Remove (const Event &ev);
+
+private:
+  enum
+  {
+    // maximum number of rungs of the ladder
+    MAX_RUNGS = 8,
+    // a bucket holding more events than this is spread over a new rung
+    // rather than sorted into bottom
+    THRESHOLD = 50
+  };
+
+  struct Node
+  {
+    Event ev;
+    uint32_t next;
+    // next node of the same bucket of the hash of top
+    uint32_t hashNext;
+    // removed while in top
+    bool removed;
+  };
+
+  struct Rung
+  {
+    // first event of every bucket
+    std::vector<uint32_t> buckets;
+    // timestamp of the start of the first bucket
+    uint64_t start;
+    uint64_t width;
+    // current bucket, the buckets before it are empty
+    uint32_t current;
+    // number of events in the rung
+    uint32_t count;
+  };
+
+  uint32_t AllocateNode (const Event &ev);
+  void FreeNode (uint32_t node);
+  inline uint64_t GetCurrentStart (const Rung &rung) const;
+  void InitRung (Rung &rung, uint64_t start, uint64_t span, uint32_t count);
+  void InsertInRung (Rung &rung, uint32_t node);
+  void InsertInBottom (const Event &ev);
+  inline uint32_t GetTopBucket (uint32_t uid) const;
+  void GrowTopIndex (void);
+  void TransferTop (void);
+  void SpawnFromBottom (void);
+  void FillBottom (void);
+
+  std::vector<Node> m_nodes;
+  uint32_t m_freeNodes;
+
+  uint32_t m_top;
+  uint32_t m_topCount;
+  uint64_t m_topMin;
+  uint64_t m_topMax;
+  // events at or after this timestamp go to top
+  uint64_t m_topStart;
+  // hash of the nodes of top by uid, a power of two of buckets
+  std::vector<uint32_t> m_topIndex;
+  // 32 minus the log2 of the number of buckets
+  uint32_t m_topShift;
+
+  Rung m_rungs[MAX_RUNGS];
+  uint32_t m_nRungs;
+
+  // sorted by key, events before m_bottomHead have been removed
+  std::vector<Event> m_bottom;
+  uint32_t m_bottomHead;
+
+  uint32_t m_size;
+};
+
+} // namespace ns3
+
+#endif /* LADDER_SCHEDULER_H */
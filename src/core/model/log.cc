@@ -22,6 +22,12 @@
 #include <list>
 #include <utility>
 #include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
 #include "assert.h"
 #include "ns3/core-config.h"
 #include "fatal-error.h"
@@ -38,6 +44,8 @@ namespace ns3 {
 
 LogTimePrinter g_logTimePrinter = 0;
 LogNodePrinter g_logNodePrinter = 0;
+LogTimeGetter g_logTimeGetter = 0;
+LogNodeGetter g_logNodeGetter = 0;
 
 typedef std::list<std::pair <std::string, LogComponent *> > ComponentList;
 typedef std::list<std::pair <std::string, LogComponent *> >::iterator ComponentListI;
@@ -83,6 +91,23 @@ PrintList::PrintList ()
 #endif
 }
 
+static class BinaryEnvVarCheck
+{
+public:
+  BinaryEnvVarCheck ();
+} g_binaryEnvVarCheck;
+
+BinaryEnvVarCheck::BinaryEnvVarCheck ()
+{
+#ifdef HAVE_GETENV
+  char *envVar = getenv ("NS_LOG_BINARY");
+  if (envVar != 0 && std::strlen (envVar) != 0)
+    {
+      LogEnableBinary (envVar);
+    }
+#endif
+}
+
 
 LogComponent::LogComponent (char const * name)
   : m_levels (0), m_name (name)
@@ -90,6 +115,7 @@ LogComponent::LogComponent (char const * name)
   EnvVarCheck (name);
 
   ComponentList *components = GetComponentList ();
+  m_id = components->size ();
   for (ComponentListI i = components->begin ();
        i != components->end ();
        i++)
@@ -272,8 +298,20 @@ LogComponent::Name (void) const
   return m_name;
 }
 
-std::string
-LogComponent::GetLevelLabel(const enum LogLevel level) const
+uint32_t
+LogComponent::GetId (void) const
+{
+  return m_id;
+}
+
+int32_t
+LogComponent::GetPrefixes (void) const
+{
+  return m_levels & LOG_PREFIX_ALL;
+}
+
+static std::string
+LevelLabel (const enum LogLevel level)
 {
   if (level == LOG_ERROR)
     {
@@ -307,6 +345,12 @@ LogComponent::GetLevelLabel(const enum LogLevel level) const
     }
 }
 
+std::string
+LogComponent::GetLevelLabel(const enum LogLevel level) const
+{
+  return LevelLabel (level);
+}
+
 void 
 LogComponentEnable (char const *name, enum LogLevel level)
 {
@@ -578,6 +622,723 @@ LogNodePrinter LogGetNodePrinter (void)
   return g_logNodePrinter;
 }
 
+void LogSetTimeGetter (LogTimeGetter getter)
+{
+  g_logTimeGetter = getter;
+}
+void LogSetNodeGetter (LogNodeGetter getter)
+{
+  g_logNodeGetter = getter;
+}
+
+
+/*
+ * The binary logs.
+ *
+ * A record starts with a header:
+ *   uint32_t  size of the record, header included
+ *   uint32_t  id of the component
+ *   int32_t   level of the message and prefixes enabled
+ *   uint8_t   RECORD_* flags
+ *   uint8_t   length of the name of the function
+ *   double    time, if RECORD_TIME
+ *   uint32_t  node, if RECORD_NODE
+ *   char[]    name of the function
+ * followed by the arguments: a TYPE_* byte and the value of the type.
+ *
+ * A file starts with the magic string, then the number of components
+ * and their names, the number of buffers and their records, oldest
+ * first. The strings and the buffers are preceded by their size, a
+ * uint32_t and a uint64_t.
+ */
+
+namespace {
+
+const char g_logMagic[8] = { 'N', 'S', '3', 'B', 'L', 'O', 'G', '1' };
+const uint32_t RECORD_HEADER_SIZE = 26;
+
+enum {
+  RECORD_PARAMETERS = 1,
+  RECORD_TIME = 2,
+  RECORD_NODE = 4
+};
+
+enum {
+  TYPE_SIGNED,
+  TYPE_UNSIGNED,
+  TYPE_CHAR,
+  TYPE_DOUBLE,
+  TYPE_STRING,
+  TYPE_POINTER
+};
+
+/**
+ * The messages recorded by a thread. The positions grow forever, their
+ * remainder by the size of the buffer is the offset of the byte. A
+ * record is never split: when it does not fit before the end of the
+ * buffer, it goes to the start, and the end is skipped, marked with a
+ * null size if there is room for it. The rings are never freed: a
+ * thread may still log while another one writes them out at exit.
+ */
+class LogRing
+{
+public:
+  LogRing (uint32_t size);
+  void Write (char const *record, uint32_t size);
+  /**
+   * \param records where to append the records, oldest first
+   */
+  void Read (std::string *records) const;
+  void Clear (void);
+
+  LogRing *m_next;
+private:
+  void Drop (void);
+
+  char *m_buffer;
+  uint32_t m_size;
+  uint64_t m_head;
+  uint64_t m_tail;
+};
+
+LogRing::LogRing (uint32_t size)
+  : m_next (0),
+    m_buffer ((char *) std::malloc (size)),
+    m_size (size),
+    m_head (0),
+    m_tail (0)
+{
+}
+
+void
+LogRing::Drop (void)
+{
+  uint32_t offset = m_head % m_size;
+  uint32_t rest = m_size - offset;
+  uint32_t size = 0;
+  if (rest >= sizeof (size))
+    {
+      std::memcpy (&size, m_buffer + offset, sizeof (size));
+    }
+  m_head += size == 0 ? rest : size;
+}
+
+void
+LogRing::Write (char const *record, uint32_t size)
+{
+  if (size > m_size / 2)
+    {
+      return;
+    }
+  uint32_t offset = m_tail % m_size;
+  uint32_t skip = offset + size > m_size ? m_size - offset : 0;
+  while (m_tail + skip + size - m_head > m_size)
+    {
+      Drop ();
+    }
+  if (skip != 0)
+    {
+      if (skip >= sizeof (uint32_t))
+        {
+          std::memset (m_buffer + offset, 0, sizeof (uint32_t));
+        }
+      m_tail += skip;
+      offset = 0;
+    }
+  std::memcpy (m_buffer + offset, record, size);
+  m_tail += size;
+}
+
+void
+LogRing::Read (std::string *records) const
+{
+  uint64_t position = m_head;
+  while (position != m_tail)
+    {
+      uint32_t offset = position % m_size;
+      uint32_t rest = m_size - offset;
+      uint32_t size = 0;
+      if (rest >= sizeof (size))
+        {
+          std::memcpy (&size, m_buffer + offset, sizeof (size));
+        }
+      if (size == 0)
+        {
+          position += rest;
+          continue;
+        }
+      records->append (m_buffer + offset, size);
+      position += size;
+    }
+}
+
+void
+LogRing::Clear (void)
+{
+  m_head = m_tail;
+}
+
+struct BinaryState
+{
+  // the buffers of all the threads, most recent first
+  LogRing *rings;
+  uint32_t size;
+  std::string filename;
+  bool decode;
+  bool atExit;
+};
+
+BinaryState *
+PeekBinaryState (void)
+{
+  static BinaryState state = { 0, 0, "", false, false };
+  return &state;
+}
+
+__thread LogRing *g_logRing = 0;
+// the stream formatting the values of the messages of the thread
+__thread std::ostringstream *g_logStream = 0;
+__thread bool g_logStreamBusy = false;
+
+LogRing *
+GetRing (void)
+{
+  if (g_logRing == 0)
+    {
+      BinaryState *state = PeekBinaryState ();
+      LogRing *ring = new LogRing (state->size);
+      ring->m_next = __atomic_load_n (&state->rings, __ATOMIC_RELAXED);
+      while (!__atomic_compare_exchange_n (&state->rings, &ring->m_next, ring, true,
+                                           __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+        {
+        }
+      g_logRing = ring;
+    }
+  return g_logRing;
+}
+
+void
+WriteBinaryAtExit (void)
+{
+  LogDisableBinary ();
+}
+
+template <typename T>
+bool
+Read (std::istream &is, T *value)
+{
+  return is.read ((char *) value, sizeof (T)).good ();
+}
+
+template <typename T>
+T
+Get (char const **p)
+{
+  T value;
+  std::memcpy (&value, *p, sizeof (T));
+  *p += sizeof (T);
+  return value;
+}
+
+struct Record
+{
+  double time;
+  uint32_t ring;
+  char const *data;
+};
+
+struct RecordLess
+{
+  bool operator () (const Record &a, const Record &b) const
+  {
+    return a.time < b.time || (a.time == b.time && a.ring < b.ring);
+  }
+};
+
+void
+PrintRecord (std::ostream &os, char const *p, const std::vector<std::string> &components)
+{
+  char const *end = p + Get<uint32_t> (&p);
+  uint32_t component = Get<uint32_t> (&p);
+  int32_t level = Get<int32_t> (&p);
+  uint8_t flags = Get<uint8_t> (&p);
+  uint8_t length = Get<uint8_t> (&p);
+  double time = Get<double> (&p);
+  uint32_t node = Get<uint32_t> (&p);
+  std::string function (p, length);
+  p += length;
+  std::string name = component < components.size () ? components[component] : "unknown";
+
+  if ((flags & RECORD_TIME) && (level & LOG_PREFIX_TIME))
+    {
+      os << time << "s ";
+    }
+  if ((flags & RECORD_NODE) && (level & LOG_PREFIX_NODE))
+    {
+      if (node == 0xffffffff)
+        {
+          os << "-1 ";
+        }
+      else
+        {
+          os << node << " ";
+        }
+    }
+  bool parameters = flags & RECORD_PARAMETERS;
+  if (parameters)
+    {
+      os << name << ":" << function << "(";
+    }
+  else
+    {
+      if (level & LOG_PREFIX_FUNC)
+        {
+          os << name << ":" << function << "(): ";
+        }
+      if (level & LOG_PREFIX_LEVEL)
+        {
+          os << "[" << LevelLabel ((enum LogLevel)(level & LOG_ALL)) << "] ";
+        }
+    }
+  for (uint32_t i = 0; p < end; i++)
+    {
+      if (parameters && i > 0)
+        {
+          os << ", ";
+        }
+      switch (Get<uint8_t> (&p))
+        {
+        case TYPE_SIGNED:
+          os << Get<int64_t> (&p);
+          break;
+        case TYPE_UNSIGNED:
+          os << Get<uint64_t> (&p);
+          break;
+        case TYPE_CHAR:
+          os << Get<char> (&p);
+          break;
+        case TYPE_DOUBLE:
+          os << Get<double> (&p);
+          break;
+        case TYPE_STRING:
+          {
+            uint32_t size = Get<uint32_t> (&p);
+            os.write (p, size);
+            p += size;
+          }
+          break;
+        case TYPE_POINTER:
+          os << (const void *)(uintptr_t) Get<uint64_t> (&p);
+          break;
+        default:
+          p = end;
+          break;
+        }
+    }
+  if (parameters)
+    {
+      os << ")";
+    }
+  os << std::endl;
+}
+
+} // anonymous namespace
+
+bool LogRecorder::m_enabled = false;
+
+void
+LogEnableBinary (std::string filename, bool decode, uint32_t size)
+{
+  BinaryState *state = PeekBinaryState ();
+  state->filename = filename;
+  state->decode = decode;
+  // the size of the buffers already there does not change
+  state->size = std::max (size, 1024U);
+  if (!state->atExit)
+    {
+      // the list of the components must still be there at exit
+      GetComponentList ();
+      std::atexit (&WriteBinaryAtExit);
+      state->atExit = true;
+    }
+  LogRecorder::m_enabled = true;
+}
+
+void
+LogDisableBinary (void)
+{
+  if (!LogRecorder::m_enabled)
+    {
+      return;
+    }
+  LogRecorder::m_enabled = false;
+  BinaryState *state = PeekBinaryState ();
+  if (!state->filename.empty ())
+    {
+      std::ofstream os (state->filename.c_str (), std::ios::binary);
+      if (state->decode)
+        {
+          std::stringstream binary;
+          LogWriteBinary (binary);
+          LogDecodeBinary (binary, os);
+        }
+      else
+        {
+          LogWriteBinary (os);
+        }
+    }
+  for (LogRing *ring = __atomic_load_n (&state->rings, __ATOMIC_ACQUIRE); ring != 0; ring = ring->m_next)
+    {
+      ring->Clear ();
+    }
+}
+
+void
+LogWriteBinary (std::ostream &os)
+{
+  os.write (g_logMagic, sizeof (g_logMagic));
+  ComponentList *components = GetComponentList ();
+  uint32_t n = components->size ();
+  os.write ((char const *) &n, sizeof (n));
+  for (ComponentListI i = components->begin (); i != components->end (); i++)
+    {
+      uint32_t size = i->first.size ();
+      os.write ((char const *) &size, sizeof (size));
+      os.write (i->first.data (), size);
+    }
+  BinaryState *state = PeekBinaryState ();
+  LogRing *rings = __atomic_load_n (&state->rings, __ATOMIC_ACQUIRE);
+  n = 0;
+  for (LogRing *ring = rings; ring != 0; ring = ring->m_next)
+    {
+      n++;
+    }
+  os.write ((char const *) &n, sizeof (n));
+  for (LogRing *ring = rings; ring != 0; ring = ring->m_next)
+    {
+      std::string records;
+      ring->Read (&records);
+      uint64_t size = records.size ();
+      os.write ((char const *) &size, sizeof (size));
+      os.write (records.data (), size);
+    }
+  os.flush ();
+}
+
+bool
+LogDecodeBinary (std::istream &is, std::ostream &os)
+{
+  char magic[sizeof (g_logMagic)];
+  if (!is.read (magic, sizeof (magic)) || std::memcmp (magic, g_logMagic, sizeof (magic)) != 0)
+    {
+      return false;
+    }
+  uint32_t n;
+  if (!Read (is, &n))
+    {
+      return false;
+    }
+  std::vector<std::string> components;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      uint32_t size;
+      if (!Read (is, &size))
+        {
+          return false;
+        }
+      std::string name (size, ' ');
+      if (size != 0 && !is.read (&name[0], size))
+        {
+          return false;
+        }
+      components.push_back (name);
+    }
+  if (!Read (is, &n))
+    {
+      return false;
+    }
+  std::vector<std::string> rings (n);
+  std::vector<Record> records;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      uint64_t size;
+      if (!Read (is, &size))
+        {
+          return false;
+        }
+      rings[i].resize (size);
+      if (size != 0 && !is.read (&rings[i][0], size))
+        {
+          return false;
+        }
+      // the messages printed before the simulator had a time stay
+      // where they are
+      double time = -1e300;
+      for (uint64_t offset = 0; offset + RECORD_HEADER_SIZE <= size; )
+        {
+          char const *p = rings[i].data () + offset;
+          uint32_t recordSize;
+          uint8_t flags;
+          std::memcpy (&recordSize, p, sizeof (recordSize));
+          std::memcpy (&flags, p + 12, sizeof (flags));
+          if (recordSize < RECORD_HEADER_SIZE || offset + recordSize > size)
+            {
+              return false;
+            }
+          if (flags & RECORD_TIME)
+            {
+              std::memcpy (&time, p + 14, sizeof (time));
+            }
+          Record record;
+          record.time = time;
+          record.ring = i;
+          record.data = p;
+          records.push_back (record);
+          offset += recordSize;
+        }
+    }
+  std::stable_sort (records.begin (), records.end (), RecordLess ());
+  for (std::vector<Record>::const_iterator i = records.begin (); i != records.end (); i++)
+    {
+      PrintRecord (os, i->data, components);
+    }
+  return true;
+}
+
+LogRecorder::LogRecorder (const LogComponent &component, enum LogLevel level,
+                          char const *function, bool parameters)
+  : m_buffer (m_local),
+    m_size (0),
+    m_capacity (sizeof (m_local)),
+    m_os (0),
+    m_ownsStream (false),
+    m_manipulated (false)
+{
+  uint32_t size = 0;
+  uint32_t id = component.GetId ();
+  int32_t levels = level | component.GetPrefixes ();
+  uint8_t flags = parameters ? RECORD_PARAMETERS : 0;
+  uint32_t length = std::strlen (function);
+  uint8_t functionLength = std::min (length, 255U);
+  double time = 0;
+  uint32_t node = 0;
+  if (g_logTimeGetter != 0)
+    {
+      flags |= RECORD_TIME;
+      time = (*g_logTimeGetter)();
+    }
+  if (g_logNodeGetter != 0)
+    {
+      flags |= RECORD_NODE;
+      node = (*g_logNodeGetter)();
+    }
+  Put (&size, sizeof (size));
+  Put (&id, sizeof (id));
+  Put (&levels, sizeof (levels));
+  Put (&flags, sizeof (flags));
+  Put (&functionLength, sizeof (functionLength));
+  Put (&time, sizeof (time));
+  Put (&node, sizeof (node));
+  Put (function, functionLength);
+}
+
+LogRecorder::~LogRecorder ()
+{
+  std::memcpy (m_buffer, &m_size, sizeof (m_size));
+  GetRing ()->Write (m_buffer, m_size);
+  if (m_buffer != m_local)
+    {
+      std::free (m_buffer);
+    }
+  if (m_ownsStream)
+    {
+      delete m_os;
+    }
+  else if (m_os != 0)
+    {
+      m_os->clear ();
+      m_os->flags (std::ios_base::skipws | std::ios_base::dec);
+      m_os->precision (6);
+      m_os->width (0);
+      m_os->fill (' ');
+      g_logStreamBusy = false;
+    }
+}
+
+void
+LogRecorder::Put (const void *data, uint32_t size)
+{
+  if (m_size + size > m_capacity)
+    {
+      m_capacity = std::max (2 * m_capacity, m_size + size);
+      if (m_buffer == m_local)
+        {
+          m_buffer = (char *) std::malloc (m_capacity);
+          std::memcpy (m_buffer, m_local, m_size);
+        }
+      else
+        {
+          m_buffer = (char *) std::realloc (m_buffer, m_capacity);
+        }
+    }
+  std::memcpy (m_buffer + m_size, data, size);
+  m_size += size;
+}
+
+void
+LogRecorder::Put (uint8_t type, const void *data, uint32_t size)
+{
+  Put (&type, sizeof (type));
+  Put (data, size);
+}
+
+void
+LogRecorder::PutString (char const *v, uint32_t size)
+{
+  uint8_t type = TYPE_STRING;
+  Put (&type, sizeof (type));
+  Put (&size, sizeof (size));
+  Put (v, size);
+}
+
+std::ostream &
+LogRecorder::BeginFormat (void)
+{
+  if (m_os == 0)
+    {
+      // the values may log while they are formatted
+      if (g_logStreamBusy)
+        {
+          m_os = new std::ostringstream;
+          m_ownsStream = true;
+        }
+      else
+        {
+          if (g_logStream == 0)
+            {
+              g_logStream = new std::ostringstream;
+            }
+          m_os = g_logStream;
+          g_logStreamBusy = true;
+        }
+    }
+  m_os->str ("");
+  return *m_os;
+}
+
+void
+LogRecorder::EndFormat (void)
+{
+  // a manipulator, or a value which changes the format, applies to the
+  // values after it: they cannot be formatted later anymore
+  if (m_os->flags () != (std::ios_base::skipws | std::ios_base::dec)
+      || m_os->precision () != 6 || m_os->width () != 0 || m_os->fill () != ' ')
+    {
+      m_manipulated = true;
+    }
+  // even if empty, NS_LOG_FUNCTION separates it from the others
+  std::string value = m_os->str ();
+  PutString (value.data (), value.size ());
+}
+
+LogRecorder &
+LogRecorder::operator << (bool v)
+{
+  if (m_manipulated)
+    {
+      return Format (v);
+    }
+  int64_t value = v;
+  Put (TYPE_SIGNED, &value, sizeof (value));
+  return *this;
+}
+
+#define LOG_RECORDER_PUT(type, tag, storage)            \
+  LogRecorder &                                         \
+  LogRecorder::operator << (type v)                     \
+  {                                                     \
+    if (m_manipulated)                                  \
+      {                                                 \
+        return Format (v);                              \
+      }                                                 \
+    storage value = v;                                  \
+    Put (tag, &value, sizeof (value));                  \
+    return *this;                                       \
+  }
+
+LOG_RECORDER_PUT (char, TYPE_CHAR, char)
+LOG_RECORDER_PUT (signed char, TYPE_CHAR, char)
+LOG_RECORDER_PUT (unsigned char, TYPE_CHAR, char)
+LOG_RECORDER_PUT (short, TYPE_SIGNED, int64_t)
+LOG_RECORDER_PUT (unsigned short, TYPE_UNSIGNED, uint64_t)
+LOG_RECORDER_PUT (int, TYPE_SIGNED, int64_t)
+LOG_RECORDER_PUT (unsigned int, TYPE_UNSIGNED, uint64_t)
+LOG_RECORDER_PUT (long, TYPE_SIGNED, int64_t)
+LOG_RECORDER_PUT (unsigned long, TYPE_UNSIGNED, uint64_t)
+LOG_RECORDER_PUT (long long, TYPE_SIGNED, int64_t)
+LOG_RECORDER_PUT (unsigned long long, TYPE_UNSIGNED, uint64_t)
+LOG_RECORDER_PUT (float, TYPE_DOUBLE, double)
+LOG_RECORDER_PUT (double, TYPE_DOUBLE, double)
+
+#undef LOG_RECORDER_PUT
+
+LogRecorder &
+LogRecorder::operator << (const void *v)
+{
+  if (m_manipulated)
+    {
+      return Format (v);
+    }
+  uint64_t value = (uintptr_t) v;
+  Put (TYPE_POINTER, &value, sizeof (value));
+  return *this;
+}
+
+LogRecorder &
+LogRecorder::operator << (char const *v)
+{
+  if (m_manipulated)
+    {
+      return Format (v);
+    }
+  // std::ostream prints nothing, but the argument is still there
+  if (v == 0)
+    {
+      v = "";
+    }
+  PutString (v, std::strlen (v));
+  return *this;
+}
+
+LogRecorder &
+LogRecorder::operator << (char *v)
+{
+  return *this << (char const *) v;
+}
+
+LogRecorder &
+LogRecorder::operator << (const std::string &v)
+{
+  if (m_manipulated)
+    {
+      return Format (v);
+    }
+  PutString (v.data (), v.size ());
+  return *this;
+}
+
+LogRecorder &
+LogRecorder::operator << (std::ostream &(*manipulator)(std::ostream &))
+{
+  return Format (manipulator);
+}
+
+LogRecorder &
+LogRecorder::operator << (std::ios_base &(*manipulator)(std::ios_base &))
+{
+  return Format (manipulator);
+}
+
 
 ParameterLogger::ParameterLogger (std::ostream &os)
   : m_itemNumber (0),
@@ -120,7 +120,44 @@ void LogComponentDisableAll (enum LogLevel level);
  * environment variable.
  */
 #define NS_LOG_COMPONENT_DEFINE(name)                           \
-  static ns3::LogComponent g_log = ns3::LogComponent (name)
+  NS_LOG_COMPONENT_DEFINE_CEILING (name, NS_LOG_CEILING)
+
+/**
+ * \ingroup logging
+ * \param name a string
+ * \param ceiling the levels which can be enabled at run time
+ *
+ * Define a Log component whose levels outside of the ceiling are
+ * compiled out: they cannot be enabled and cost nothing, not even the
+ * test of the enabled levels. For example, to keep only the errors and
+ * the warnings of a component called in the inner loops:
+ * \code
+ * NS_LOG_COMPONENT_DEFINE_CEILING ("Foo", ns3::LOG_LEVEL_WARN);
+ * \endcode
+ *
+ * NS_LOG_COMPONENT_DEFINE uses the ceiling NS_LOG_CEILING, which is
+ * LOG_LEVEL_ALL unless defined otherwise when building, for example
+ * with ./waf configure --log-ceiling=warn.
+ */
+#define NS_LOG_COMPONENT_DEFINE_CEILING(name, ceiling)          \
+  static ns3::LogComponent g_log = ns3::LogComponent (name);   \
+  static const int32_t g_logCeiling = (ceiling)
+
+#ifndef NS_LOG_CEILING
+#define NS_LOG_CEILING ns3::LOG_LEVEL_ALL
+#endif /* NS_LOG_CEILING */
+
+/**
+ * \ingroup logging
+ * \param level a logging level
+ * \returns true if the level is below the ceiling of the component
+ * and enabled
+ *
+ * The first test is a constant expression: the compiler drops the
+ * messages of the levels above the ceiling.
+ */
+#define NS_LOG_IS_ENABLED(level)                                \
+  (((level) & g_logCeiling) != 0 && g_log.IsEnabled (level))
 
 #define NS_LOG_APPEND_TIME_PREFIX                               \
   if (g_log.IsEnabled (ns3::LOG_PREFIX_TIME))                   \
@@ -196,6 +233,15 @@ void LogComponentDisableAll (enum LogLevel level);
  * A note on NS_LOG_FUNCTION() and NS_LOG_FUNCTION_NOARGS():
  * generally, use of (at least) NS_LOG_FUNCTION(this) is preferred.
  * Use NS_LOG_FUNCTION_NOARGS() only in static functions.
+ *
+ * Formatting the messages is what makes the logging slow. Once
+ * ns3::LogEnableBinary has been called, or if the NS_LOG_BINARY
+ * environment variable holds the name of a file, the messages are not
+ * formatted anymore: their arguments are recorded, along with the time
+ * and the node, in a ring buffer per thread which keeps the latest
+ * messages. The buffers are written to the file at exit or on a fatal
+ * error, and utils/decode-binary-log turns them into the text the
+ * messages would have printed (see ns3::LogRecorder for what differs).
  */
 
 
@@ -216,8 +262,14 @@ void LogComponentDisableAll (enum LogLevel level);
 #define NS_LOG(level, msg)                                      \
   do                                                            \
     {                                                           \
-      if (g_log.IsEnabled (level))                              \
+      if (NS_LOG_IS_ENABLED (level))                            \
         {                                                       \
+          if (ns3::LogRecorder::IsEnabled ())                   \
+            {                                                   \
+              ns3::LogRecorder (g_log, level, __FUNCTION__,     \
+                                false) << msg;                  \
+              break;                                            \
+            }                                                   \
           NS_LOG_APPEND_TIME_PREFIX;                            \
           NS_LOG_APPEND_NODE_PREFIX;                            \
           NS_LOG_APPEND_CONTEXT;                                \
@@ -275,8 +327,14 @@ void LogComponentDisableAll (enum LogLevel level);
 #define NS_LOG_FUNCTION_NOARGS()                                \
   do                                                            \
     {                                                           \
-      if (g_log.IsEnabled (ns3::LOG_FUNCTION))                  \
+      if (NS_LOG_IS_ENABLED (ns3::LOG_FUNCTION))                \
         {                                                       \
+          if (ns3::LogRecorder::IsEnabled ())                   \
+            {                                                   \
+              ns3::LogRecorder (g_log, ns3::LOG_FUNCTION,       \
+                                __FUNCTION__, true);            \
+              break;                                            \
+            }                                                   \
           NS_LOG_APPEND_TIME_PREFIX;                            \
           NS_LOG_APPEND_NODE_PREFIX;                            \
           NS_LOG_APPEND_CONTEXT;                                \
@@ -311,8 +369,15 @@ void LogComponentDisableAll (enum LogLevel level);
 #define NS_LOG_FUNCTION(parameters)                             \
   do                                                            \
     {                                                           \
-      if (g_log.IsEnabled (ns3::LOG_FUNCTION))                  \
+      if (NS_LOG_IS_ENABLED (ns3::LOG_FUNCTION))                \
         {                                                       \
+          if (ns3::LogRecorder::IsEnabled ())                   \
+            {                                                   \
+              ns3::LogRecorder (g_log, ns3::LOG_FUNCTION,       \
+                                __FUNCTION__, true)             \
+                << parameters;                                  \
+              break;                                            \
+            }                                                   \
           NS_LOG_APPEND_TIME_PREFIX;                            \
           NS_LOG_APPEND_NODE_PREFIX;                            \
           NS_LOG_APPEND_CONTEXT;                                \
@@ -381,6 +446,60 @@ LogTimePrinter LogGetTimePrinter (void);
 void LogSetNodePrinter (LogNodePrinter);
 LogNodePrinter LogGetNodePrinter (void);
 
+/**
+ * Return the values the time and node printers print, for the messages
+ * recorded by ns3::LogEnableBinary
+ */
+typedef double (*LogTimeGetter)(void);
+typedef uint32_t (*LogNodeGetter)(void);
+
+void LogSetTimeGetter (LogTimeGetter);
+void LogSetNodeGetter (LogNodeGetter);
+
+/**
+ * \ingroup logging
+ * \param filename the file the messages are written to at exit and on
+ *        a fatal error, none if empty
+ * \param decode whether to write the messages as text rather than in
+ *        the binary format read by ns3::LogDecodeBinary
+ * \param size the size of the ring buffer of every thread, 1 MiB by
+ *        default: the oldest messages are dropped once it is full
+ *
+ * Record the logging messages instead of printing them.
+ *
+ * Same as running your program with the NS_LOG_BINARY environment
+ * variable set to the name of the file.
+ */
+void LogEnableBinary (std::string filename, bool decode = false, uint32_t size = 1024 * 1024);
+
+/**
+ * \ingroup logging
+ *
+ * Write the recorded messages to the file given to ns3::LogEnableBinary,
+ * forget them and print the next messages again.
+ */
+void LogDisableBinary (void);
+
+/**
+ * \ingroup logging
+ * \param os the stream to write to
+ *
+ * Write the messages recorded so far, in the binary format read by
+ * ns3::LogDecodeBinary. The binary format is the one of the host.
+ */
+void LogWriteBinary (std::ostream &os);
+
+/**
+ * \ingroup logging
+ * \param is the stream written by ns3::LogWriteBinary
+ * \param os the stream to print the messages to
+ * \returns false if the input is not a binary log
+ *
+ * Print the recorded messages in the order of their time, as
+ * they would have been printed.
+ */
+bool LogDecodeBinary (std::istream &is, std::ostream &os);
+
 
 class LogComponent {
 public:
@@ -392,9 +511,116 @@ public:
   void Disable (enum LogLevel level);
   char const *Name (void) const;
   std::string GetLevelLabel(const enum LogLevel level) const;
+  /**
+   * \returns the index of the component in the order of registration
+   */
+  uint32_t GetId (void) const;
+  /**
+   * \returns the enabled prefixes, LOG_PREFIX_ALL included
+   */
+  int32_t GetPrefixes (void) const;
 private:
   int32_t     m_levels;
   char const *m_name;
+  uint32_t    m_id;
+};
+
+template <typename T>
+class Ptr;
+
+/**
+ * \ingroup logging
+ *
+ * Records a message in the ring buffer of the thread, when
+ * ns3::LogEnableBinary has been called. The message is stored when the
+ * recorder is destroyed, at the end of the NS_LOG statement.
+ *
+ * The numbers, the strings, the characters and the pointers, Ptr
+ * included, are copied in binary. The other values are formatted with
+ * their operator <<, when they are recorded, and copied as strings:
+ * their output does not change, only its cost. Every argument is
+ * recorded, even one which prints nothing, so that the arguments of
+ * NS_LOG_FUNCTION are separated as when printed. Once a manipulator, or
+ * a value, has changed the format of the stream, the rest of the
+ * message is formatted as well.
+ *
+ * The prefix NS_LOG_APPEND_CONTEXT prints is not recorded.
+ */
+class LogRecorder
+{
+public:
+  /**
+   * \param component the component of the message
+   * \param level the level of the message
+   * \param function the name of the function logging
+   * \param parameters whether the arguments are the parameters of
+   *        NS_LOG_FUNCTION
+   */
+  LogRecorder (const LogComponent &component, enum LogLevel level,
+               char const *function, bool parameters);
+  ~LogRecorder ();
+
+  /**
+   * \returns true if the messages are recorded rather than printed
+   */
+  static bool IsEnabled (void)
+  {
+    return m_enabled;
+  }
+
+  LogRecorder &operator << (bool v);
+  LogRecorder &operator << (char v);
+  LogRecorder &operator << (signed char v);
+  LogRecorder &operator << (unsigned char v);
+  LogRecorder &operator << (short v);
+  LogRecorder &operator << (unsigned short v);
+  LogRecorder &operator << (int v);
+  LogRecorder &operator << (unsigned int v);
+  LogRecorder &operator << (long v);
+  LogRecorder &operator << (unsigned long v);
+  LogRecorder &operator << (long long v);
+  LogRecorder &operator << (unsigned long long v);
+  LogRecorder &operator << (float v);
+  LogRecorder &operator << (double v);
+  LogRecorder &operator << (char const *v);
+  LogRecorder &operator << (char *v);
+  LogRecorder &operator << (const std::string &v);
+  LogRecorder &operator << (const void *v);
+  LogRecorder &operator << (std::ostream &(*manipulator)(std::ostream &));
+  LogRecorder &operator << (std::ios_base &(*manipulator)(std::ios_base &));
+  template <typename T>
+  LogRecorder &operator << (T *v);
+  template <typename T>
+  LogRecorder &operator << (const Ptr<T> &v);
+  template <typename T>
+  LogRecorder &operator << (const T &v);
+  // for the operators << which take a non-const reference
+  template <typename T>
+  LogRecorder &operator << (T &v);
+
+private:
+  LogRecorder (const LogRecorder &);
+  LogRecorder &operator = (const LogRecorder &);
+  void PutString (char const *v, uint32_t size);
+  void Put (uint8_t type, const void *data, uint32_t size);
+  void Put (const void *data, uint32_t size);
+  template <typename T>
+  LogRecorder &Format (T &v);
+  std::ostream &BeginFormat (void);
+  void EndFormat (void);
+
+  friend void LogEnableBinary (std::string filename, bool decode, uint32_t size);
+  friend void LogDisableBinary (void);
+
+  static bool m_enabled;
+  char m_local[256];
+  char *m_buffer;
+  uint32_t m_size;
+  uint32_t m_capacity;
+  // the stream of the formatted arguments, 0 until one is
+  std::ostringstream *m_os;
+  bool m_ownsStream;
+  bool m_manipulated;
 };
 
 class ParameterLogger : public std::ostream
@@ -421,6 +647,43 @@ public:
   }
 };
 
+template <typename T>
+LogRecorder &
+LogRecorder::operator << (T *v)
+{
+  return *this << (const void *) v;
+}
+
+template <typename T>
+LogRecorder &
+LogRecorder::operator << (const Ptr<T> &v)
+{
+  return *this << (const void *) PeekPointer (v);
+}
+
+template <typename T>
+LogRecorder &
+LogRecorder::operator << (const T &v)
+{
+  return Format (v);
+}
+
+template <typename T>
+LogRecorder &
+LogRecorder::operator << (T &v)
+{
+  return Format (v);
+}
+
+template <typename T>
+LogRecorder &
+LogRecorder::Format (T &v)
+{
+  BeginFormat () << v;
+  EndFormat ();
+  return *this;
+}
+
 } // namespace ns3
 
 
@@ -27,6 +27,10 @@ protected:
     	if (m_function !=0)
     		(*m_function)();
     }
+    virtual const void *GetFunction (void) const
+    {
+      return GetAddress (m_function);
+    }
 private:
     F m_function;
   } *ev = new EventFunctionImpl0 (f);
@@ -0,0 +1,119 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+
+namespace ns3 {
+
+/**
+ * \ingroup core
+ * \brief An intrusive lock-free multiple producer, single consumer queue
+ *
+ * Items are linked through their own \c next member, a T *, so pushing
+ * an item never allocates. Any number of threads may push concurrently
+ * with a single compare and swap each. The consumer takes the whole
+ * content of the queue at once with a single exchange, so it never
+ * contends with the producers item by item, and gets the items in the
+ * order they were pushed.
+ *
+ * The queue does not own its items: whoever pops them is responsible for
+ * them.
+ */
+template <typename T>
+class MpscQueue
+{
+public:
+  MpscQueue ();
+
+  /**
+   * Can be called from any thread.
+   *
+   * \param item the item to append
+   * \returns true if the queue was empty, which tells the producer that
+   * the consumer may have to be woken up
+   */
+  bool Push (T *item);
+  /**
+   * Can only be called from the consumer thread.
+   *
+   * \returns the items pushed so far, oldest first and linked through
+   * their next member, or 0 if the queue is empty
+   */
+  T *PopAll (void);
+  /**
+   * \returns true if the queue was empty when it was looked at
+   */
+  bool IsEmpty (void) const;
+
+private:
+  // most recently pushed item
+  T *m_head;
+};
+
+} // namespace ns3
+
+namespace ns3 {
+
+template <typename T>
+MpscQueue<T>::MpscQueue ()
+  : m_head (0)
+{
+}
+
+template <typename T>
+bool
+MpscQueue<T>::Push (T *item)
+{
+  T *head = __atomic_load_n (&m_head, __ATOMIC_RELAXED);
+  do
+    {
+      item->next = head;
+    }
+  while (!__atomic_compare_exchange_n (&m_head, &head, item, true,
+                                       __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+  // not item->next: once pushed, the item may already be popped and
+  // relinked by the consumer
+  return head == 0;
+}
+
+template <typename T>
+T *
+MpscQueue<T>::PopAll (void)
+{
+  T *item = __atomic_exchange_n (&m_head, (T *) 0, __ATOMIC_ACQUIRE);
+  // the items are stacked, newest first
+  T *first = 0;
+  while (item != 0)
+    {
+      T *next = item->next;
+      item->next = first;
+      first = item;
+      item = next;
+    }
+  return first;
+}
+
+template <typename T>
+bool
+MpscQueue<T>::IsEmpty (void) const
+{
+  return __atomic_load_n (&m_head, __ATOMIC_RELAXED) == 0;
+}
+
+} // namespace ns3
+
+#endif /* MPSC_QUEUE_H */
@@ -412,6 +412,18 @@ public:
    */
   inline static Time FromDouble (double value, enum Unit timeUnit)
   {
+    struct Information *info = PeekInformation (timeUnit);
+    if (info->fromMul)
+      {
+        // When the product is an exact integer, as in Seconds (1.5),
+        // int64x64_t would find the same value.
+        double v = value * info->factor;
+        if (v == std::floor (v) && std::fabs (v) < 9.2e18
+            && fma (value, info->factor, -v) == 0)
+          {
+            return Time ((int64_t) v);
+          }
+      }
     return From (int64x64_t (value), timeUnit);
   }
   /**
@@ -423,7 +435,15 @@ public:
    */
   inline double ToDouble (enum Unit timeUnit) const
   {
-    return To (timeUnit).GetDouble ();
+    struct Information *info = PeekInformation (timeUnit);
+    if (info->toMul)
+      {
+        return (double)(m_data * info->factor);
+      }
+    // the integer part is exact, the fraction is rounded once
+    int64_t v = m_data / info->factor;
+    int64_t r = m_data % info->factor;
+    return v + (double) r / info->factor;
   }
   static inline Time From (const int64x64_t &from, enum Unit timeUnit)
   {
@@ -431,6 +451,10 @@ public:
     // DO NOT REMOVE this temporary variable. It's here
     // to work around a compiler bug in gcc 3.4
     int64x64_t retval = from;
+    if (info->factor == 1)
+      {
+        return Time (retval);
+      }
     if (info->fromMul)
       {
         retval *= info->timeFrom;
@@ -444,15 +468,13 @@ public:
   inline int64x64_t To (enum Unit timeUnit) const
   {
     struct Information *info = PeekInformation (timeUnit);
-    int64x64_t retval = int64x64_t (m_data);
     if (info->toMul)
       {
-        retval *= info->timeTo;
-      }
-    else
-      {
-        retval.MulByInvert (info->timeTo);
+        // exact: no need to multiply in int64x64_t
+        return int64x64_t (m_data * info->factor);
       }
+    int64x64_t retval = int64x64_t (m_data);
+    retval.MulByInvert (info->timeTo);
     return retval;
   }
   inline operator int64x64_t () const
@@ -645,6 +667,47 @@ inline Time &operator -= (Time &lhs, const Time &rhs)
   return lhs;
 }
 
+/**
+ * \relates ns3::Time
+ *
+ * The product of a Time and an integer is computed on the integers,
+ * without converting to int64x64_t, and is a Time: it used to be an
+ * int64x64_t.  The product with a double still converts the Time to
+ * int64x64_t and is an int64x64_t; a float is promoted to double, the
+ * other types need an explicit conversion.
+ */
+#define TIME_OP_MUL_TYPE(type)                                          \
+  inline Time operator * (const Time &lhs, type rhs)                    \
+  {                                                                     \
+    return Time ((int64_t)(lhs.GetTimeStep () * rhs));                  \
+  }                                                                     \
+  inline Time operator * (type lhs, const Time &rhs)                    \
+  {                                                                     \
+    return Time ((int64_t)(lhs * rhs.GetTimeStep ()));                  \
+  }
+
+TIME_OP_MUL_TYPE (signed char)
+TIME_OP_MUL_TYPE (signed short)
+TIME_OP_MUL_TYPE (signed int)
+TIME_OP_MUL_TYPE (signed long int)
+TIME_OP_MUL_TYPE (signed long long int)
+TIME_OP_MUL_TYPE (unsigned char)
+TIME_OP_MUL_TYPE (unsigned short)
+TIME_OP_MUL_TYPE (unsigned int)
+TIME_OP_MUL_TYPE (unsigned long int)
+TIME_OP_MUL_TYPE (unsigned long long int)
+
+#undef TIME_OP_MUL_TYPE
+
+inline int64x64_t operator * (const Time &lhs, double rhs)
+{
+  return int64x64_t (lhs) * rhs;
+}
+inline int64x64_t operator * (double lhs, const Time &rhs)
+{
+  return lhs * int64x64_t (rhs);
+}
+
 /**
  * \anchor ns3-Time-Abs
  * \relates ns3::TimeUnit
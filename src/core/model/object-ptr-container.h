@@ -139,6 +139,23 @@ public:
   virtual bool Get (const ObjectBase * object, AttributeValue &value) const;
   virtual bool HasGetter (void) const;
   virtual bool HasSetter (void) const;
+  /**
+   * \param object the object holding the container
+   * \param n where to store the number of objects in the container
+   * \returns false if \p object does not hold this container
+   */
+  bool GetN (const ObjectBase *object, uint32_t *n) const;
+  /**
+   * Gets a single object, without copying the whole container as Get
+   * does.
+   *
+   * \param object the object holding the container, checked by GetN
+   * \param i the position of the requested object, in [0,n[
+   * \param index where to store the index of the object in the
+   * container
+   * \returns the requested object
+   */
+  Ptr<Object> Get (const ObjectBase *object, uint32_t i, uint32_t *index) const;
 private:
   virtual bool DoGetN (const ObjectBase *object, uint32_t *n) const = 0;
   virtual Ptr<Object> DoGet (const ObjectBase *object, uint32_t i, uint32_t *index) const = 0;
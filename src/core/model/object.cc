@@ -98,6 +98,7 @@ Object::Object ()
 {
   NS_LOG_FUNCTION (this);
   m_aggregates->n = 1;
+  m_aggregates->cache = 0;
   m_aggregates->buffer[0] = this;
 }
 Object::~Object () 
@@ -116,11 +117,16 @@ Object::~Object ()
           m_aggregates->n--;
         }
     }
+  // the cache might point to this object
+  if (m_aggregates->cache != 0)
+    {
+      std::memset (m_aggregates->cache, 0, sizeof (struct Cache));
+    }
   // finally, if all objects have been removed from the list,
   // delete the aggregate list
   if (m_aggregates->n == 0)
     {
-      std::free (m_aggregates);
+      FreeAggregates (m_aggregates);
     }
   m_aggregates = 0;
 }
@@ -132,6 +138,7 @@ Object::Object (const Object &o)
     m_getObjectCount (0)
 {
   m_aggregates->n = 1;
+  m_aggregates->cache = 0;
   m_aggregates->buffer[0] = this;
 }
 void
@@ -147,8 +154,20 @@ Object::DoGetObject (TypeId tid) const
   NS_LOG_FUNCTION (this << tid);
   NS_ASSERT (CheckLoose ());
 
+  uint16_t uid = tid.GetUid ();
+  struct Cache *cache = m_aggregates->cache;
+  if (cache != 0)
+    {
+      struct Cache::Entry *entry = &cache->entries[uid % Cache::SIZE];
+      if (entry->uid == uid)
+        {
+          return entry->object;
+        }
+    }
+
   uint32_t n = m_aggregates->n;
   TypeId objectTid = Object::GetTypeId ();
+  Object *found = 0;
   for (uint32_t i = 0; i < n; i++)
     {
       Object *current = m_aggregates->buffer[i];
@@ -169,11 +188,24 @@ Object::DoGetObject (TypeId tid) const
           current->m_getObjectCount++;
           // then, update the sort
           UpdateSortedArray (m_aggregates, i);
-          // finally, return the match
-          return const_cast<Object *> (current);
+          found = current;
+          break;
         }
     }
-  return 0;
+  // a lone object is mostly looked up for its own type, which
+  // GetObject finds without calling us: it does not need a cache.
+  if (n > 1)
+    {
+      if (cache == 0)
+        {
+          cache = (struct Cache *) std::calloc (1, sizeof (struct Cache));
+          m_aggregates->cache = cache;
+        }
+      struct Cache::Entry *entry = &cache->entries[uid % Cache::SIZE];
+      entry->uid = uid;
+      entry->object = found;
+    }
+  return found;
 }
 void
 Object::Initialize (void)
@@ -238,6 +270,13 @@ Object::UpdateSortedArray (struct Aggregates *aggregates, uint32_t j) const
       j--;
     }
 }
+void
+Object::FreeAggregates (struct Aggregates *aggregates)
+{
+  NS_LOG_FUNCTION (aggregates);
+  std::free (aggregates->cache);
+  std::free (aggregates);
+}
 void 
 Object::AggregateObject (Ptr<Object> o)
 {
@@ -260,6 +299,7 @@ Object::AggregateObject (Ptr<Object> o)
   struct Aggregates *aggregates = 
     (struct Aggregates *)std::malloc (sizeof(struct Aggregates)+(total-1)*sizeof(Object*));
   aggregates->n = total;
+  aggregates->cache = 0;
 
   // copy our buffer to the new buffer
   std::memcpy (&aggregates->buffer[0], 
@@ -303,8 +343,8 @@ Object::AggregateObject (Ptr<Object> o)
     }
 
   // Now that we are done with them, we can free our old aggregate buffers
-  std::free (a);
-  std::free (b);
+  FreeAggregates (a);
+  FreeAggregates (b);
 }
 /**
  * This function must be implemented in the stack that needs to notify
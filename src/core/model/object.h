@@ -229,6 +229,20 @@ private:
   friend class AggregateIterator;
   friend struct ObjectDeleter;
 
+  /**
+   * A direct-mapped cache of the results of DoGetObject, indexed by the
+   * uid of the TypeId looked up, the failed lookups included. It belongs
+   * to the Aggregates, so it is shared by all the aggregated objects and
+   * replaced with them by AggregateObject.
+   */
+  struct Cache {
+    enum { SIZE = 16 };
+    struct Entry {
+      // 0 if the entry is free
+      uint16_t uid;
+      Object *object;
+    } entries[SIZE];
+  };
   /**
    * This data structure uses a classic C-style trick to 
    * hold an array of variable size without performing
@@ -241,6 +255,11 @@ private:
    */
   struct Aggregates {
     uint32_t n;
+    /**
+     * The results of DoGetObject, 0 until a lookup has to search
+     * the buffer.
+     */
+    struct Cache *cache;
     Object *buffer[1];
   };
 
@@ -291,6 +310,12 @@ private:
    * \param i the most recently used entry in the list
    */
   void UpdateSortedArray (struct Aggregates *aggregates, uint32_t i) const;
+  /**
+   * Frees an array of aggregates and its cache
+   *
+   * \param aggregates the array to free
+   */
+  static void FreeAggregates (struct Aggregates *aggregates);
   /**
    * Attempt to delete this object. This method iterates
    * over all aggregated objects to check if they all 
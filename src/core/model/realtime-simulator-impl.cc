@@ -34,6 +34,7 @@
 
 
 #include <cmath>
+#include <algorithm>
 
 // Note:  Logging in this file is largely avoided due to the
 // number of calls that are made to these functions and the possibility
@@ -109,6 +110,14 @@ RealtimeSimulatorImpl::DoDispose (void)
       Scheduler::Event next = m_events->RemoveNext ();
       next.impl->Unref ();
     }
+  EventWithContext *event = m_eventsWithContext.PopAll ();
+  while (event != 0)
+    {
+      event->event->Unref ();
+      EventWithContext *next = event->next;
+      delete event;
+      event = next;
+    }
   m_events = 0;
   m_synchronizer = 0;
   SimulatorImpl::DoDispose ();
@@ -205,6 +214,15 @@ RealtimeSimulatorImpl::ProcessOneEvent (void)
 
       { 
         CriticalSection cs (m_mutex);
+        //
+        // This resets the synchronizer so that any future event will cause it
+        // to interrupt the wait below.  It has to come before the events
+        // scheduled from other threads are picked up: a thread which schedules
+        // one after this point finds the queue empty and signals.
+        //
+        m_synchronizer->SetCondition (false);
+        ProcessEventsWithContext ();
+
         //
         // Since we are in realtime mode, the time to delay has got to be the 
         // difference between the current realtime and the timestamp of the next 
@@ -248,12 +266,10 @@ RealtimeSimulatorImpl::ProcessOneEvent (void)
 
         //
         // We've figured out how long we need to delay in order to pace the 
-        // simulation time with the real time.  We're going to sleep, but need
-        // to work with the synchronizer to make sure we're awakened if something 
-        // external happens (like a packet is received).  This next line resets
-        // the synchronizer so that any future event will cause it to interrupt.
+        // simulation time with the real time.  We're going to sleep, but the
+        // synchronizer has been reset above, so we're awakened if something 
+        // external happens (like a packet is received).
         //
-        m_synchronizer->SetCondition (false);
       }
 
       //
@@ -415,6 +431,58 @@ RealtimeSimulatorImpl::NextTs (void) const
   return ev.key.m_ts;
 }
 
+//
+// Picks up the events scheduled from other threads.  Should be called with
+// critical section locked.
+//
+void
+RealtimeSimulatorImpl::ProcessEventsWithContext (void)
+{
+  if (m_eventsWithContext.IsEmpty ())
+    {
+      return;
+    }
+
+  EventWithContext *event = m_eventsWithContext.PopAll ();
+  while (event != 0)
+    {
+      Scheduler::Event ev;
+      ev.impl = event->event;
+      //
+      // The realtime clock was read before the event was queued, the event
+      // we're running may have been started later than that.
+      //
+      ev.key.m_ts = std::max (event->timestamp, m_currentTs);
+      ev.key.m_context = event->context;
+      ev.key.m_uid = m_uid;
+      m_uid++;
+      m_unscheduledEvents++;
+      m_events->Insert (ev);
+      EventWithContext *next = event->next;
+      delete event;
+      event = next;
+    }
+}
+
+//
+// Queues an event scheduled from a thread other than the one running the
+// simulation, without taking the critical section.  The simulation thread
+// only needs to be woken up by the first event of a batch, it picks up the
+// whole queue at once.
+//
+void
+RealtimeSimulatorImpl::ScheduleFromOtherThread (uint32_t context, uint64_t ts, EventImpl *impl)
+{
+  EventWithContext *event = new EventWithContext;
+  event->context = context;
+  event->timestamp = ts;
+  event->event = impl;
+  if (m_eventsWithContext.Push (event))
+    {
+      m_synchronizer->Signal ();
+    }
+}
+
 void
 RealtimeSimulatorImpl::Run (void)
 {
@@ -440,6 +508,8 @@ RealtimeSimulatorImpl::Run (void)
       {
         CriticalSection cs (m_mutex);
 
+        m_synchronizer->SetCondition (false);
+        ProcessEventsWithContext ();
         if (!m_events->IsEmpty ())
           {
             process = true;
@@ -541,23 +611,20 @@ RealtimeSimulatorImpl::ScheduleWithContext (uint32_t context, Time const &time,
 {
   NS_LOG_FUNCTION (this << context << time << impl);
 
+  if (!SystemThread::Equals (m_main))
+    {
+      //
+      // If the simulator is running, we're pacing and have a meaningful 
+      // realtime clock.  If we're not, then m_currentTs is where we stopped.
+      // 
+      uint64_t ts = m_running ? m_synchronizer->GetCurrentRealtime () : m_currentTs;
+      ScheduleFromOtherThread (context, ts + time.GetTimeStep (), impl);
+      return;
+    }
+
   {
     CriticalSection cs (m_mutex);
-    uint64_t ts;
-
-    if (SystemThread::Equals (m_main))
-      {
-        ts = m_currentTs + time.GetTimeStep ();
-      }
-    else
-      {
-        //
-        // If the simulator is running, we're pacing and have a meaningful 
-        // realtime clock.  If we're not, then m_currentTs is where we stopped.
-        // 
-        ts = m_running ? m_synchronizer->GetCurrentRealtime () : m_currentTs;
-        ts += time.GetTimeStep ();
-      }
+    uint64_t ts = m_currentTs + time.GetTimeStep ();
 
     NS_ASSERT_MSG (ts >= m_currentTs, "RealtimeSimulatorImpl::ScheduleRealtime(): schedule for time < m_currentTs");
     Scheduler::Event ev;
@@ -607,6 +674,12 @@ RealtimeSimulatorImpl::ScheduleRealtimeWithContext (uint32_t context, Time const
 {
   NS_LOG_FUNCTION (this << context << time << impl);
 
+  if (!SystemThread::Equals (m_main))
+    {
+      ScheduleFromOtherThread (context, m_synchronizer->GetCurrentRealtime () + time.GetTimeStep (), impl);
+      return;
+    }
+
   {
     CriticalSection cs (m_mutex);
 
@@ -615,6 +688,7 @@ RealtimeSimulatorImpl::ScheduleRealtimeWithContext (uint32_t context, Time const
     Scheduler::Event ev;
     ev.impl = impl;
     ev.key.m_ts = ts;
+    ev.key.m_context = context;
     ev.key.m_uid = m_uid;
     m_uid++;
     m_unscheduledEvents++;
@@ -634,13 +708,21 @@ void
 RealtimeSimulatorImpl::ScheduleRealtimeNowWithContext (uint32_t context, EventImpl *impl)
 {
   NS_LOG_FUNCTION (this << context << impl);
+
+  //
+  // If the simulator is running, we're pacing and have a meaningful 
+  // realtime clock.  If we're not, then m_currentTs is were we stopped.
+  // 
+  if (!SystemThread::Equals (m_main))
+    {
+      uint64_t ts = m_running ? m_synchronizer->GetCurrentRealtime () : m_currentTs;
+      ScheduleFromOtherThread (context, ts, impl);
+      return;
+    }
+
   {
     CriticalSection cs (m_mutex);
 
-    //
-    // If the simulator is running, we're pacing and have a meaningful 
-    // realtime clock.  If we're not, then m_currentTs is were we stopped.
-    // 
     uint64_t ts = m_running ? m_synchronizer->GetCurrentRealtime () : m_currentTs;
     NS_ASSERT_MSG (ts >= m_currentTs, 
                    "RealtimeSimulatorImpl::ScheduleRealtimeNowWithContext(): schedule for time < m_currentTs");
@@ -31,6 +31,7 @@
 #include "assert.h"
 #include "log.h"
 #include "system-mutex.h"
+#include "mpsc-queue.h"
 
 #include <list>
 
@@ -92,6 +93,8 @@ private:
   bool Realtime (void) const;
   uint64_t NextTs (void) const;
   void ProcessOneEvent (void);
+  void ProcessEventsWithContext (void);
+  void ScheduleFromOtherThread (uint32_t context, uint64_t ts, EventImpl *event);
   virtual void DoDispose (void);
 
   typedef std::list<EventId> DestroyEvents;
@@ -110,6 +113,15 @@ private:
 
   mutable SystemMutex m_mutex;
 
+  struct EventWithContext {
+    EventWithContext *next;
+    uint32_t context;
+    uint64_t timestamp;
+    EventImpl *event;
+  };
+  // events scheduled from other threads, which do not take m_mutex
+  MpscQueue<EventWithContext> m_eventsWithContext;
+
   Ptr<Synchronizer> m_synchronizer;
 
   /**
@@ -1,4 +1,5 @@
 #include "rng-seed-manager.h"
+#include "rng-stream.h"
 #include "global-value.h"
 #include "attribute-helper.h"
 #include "integer.h"
@@ -49,6 +50,13 @@ uint64_t RngSeedManager::GetRun ()
   return run;
 }
 
+void RngSeedManager::ResetRun (uint64_t run)
+{
+  NS_LOG_FUNCTION (run);
+  SetRun (run);
+  RngStream::RestartAll (run);
+}
+
 uint64_t RngSeedManager::GetNextStreamIndex (void)
 {
   NS_LOG_FUNCTION_NOARGS ();
@@ -60,6 +60,20 @@ public:
    */
   static uint64_t GetRun (void);
 
+  /**
+   * \brief Switch every rng stream, including the ones already in use, to
+   * another run
+   *
+   * Streams created from now on use \p run, as after SetRun. The streams
+   * created before restart from the beginning of the substream of \p run
+   * the next time they are used, as if they had been created with it. This
+   * lets copies of a simulation that share the same past, such as the
+   * branches of a SimulatorFork, draw independent numbers from then on.
+   *
+   * \param run the new run number
+   */
+  static void ResetRun (uint64_t run);
+
   static uint64_t GetNextStreamIndex(void);
 
 };
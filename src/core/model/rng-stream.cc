@@ -256,6 +256,12 @@ void PowerOfTwoMatrix (int n, Matrix a1p, Matrix a2p)
 
 
 namespace ns3 {
+
+// number of calls to RestartAll
+static uint32_t g_generation = 0;
+// substream of the last call to RestartAll
+static uint64_t g_substream = 0;
+
 //-------------------------------------------------------------------------
 // Generate the next random number.
 //
@@ -264,6 +270,11 @@ double RngStream::RandU01 ()
   int32_t k;
   double p1, p2, u;
 
+  if (m_generation != g_generation)
+    {
+      Restart ();
+    }
+
   /* Component 1 */
   p1 = a12 * m_currentState[1] - a13n * m_currentState[0];
   k = static_cast<int32_t> (p1 / m1);
@@ -291,6 +302,9 @@ double RngStream::RandU01 ()
 }
 
 RngStream::RngStream (uint32_t seedNumber, uint64_t stream, uint64_t substream)
+  : m_seed (seedNumber),
+    m_stream (stream),
+    m_generation (g_generation)
 {
   if (seedNumber >= m1 || seedNumber >= m2 || seedNumber == 0)
     {
@@ -305,6 +319,9 @@ RngStream::RngStream (uint32_t seedNumber, uint64_t stream, uint64_t substream)
 }
 
 RngStream::RngStream(const RngStream& r)
+  : m_seed (r.m_seed),
+    m_stream (r.m_stream),
+    m_generation (r.m_generation)
 {
   for (int i = 0; i < 6; ++i)
     {
@@ -312,6 +329,25 @@ RngStream::RngStream(const RngStream& r)
     }
 }
 
+void
+RngStream::RestartAll (uint64_t substream)
+{
+  g_substream = substream;
+  g_generation++;
+}
+
+void
+RngStream::Restart (void)
+{
+  for (int i = 0; i < 6; ++i)
+    {
+      m_currentState[i] = m_seed;
+    }
+  AdvanceNthBy (m_stream, 127, m_currentState);
+  AdvanceNthBy (g_substream, 76, m_currentState);
+  m_generation = g_generation;
+}
+
 void 
 RngStream::AdvanceNthBy (uint64_t nth, int by, double state[6])
 {
@@ -46,10 +46,24 @@ public:
    */
   double RandU01 (void);
 
+  /**
+   * Moves every stream, including the ones already created, to the
+   * beginning of another substream. Each stream is restarted from the
+   * beginning of \p substream of its own stream the next time it is used.
+   *
+   * \param substream the substream to restart from
+   */
+  static void RestartAll (uint64_t substream);
+
 private:
   void AdvanceNthBy (uint64_t nth, int by, double state[6]);
+  void Restart (void);
 
   double m_currentState[6];
+  uint32_t m_seed;
+  uint64_t m_stream;
+  // value of the RestartAll count when the state was computed
+  uint32_t m_generation;
 };
 
 } // namespace ns3
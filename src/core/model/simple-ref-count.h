@@ -22,6 +22,7 @@
 #ifndef SIMPLE_REF_COUNT_H
 #define SIMPLE_REF_COUNT_H
 
+#include "ns3/core-config.h"
 #include "empty.h"
 #include "default-deleter.h"
 #include "assert.h"
@@ -30,6 +31,43 @@
 
 namespace ns3 {
 
+/**
+ * \ingroup ptr
+ * \brief Increments a reference count.
+ *
+ * When ns-3 is configured with --enable-mtp, reference counts are updated
+ * atomically so that the objects and packets they guard can be shared by
+ * the threads of the MultithreadedSimulatorImpl.
+ *
+ * \param count the reference count
+ */
+inline void
+RefCountIncrement (uint32_t &count)
+{
+#ifdef NS3_MTP
+  __atomic_add_fetch (&count, 1, __ATOMIC_RELAXED);
+#else
+  count++;
+#endif
+}
+
+/**
+ * \ingroup ptr
+ * \brief Decrements a reference count.
+ *
+ * \param count the reference count
+ * \returns the reference count after the decrement
+ */
+inline uint32_t
+RefCountDecrement (uint32_t &count)
+{
+#ifdef NS3_MTP
+  return __atomic_sub_fetch (&count, 1, __ATOMIC_ACQ_REL);
+#else
+  return --count;
+#endif
+}
+
 /**
  * \ingroup ptr
  * \brief A template-based reference counting class
@@ -92,7 +130,7 @@ public:
   inline void Ref (void) const
   {
     NS_ASSERT (m_count < std::numeric_limits<uint32_t>::max());
-    m_count++;
+    RefCountIncrement (m_count);
   }
   /**
    * Decrement the reference count. This method should not be called
@@ -102,8 +140,7 @@ public:
    */
   inline void Unref (void) const
   {
-    m_count--;
-    if (m_count == 0)
+    if (RefCountDecrement (m_count) == 0)
       {
         DELETER::Delete (static_cast<T*> (const_cast<SimpleRefCount *> (this)));
       }
@@ -0,0 +1,286 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "simulator-fork.h"
+#include "simulator.h"
+#include "rng-seed-manager.h"
+#include "config.h"
+#include "assert.h"
+#include "fatal-error.h"
+#include "log.h"
+
+#include <cerrno>
+#include <cstring>
+#include <cstdio>
+#include <iostream>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/wait.h>
+
+NS_LOG_COMPONENT_DEFINE ("SimulatorFork");
+
+namespace ns3 {
+
+const uint32_t SimulatorFork::PARENT;
+
+SimulatorFork::SimulatorFork ()
+  : m_branch (PARENT),
+    m_forked (false)
+{
+  NS_LOG_FUNCTION (this);
+  long n = sysconf (_SC_NPROCESSORS_ONLN);
+  m_maxRunning = n > 0 ? n : 1;
+}
+
+SimulatorFork::~SimulatorFork ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+uint32_t
+SimulatorFork::AddBranch (uint64_t run)
+{
+  NS_LOG_FUNCTION (this << run);
+  NS_ASSERT_MSG (!m_forked, "SimulatorFork::AddBranch(): already forked");
+  Branch branch;
+  branch.run = run;
+  branch.pid = -1;
+  branch.fd = -1;
+  branch.status = 0;
+  m_branches.push_back (branch);
+  return m_branches.size () - 1;
+}
+
+void
+SimulatorFork::Set (uint32_t branch, std::string path, const AttributeValue &value)
+{
+  NS_LOG_FUNCTION (this << branch << path);
+  NS_ASSERT (branch < m_branches.size ());
+  Override o;
+  o.path = path;
+  o.value = value.Copy ();
+  m_branches[branch].overrides.push_back (o);
+}
+
+void
+SimulatorFork::SetMaxRunning (uint32_t n)
+{
+  NS_LOG_FUNCTION (this << n);
+  NS_ASSERT (n > 0);
+  m_maxRunning = n;
+}
+
+uint32_t
+SimulatorFork::GetMaxRunning (void) const
+{
+  return m_maxRunning;
+}
+
+void
+SimulatorFork::ForkAt (Time const &time)
+{
+  NS_LOG_FUNCTION (this << time);
+  Simulator::Schedule (time, &SimulatorFork::Fork, this);
+}
+
+uint32_t
+SimulatorFork::GetNBranches (void) const
+{
+  return m_branches.size ();
+}
+
+uint32_t
+SimulatorFork::GetBranch (void) const
+{
+  return m_branch;
+}
+
+bool
+SimulatorFork::IsBranch (void) const
+{
+  return m_branch != PARENT;
+}
+
+std::string
+SimulatorFork::GetOutput (uint32_t branch) const
+{
+  NS_ASSERT (!IsBranch () && branch < m_branches.size ());
+  return m_branches[branch].output;
+}
+
+int
+SimulatorFork::GetStatus (uint32_t branch) const
+{
+  NS_ASSERT (!IsBranch () && branch < m_branches.size ());
+  return m_branches[branch].status;
+}
+
+void
+SimulatorFork::Fork (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT_MSG (!m_forked, "SimulatorFork::Fork(): already forked");
+  m_forked = true;
+  uint32_t running = 0;
+  for (uint32_t i = 0; i < m_branches.size (); i++)
+    {
+      if (running == m_maxRunning)
+        {
+          Collect ();
+          running--;
+        }
+      Start (i);
+      if (IsBranch ())
+        {
+          // back to the simulation, in the new process
+          return;
+        }
+      running++;
+    }
+  while (running > 0)
+    {
+      Collect ();
+      running--;
+    }
+  Simulator::Stop ();
+}
+
+void
+SimulatorFork::Start (uint32_t branch)
+{
+  NS_LOG_FUNCTION (this << branch);
+  int fds[2];
+  if (pipe (fds) == -1)
+    {
+      NS_FATAL_ERROR ("pipe() failed: " << std::strerror (errno));
+    }
+  // the buffered output would otherwise be written again by the branch
+  std::cout.flush ();
+  std::cerr.flush ();
+  std::fflush (0);
+  pid_t pid = fork ();
+  if (pid == -1)
+    {
+      NS_FATAL_ERROR ("fork() failed: " << std::strerror (errno));
+    }
+  if (pid == 0)
+    {
+      close (fds[0]);
+      RunBranch (branch, fds[1]);
+      return;
+    }
+  NS_LOG_LOGIC ("branch " << branch << " runs in process " << pid);
+  close (fds[1]);
+  m_branches[branch].pid = pid;
+  m_branches[branch].fd = fds[0];
+}
+
+void
+SimulatorFork::RunBranch (uint32_t branch, int fd)
+{
+  NS_LOG_FUNCTION (this << branch << fd);
+  // the pipes of the branches started before belong to the parent
+  for (uint32_t i = 0; i < m_branches.size (); i++)
+    {
+      if (m_branches[i].fd != -1)
+        {
+          close (m_branches[i].fd);
+          m_branches[i].fd = -1;
+        }
+    }
+  if (dup2 (fd, STDOUT_FILENO) == -1)
+    {
+      NS_FATAL_ERROR ("dup2() failed: " << std::strerror (errno));
+    }
+  close (fd);
+  m_branch = branch;
+
+  RngSeedManager::ResetRun (m_branches[branch].run);
+  for (std::vector<Override>::const_iterator i = m_branches[branch].overrides.begin ();
+       i != m_branches[branch].overrides.end (); i++)
+    {
+      Config::Set (i->path, *i->value);
+    }
+}
+
+void
+SimulatorFork::Collect (void)
+{
+  NS_LOG_FUNCTION (this);
+  for (;;)
+    {
+      std::vector<struct pollfd> fds;
+      std::vector<uint32_t> branches;
+      for (uint32_t i = 0; i < m_branches.size (); i++)
+        {
+          if (m_branches[i].fd != -1)
+            {
+              struct pollfd pfd;
+              pfd.fd = m_branches[i].fd;
+              pfd.events = POLLIN;
+              pfd.revents = 0;
+              fds.push_back (pfd);
+              branches.push_back (i);
+            }
+        }
+      NS_ASSERT (!fds.empty ());
+      if (poll (&fds[0], fds.size (), -1) == -1)
+        {
+          if (errno == EINTR)
+            {
+              continue;
+            }
+          NS_FATAL_ERROR ("poll() failed: " << std::strerror (errno));
+        }
+      for (uint32_t i = 0; i < fds.size (); i++)
+        {
+          if (fds[i].revents == 0)
+            {
+              continue;
+            }
+          Branch &branch = m_branches[branches[i]];
+          char buf[4096];
+          ssize_t len = read (branch.fd, buf, sizeof (buf));
+          if (len > 0)
+            {
+              branch.output.append (buf, len);
+              continue;
+            }
+          if (len == -1 && errno == EINTR)
+            {
+              continue;
+            }
+          if (len == -1)
+            {
+              NS_FATAL_ERROR ("read() failed: " << std::strerror (errno));
+            }
+          // end of file, the branch is exiting
+          close (branch.fd);
+          branch.fd = -1;
+          while (waitpid (branch.pid, &branch.status, 0) == -1)
+            {
+              if (errno != EINTR)
+                {
+                  NS_FATAL_ERROR ("waitpid() failed: " << std::strerror (errno));
+                }
+            }
+          NS_LOG_LOGIC ("branch " << branches[i] << " exited with status " << branch.status);
+          return;
+        }
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,182 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef SIMULATOR_FORK_H
+#define SIMULATOR_FORK_H
+
+#include "nstime.h"
+#include "attribute.h"
+#include "ptr.h"
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+namespace ns3 {
+
+/**
+ * \ingroup simulator
+ * \brief Branches a running simulation into several processes
+ *
+ * Parameter sweeps often spend most of their time in the same warm-up
+ * (routing convergence, association, joining the network) before the
+ * parameter under study makes any difference. A SimulatorFork runs the
+ * warm-up once: at the time given to ForkAt, the process is fork()ed once
+ * per branch, so every branch starts from exactly the same state: the
+ * same pending events, objects and random streams.  Each branch then
+ * - switches every random stream, including the ones already in use, to
+ *   the run number of the branch (see RngSeedManager::ResetRun),
+ * - applies its attribute overrides with Config::Set,
+ * - resumes the simulation with its standard output redirected to a pipe
+ *   read by the parent.
+ *
+ * The parent does not simulate past the fork point: it collects the
+ * output of the branches, running at most GetMaxRunning of them at once,
+ * and stops the simulation once they have all exited.  A typical sweep
+ * looks like:
+ * \code
+ * SimulatorFork fork;
+ * for (uint32_t i = 0; i < 10; i++)
+ *   {
+ *     uint32_t branch = fork.AddBranch (i + 1);
+ *     fork.Set (branch, "/NodeList/0/DeviceList/0/Mtu", UintegerValue (100 * (i + 1)));
+ *   }
+ * fork.ForkAt (Seconds (30));
+ * Simulator::Stop (Seconds (100));
+ * Simulator::Run ();
+ * if (fork.IsBranch ())
+ *   {
+ *     std::cout << results;
+ *   }
+ * else
+ *   {
+ *     for (uint32_t i = 0; i < fork.GetNBranches (); i++)
+ *       {
+ *         std::cout << fork.GetOutput (i);
+ *       }
+ *   }
+ * Simulator::Destroy ();
+ * \endcode
+ *
+ * Only the thread running the fork event survives in the branches, the
+ * simulation must not be running other threads at that time, which rules
+ * out the realtime and multithreaded simulator implementations. Files
+ * opened before the fork point are shared by all the processes: traces
+ * should be enabled, or given a name derived from GetBranch, after it.
+ * The standard error of the branches is not redirected.
+ */
+class SimulatorFork
+{
+public:
+  /**
+   * Returned by GetBranch in the parent process
+   */
+  static const uint32_t PARENT = 0xffffffff;
+
+  SimulatorFork ();
+  ~SimulatorFork ();
+
+  /**
+   * \param run the run number of the branch
+   * \returns the index of the new branch
+   */
+  uint32_t AddBranch (uint64_t run);
+  /**
+   * Adds an attribute override to a branch, applied with Config::Set
+   * right after the fork
+   *
+   * \param branch the index of the branch
+   * \param path the path of the attribute
+   * \param value the value of the attribute
+   */
+  void Set (uint32_t branch, std::string path, const AttributeValue &value);
+  /**
+   * \param n the maximum number of branches running at the same time,
+   * the number of processors by default
+   */
+  void SetMaxRunning (uint32_t n);
+  /**
+   * \returns the maximum number of branches running at the same time
+   */
+  uint32_t GetMaxRunning (void) const;
+  /**
+   * Schedules the fork
+   *
+   * \param time the delay of the fork point
+   */
+  void ForkAt (Time const &time);
+
+  /**
+   * \returns the number of branches
+   */
+  uint32_t GetNBranches (void) const;
+  /**
+   * \returns the index of the branch run by this process, or PARENT
+   */
+  uint32_t GetBranch (void) const;
+  /**
+   * \returns true in the processes of the branches
+   */
+  bool IsBranch (void) const;
+  /**
+   * Can only be called in the parent, once the simulation has stopped.
+   *
+   * \param branch the index of the branch
+   * \returns everything the branch wrote to its standard output
+   */
+  std::string GetOutput (uint32_t branch) const;
+  /**
+   * Can only be called in the parent, once the simulation has stopped.
+   *
+   * \param branch the index of the branch
+   * \returns the exit status of the branch, as returned by waitpid
+   */
+  int GetStatus (uint32_t branch) const;
+
+private:
+  struct Override
+  {
+    std::string path;
+    Ptr<const AttributeValue> value;
+  };
+  struct Branch
+  {
+    uint64_t run;
+    std::vector<Override> overrides;
+    pid_t pid;
+    // read end of the pipe of its standard output, -1 once closed
+    int fd;
+    std::string output;
+    int status;
+  };
+
+  void Fork (void);
+  void Start (uint32_t branch);
+  /**
+   * Reads the outputs of the running branches until one of them exits
+   */
+  void Collect (void);
+  void RunBranch (uint32_t branch, int fd);
+
+  std::vector<Branch> m_branches;
+  uint32_t m_maxRunning;
+  uint32_t m_branch;
+  bool m_forked;
+};
+
+} // namespace ns3
+
+#endif /* SIMULATOR_FORK_H */
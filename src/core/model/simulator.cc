@@ -61,6 +61,18 @@ TimePrinter (std::ostream &os)
   os << Simulator::Now ().GetSeconds () << "s";
 }
 
+static double
+TimeGetter (void)
+{
+  return Simulator::Now ().GetSeconds ();
+}
+
+static uint32_t
+NodeGetter (void)
+{
+  return Simulator::GetContext ();
+}
+
 static void
 NodePrinter (std::ostream &os)
 {
@@ -113,6 +125,8 @@ static SimulatorImpl * GetImpl (void)
 //
       LogSetTimePrinter (&TimePrinter);
       LogSetNodePrinter (&NodePrinter);
+      LogSetTimeGetter (&TimeGetter);
+      LogSetNodeGetter (&NodeGetter);
     }
   return *pimpl;
 }
@@ -134,6 +148,8 @@ Simulator::Destroy (void)
    */
   LogSetTimePrinter (0);
   LogSetNodePrinter (0);
+  LogSetTimeGetter (0);
+  LogSetNodeGetter (0);
   (*pimpl)->Destroy ();
   (*pimpl)->Unref ();
   *pimpl = 0;
@@ -341,6 +357,8 @@ Simulator::SetImplementation (Ptr<SimulatorImpl> impl)
 //
   LogSetTimePrinter (&TimePrinter);
   LogSetNodePrinter (&NodePrinter);
+  LogSetTimeGetter (&TimeGetter);
+  LogSetNodeGetter (&NodeGetter);
 }
 Ptr<SimulatorImpl>
 Simulator::GetImplementation (void)
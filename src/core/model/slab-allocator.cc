@@ -0,0 +1,389 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "slab-allocator.h"
+#include "assert.h"
+#include "ns3/core-config.h"
+#include <algorithm>
+#include <iomanip>
+#include <new>
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif /* HAVE_PTHREAD_H */
+
+namespace ns3 {
+
+namespace {
+
+const uint32_t SLAB_CLASSES = 18;
+const uint32_t g_blockSizes[SLAB_CLASSES] = {
+  16, 32, 48, 64,
+  96, 128, 192, 256, 384, 512, 768, 1024,
+  1536, 2048, 3072, 4096, 6144, 8192
+};
+// size of the chunks of memory carved into blocks
+const uint32_t SLAB_CHUNK = 64 * 1024;
+
+struct FreeBlock
+{
+  FreeBlock *next;
+  // the next batch, in the first block of a batch of the depot
+  FreeBlock *nextBatch;
+};
+
+struct ThreadCache
+{
+  FreeBlock *freeBlocks[SLAB_CLASSES];
+  uint32_t nFreeBlocks[SLAB_CLASSES];
+  // the large requests are counted in the last one
+  SlabAllocator::Stats stats[SLAB_CLASSES + 1];
+  // set while a thread owns the cache
+  bool owned;
+  // the next cache of the list of all the threads
+  ThreadCache *next;
+};
+
+__thread ThreadCache *g_cache = 0;
+// the caches are never freed: those of the threads which exited are
+// taken over by the new threads, with their counters
+ThreadCache *g_caches = 0;
+
+// batches of blocks freed by a thread that held too many of them
+FreeBlock *g_depot[SLAB_CLASSES];
+// blocks left by the threads which exited, fewer than a batch each
+FreeBlock *g_depotLoose[SLAB_CLASSES];
+uint32_t g_nDepotLoose[SLAB_CLASSES];
+volatile bool g_depotLock = false;
+
+void
+LockDepot (void)
+{
+  while (__atomic_test_and_set (&g_depotLock, __ATOMIC_ACQUIRE))
+    {
+    }
+}
+
+void
+UnlockDepot (void)
+{
+  __atomic_clear (&g_depotLock, __ATOMIC_RELEASE);
+}
+
+/**
+ * Counts one more event in a counter of the calling thread, which the
+ * other threads may read at the same time
+ */
+inline void
+Increment (uint64_t *counter)
+{
+  __atomic_store_n (counter, __atomic_load_n (counter, __ATOMIC_RELAXED) + 1, __ATOMIC_RELAXED);
+}
+
+inline uint32_t
+GetSizeClass (uint32_t size)
+{
+  if (size <= 64)
+    {
+      return size == 0 ? 0 : (size - 1) >> 4;
+    }
+  // two classes between consecutive powers of two
+  uint32_t s = size - 1;
+  uint32_t log = 31 - __builtin_clz (s);
+  return 4 + 2 * (log - 6) + ((s >> (log - 1)) & 1);
+}
+
+/**
+ * \returns the number of blocks moved at once between a thread and the
+ * depot: no more than a chunk for the large blocks
+ */
+inline uint32_t
+GetBatchSize (uint32_t sizeClass)
+{
+  return std::max (16U, std::min (256U, SLAB_CHUNK / g_blockSizes[sizeClass]));
+}
+
+void
+Flush (ThreadCache *cache, uint32_t sizeClass)
+{
+  uint32_t batchSize = GetBatchSize (sizeClass);
+  FreeBlock *batch = cache->freeBlocks[sizeClass];
+  FreeBlock *last = batch;
+  for (uint32_t i = 1; i < batchSize; i++)
+    {
+      last = last->next;
+    }
+  cache->freeBlocks[sizeClass] = last->next;
+  cache->nFreeBlocks[sizeClass] -= batchSize;
+  last->next = 0;
+
+  LockDepot ();
+  batch->nextBatch = g_depot[sizeClass];
+  g_depot[sizeClass] = batch;
+  UnlockDepot ();
+}
+
+#ifdef HAVE_PTHREAD_H
+
+/**
+ * Gives the free blocks of a cache back to the depot, and the cache to
+ * the next thread which starts
+ */
+void
+ReleaseCache (void *p)
+{
+  ThreadCache *cache = static_cast<ThreadCache *> (p);
+  for (uint32_t sizeClass = 0; sizeClass < SLAB_CLASSES; sizeClass++)
+    {
+      while (cache->nFreeBlocks[sizeClass] >= GetBatchSize (sizeClass))
+        {
+          Flush (cache, sizeClass);
+        }
+      FreeBlock *head = cache->freeBlocks[sizeClass];
+      if (head == 0)
+        {
+          continue;
+        }
+      FreeBlock *last = head;
+      while (last->next != 0)
+        {
+          last = last->next;
+        }
+      LockDepot ();
+      last->next = g_depotLoose[sizeClass];
+      g_depotLoose[sizeClass] = head;
+      g_nDepotLoose[sizeClass] += cache->nFreeBlocks[sizeClass];
+      UnlockDepot ();
+      cache->freeBlocks[sizeClass] = 0;
+      cache->nFreeBlocks[sizeClass] = 0;
+    }
+  g_cache = 0;
+  __atomic_store_n (&cache->owned, false, __ATOMIC_RELEASE);
+}
+
+pthread_key_t g_threadExitKey;
+pthread_once_t g_threadExitOnce = PTHREAD_ONCE_INIT;
+
+void
+CreateThreadExitKey (void)
+{
+  pthread_key_create (&g_threadExitKey, &ReleaseCache);
+}
+
+#endif /* HAVE_PTHREAD_H */
+
+ThreadCache *
+CreateCache (void)
+{
+  ThreadCache *cache;
+  for (cache = __atomic_load_n (&g_caches, __ATOMIC_ACQUIRE); cache != 0; cache = cache->next)
+    {
+      if (!__atomic_load_n (&cache->owned, __ATOMIC_RELAXED)
+          && !__atomic_exchange_n (&cache->owned, true, __ATOMIC_ACQUIRE))
+        {
+          break;
+        }
+    }
+  if (cache == 0)
+    {
+      cache = new ThreadCache ();
+      cache->owned = true;
+      for (uint32_t i = 0; i <= SLAB_CLASSES; i++)
+        {
+          cache->stats[i].blockSize = i < SLAB_CLASSES ? g_blockSizes[i] : 0;
+        }
+      cache->next = __atomic_load_n (&g_caches, __ATOMIC_RELAXED);
+      while (!__atomic_compare_exchange_n (&g_caches, &cache->next, cache, true,
+                                           __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+        {
+        }
+    }
+#ifdef HAVE_PTHREAD_H
+  // the destructor of a key only runs for the threads that set it
+  pthread_once (&g_threadExitOnce, &CreateThreadExitKey);
+  pthread_setspecific (g_threadExitKey, cache);
+#endif /* HAVE_PTHREAD_H */
+  g_cache = cache;
+  return cache;
+}
+
+inline ThreadCache *
+GetCache (void)
+{
+  ThreadCache *cache = g_cache;
+  if (cache == 0)
+    {
+      cache = CreateCache ();
+    }
+  return cache;
+}
+
+FreeBlock *
+Refill (ThreadCache *cache, uint32_t sizeClass)
+{
+  LockDepot ();
+  FreeBlock *batch = g_depotLoose[sizeClass];
+  uint32_t n = g_nDepotLoose[sizeClass];
+  if (batch != 0)
+    {
+      g_depotLoose[sizeClass] = 0;
+      g_nDepotLoose[sizeClass] = 0;
+    }
+  else
+    {
+      batch = g_depot[sizeClass];
+      n = GetBatchSize (sizeClass);
+      if (batch != 0)
+        {
+          g_depot[sizeClass] = batch->nextBatch;
+        }
+    }
+  UnlockDepot ();
+  if (batch != 0)
+    {
+      Increment (&cache->stats[sizeClass].refills);
+      cache->nFreeBlocks[sizeClass] = n;
+      return batch;
+    }
+
+  uint32_t blockSize = g_blockSizes[sizeClass];
+  n = SLAB_CHUNK / blockSize;
+  char *chunk = static_cast<char *> (::operator new (SLAB_CHUNK));
+  FreeBlock *head = 0;
+  for (uint32_t i = n; i > 0; i--)
+    {
+      FreeBlock *block = reinterpret_cast<FreeBlock *> (chunk + (i - 1) * blockSize);
+      block->next = head;
+      head = block;
+    }
+  Increment (&cache->stats[sizeClass].chunks);
+  cache->nFreeBlocks[sizeClass] = n;
+  return head;
+}
+
+} // anonymous namespace
+
+void *
+SlabAllocator::Allocate (uint32_t size)
+{
+  ThreadCache *cache = GetCache ();
+  uint32_t sizeClass = GetSizeClass (size);
+  if (sizeClass >= SLAB_CLASSES)
+    {
+      Increment (&cache->stats[SLAB_CLASSES].allocations);
+      return ::operator new (size);
+    }
+  Increment (&cache->stats[sizeClass].allocations);
+  FreeBlock *block = cache->freeBlocks[sizeClass];
+  if (block == 0)
+    {
+      block = Refill (cache, sizeClass);
+    }
+  cache->freeBlocks[sizeClass] = block->next;
+  cache->nFreeBlocks[sizeClass]--;
+  return block;
+}
+
+void
+SlabAllocator::Deallocate (void *p, uint32_t size)
+{
+  ThreadCache *cache = GetCache ();
+  uint32_t sizeClass = GetSizeClass (size);
+  if (sizeClass >= SLAB_CLASSES)
+    {
+      Increment (&cache->stats[SLAB_CLASSES].deallocations);
+      ::operator delete (p);
+      return;
+    }
+  Increment (&cache->stats[sizeClass].deallocations);
+  FreeBlock *block = static_cast<FreeBlock *> (p);
+  block->next = cache->freeBlocks[sizeClass];
+  cache->freeBlocks[sizeClass] = block;
+  cache->nFreeBlocks[sizeClass]++;
+  if (cache->nFreeBlocks[sizeClass] >= 2 * GetBatchSize (sizeClass))
+    {
+      Flush (cache, sizeClass);
+    }
+}
+
+uint32_t
+SlabAllocator::GetBlockSize (uint32_t size)
+{
+  uint32_t sizeClass = GetSizeClass (size);
+  return sizeClass < SLAB_CLASSES ? g_blockSizes[sizeClass] : size;
+}
+
+uint32_t
+SlabAllocator::GetNClasses (void)
+{
+  return SLAB_CLASSES + 1;
+}
+
+struct SlabAllocator::Stats
+SlabAllocator::GetStats (uint32_t sizeClass)
+{
+  NS_ASSERT (sizeClass <= SLAB_CLASSES);
+  struct Stats stats;
+  stats.blockSize = sizeClass < SLAB_CLASSES ? g_blockSizes[sizeClass] : 0;
+  stats.allocations = 0;
+  stats.deallocations = 0;
+  stats.chunks = 0;
+  stats.refills = 0;
+  // the counters of the other threads may be a little behind
+  for (ThreadCache *cache = __atomic_load_n (&g_caches, __ATOMIC_ACQUIRE);
+       cache != 0; cache = cache->next)
+    {
+      Stats *counters = &cache->stats[sizeClass];
+      stats.allocations += __atomic_load_n (&counters->allocations, __ATOMIC_RELAXED);
+      stats.deallocations += __atomic_load_n (&counters->deallocations, __ATOMIC_RELAXED);
+      stats.chunks += __atomic_load_n (&counters->chunks, __ATOMIC_RELAXED);
+      stats.refills += __atomic_load_n (&counters->refills, __ATOMIC_RELAXED);
+    }
+  return stats;
+}
+
+void
+SlabAllocator::PrintStats (std::ostream &os)
+{
+  os << std::setw (10) << "block size"
+     << std::setw (14) << "allocations"
+     << std::setw (14) << "deallocations"
+     << std::setw (10) << "in use"
+     << std::setw (8) << "chunks"
+     << std::setw (10) << "refills" << std::endl;
+  for (uint32_t i = 0; i < GetNClasses (); i++)
+    {
+      struct Stats stats = GetStats (i);
+      if (stats.allocations == 0)
+        {
+          continue;
+        }
+      if (stats.blockSize == 0)
+        {
+          os << std::setw (10) << "large";
+        }
+      else
+        {
+          os << std::setw (10) << stats.blockSize;
+        }
+      os << std::setw (14) << stats.allocations
+         << std::setw (14) << stats.deallocations
+         << std::setw (10) << (int64_t)(stats.allocations - stats.deallocations)
+         << std::setw (8) << stats.chunks
+         << std::setw (10) << stats.refills << std::endl;
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,102 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef SLAB_ALLOCATOR_H
+#define SLAB_ALLOCATOR_H
+
+#include <stdint.h>
+#include <ostream>
+
+namespace ns3 {
+
+/**
+ * \ingroup core
+ *
+ * \brief Allocates small objects from size-classed slabs
+ *
+ * The events, and the bytes of the Buffer, the PacketMetadata, the
+ * ByteTagList and the PacketTagList of a packet, are carved from 64 KiB
+ * chunks divided into blocks of one size class: every multiple of 16
+ * bytes up to 64 bytes, then two classes per power of two (96, 128,
+ * 192, 256, ...) up to 8 KiB, so that at most a third of a block is
+ * lost to rounding. The larger requests go to the global allocator.
+ *
+ * Every thread keeps its own free list of each class, so that the
+ * threads of a multithreaded simulation do not contend. A block freed
+ * by another thread than the one that allocated it joins the free list
+ * of the freeing thread; once a thread holds too many free blocks of a
+ * class, it hands a batch of them back to a shared depot, where the
+ * threads which run dry take them before carving a new chunk. The free
+ * blocks of a thread go to the depot as well when it exits, and its
+ * counters to the next thread which starts. The chunks are never
+ * released: their blocks keep being reused.
+ *
+ * The users round their requests up with GetBlockSize to use the whole
+ * block, and must give the same size back to Deallocate.
+ */
+class SlabAllocator
+{
+public:
+  /**
+   * The counters of a size class, summed over the threads, those which
+   * exited included
+   */
+  struct Stats
+  {
+    uint32_t blockSize;      //!< size of the blocks, 0 for the large requests
+    uint64_t allocations;    //!< number of calls to Allocate
+    uint64_t deallocations;  //!< number of calls to Deallocate
+    uint64_t chunks;         //!< number of chunks carved into blocks
+    uint64_t refills;        //!< number of batches taken from the depot
+  };
+
+  /**
+   * \param size the number of bytes needed
+   * \returns a block of at least size bytes, aligned on 16 bytes
+   */
+  static void *Allocate (uint32_t size);
+  /**
+   * \param p a block returned by Allocate
+   * \param size the size given to Allocate, or the block size it was
+   *        rounded up to
+   */
+  static void Deallocate (void *p, uint32_t size);
+  /**
+   * \param size the number of bytes needed
+   * \returns the size of the block Allocate returns for this size
+   */
+  static uint32_t GetBlockSize (uint32_t size);
+
+  /**
+   * \returns the number of size classes, the large requests included
+   */
+  static uint32_t GetNClasses (void);
+  /**
+   * \param sizeClass the index of the class, GetNClasses () - 1 for the
+   *        large requests
+   * \returns the counters of the class
+   */
+  static struct Stats GetStats (uint32_t sizeClass);
+  /**
+   * Prints the counters of the classes which have been used
+   *
+   * \param os the output stream
+   */
+  static void PrintStats (std::ostream &os);
+};
+
+} // namespace ns3
+
+#endif /* SLAB_ALLOCATOR_H */
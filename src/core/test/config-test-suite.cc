@@ -33,6 +33,7 @@
 
 
 #include <sstream>
+#include <vector>
 
 using namespace ns3;
 
@@ -606,6 +607,121 @@ ObjectVectorTraceConfigTestCase::DoRun (void)
   NS_TEST_ASSERT_MSG_EQ (m_path, "/NodeA/NodeB/NodesB/1/Source", "Trace 1 did not provide expected context");
 }
 
+// ===========================================================================
+// Test for the resolution of several paths at once
+// ===========================================================================
+class BatchConfigTestCase : public TestCase
+{
+public:
+  BatchConfigTestCase ();
+  virtual ~BatchConfigTestCase () {}
+
+  void Trace (int16_t oldValue, int16_t newValue) { m_nTraces++; }
+  void TraceWithPath (std::string path, int16_t old, int16_t newValue) { m_paths.push_back (path); }
+
+private:
+  virtual void DoRun (void);
+
+  uint32_t m_nTraces;
+  std::vector<std::string> m_paths;
+};
+
+BatchConfigTestCase::BatchConfigTestCase ()
+  : TestCase ("Check that several paths resolved together match as one at a time")
+{
+}
+
+void
+BatchConfigTestCase::DoRun (void)
+{
+  IntegerValue iv;
+
+  Ptr<ConfigTestObject> root = CreateObject<ConfigTestObject> ();
+  Config::RegisterRootNamespaceObject (root);
+  Ptr<ConfigTestObject> a = CreateObject<ConfigTestObject> ();
+  root->SetNodeA (a);
+  std::vector<Ptr<ConfigTestObject> > objects;
+  for (uint32_t i = 0; i < 5; i++)
+    {
+      objects.push_back (CreateObject<ConfigTestObject> ());
+      a->AddNodeA (objects[i]);
+    }
+
+  //
+  // The paths share their beginning, overlap, and one of them does not
+  // match anything.
+  //
+  std::vector<std::string> paths;
+  paths.push_back ("/NodeA/NodesA/3");
+  paths.push_back ("/NodeA/NodesA/[0-1]|3");
+  paths.push_back ("/NodeA/NodesA/*");
+  paths.push_back ("/NodeA/NodesA/7");
+  paths.push_back ("NodeA/NodeB");
+  paths.push_back ("/NodeA");
+  std::vector<Config::MatchContainer> matches = Config::LookupMatches (paths);
+  NS_TEST_ASSERT_MSG_EQ (matches.size (), paths.size (), "one container per path");
+  for (uint32_t i = 0; i < paths.size (); i++)
+    {
+      Config::MatchContainer single = Config::LookupMatches (paths[i]);
+      NS_TEST_EXPECT_MSG_EQ (matches[i].GetPath (), single.GetPath (), "path " << i);
+      NS_TEST_ASSERT_MSG_EQ (matches[i].GetN (), single.GetN (), "path " << paths[i]);
+      for (uint32_t j = 0; j < single.GetN (); j++)
+        {
+          NS_TEST_EXPECT_MSG_EQ (matches[i].Get (j), single.Get (j), "path " << paths[i]);
+          NS_TEST_EXPECT_MSG_EQ (matches[i].GetMatchedPath (j), single.GetMatchedPath (j), "path " << paths[i]);
+        }
+    }
+  NS_TEST_ASSERT_MSG_EQ (matches[0].GetN (), 1, "a single index");
+  NS_TEST_EXPECT_MSG_EQ (matches[0].Get (0), objects[3], "a single index");
+  NS_TEST_EXPECT_MSG_EQ (matches[0].GetMatchedPath (0), "/NodeA/NodesA/3/", "a single index");
+  NS_TEST_ASSERT_MSG_EQ (matches[1].GetN (), 3, "alternatives");
+  NS_TEST_EXPECT_MSG_EQ (matches[1].Get (2), objects[3], "alternatives");
+  NS_TEST_EXPECT_MSG_EQ (matches[2].GetN (), 5, "wildcard");
+  NS_TEST_EXPECT_MSG_EQ (matches[3].GetN (), 0, "index out of the container");
+  // the roots registered by the other test cases are still there
+  bool found = false;
+  for (uint32_t j = 0; j < matches[5].GetN (); j++)
+    {
+      found = found || matches[5].Get (j) == a;
+    }
+  NS_TEST_EXPECT_MSG_EQ (found, true, "intermediate object");
+
+  //
+  // The operations of a batch are applied in order.
+  //
+  Config::Batch batch;
+  batch.Set ("/NodeA/NodesA/*/A", IntegerValue (1));
+  batch.Set ("/NodeA/NodesA/[1-2]/A", IntegerValue (2));
+  batch.Set ("/NodeA/NodesA/4/B", IntegerValue (3));
+  batch.ConnectWithoutContext ("/NodeA/NodesA/0|4/Source",
+                               MakeCallback (&BatchConfigTestCase::Trace, this));
+  batch.Connect ("/NodeA/NodesA/2/Source",
+                 MakeCallback (&BatchConfigTestCase::TraceWithPath, this));
+  NS_TEST_EXPECT_MSG_EQ (batch.GetN (), 5, "operations of the batch");
+  batch.Apply ();
+  NS_TEST_EXPECT_MSG_EQ (batch.GetN (), 0, "the batch is empty once applied");
+
+  int8_t expected[] = {1, 2, 2, 1, 1};
+  for (uint32_t i = 0; i < objects.size (); i++)
+    {
+      objects[i]->GetAttribute ("A", iv);
+      NS_TEST_EXPECT_MSG_EQ (iv.Get (), expected[i], "A of object " << i);
+      objects[i]->GetAttribute ("B", iv);
+      NS_TEST_EXPECT_MSG_EQ (iv.Get (), (i == 4 ? 3 : 9), "B of object " << i);
+    }
+
+  m_nTraces = 0;
+  for (uint32_t i = 0; i < objects.size (); i++)
+    {
+      objects[i]->SetAttribute ("Source", IntegerValue (i));
+    }
+  NS_TEST_EXPECT_MSG_EQ (m_nTraces, 2, "traces connected without context");
+  NS_TEST_ASSERT_MSG_EQ (m_paths.size (), 1, "trace connected with context");
+  NS_TEST_EXPECT_MSG_EQ (m_paths[0], "/NodeA/NodesA/2/Source", "context of the trace");
+
+  Config::UnregisterRootNamespaceObject (root);
+}
+
 // ===========================================================================
 // The Test Suite that glues all of the Test Cases together.
 // ===========================================================================
@@ -621,6 +737,7 @@ ConfigTestSuite::ConfigTestSuite ()
   AddTestCase (new RootNamespaceConfigTestCase, TestCase::QUICK);
   AddTestCase (new UnderRootNamespaceConfigTestCase, TestCase::QUICK);
   AddTestCase (new ObjectVectorConfigTestCase, TestCase::QUICK);
+  AddTestCase (new BatchConfigTestCase, TestCase::QUICK);
 }
 
 static ConfigTestSuite configTestSuite;
@@ -0,0 +1,140 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "ns3/test.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/nstime.h"
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+NS_LOG_COMPONENT_DEFINE_CEILING ("LogTestSuite", ns3::LOG_LEVEL_FUNCTION);
+
+using namespace ns3;
+
+// a value which prints nothing
+struct LogEmpty
+{
+};
+
+static std::ostream &
+operator << (std::ostream &os, const LogEmpty &empty)
+{
+  return os;
+}
+
+class LogBinaryTestCase : public TestCase
+{
+public:
+  LogBinaryTestCase ();
+  virtual void DoRun (void);
+private:
+  void Log (uint32_t i);
+  void LogNull (uint32_t i);
+  std::string Capture (bool binary);
+};
+
+LogBinaryTestCase::LogBinaryTestCase ()
+  : TestCase ("Check that the binary logs decode to the text of the messages")
+{
+}
+
+void
+LogBinaryTestCase::Log (uint32_t i)
+{
+  std::string s = "string";
+  uint8_t c = 'c';
+  NS_LOG_FUNCTION (this << i << s << Seconds (i));
+  NS_LOG_FUNCTION_NOARGS ();
+  NS_LOG_FUNCTION (i << LogEmpty () << i << std::hex << i << std::dec << i);
+  NS_LOG_INFO ("i=" << i << " -1=" << -1 << " c=" << c << " s=" << s << " 1.5=" << 1.5
+               << " true=" << true << " time=" << Seconds (i)
+               << " hex=" << std::hex << 255 << std::dec << " " << std::setw (4) << 3);
+  NS_LOG_WARN ("warning " << i);
+  NS_LOG_LOGIC ("above the ceiling " << i);
+}
+
+void
+LogBinaryTestCase::LogNull (uint32_t i)
+{
+  char const *null = 0;
+  NS_LOG_FUNCTION (i << null << i);
+}
+
+std::string
+LogBinaryTestCase::Capture (bool binary)
+{
+  std::ostringstream os;
+  std::streambuf *clog = std::clog.rdbuf (os.rdbuf ());
+  if (binary)
+    {
+      LogEnableBinary ("");
+    }
+  Log (0);
+  for (uint32_t i = 1; i < 4; i++)
+    {
+      Simulator::Schedule (Seconds (i), &LogBinaryTestCase::Log, this, i);
+      Simulator::ScheduleWithContext (i, Seconds (i + 0.5), &LogBinaryTestCase::Log, this, i);
+    }
+  Simulator::Run ();
+  Simulator::Destroy ();
+  if (binary)
+    {
+      std::stringstream records;
+      LogWriteBinary (records);
+      LogDisableBinary ();
+      NS_TEST_EXPECT_MSG_EQ (os.str (), "", "nothing printed while recording");
+      NS_TEST_EXPECT_MSG_EQ (LogDecodeBinary (records, os), true, "valid binary log");
+    }
+  std::clog.rdbuf (clog);
+  return os.str ();
+}
+
+void
+LogBinaryTestCase::DoRun (void)
+{
+  LogComponentEnable ("LogTestSuite", LogLevel (LOG_LEVEL_ALL | LOG_PREFIX_ALL));
+  std::string text = Capture (false);
+  std::string binary = Capture (true);
+
+  // a null string puts std::clog in error, it is only checked recorded
+  LogEnableBinary ("");
+  LogNull (7);
+  std::stringstream records;
+  LogWriteBinary (records);
+  LogDisableBinary ();
+  std::ostringstream null;
+  LogDecodeBinary (records, null);
+  NS_TEST_EXPECT_MSG_NE (null.str ().find ("LogNull(7, , 7)"), std::string::npos,
+                         "null string not recorded as an argument");
+  LogComponentDisable ("LogTestSuite", LogLevel (LOG_LEVEL_ALL | LOG_PREFIX_ALL));
+
+  NS_TEST_EXPECT_MSG_NE (text, "", "messages printed");
+  NS_TEST_EXPECT_MSG_EQ (binary, text, "same text once decoded");
+  NS_TEST_EXPECT_MSG_EQ (text.find ("above the ceiling"), std::string::npos,
+                         "LOGIC is above the ceiling of the component");
+}
+
+static class LogTestSuite : public TestSuite
+{
+public:
+  LogTestSuite ()
+    : TestSuite ("log")
+  {
+    AddTestCase (new LogBinaryTestCase (), TestCase::QUICK);
+  }
+} g_logTestSuite;
@@ -335,6 +335,70 @@ AggregateObjectTestCase::DoRun (void)
   NS_TEST_ASSERT_MSG_NE (baseA, 0, "Unable to GetObject on released object");
 }
 
+// ===========================================================================
+// Test case to make sure that the results of GetObject are not kept across
+// aggregations
+// ===========================================================================
+class GetObjectCacheTestCase : public TestCase
+{
+public:
+  GetObjectCacheTestCase ();
+  virtual ~GetObjectCacheTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+GetObjectCacheTestCase::GetObjectCacheTestCase ()
+  : TestCase ("Check that GetObject follows the aggregations")
+{
+}
+
+GetObjectCacheTestCase::~GetObjectCacheTestCase ()
+{
+}
+
+void
+GetObjectCacheTestCase::DoRun (void)
+{
+  Ptr<BaseA> baseA = CreateObject<BaseA> ();
+  Ptr<BaseB> baseB = CreateObject<BaseB> ();
+  baseA->AggregateObject (baseB);
+
+  //
+  // Look the types up several times, so that the later lookups are
+  // answered from what the first ones found.
+  //
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (baseA->GetObject<BaseB> (), baseB, "Cannot GetObject (through baseA) for BaseB Object");
+      NS_TEST_ASSERT_MSG_EQ (baseB->GetObject<BaseA> (), baseA, "Cannot GetObject (through baseB) for BaseA Object");
+      NS_TEST_ASSERT_MSG_EQ (baseA->GetObject<DerivedB> (), 0, "Unexpectedly found a DerivedB through baseA");
+    }
+
+  //
+  // The type which was missing is found once it is aggregated, through
+  // every object of the aggregation.
+  //
+  Ptr<DerivedB> derivedB = CreateObject<DerivedB> ();
+  baseA->AggregateObject (derivedB);
+  NS_TEST_ASSERT_MSG_EQ (baseA->GetObject<DerivedB> (), derivedB, "Cannot GetObject (through baseA) for new DerivedB Object");
+  NS_TEST_ASSERT_MSG_EQ (baseB->GetObject<DerivedB> (), derivedB, "Cannot GetObject (through baseB) for new DerivedB Object");
+  NS_TEST_ASSERT_MSG_EQ (derivedB->GetObject<BaseA> (), baseA, "Cannot GetObject (through derivedB) for BaseA Object");
+
+  //
+  // An aggregate made of two aggregates which were both looked up.
+  //
+  Ptr<DerivedA> derivedA = CreateObject<DerivedA> ();
+  Ptr<BaseB> otherB = CreateObject<BaseB> ();
+  derivedA->AggregateObject (otherB);
+  NS_TEST_ASSERT_MSG_EQ (otherB->GetObject<DerivedA> (), derivedA, "Cannot GetObject (through otherB) for DerivedA Object");
+  NS_TEST_ASSERT_MSG_EQ (otherB->GetObject<DerivedB> (), 0, "Unexpectedly found a DerivedB through otherB");
+  Ptr<Object> lone = CreateObject<Object> ();
+  lone->AggregateObject (otherB);
+  NS_TEST_ASSERT_MSG_EQ (lone->GetObject<DerivedA> (), derivedA, "Cannot GetObject (through lone) for DerivedA Object");
+}
+
 // ===========================================================================
 // Test case to make sure that an Object factory can create Objects
 // ===========================================================================
@@ -421,6 +485,7 @@ ObjectTestSuite::ObjectTestSuite ()
 {
   AddTestCase (new CreateObjectTestCase, TestCase::QUICK);
   AddTestCase (new AggregateObjectTestCase, TestCase::QUICK);
+  AddTestCase (new GetObjectCacheTestCase, TestCase::QUICK);
   AddTestCase (new ObjectFactoryTestCase, TestCase::QUICK);
 }
 
@@ -0,0 +1,133 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/simulator-fork.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/double.h"
+#include "ns3/config.h"
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+#include <unistd.h>
+#include <sys/wait.h>
+
+using namespace ns3;
+
+class SimulatorForkTestCase : public TestCase
+{
+public:
+  SimulatorForkTestCase ();
+  virtual void DoRun (void);
+private:
+  void Draw (void);
+  std::vector<double> Parse (std::string output);
+  Ptr<UniformRandomVariable> m_rv;
+  std::vector<double> m_values;
+};
+
+SimulatorForkTestCase::SimulatorForkTestCase ()
+  : TestCase ("Check that the branches share the past and diverge after the fork")
+{
+}
+
+void
+SimulatorForkTestCase::Draw (void)
+{
+  m_values.push_back (m_rv->GetValue ());
+}
+
+std::vector<double>
+SimulatorForkTestCase::Parse (std::string output)
+{
+  std::istringstream is (output);
+  std::vector<double> values;
+  double value;
+  while (is >> value)
+    {
+      values.push_back (value);
+    }
+  return values;
+}
+
+void
+SimulatorForkTestCase::DoRun (void)
+{
+  m_rv = CreateObject<UniformRandomVariable> ();
+  m_rv->SetAttribute ("Min", DoubleValue (0));
+  m_rv->SetAttribute ("Max", DoubleValue (1));
+  Config::RegisterRootNamespaceObject (m_rv);
+  for (uint32_t i = 0; i < 20; i++)
+    {
+      Simulator::Schedule (Seconds (i), &SimulatorForkTestCase::Draw, this);
+    }
+
+  SimulatorFork fork;
+  fork.SetMaxRunning (2);
+  uint32_t a = fork.AddBranch (2);
+  uint32_t b = fork.AddBranch (3);
+  uint32_t c = fork.AddBranch (2);
+  fork.Set (c, "/Max", DoubleValue (1000));
+  fork.ForkAt (Seconds (9.5));
+  Simulator::Run ();
+
+  if (fork.IsBranch ())
+    {
+      for (uint32_t i = 0; i < m_values.size (); i++)
+        {
+          std::cout << std::setprecision (17) << m_values[i] << std::endl;
+        }
+      // leave the rest of the test suite to the parent
+      _exit (0);
+    }
+
+  NS_TEST_EXPECT_MSG_EQ (Simulator::Now (), Seconds (9.5), "the parent stops at the fork point");
+  NS_TEST_ASSERT_MSG_EQ (m_values.size (), 10, "the parent draws the values of the warm-up only");
+  NS_TEST_ASSERT_MSG_EQ (fork.GetNBranches (), 3, "3 branches");
+  std::vector<std::vector<double> > values;
+  for (uint32_t i = 0; i < fork.GetNBranches (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (WIFEXITED (fork.GetStatus (i)) && WEXITSTATUS (fork.GetStatus (i)) == 0,
+                             true, "branch " << i << " failed");
+      values.push_back (Parse (fork.GetOutput (i)));
+      NS_TEST_ASSERT_MSG_EQ (values[i].size (), 20, "branch " << i << " runs to the end");
+      for (uint32_t j = 0; j < 10; j++)
+        {
+          NS_TEST_EXPECT_MSG_EQ_TOL (values[i][j], m_values[j], 1e-12, "branches share the warm-up");
+        }
+    }
+  for (uint32_t j = 10; j < 20; j++)
+    {
+      NS_TEST_EXPECT_MSG_NE (values[a][j], values[b][j], "runs 2 and 3 diverge");
+      NS_TEST_EXPECT_MSG_EQ_TOL (values[c][j], values[a][j] * 1000, 1e-6,
+                                 "same run with the overridden attribute");
+    }
+
+  Config::UnregisterRootNamespaceObject (m_rv);
+  m_rv = 0;
+  Simulator::Destroy ();
+}
+
+static class SimulatorForkTestSuite : public TestSuite
+{
+public:
+  SimulatorForkTestSuite ()
+    : TestSuite ("simulator-fork")
+  {
+    AddTestCase (new SimulatorForkTestCase (), TestCase::QUICK);
+  }
+} g_simulatorForkTestSuite;
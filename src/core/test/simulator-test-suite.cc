@@ -23,6 +23,24 @@
 #include "ns3/heap-scheduler.h"
 #include "ns3/map-scheduler.h"
 #include "ns3/calendar-scheduler.h"
+#include "ns3/ladder-scheduler.h"
+#include "ns3/simulator-impl.h"
+#include "ns3/boolean.h"
+#include "ns3/string.h"
+#include "ns3/mpsc-queue.h"
+#include "ns3/make-event.h"
+#include "ns3/core-config.h"
+#ifdef HAVE_PTHREAD_H
+#include "ns3/system-thread.h"
+#endif /* HAVE_PTHREAD_H */
+#ifdef HAVE_RT
+#include "ns3/realtime-simulator-impl.h"
+#endif /* HAVE_RT */
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <set>
+#include <vector>
 
 using namespace ns3;
 
@@ -168,6 +186,96 @@ SimulatorEventsTestCase::DoRun (void)
   NS_TEST_EXPECT_MSG_EQ (m_destroy, true, "Event should have run");
 }
 
+class SchedulerOrderTestCase : public TestCase
+{
+public:
+  SchedulerOrderTestCase (ObjectFactory schedulerFactory);
+  virtual void DoRun (void);
+  uint32_t Random (void);
+  uint64_t m_random;
+  ObjectFactory m_schedulerFactory;
+};
+
+SchedulerOrderTestCase::SchedulerOrderTestCase (ObjectFactory schedulerFactory)
+  : TestCase ("Check the order of the events of a large event set with " +
+              schedulerFactory.GetTypeId ().GetName ()),
+    m_schedulerFactory (schedulerFactory)
+{
+}
+
+uint32_t
+SchedulerOrderTestCase::Random (void)
+{
+  m_random = m_random * 6364136223846793005ULL + 1442695040888963407ULL;
+  return m_random >> 33;
+}
+
+void
+SchedulerOrderTestCase::DoRun (void)
+{
+  m_random = 1;
+  Ptr<Scheduler> scheduler = m_schedulerFactory.Create<Scheduler> ();
+  std::set<Scheduler::Event> reference;
+  std::vector<Scheduler::Event> pending;
+  uint32_t uid = 0;
+  uint64_t now = 0;
+  for (uint32_t i = 0; i < 60000; i++)
+    {
+      uint32_t op = Random () % 8;
+      if (op < 4 || reference.empty ())
+        {
+          // a mix of distant events and of bursts of events at the same time
+          Scheduler::Event ev;
+          ev.impl = 0;
+          switch (Random () % 3)
+            {
+            case 0:
+              ev.key.m_ts = now + Random () % 1000000;
+              break;
+            case 1:
+              ev.key.m_ts = now + (Random () % 4) * 1000;
+              break;
+            default:
+              ev.key.m_ts = now + Random () % 100;
+              break;
+            }
+          ev.key.m_uid = uid++;
+          ev.key.m_context = 0;
+          scheduler->Insert (ev);
+          reference.insert (ev);
+          pending.push_back (ev);
+        }
+      else if (op < 7)
+        {
+          Scheduler::Event expected = *reference.begin ();
+          NS_TEST_ASSERT_MSG_EQ (scheduler->PeekNext ().key.m_uid, expected.key.m_uid, "wrong next event");
+          Scheduler::Event ev = scheduler->RemoveNext ();
+          NS_TEST_ASSERT_MSG_EQ (ev.key.m_uid, expected.key.m_uid, "wrong event removed");
+          reference.erase (reference.begin ());
+          now = ev.key.m_ts;
+        }
+      else
+        {
+          uint32_t j = Random () % pending.size ();
+          Scheduler::Event ev = pending[j];
+          pending[j] = pending.back ();
+          pending.pop_back ();
+          if (reference.erase (ev) != 0)
+            {
+              scheduler->Remove (ev);
+            }
+        }
+    }
+  while (!reference.empty ())
+    {
+      NS_TEST_ASSERT_MSG_EQ (scheduler->IsEmpty (), false, "events missing");
+      Scheduler::Event ev = scheduler->RemoveNext ();
+      NS_TEST_ASSERT_MSG_EQ (ev.key.m_uid, reference.begin ()->key.m_uid, "wrong event removed");
+      reference.erase (reference.begin ());
+    }
+  NS_TEST_EXPECT_MSG_EQ (scheduler->IsEmpty (), true, "too many events");
+}
+
 class SimulatorTemplateTestCase : public TestCase
 {
 public:
@@ -459,12 +567,299 @@ SimulatorTemplateTestCase::DoRun (void)
   Simulator::Destroy ();
 }
 
+class SimulatorProfileTestCase : public TestCase
+{
+public:
+  SimulatorProfileTestCase ();
+  virtual void DoRun (void);
+  void Event (void);
+  virtual void VirtualEvent1 (void);
+  virtual void VirtualEvent2 (void);
+};
+
+SimulatorProfileTestCase::SimulatorProfileTestCase ()
+  : TestCase ("Check that the events are profiled by function and node")
+{
+}
+
+void
+SimulatorProfileTestCase::Event (void)
+{
+}
+
+void
+SimulatorProfileTestCase::VirtualEvent1 (void)
+{
+}
+
+void
+SimulatorProfileTestCase::VirtualEvent2 (void)
+{
+}
+
+void
+SimulatorProfileTestCase::DoRun (void)
+{
+  std::string file = CreateTempDirFilename ("simulator-profile.txt");
+  ObjectFactory factory;
+  factory.SetTypeId ("ns3::DefaultSimulatorImpl");
+  factory.Set ("Profile", BooleanValue (true));
+  factory.Set ("ProfileFile", StringValue (file));
+  Simulator::SetImplementation (factory.Create<SimulatorImpl> ());
+  for (uint32_t i = 0; i < 10; i++)
+    {
+      Simulator::Schedule (MicroSeconds (i), &SimulatorProfileTestCase::Event, this);
+      Simulator::ScheduleWithContext (7, MicroSeconds (i), &SimulatorProfileTestCase::Event, this);
+    }
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      Simulator::Schedule (MicroSeconds (i), &SimulatorProfileTestCase::VirtualEvent1, this);
+    }
+  for (uint32_t i = 0; i < 5; i++)
+    {
+      Simulator::Schedule (MicroSeconds (i), &SimulatorProfileTestCase::VirtualEvent2, this);
+    }
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  std::ifstream is (file.c_str ());
+  NS_TEST_ASSERT_MSG_EQ (is.is_open (), true, "the profile is written by Simulator::Destroy");
+  std::string profile ((std::istreambuf_iterator<char> (is)), std::istreambuf_iterator<char> ());
+  std::string::size_type flat = profile.find ("SimulatorProfileTestCase::Event");
+  NS_TEST_ASSERT_MSG_NE (flat, std::string::npos, "the event is named after its function");
+  std::istringstream line (profile.substr (profile.rfind ('\n', flat) + 1));
+  std::string percent, seconds;
+  uint32_t count;
+  line >> percent >> seconds >> count;
+  NS_TEST_EXPECT_MSG_EQ (count, 20, "flat profile");
+  std::string::size_type node = profile.find ("Node 7:");
+  NS_TEST_ASSERT_MSG_NE (node, std::string::npos, "per node profile");
+  line.clear ();
+  line.str (profile.substr (profile.find ('\n', node) + 1));
+  line >> percent >> seconds >> count;
+  NS_TEST_EXPECT_MSG_EQ (count, 10, "profile of node 7");
+
+  // the virtual functions of the same class and signature have their own
+  // lines, whichever comes first
+  std::string::size_type first = profile.find ("[virtual ");
+  NS_TEST_ASSERT_MSG_NE (first, std::string::npos, "virtual function not named after its slot");
+  std::string::size_type second = profile.find ("[virtual ", first + 1);
+  NS_TEST_ASSERT_MSG_NE (second, std::string::npos, "virtual functions merged");
+  NS_TEST_ASSERT_MSG_LT (second, node, "virtual functions merged");
+  uint32_t counts[2];
+  std::string::size_type at[2] = { first, second };
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      line.clear ();
+      line.str (profile.substr (profile.rfind ('\n', at[i]) + 1));
+      line >> percent >> seconds >> counts[i];
+    }
+  NS_TEST_EXPECT_MSG_EQ (counts[0] + counts[1], 8, "virtual function events");
+  NS_TEST_EXPECT_MSG_EQ ((counts[0] == 3 || counts[0] == 5), true, "virtual function events");
+}
+
+class MpscQueueTestCase : public TestCase
+{
+public:
+  MpscQueueTestCase ();
+  virtual void DoRun (void);
+
+  struct Item
+  {
+    Item *next;
+    uint32_t producer;
+    uint32_t seq;
+  };
+
+private:
+  void Produce (uint32_t producer);
+
+  MpscQueue<Item> m_queue;
+  std::vector<Item> m_items;
+  uint32_t m_wasEmpty;
+  uint32_t m_finished;
+};
+
+static const uint32_t N_PRODUCERS = 4;
+static const uint32_t N_ITEMS = 20000;
+
+MpscQueueTestCase::MpscQueueTestCase ()
+  : TestCase ("Check the order of the items of an MpscQueue, and when it reports being empty")
+{
+}
+
+void
+MpscQueueTestCase::Produce (uint32_t producer)
+{
+  uint32_t wasEmpty = 0;
+  for (uint32_t i = 0; i < N_ITEMS; i++)
+    {
+      Item *item = &m_items[producer * N_ITEMS + i];
+      item->producer = producer;
+      item->seq = i;
+      wasEmpty += m_queue.Push (item) ? 1 : 0;
+    }
+  __atomic_add_fetch (&m_wasEmpty, wasEmpty, __ATOMIC_RELAXED);
+  __atomic_add_fetch (&m_finished, 1, __ATOMIC_RELEASE);
+}
+
+void
+MpscQueueTestCase::DoRun (void)
+{
+  Item items[3];
+  NS_TEST_EXPECT_MSG_EQ (m_queue.IsEmpty (), true, "new queue not empty");
+  NS_TEST_EXPECT_MSG_EQ ((m_queue.PopAll () == 0), true, "items popped from an empty queue");
+  NS_TEST_EXPECT_MSG_EQ (m_queue.Push (&items[0]), true, "first push did not find the queue empty");
+  NS_TEST_EXPECT_MSG_EQ (m_queue.Push (&items[1]), false, "second push found the queue empty");
+  NS_TEST_EXPECT_MSG_EQ (m_queue.Push (&items[2]), false, "third push found the queue empty");
+  NS_TEST_EXPECT_MSG_EQ (m_queue.IsEmpty (), false, "queue of three items empty");
+  Item *item = m_queue.PopAll ();
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (item, &items[i], "item " << i << " popped out of order");
+      item = item->next;
+    }
+  NS_TEST_EXPECT_MSG_EQ ((item == 0), true, "more items popped than pushed");
+  NS_TEST_EXPECT_MSG_EQ (m_queue.IsEmpty (), true, "queue not empty after PopAll");
+  NS_TEST_EXPECT_MSG_EQ (m_queue.Push (&items[0]), true, "push after PopAll did not find the queue empty");
+  m_queue.PopAll ();
+
+#ifdef HAVE_PTHREAD_H
+  // producers racing with the consumer: every producer's items come out in
+  // order, and every batch popped starts with a push that found the queue
+  // empty
+  m_items.resize (N_PRODUCERS * N_ITEMS);
+  m_wasEmpty = 0;
+  m_finished = 0;
+  std::vector<Ptr<SystemThread> > threads;
+  for (uint32_t i = 0; i < N_PRODUCERS; i++)
+    {
+      threads.push_back (Create<SystemThread> (MakeCallback (&MpscQueueTestCase::Produce, this).Bind (i)));
+      threads.back ()->Start ();
+    }
+  std::vector<uint32_t> next (N_PRODUCERS, 0);
+  uint32_t popped = 0;
+  uint32_t batches = 0;
+  bool ordered = true;
+  bool finished = false;
+  while (!finished)
+    {
+      // the last pass drains what was pushed before the producers finished
+      finished = __atomic_load_n (&m_finished, __ATOMIC_ACQUIRE) == N_PRODUCERS;
+      item = m_queue.PopAll ();
+      batches += item != 0 ? 1 : 0;
+      for (; item != 0; item = item->next)
+        {
+          ordered &= item->seq == next[item->producer];
+          next[item->producer] = item->seq + 1;
+          popped++;
+        }
+    }
+  for (uint32_t i = 0; i < N_PRODUCERS; i++)
+    {
+      threads[i]->Join ();
+    }
+  NS_TEST_EXPECT_MSG_EQ (ordered, true, "items of a producer out of order");
+  NS_TEST_EXPECT_MSG_EQ (popped, N_PRODUCERS * N_ITEMS, "items lost");
+  NS_TEST_EXPECT_MSG_EQ (m_wasEmpty, batches, "pushes that found the queue empty");
+#endif /* HAVE_PTHREAD_H */
+}
+
+#ifdef HAVE_RT
+
+class RealtimeForeignThreadTestCase : public TestCase
+{
+public:
+  RealtimeForeignThreadTestCase ();
+  virtual void DoRun (void);
+
+private:
+  void StartThread (void);
+  void Schedule (void);
+  void Event (uint32_t i, uint64_t scheduled);
+
+  Ptr<SystemThread> m_thread;
+  std::vector<uint32_t> m_events;
+  std::string m_error;
+};
+
+static const uint32_t N_FOREIGN_EVENTS = 100;
+
+RealtimeForeignThreadTestCase::RealtimeForeignThreadTestCase ()
+  : TestCase ("Check the events scheduled in real time from another thread")
+{
+}
+
+void
+RealtimeForeignThreadTestCase::Event (uint32_t i, uint64_t scheduled)
+{
+  m_events.push_back (i);
+  if (Simulator::GetContext () != i)
+    {
+      m_error = "wrong context";
+    }
+  if ((uint64_t) Simulator::Now ().GetTimeStep () < scheduled)
+    {
+      m_error = "event run before the time it was scheduled at";
+    }
+  if (i == N_FOREIGN_EVENTS - 1)
+    {
+      Simulator::Stop ();
+    }
+}
+
+void
+RealtimeForeignThreadTestCase::Schedule (void)
+{
+  Ptr<RealtimeSimulatorImpl> impl = DynamicCast<RealtimeSimulatorImpl> (Simulator::GetImplementation ());
+  for (uint32_t i = 0; i < N_FOREIGN_EVENTS; i++)
+    {
+      // the real time goes on between two events, they are not simultaneous
+      uint64_t now = impl->RealtimeNow ().GetTimeStep ();
+      impl->ScheduleRealtimeWithContext (i, MicroSeconds (10),
+                                         MakeEvent (&RealtimeForeignThreadTestCase::Event, this, i, now));
+    }
+}
+
+void
+RealtimeForeignThreadTestCase::StartThread (void)
+{
+  m_thread = Create<SystemThread> (MakeCallback (&RealtimeForeignThreadTestCase::Schedule, this));
+  m_thread->Start ();
+}
+
+void
+RealtimeForeignThreadTestCase::DoRun (void)
+{
+  Simulator::SetImplementation (CreateObject<RealtimeSimulatorImpl> ());
+  Simulator::Schedule (MilliSeconds (1), &RealtimeForeignThreadTestCase::StartThread, this);
+  // in case an event is lost
+  Simulator::Schedule (Seconds (10), &Simulator::Stop);
+  Simulator::Run ();
+  m_thread->Join ();
+  Simulator::Destroy ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_error, "", "events scheduled from another thread");
+  NS_TEST_ASSERT_MSG_EQ (m_events.size (), N_FOREIGN_EVENTS, "events scheduled from another thread lost");
+  for (uint32_t i = 0; i < N_FOREIGN_EVENTS; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_events[i], i, "events scheduled from another thread out of order");
+    }
+}
+
+#endif /* HAVE_RT */
+
 class SimulatorTestSuite : public TestSuite
 {
 public:
   SimulatorTestSuite ()
     : TestSuite ("simulator")
   {
+    AddTestCase (new SimulatorProfileTestCase (), TestCase::QUICK);
+    AddTestCase (new MpscQueueTestCase (), TestCase::QUICK);
+#ifdef HAVE_RT
+    AddTestCase (new RealtimeForeignThreadTestCase (), TestCase::QUICK);
+#endif /* HAVE_RT */
     ObjectFactory factory;
     factory.SetTypeId (ListScheduler::GetTypeId ());
 
@@ -475,5 +870,14 @@ public:
     AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
     factory.SetTypeId (CalendarScheduler::GetTypeId ());
     AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (LadderScheduler::GetTypeId ());
+    AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+
+    factory.SetTypeId (CalendarScheduler::GetTypeId ());
+    AddTestCase (new SchedulerOrderTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (MapScheduler::GetTypeId ());
+    AddTestCase (new SchedulerOrderTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (LadderScheduler::GetTypeId ());
+    AddTestCase (new SchedulerOrderTestCase (factory), TestCase::QUICK);
   }
 } g_simulatorTestSuite;
@@ -26,10 +26,14 @@
 #include "ns3/config.h"
 #include "ns3/string.h"
 #include "ns3/system-thread.h"
+#include "ns3/make-event.h"
+#include "ns3/slab-allocator.h"
 
 #include <ctime>
 #include <list>
+#include <set>
 #include <utility>
+#include <vector>
 
 using namespace ns3;
 
@@ -225,6 +229,116 @@ ThreadedSimulatorEventsTestCase::DoRun (void)
   NS_TEST_EXPECT_MSG_EQ (m_a, m_d, "Bad scheduling");
 }
 
+// ===========================================================================
+// Test case to make sure that the blocks of the events freed by another
+// thread than the one that allocated them, and those held by threads that
+// exit, are reused instead of piling up.
+// ===========================================================================
+class EventImplPoolTestCase : public TestCase
+{
+public:
+  EventImplPoolTestCase ();
+
+private:
+  virtual void DoRun (void);
+  void Allocate (void);
+  void AllocateAndFree (void);
+  static void Count (uint32_t *counter, uint32_t n);
+  static uint64_t GetInUse (void);
+
+  std::vector<EventImpl *> m_events;
+  // every block seen, only touched by one thread at a time
+  std::set<EventImpl *> m_blocks;
+  uint32_t m_counter;
+};
+
+// events allocated by every thread
+static const uint32_t N_EVENTS = 1000;
+static const uint32_t N_THREADS = 50;
+
+EventImplPoolTestCase::EventImplPoolTestCase ()
+  : TestCase ("Check that the blocks of the events are reused across threads")
+{
+}
+
+void
+EventImplPoolTestCase::Count (uint32_t *counter, uint32_t n)
+{
+  *counter += n;
+}
+
+uint64_t
+EventImplPoolTestCase::GetInUse (void)
+{
+  uint64_t inUse = 0;
+  for (uint32_t i = 0; i < SlabAllocator::GetNClasses (); i++)
+    {
+      SlabAllocator::Stats stats = SlabAllocator::GetStats (i);
+      inUse += stats.allocations - stats.deallocations;
+    }
+  return inUse;
+}
+
+void
+EventImplPoolTestCase::Allocate (void)
+{
+  for (uint32_t i = 0; i < N_EVENTS; i++)
+    {
+      m_events.push_back (MakeEvent (&EventImplPoolTestCase::Count, &m_counter, i));
+    }
+}
+
+void
+EventImplPoolTestCase::AllocateAndFree (void)
+{
+  Allocate ();
+  for (uint32_t i = 0; i < N_EVENTS; i++)
+    {
+      m_blocks.insert (m_events[i]);
+      m_events[i]->Invoke ();
+      m_events[i]->Unref ();
+    }
+  m_events.clear ();
+}
+
+void
+EventImplPoolTestCase::DoRun (void)
+{
+  uint64_t inUse = GetInUse ();
+
+  // allocated by a thread, freed by another
+  m_counter = 0;
+  for (uint32_t i = 0; i < N_THREADS; i++)
+    {
+      Ptr<SystemThread> thread = Create<SystemThread> (MakeCallback (&EventImplPoolTestCase::Allocate, this));
+      thread->Start ();
+      thread->Join ();
+      for (uint32_t j = 0; j < N_EVENTS; j++)
+        {
+          m_blocks.insert (m_events[j]);
+          m_events[j]->Invoke ();
+          m_events[j]->Unref ();
+        }
+      m_events.clear ();
+    }
+  NS_TEST_EXPECT_MSG_EQ (m_counter, N_THREADS * N_EVENTS * (N_EVENTS - 1) / 2, "events freed by another thread were corrupted");
+  NS_TEST_EXPECT_MSG_LT (m_blocks.size (), 3 * N_EVENTS, "blocks freed by another thread are not reused");
+  NS_TEST_EXPECT_MSG_EQ (GetInUse (), inUse, "allocations of the threads that exited not counted");
+
+  // allocated and freed by threads that exit
+  m_blocks.clear ();
+  m_counter = 0;
+  for (uint32_t i = 0; i < N_THREADS; i++)
+    {
+      Ptr<SystemThread> thread = Create<SystemThread> (MakeCallback (&EventImplPoolTestCase::AllocateAndFree, this));
+      thread->Start ();
+      thread->Join ();
+    }
+  NS_TEST_EXPECT_MSG_EQ (m_counter, N_THREADS * N_EVENTS * (N_EVENTS - 1) / 2, "events were corrupted");
+  NS_TEST_EXPECT_MSG_LT (m_blocks.size (), 3 * N_EVENTS, "blocks held by the threads that exited are not reused");
+  NS_TEST_EXPECT_MSG_EQ (GetInUse (), inUse, "deallocations of the threads that exited not counted");
+}
+
 class ThreadedSimulatorTestSuite : public TestSuite
 {
 public:
@@ -241,7 +355,8 @@ public:
       "ns3::ListScheduler",
       "ns3::HeapScheduler",
       "ns3::MapScheduler",
-      "ns3::CalendarScheduler"
+      "ns3::CalendarScheduler",
+      "ns3::LadderScheduler"
     };
     unsigned int threadcounts[] = {
       0,
@@ -262,5 +377,6 @@ public:
               }
           }
       }
+    AddTestCase (new EventImplPoolTestCase (), TestCase::QUICK);
   }
 } g_threadedSimulatorTestSuite;
@@ -134,6 +134,43 @@ TimesWithSignsTestCase::DoTeardown (void)
 {
 }
 
+class TimeIntegerTestCase : public TestCase
+{
+public:
+  TimeIntegerTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+TimeIntegerTestCase::TimeIntegerTestCase ()
+  : TestCase ("Checks that the integer conversions match int64x64_t")
+{
+}
+
+void
+TimeIntegerTestCase::DoRun (void)
+{
+  double values[] = { 0, 1, 1.5, -1.5, 0.25, 0.1, 0.3, -0.3, 1e-9, 123.456789, 1e6 };
+  for (uint32_t i = 0; i < sizeof (values) / sizeof (values[0]); i++)
+    {
+      double v = values[i];
+      NS_TEST_EXPECT_MSG_EQ (Time::FromDouble (v, Time::S),
+                             Time::From (int64x64_t (v), Time::S), "FromDouble " << v);
+      NS_TEST_EXPECT_MSG_EQ (Time::FromDouble (v, Time::MS),
+                             Time::From (int64x64_t (v), Time::MS), "FromDouble " << v << "ms");
+      Time t = Time::FromDouble (v, Time::S);
+      NS_TEST_EXPECT_MSG_EQ_TOL (t.GetSeconds (), t.To (Time::S).GetDouble (), 1e-15,
+                                 "GetSeconds " << v);
+      NS_TEST_EXPECT_MSG_EQ (t.ToDouble (Time::FS), t.To (Time::FS).GetDouble (), "ToDouble " << v);
+    }
+  Time slot = MicroSeconds (9);
+  NS_TEST_EXPECT_MSG_EQ (slot * 3, Time (int64x64_t (slot) * 3), "Time * int");
+  NS_TEST_EXPECT_MSG_EQ (3U * slot, MicroSeconds (27), "unsigned * Time");
+  NS_TEST_EXPECT_MSG_EQ (slot * -2, MicroSeconds (9) - MicroSeconds (27), "Time * negative int");
+  NS_TEST_EXPECT_MSG_EQ (Time (slot * 0.5), Time (int64x64_t (slot) * int64x64_t (0.5)), "Time * double");
+  NS_TEST_EXPECT_MSG_EQ (Time::From (int64x64_t (42)), Time (42), "From, same unit");
+}
+
 static class TimeTestSuite : public TestSuite
 {
 public:
@@ -142,5 +179,6 @@ public:
   {
     AddTestCase (new TimeSimpleTestCase (), TestCase::QUICK);
     AddTestCase (new TimesWithSignsTestCase (), TestCase::QUICK);
+    AddTestCase (new TimeIntegerTestCase (), TestCase::QUICK);
   }
 } g_timeTestSuite;
@@ -156,11 +156,17 @@ public:
    * used by the channel to indicate that the last bit of a packet has 
    * arrived at the device.
    *
+   * The sinks of the PhyRxEnd, PhyRxDrop, MacRx, MacPromiscRx, Sniffer and
+   * PromiscSniffer traces get the shared packet: they must not add tags to
+   * it (AddPacketTag and AddByteTag are const), the other devices of the
+   * channel would see them.
+   *
    * \see CsmaChannel
-   * \param p a reference to the received packet
+   * \param p a reference to the received packet, shared by all the devices
+   *        of the channel: the device copies it once it accepts it
    * \param sender the CsmaNetDevice that transmitted the packet in the first place
    */
-  void Receive (Ptr<Packet> p, Ptr<CsmaNetDevice> sender);
+  void Receive (Ptr<const Packet> p, Ptr<CsmaNetDevice> sender);
 
   /**
    * Is the send side of the network device enabled?
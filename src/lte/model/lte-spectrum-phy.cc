@@ -944,7 +944,7 @@ LteSpectrumPhy::EndRxData ()
                 
                     if (!m_ltePhyRxDataEndOkCallback.IsNull ())
                       {
-                        m_ltePhyRxDataEndOkCallback (*j);
+                        m_ltePhyRxDataEndOkCallback ((*j)->Copy ());
                       }
                   }
                 else
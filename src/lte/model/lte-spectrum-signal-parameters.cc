@@ -39,7 +39,8 @@ LteSpectrumSignalParameters::LteSpectrumSignalParameters (const LteSpectrumSigna
   : SpectrumSignalParameters (p)
 {
   NS_LOG_FUNCTION (this << &p);
-  packetBurst = p.packetBurst->Copy ();
+  // the receivers share the packets, they copy them once they receive them
+  packetBurst = p.packetBurst;
 }
 
 Ptr<SpectrumSignalParameters>
@@ -68,10 +69,8 @@ LteSpectrumSignalParametersDataFrame::LteSpectrumSignalParametersDataFrame (cons
 {
   NS_LOG_FUNCTION (this << &p);
   cellId = p.cellId;
-  if (p.packetBurst)
-    {
-      packetBurst = p.packetBurst->Copy ();
-    }
+  // the receivers share the packets, they copy them once they receive them
+  packetBurst = p.packetBurst;
   ctrlMsgList = p.ctrlMsgList;
 }
 
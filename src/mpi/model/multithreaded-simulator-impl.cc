@@ -0,0 +1,940 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "multithreaded-simulator-impl.h"
+
+#include "ns3/core-config.h"
+#include "ns3/simulator.h"
+#include "ns3/system-thread.h"
+#include "ns3/channel.h"
+#include "ns3/net-device.h"
+#include "ns3/node.h"
+#include "ns3/node-list.h"
+#include "ns3/nstime.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include "ns3/assert.h"
+#include "ns3/log.h"
+
+#include <algorithm>
+#include <sched.h>
+#include <unistd.h>
+
+// Note:  Logging in this file is largely avoided due to the
+// number of calls that are made to these functions and the possibility
+// of causing recursions leading to stack overflow
+
+NS_LOG_COMPONENT_DEFINE ("MultithreadedSimulatorImpl");
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED (MultithreadedSimulatorImpl);
+
+// the partition run by the calling thread, none outside of Run and for
+// threads which are not running a partition
+static __thread void *g_partition = 0;
+
+static const uint64_t MAX_TS = 0x7fffffffffffffffLL;
+static const uint32_t NO_SOURCE = 0xffffffff;
+
+TypeId
+MultithreadedSimulatorImpl::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::MultithreadedSimulatorImpl")
+    .SetParent<SimulatorImpl> ()
+    .AddConstructor<MultithreadedSimulatorImpl> ()
+    .AddAttribute ("PartitionCount",
+                   "The number of partitions, and of threads, the nodes are spread over, "
+                   "0 for one per processor.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&MultithreadedSimulatorImpl::m_partitionCount),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("UseSystemId",
+                   "Partition the nodes by system id, rather than by context.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&MultithreadedSimulatorImpl::m_useSystemId),
+                   MakeBooleanChecker ())
+  ;
+  return tid;
+}
+
+bool
+MultithreadedSimulatorImpl::CrossEventLess::operator () (const CrossEvent *a, const CrossEvent *b) const
+{
+  // the inbox order depends on the thread interleaving, this one does not
+  if (a->ts != b->ts)
+    {
+      return a->ts < b->ts;
+    }
+  if (a->source != b->source)
+    {
+      return a->source < b->source;
+    }
+  return a->seq < b->seq;
+}
+
+MultithreadedSimulatorImpl::Partition::Partition (MultithreadedSimulatorImpl *impl, uint32_t id)
+  : m_impl (impl),
+    m_id (id),
+    m_events (0),
+    m_currentTs (0),
+    m_currentUid (0),
+    m_currentContext (0xffffffff),
+    // uids are allocated from 4.
+    // uid 0 is "invalid" events
+    // uid 1 is "now" events
+    // uid 2 is "destroy" events
+    m_uid (4),
+    m_unscheduledEvents (0),
+    m_grantedTs (0),
+    m_txCount (0),
+    m_rxCount (0)
+{
+}
+
+void
+MultithreadedSimulatorImpl::Partition::Run (void)
+{
+  g_partition = this;
+  for (;;)
+    {
+      while (!m_events->IsEmpty ()
+             && m_events->PeekNext ().key.m_ts < m_grantedTs
+             && m_events->PeekNext ().key.m_ts < __atomic_load_n (&m_impl->m_stopTs, __ATOMIC_RELAXED))
+        {
+          m_impl->ProcessOneEvent (this);
+        }
+      if (m_impl->Synchronize (this))
+        {
+          break;
+        }
+    }
+  g_partition = 0;
+}
+
+MultithreadedSimulatorImpl::Barrier::Barrier ()
+  : m_n (1),
+    m_spins (0),
+    m_count (0),
+    m_generation (0)
+{
+}
+
+void
+MultithreadedSimulatorImpl::Barrier::Reset (uint32_t n)
+{
+  m_n = n;
+  m_count = 0;
+  // spinning only pays off when the other threads run on other cores
+  m_spins = sysconf (_SC_NPROCESSORS_ONLN) > 1 ? 1000 : 0;
+}
+
+void
+MultithreadedSimulatorImpl::Barrier::Wait (void)
+{
+  uint32_t generation = __atomic_load_n (&m_generation, __ATOMIC_ACQUIRE);
+  if (__atomic_add_fetch (&m_count, 1, __ATOMIC_ACQ_REL) == m_n)
+    {
+      // the last one in lets everybody go
+      __atomic_store_n (&m_count, 0, __ATOMIC_RELAXED);
+      __atomic_add_fetch (&m_generation, 1, __ATOMIC_RELEASE);
+      return;
+    }
+  for (uint32_t i = 0; __atomic_load_n (&m_generation, __ATOMIC_ACQUIRE) == generation; i++)
+    {
+      if (i >= m_spins)
+        {
+          sched_yield ();
+        }
+    }
+}
+
+MultithreadedSimulatorImpl::MultithreadedSimulatorImpl ()
+{
+  NS_LOG_FUNCTION (this);
+#ifndef NS3_MTP
+  NS_FATAL_ERROR ("Can't use the multithreaded simulator without --enable-mtp configured in");
+#endif
+  m_partitions.push_back (new Partition (this, 0));
+  m_partitionCount = 0;
+  m_useSystemId = false;
+  m_partitioned = false;
+  m_uidStep = 1;
+  m_lookAhead = MAX_TS;
+  m_pLBTS = 0;
+  m_stopTs = MAX_TS;
+  m_running = false;
+  m_foreignSeq = 0;
+}
+
+MultithreadedSimulatorImpl::~MultithreadedSimulatorImpl ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+MultithreadedSimulatorImpl::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  for (std::vector<Partition *>::iterator i = m_partitions.begin (); i != m_partitions.end (); i++)
+    {
+      Partition *partition = *i;
+      while (!partition->m_events->IsEmpty ())
+        {
+          Scheduler::Event next = partition->m_events->RemoveNext ();
+          next.impl->Unref ();
+        }
+      for (CrossEvent *cross = partition->m_inbox.PopAll (); cross != 0;)
+        {
+          CrossEvent *next = cross->next;
+          cross->event->Unref ();
+          delete cross;
+          cross = next;
+        }
+      delete partition;
+    }
+  m_partitions.clear ();
+  delete [] m_pLBTS;
+  m_pLBTS = 0;
+  SimulatorImpl::DoDispose ();
+}
+
+void
+MultithreadedSimulatorImpl::Destroy ()
+{
+  NS_LOG_FUNCTION (this);
+  for (;;)
+    {
+      Ptr<EventImpl> ev;
+      {
+        CriticalSection cs (m_destroyEventsMutex);
+        if (m_destroyEvents.empty ())
+          {
+            break;
+          }
+        ev = m_destroyEvents.front ().PeekEventImpl ();
+        m_destroyEvents.pop_front ();
+      }
+      NS_LOG_LOGIC ("handle destroy " << ev);
+      if (!ev->IsCancelled ())
+        {
+          ev->Invoke ();
+        }
+    }
+}
+
+void
+MultithreadedSimulatorImpl::SetScheduler (ObjectFactory schedulerFactory)
+{
+  NS_LOG_FUNCTION (this << schedulerFactory);
+  NS_ASSERT (!m_running);
+  m_schedulerFactory = schedulerFactory;
+  for (std::vector<Partition *>::iterator i = m_partitions.begin (); i != m_partitions.end (); i++)
+    {
+      Ptr<Scheduler> scheduler = schedulerFactory.Create<Scheduler> ();
+      if ((*i)->m_events != 0)
+        {
+          while (!(*i)->m_events->IsEmpty ())
+            {
+              Scheduler::Event next = (*i)->m_events->RemoveNext ();
+              scheduler->Insert (next);
+            }
+        }
+      (*i)->m_events = scheduler;
+    }
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetSystemId (void) const
+{
+  return GetPartition ()->m_id;
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetPartitionCount (void) const
+{
+  return m_partitions.size ();
+}
+
+MultithreadedSimulatorImpl::Partition *
+MultithreadedSimulatorImpl::GetPartition (void) const
+{
+  Partition *partition = static_cast<Partition *> (g_partition);
+  if (partition == 0)
+    {
+      // the main thread, out of Run
+      return m_partitions[0];
+    }
+  return partition;
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetPartitionOf (uint32_t context) const
+{
+  if (context < m_partitionOf.size ())
+    {
+      return m_partitionOf[context];
+    }
+  // events without a node, and nodes created after the first run
+  return 0;
+}
+
+void
+MultithreadedSimulatorImpl::Insert (Partition *partition, uint64_t ts, uint32_t context,
+                                    EventImpl *event, uint32_t uid)
+{
+  Scheduler::Event ev;
+  ev.impl = event;
+  ev.key.m_ts = ts;
+  ev.key.m_context = context;
+  ev.key.m_uid = uid;
+  partition->m_unscheduledEvents++;
+  partition->m_events->Insert (ev);
+}
+
+void
+MultithreadedSimulatorImpl::ProcessOneEvent (Partition *partition)
+{
+  Scheduler::Event next = partition->m_events->RemoveNext ();
+
+  NS_ASSERT (next.key.m_ts >= partition->m_currentTs);
+  partition->m_unscheduledEvents--;
+
+  partition->m_currentTs = next.key.m_ts;
+  partition->m_currentContext = next.key.m_context;
+  partition->m_currentUid = next.key.m_uid;
+  next.impl->Invoke ();
+  next.impl->Unref ();
+}
+
+bool
+MultithreadedSimulatorImpl::IsLocalFinished (Partition *partition) const
+{
+  return partition->m_events->IsEmpty ()
+         || partition->m_events->PeekNext ().key.m_ts >= __atomic_load_n (&m_stopTs, __ATOMIC_RELAXED);
+}
+
+void
+MultithreadedSimulatorImpl::StopAt (uint64_t ts)
+{
+  uint64_t stopTs = __atomic_load_n (&m_stopTs, __ATOMIC_RELAXED);
+  while (ts < stopTs && !__atomic_compare_exchange_n (&m_stopTs, &stopTs, ts, true,
+                                                      __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    {
+    }
+}
+
+uint64_t
+MultithreadedSimulatorImpl::NextTs (Partition *partition) const
+{
+  if (IsLocalFinished (partition))
+    {
+      return MAX_TS;
+    }
+  return partition->m_events->PeekNext ().key.m_ts;
+}
+
+bool
+MultithreadedSimulatorImpl::IsFinished (void) const
+{
+  for (std::vector<Partition *>::const_iterator i = m_partitions.begin (); i != m_partitions.end (); i++)
+    {
+      if (!IsLocalFinished (*i))
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+void
+MultithreadedSimulatorImpl::Drain (Partition *partition)
+{
+  CrossEvent *cross = partition->m_inbox.PopAll ();
+  if (cross == 0)
+    {
+      return;
+    }
+  for (; cross != 0; cross = cross->next)
+    {
+      if (cross->source == NO_SOURCE)
+        {
+          cross->ts += partition->m_currentTs;
+        }
+      else
+        {
+          partition->m_rxCount++;
+        }
+      partition->m_drained.push_back (cross);
+    }
+  std::sort (partition->m_drained.begin (), partition->m_drained.end (), CrossEventLess ());
+  for (std::vector<CrossEvent *>::iterator i = partition->m_drained.begin ();
+       i != partition->m_drained.end (); i++)
+    {
+      Insert (partition, (*i)->ts, (*i)->context, (*i)->event, partition->m_uid);
+      partition->m_uid += m_uidStep;
+      delete *i;
+    }
+  partition->m_drained.clear ();
+}
+
+bool
+MultithreadedSimulatorImpl::Synchronize (Partition *partition)
+{
+  // every event of the window has been pushed once all are in
+  m_barrier.Wait ();
+  Drain (partition);
+  m_pLBTS[partition->m_id] = LbtsMessage (partition->m_rxCount, partition->m_txCount, partition->m_id,
+                                          IsLocalFinished (partition), TimeStep (NextTs (partition)));
+  m_barrier.Wait ();
+
+  // every partition reduces the same messages to the same result
+  Time smallestTime = m_pLBTS[0].GetSmallestTime ();
+  uint32_t totRx = m_pLBTS[0].GetRxCount ();
+  uint32_t totTx = m_pLBTS[0].GetTxCount ();
+  bool globalFinished = m_pLBTS[0].IsFinished ();
+  for (uint32_t i = 1; i < m_partitions.size (); ++i)
+    {
+      if (m_pLBTS[i].GetSmallestTime () < smallestTime)
+        {
+          smallestTime = m_pLBTS[i].GetSmallestTime ();
+        }
+      totRx += m_pLBTS[i].GetRxCount ();
+      totTx += m_pLBTS[i].GetTxCount ();
+      globalFinished &= m_pLBTS[i].IsFinished ();
+    }
+  // the barriers leave no event in transit
+  NS_ASSERT (totRx == totTx);
+  uint64_t smallest = smallestTime.GetTimeStep ();
+  if (m_lookAhead == MAX_TS || smallest >= MAX_TS - m_lookAhead)
+    {
+      partition->m_grantedTs = MAX_TS;
+    }
+  else
+    {
+      partition->m_grantedTs = smallest + m_lookAhead;
+    }
+  return globalFinished;
+}
+
+bool
+MultithreadedSimulatorImpl::GetLink (Ptr<NetDevice> device, Ptr<Node> &remote, uint64_t &delay)
+{
+  // only works for p2p links currently
+  if (!device->IsPointToPoint ())
+    {
+      return false;
+    }
+  Ptr<Channel> channel = device->GetChannel ();
+  if (channel == 0 || channel->GetNDevices () != 2)
+    {
+      return false;
+    }
+  TimeValue value;
+  if (!channel->GetAttributeFailSafe ("Delay", value))
+    {
+      return false;
+    }
+
+  // grab the adjacent node
+  if (channel->GetDevice (0) == device)
+    {
+      remote = (channel->GetDevice (1))->GetNode ();
+    }
+  else
+    {
+      remote = (channel->GetDevice (0))->GetNode ();
+    }
+  delay = value.Get ().GetTimeStep ();
+  return true;
+}
+
+uint32_t
+MultithreadedSimulatorImpl::PartitionBySystemId (void)
+{
+  NS_LOG_FUNCTION (this);
+  uint32_t n = 1;
+  for (NodeList::Iterator i = NodeList::Begin (); i != NodeList::End (); ++i)
+    {
+      uint32_t systemId = (*i)->GetSystemId ();
+      m_partitionOf[(*i)->GetId ()] = systemId;
+      n = std::max (n, systemId + 1);
+    }
+  return n;
+}
+
+uint32_t
+MultithreadedSimulatorImpl::PartitionByContext (void)
+{
+  NS_LOG_FUNCTION (this);
+  uint32_t nNodes = NodeList::GetNNodes ();
+
+  // union-find of the nodes linked by anything but a link with a delay
+  std::vector<uint32_t> group (nNodes);
+  for (uint32_t i = 0; i < nNodes; i++)
+    {
+      group[i] = i;
+    }
+  for (NodeList::Iterator iter = NodeList::Begin (); iter != NodeList::End (); ++iter)
+    {
+      for (uint32_t i = 0; i < (*iter)->GetNDevices (); ++i)
+        {
+          Ptr<NetDevice> device = (*iter)->GetDevice (i);
+          Ptr<Node> remote;
+          uint64_t delay;
+          Ptr<Channel> channel = device->GetChannel ();
+          if (channel == 0 || channel->GetNDevices () == 0
+              || (GetLink (device, remote, delay) && delay > 0))
+            {
+              continue;
+            }
+          // joining every node of a channel to its first one is enough
+          uint32_t a = (*iter)->GetId ();
+          uint32_t b = channel->GetDevice (0)->GetNode ()->GetId ();
+          while (group[a] != a)
+            {
+              a = group[a] = group[group[a]];
+            }
+          while (group[b] != b)
+            {
+              b = group[b] = group[group[b]];
+            }
+          group[std::max (a, b)] = std::min (a, b);
+        }
+    }
+
+  // the groups, in the order of their first node
+  std::vector<uint32_t> sizes (nNodes, 0);
+  std::vector<std::pair<uint32_t, uint32_t> > groups;
+  for (uint32_t i = 0; i < nNodes; i++)
+    {
+      uint32_t root = i;
+      while (group[root] != root)
+        {
+          root = group[root];
+        }
+      group[i] = root;
+      sizes[root]++;
+    }
+  for (uint32_t i = 0; i < nNodes; i++)
+    {
+      if (sizes[i] != 0)
+        {
+          // largest first, then by first node
+          groups.push_back (std::make_pair (nNodes - sizes[i], i));
+        }
+    }
+  std::sort (groups.begin (), groups.end ());
+
+  uint32_t n = m_partitionCount;
+  if (n == 0)
+    {
+      n = std::max (1L, sysconf (_SC_NPROCESSORS_ONLN));
+    }
+  n = std::max (1U, std::min (n, (uint32_t) groups.size ()));
+  std::vector<uint32_t> load (n, 0);
+  std::vector<uint32_t> partitionOfGroup (nNodes, 0);
+  for (std::vector<std::pair<uint32_t, uint32_t> >::iterator i = groups.begin (); i != groups.end (); i++)
+    {
+      uint32_t target = std::min_element (load.begin (), load.end ()) - load.begin ();
+      partitionOfGroup[i->second] = target;
+      load[target] += nNodes - i->first;
+    }
+  for (uint32_t i = 0; i < nNodes; i++)
+    {
+      m_partitionOf[i] = partitionOfGroup[group[i]];
+    }
+  return n;
+}
+
+void
+MultithreadedSimulatorImpl::Partitionate (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_partitioned)
+    {
+      m_partitionOf.resize (NodeList::GetNNodes (), 0);
+      return;
+    }
+  m_partitioned = true;
+
+  m_partitionOf.assign (NodeList::GetNNodes (), 0);
+  uint32_t n = m_useSystemId ? PartitionBySystemId () : PartitionByContext ();
+
+  Partition *first = m_partitions[0];
+  for (uint32_t i = 1; i < n; i++)
+    {
+      Partition *partition = new Partition (this, i);
+      partition->m_events = m_schedulerFactory.Create<Scheduler> ();
+      partition->m_currentTs = first->m_currentTs;
+      m_partitions.push_back (partition);
+    }
+
+  // uids stay unique across partitions: partition i allocates the uids
+  // equal to i modulo the number of partitions
+  uint32_t base = first->m_uid;
+  m_uidStep = n;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      m_partitions[i]->m_uid = base + i;
+    }
+
+  std::vector<Scheduler::Event> events;
+  while (!first->m_events->IsEmpty ())
+    {
+      events.push_back (first->m_events->RemoveNext ());
+    }
+  first->m_unscheduledEvents = 0;
+  for (std::vector<Scheduler::Event>::iterator i = events.begin (); i != events.end (); i++)
+    {
+      Partition *partition = m_partitions[GetPartitionOf (i->key.m_context)];
+      partition->m_unscheduledEvents++;
+      partition->m_events->Insert (*i);
+    }
+  NS_LOG_LOGIC (n << " partitions");
+}
+
+void
+MultithreadedSimulatorImpl::CalculateLookAhead (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_lookAhead = MAX_TS;
+  for (NodeList::Iterator iter = NodeList::Begin (); iter != NodeList::End (); ++iter)
+    {
+      uint32_t local = GetPartitionOf ((*iter)->GetId ());
+      for (uint32_t i = 0; i < (*iter)->GetNDevices (); ++i)
+        {
+          Ptr<NetDevice> device = (*iter)->GetDevice (i);
+          Ptr<Node> remoteNode;
+          uint64_t delay;
+          if (!GetLink (device, remoteNode, delay))
+            {
+              // the other channels, radio channels included, deliver as
+              // soon as they are sent to: they can't span partitions
+              Ptr<Channel> channel = device->GetChannel ();
+              for (uint32_t j = 0; channel != 0 && j < channel->GetNDevices (); j++)
+                {
+                  uint32_t remote = channel->GetDevice (j)->GetNode ()->GetId ();
+                  if (GetPartitionOf (remote) != local)
+                    {
+                      NS_FATAL_ERROR ("Nodes " << (*iter)->GetId () << " and " << remote <<
+                                      " share a channel without delay but are in different partitions");
+                    }
+                }
+              continue;
+            }
+
+          // if it's not in another partition, don't consider it
+          if (GetPartitionOf (remoteNode->GetId ()) == local)
+            {
+              continue;
+            }
+
+          if (delay < m_lookAhead)
+            {
+              m_lookAhead = delay;
+            }
+        }
+    }
+  if (m_lookAhead == 0)
+    {
+      NS_FATAL_ERROR ("Links between partitions need a non zero delay");
+    }
+  NS_LOG_LOGIC ("lookahead " << m_lookAhead);
+}
+
+void
+MultithreadedSimulatorImpl::Run (void)
+{
+  NS_LOG_FUNCTION (this);
+  Partitionate ();
+  CalculateLookAhead ();
+
+  uint32_t n = m_partitions.size ();
+  delete [] m_pLBTS;
+  m_pLBTS = new LbtsMessage[n];
+  m_barrier.Reset (n);
+  for (uint32_t i = 0; i < n; i++)
+    {
+      m_partitions[i]->m_grantedTs = 0;
+      m_partitions[i]->m_txCount = 0;
+      m_partitions[i]->m_rxCount = 0;
+    }
+  __atomic_store_n (&m_running, true, __ATOMIC_SEQ_CST);
+
+  // the calling thread runs the first partition
+  std::vector<Ptr<SystemThread> > threads;
+  for (uint32_t i = 1; i < n; i++)
+    {
+      Ptr<SystemThread> thread = Create<SystemThread> (MakeCallback (&Partition::Run, m_partitions[i]));
+      thread->Start ();
+      threads.push_back (thread);
+    }
+  m_partitions[0]->Run ();
+  for (std::vector<Ptr<SystemThread> >::iterator i = threads.begin (); i != threads.end (); i++)
+    {
+      (*i)->Join ();
+    }
+  __atomic_store_n (&m_running, false, __ATOMIC_SEQ_CST);
+  // the stop has been reached, the next run goes on
+  m_stopTs = MAX_TS;
+
+  // If the simulator stopped naturally by lack of events, make a
+  // consistency test to check that we didn't lose any events along the way.
+  for (uint32_t i = 0; i < n; i++)
+    {
+      NS_ASSERT (!m_partitions[i]->m_events->IsEmpty () || m_partitions[i]->m_unscheduledEvents == 0);
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Stop (void)
+{
+  NS_LOG_FUNCTION (this);
+  Partition *partition = static_cast<Partition *> (g_partition);
+  if (partition == 0)
+    {
+      // out of the partitions, there is no current time to stop at
+      if (__atomic_load_n (&m_running, __ATOMIC_SEQ_CST))
+        {
+          StopAt (0);
+        }
+      return;
+    }
+  // the events at the same time in the partition come after this one
+  StopAt (partition->m_currentTs);
+}
+
+void
+MultithreadedSimulatorImpl::Stop (Time const &time)
+{
+  NS_LOG_FUNCTION (this << time.GetTimeStep ());
+  // the other partitions may be far ahead of this one by the time the
+  // event runs: they learn the time now, and may still run its events
+  StopAt (GetPartition ()->m_currentTs + time.GetTimeStep () + 1);
+  Simulator::Schedule (time, &Simulator::Stop);
+}
+
+//
+// Schedule an event for a _relative_ time in the future.
+//
+EventId
+MultithreadedSimulatorImpl::Schedule (Time const &time, EventImpl *event)
+{
+  Partition *partition = GetPartition ();
+  NS_ASSERT_MSG (g_partition != 0 || !m_running, "Simulator::Schedule Thread-unsafe invocation!");
+
+  Time tAbsolute = time + TimeStep (partition->m_currentTs);
+
+  NS_ASSERT (tAbsolute.IsPositive ());
+  NS_ASSERT (tAbsolute >= TimeStep (partition->m_currentTs));
+  uint64_t ts = (uint64_t) tAbsolute.GetTimeStep ();
+  uint32_t uid = partition->m_uid;
+  partition->m_uid += m_uidStep;
+  Insert (partition, ts, partition->m_currentContext, event, uid);
+  return EventId (event, ts, partition->m_currentContext, uid);
+}
+
+void
+MultithreadedSimulatorImpl::ScheduleWithContext (uint32_t context, Time const &time, EventImpl *event)
+{
+  NS_LOG_FUNCTION (this << context << time.GetTimeStep () << event);
+
+  Partition *target = m_partitions[GetPartitionOf (context)];
+  Partition *partition = static_cast<Partition *> (g_partition);
+
+  if (partition == 0 && __atomic_load_n (&m_running, __ATOMIC_ACQUIRE))
+    {
+      // a thread out of the partitions, picked up at the next window
+      CrossEvent *cross = new CrossEvent;
+      cross->ts = time.GetTimeStep ();
+      cross->context = context;
+      cross->source = NO_SOURCE;
+      cross->seq = __atomic_fetch_add (&m_foreignSeq, 1, __ATOMIC_RELAXED);
+      cross->event = event;
+      target->m_inbox.Push (cross);
+      return;
+    }
+
+  if (partition == 0)
+    {
+      // out of Run, nothing else is running
+      partition = m_partitions[0];
+      uint64_t ts = std::max (partition->m_currentTs, target->m_currentTs) + time.GetTimeStep ();
+      Insert (target, ts, context, event, target->m_uid);
+      target->m_uid += m_uidStep;
+      return;
+    }
+
+  uint64_t ts = partition->m_currentTs + time.GetTimeStep ();
+  if (target == partition)
+    {
+      Insert (partition, ts, context, event, partition->m_uid);
+      partition->m_uid += m_uidStep;
+      return;
+    }
+
+  if ((uint64_t) time.GetTimeStep () < m_lookAhead)
+    {
+      NS_FATAL_ERROR ("Event scheduled on node " << context << " of partition " << target->m_id <<
+                      " from partition " << partition->m_id << " " << time <<
+                      " ahead, less than the lookahead " << TimeStep (m_lookAhead));
+    }
+  CrossEvent *cross = new CrossEvent;
+  cross->ts = ts;
+  cross->context = context;
+  cross->source = partition->m_id;
+  cross->seq = partition->m_uid;
+  partition->m_uid += m_uidStep;
+  cross->event = event;
+  target->m_inbox.Push (cross);
+  partition->m_txCount++;
+}
+
+EventId
+MultithreadedSimulatorImpl::ScheduleNow (EventImpl *event)
+{
+  Partition *partition = GetPartition ();
+  NS_ASSERT_MSG (g_partition != 0 || !m_running, "Simulator::ScheduleNow Thread-unsafe invocation!");
+
+  uint32_t uid = partition->m_uid;
+  partition->m_uid += m_uidStep;
+  Insert (partition, partition->m_currentTs, partition->m_currentContext, event, uid);
+  return EventId (event, partition->m_currentTs, partition->m_currentContext, uid);
+}
+
+EventId
+MultithreadedSimulatorImpl::ScheduleDestroy (EventImpl *event)
+{
+  EventId id (Ptr<EventImpl> (event, false), GetPartition ()->m_currentTs, 0xffffffff, 2);
+  CriticalSection cs (m_destroyEventsMutex);
+  m_destroyEvents.push_back (id);
+  return id;
+}
+
+Time
+MultithreadedSimulatorImpl::Now (void) const
+{
+  // Do not add function logging here, to avoid stack overflow
+  return TimeStep (GetPartition ()->m_currentTs);
+}
+
+Time
+MultithreadedSimulatorImpl::GetDelayLeft (const EventId &id) const
+{
+  if (IsExpired (id))
+    {
+      return TimeStep (0);
+    }
+  else
+    {
+      return TimeStep (id.GetTs () - GetPartition ()->m_currentTs);
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Remove (const EventId &id)
+{
+  if (id.GetUid () == 2)
+    {
+      // destroy events.
+      CriticalSection cs (m_destroyEventsMutex);
+      for (DestroyEvents::iterator i = m_destroyEvents.begin (); i != m_destroyEvents.end (); i++)
+        {
+          if (*i == id)
+            {
+              m_destroyEvents.erase (i);
+              break;
+            }
+        }
+      return;
+    }
+  if (IsExpired (id))
+    {
+      return;
+    }
+  Partition *partition = m_partitions[GetPartitionOf (id.GetContext ())];
+  Scheduler::Event event;
+  event.impl = id.PeekEventImpl ();
+  event.key.m_ts = id.GetTs ();
+  event.key.m_context = id.GetContext ();
+  event.key.m_uid = id.GetUid ();
+  partition->m_events->Remove (event);
+  event.impl->Cancel ();
+  // whenever we remove an event from the event list, we have to unref it.
+  event.impl->Unref ();
+
+  partition->m_unscheduledEvents--;
+}
+
+void
+MultithreadedSimulatorImpl::Cancel (const EventId &id)
+{
+  if (!IsExpired (id))
+    {
+      id.PeekEventImpl ()->Cancel ();
+    }
+}
+
+bool
+MultithreadedSimulatorImpl::IsExpired (const EventId &ev) const
+{
+  if (ev.GetUid () == 2)
+    {
+      if (ev.PeekEventImpl () == 0
+          || ev.PeekEventImpl ()->IsCancelled ())
+        {
+          return true;
+        }
+      // destroy events.
+      CriticalSection cs (const_cast<SystemMutex &> (m_destroyEventsMutex));
+      for (DestroyEvents::const_iterator i = m_destroyEvents.begin (); i != m_destroyEvents.end (); i++)
+        {
+          if (*i == ev)
+            {
+              return false;
+            }
+        }
+      return true;
+    }
+  Partition *partition = m_partitions[GetPartitionOf (ev.GetContext ())];
+  if (ev.PeekEventImpl () == 0
+      || ev.GetTs () < partition->m_currentTs
+      || (ev.GetTs () == partition->m_currentTs
+          && ev.GetUid () <= partition->m_currentUid)
+      || ev.PeekEventImpl ()->IsCancelled ())
+    {
+      return true;
+    }
+  else
+    {
+      return false;
+    }
+}
+
+Time
+MultithreadedSimulatorImpl::GetMaximumSimulationTime (void) const
+{
+  return TimeStep (MAX_TS);
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetContext (void) const
+{
+  return GetPartition ()->m_currentContext;
+}
+
+} // namespace ns3
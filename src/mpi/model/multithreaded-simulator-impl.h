@@ -0,0 +1,248 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef NS3_MULTITHREADED_SIMULATOR_IMPL_H
+#define NS3_MULTITHREADED_SIMULATOR_IMPL_H
+
+#include "distributed-simulator-impl.h"
+
+#include "ns3/simulator-impl.h"
+#include "ns3/scheduler.h"
+#include "ns3/event-impl.h"
+#include "ns3/object-factory.h"
+#include "ns3/system-mutex.h"
+#include "ns3/mpsc-queue.h"
+#include "ns3/ptr.h"
+#include "ns3/net-device.h"
+#include "ns3/node.h"
+
+#include <list>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup mpi
+ *
+ * \brief Parallel simulator running the partitions of a simulation on the
+ * threads of a single process.
+ *
+ * Every partition owns the events of the nodes (contexts) it holds and
+ * runs them on its own thread.  Events without a node context belong to
+ * partition 0, which runs on the thread calling Simulator::Run.  At the
+ * first run, the nodes are partitioned by context: the nodes sharing a
+ * link other than a point to point link with a delay (a CSMA or a wifi
+ * channel, a point to point link without delay) are grouped together, as
+ * only point to point links give the lookahead needed between two
+ * partitions, and the groups are spread over PartitionCount partitions,
+ * the largest groups first, each to the partition holding the fewest
+ * nodes so far.  With UseSystemId, the nodes are partitioned by their
+ * system id instead, just as they are spread over the MPI ranks by the
+ * DistributedSimulatorImpl.
+ *
+ * The synchronization is the same conservative time window scheme as the
+ * DistributedSimulatorImpl: the lookahead is the smallest delay of the
+ * point to point links between two partitions, and after every window the
+ * partitions exchange an LbtsMessage to agree on the next one.  Instead of
+ * being serialized over MPI, an event scheduled on a node of another
+ * partition is handed over as is (packets by reference) through the
+ * lock-free inbox of that partition.  Such events must be scheduled at
+ * least a lookahead in the future.  Point to point links between partitions
+ * use the ordinary PointToPointChannel, MPI does not need to be enabled.
+ *
+ * Objects are shared across threads, ns-3 has to be configured with
+ * --enable-mtp to make the reference counts of the core and of the packets
+ * atomic.  Models must still not touch the state of a node of another
+ * partition other than through scheduled events, nor modify a packet once
+ * it has been handed to another partition.  Events may only be cancelled
+ * or removed from the partition they belong to.  Simulator::Stop (time)
+ * stops every partition before the events after that time, which they all
+ * know as soon as it is called.  Simulator::Stop stops them before the
+ * time of the event calling it, but a partition ahead of that event in the
+ * current window may have run past it.
+ */
+class MultithreadedSimulatorImpl : public SimulatorImpl
+{
+public:
+  static TypeId GetTypeId (void);
+
+  MultithreadedSimulatorImpl ();
+  ~MultithreadedSimulatorImpl ();
+
+  virtual void Destroy ();
+  virtual bool IsFinished (void) const;
+  virtual void Stop (void);
+  virtual void Stop (Time const &time);
+  virtual EventId Schedule (Time const &time, EventImpl *event);
+  virtual void ScheduleWithContext (uint32_t context, Time const &time, EventImpl *event);
+  virtual EventId ScheduleNow (EventImpl *event);
+  virtual EventId ScheduleDestroy (EventImpl *event);
+  virtual void Remove (const EventId &ev);
+  virtual void Cancel (const EventId &ev);
+  virtual bool IsExpired (const EventId &ev) const;
+  virtual void Run (void);
+  virtual Time Now (void) const;
+  virtual Time GetDelayLeft (const EventId &id) const;
+  virtual Time GetMaximumSimulationTime (void) const;
+  virtual void SetScheduler (ObjectFactory schedulerFactory);
+  virtual uint32_t GetSystemId (void) const;
+  virtual uint32_t GetContext (void) const;
+
+  /**
+   * \returns the number of partitions of the last run
+   */
+  uint32_t GetPartitionCount (void) const;
+
+private:
+  /**
+   * An event scheduled on a node of another partition
+   */
+  struct CrossEvent
+  {
+    CrossEvent *next;
+    uint64_t ts;
+    uint32_t context;
+    // partition the event comes from, or 0xffffffff if it comes from a
+    // thread outside of the partitions, in which case ts is relative to the time of the
+    // destination when it is drained
+    uint32_t source;
+    uint32_t seq;
+    EventImpl *event;
+  };
+  struct CrossEventLess
+  {
+    bool operator () (const CrossEvent *a, const CrossEvent *b) const;
+  };
+
+  /**
+   * The state of a partition, only touched by its own thread but for the
+   * inbox
+   */
+  struct Partition
+  {
+    Partition (MultithreadedSimulatorImpl *impl, uint32_t id);
+    void Run (void);
+
+    MultithreadedSimulatorImpl *m_impl;
+    uint32_t m_id;
+    Ptr<Scheduler> m_events;
+    uint64_t m_currentTs;
+    uint32_t m_currentUid;
+    uint32_t m_currentContext;
+    uint32_t m_uid;
+    int m_unscheduledEvents;
+    uint64_t m_grantedTs;
+    uint32_t m_txCount;
+    uint32_t m_rxCount;
+    std::vector<CrossEvent *> m_drained;
+    // events pushed by the other partitions, on its own cache line
+    char m_pad0[64];
+    MpscQueue<CrossEvent> m_inbox;
+    char m_pad1[64];
+  };
+
+  /**
+   * Barrier counting generations, spins for a while then yields
+   */
+  class Barrier
+  {
+public:
+    Barrier ();
+    void Reset (uint32_t n);
+    void Wait (void);
+private:
+    uint32_t m_n;
+    uint32_t m_spins;
+    volatile uint32_t m_count;
+    volatile uint32_t m_generation;
+  };
+
+  virtual void DoDispose (void);
+  Partition *GetPartition (void) const;
+  uint32_t GetPartitionOf (uint32_t context) const;
+  void Insert (Partition *partition, uint64_t ts, uint32_t context, EventImpl *event, uint32_t uid);
+  void ProcessOneEvent (Partition *partition);
+  bool IsLocalFinished (Partition *partition) const;
+  /// Lowers m_stopTs to ts, the partitions may be running
+  void StopAt (uint64_t ts);
+  uint64_t NextTs (Partition *partition) const;
+  void Drain (Partition *partition);
+  /**
+   * Agrees with the other partitions on the next window
+   *
+   * \returns true once every partition is done
+   */
+  bool Synchronize (Partition *partition);
+  /**
+   * Splits the nodes into partitions and moves the events scheduled so
+   * far into the partition of their context
+   */
+  void Partitionate (void);
+  /**
+   * Fills m_partitionOf with the system ids of the nodes
+   *
+   * \returns the number of partitions
+   */
+  uint32_t PartitionBySystemId (void);
+  /**
+   * Fills m_partitionOf with the groups of nodes which can not be split,
+   * spread over at most m_partitionCount partitions
+   *
+   * \returns the number of partitions
+   */
+  uint32_t PartitionByContext (void);
+  /**
+   * \param device a device of a node
+   * \param remote the node at the other end of the link, if any
+   * \param delay the delay of the link, in time steps
+   * \returns true if the device is on a point to point link, which
+   *          partitions may be split along if it has a delay
+   */
+  static bool GetLink (Ptr<NetDevice> device, Ptr<Node> &remote, uint64_t &delay);
+  /**
+   * Smallest delay of the point to point links between two partitions,
+   * as DistributedSimulatorImpl::CalculateLookAhead computes it between
+   * ranks. The nodes of the other channels must share a partition.
+   */
+  void CalculateLookAhead (void);
+
+  // number of partitions to spread the nodes over, 0 for one per processor
+  uint32_t m_partitionCount;
+  bool m_useSystemId;
+  std::vector<Partition *> m_partitions;
+  // partition of every node, indexed by context
+  std::vector<uint32_t> m_partitionOf;
+  bool m_partitioned;
+  // uids allocated by a partition are congruent to its id modulo this step
+  uint32_t m_uidStep;
+  ObjectFactory m_schedulerFactory;
+  uint64_t m_lookAhead;
+  LbtsMessage *m_pLBTS;
+  Barrier m_barrier;
+  // the events from this time on are not run
+  uint64_t m_stopTs;
+  bool m_running;
+  // sequence of the events pushed from threads outside of the partitions
+  uint32_t m_foreignSeq;
+
+  typedef std::list<EventId> DestroyEvents;
+  DestroyEvents m_destroyEvents;
+  SystemMutex m_destroyEventsMutex;
+};
+
+} // namespace ns3
+
+#endif /* NS3_MULTITHREADED_SIMULATOR_IMPL_H */
@@ -0,0 +1,235 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Creates, copies and destroys packets the way a network of 802.15.4
+// and Ethernet devices does: short frames, full segments and bare
+// acknowledgements, each with a couple of headers and tags, a window of
+// them in flight in the queues. Then prints the counters of the slabs
+// the packets were allocated from, to tune the size classes.
+
+#include "ns3/command-line.h"
+#include "ns3/header.h"
+#include "ns3/packet.h"
+#include "ns3/packet-metadata.h"
+#include "ns3/slab-allocator.h"
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/tag.h"
+#include <iostream>
+#include <vector>
+
+using namespace ns3;
+
+class ChurnHeader : public Header
+{
+public:
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual void Print (std::ostream &os) const;
+  virtual uint32_t GetSerializedSize (void) const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+};
+
+TypeId
+ChurnHeader::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::ChurnHeader")
+    .SetParent<Header> ()
+    .AddConstructor<ChurnHeader> ()
+  ;
+  return tid;
+}
+TypeId
+ChurnHeader::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+void
+ChurnHeader::Print (std::ostream &os) const
+{
+}
+uint32_t
+ChurnHeader::GetSerializedSize (void) const
+{
+  return 20;
+}
+void
+ChurnHeader::Serialize (Buffer::Iterator start) const
+{
+  start.WriteU8 (0x45, 20);
+}
+uint32_t
+ChurnHeader::Deserialize (Buffer::Iterator start)
+{
+  start.Next (20);
+  return 20;
+}
+
+class ChurnTag : public Tag
+{
+public:
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual uint32_t GetSerializedSize (void) const;
+  virtual void Serialize (TagBuffer i) const;
+  virtual void Deserialize (TagBuffer i);
+  virtual void Print (std::ostream &os) const;
+};
+
+TypeId
+ChurnTag::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::ChurnTag")
+    .SetParent<Tag> ()
+    .AddConstructor<ChurnTag> ()
+  ;
+  return tid;
+}
+TypeId
+ChurnTag::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+uint32_t
+ChurnTag::GetSerializedSize (void) const
+{
+  return 8;
+}
+void
+ChurnTag::Serialize (TagBuffer i) const
+{
+  i.WriteU64 (0);
+}
+void
+ChurnTag::Deserialize (TagBuffer i)
+{
+  i.ReadU64 ();
+}
+void
+ChurnTag::Print (std::ostream &os) const
+{
+}
+
+// 802.15.4 frames, Ethernet segments and acknowledgements
+static const uint32_t g_sizes[] = { 127, 1500, 40, 127, 80, 1500, 127, 40 };
+static const uint32_t N_SIZES = sizeof (g_sizes) / sizeof (g_sizes[0]);
+
+static void
+ChurnPackets (uint32_t n, uint32_t window)
+{
+  std::vector<Ptr<Packet> > inFlight (window);
+  ChurnHeader header;
+  ChurnTag tag;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Ptr<Packet> p = Create<Packet> (g_sizes[i % N_SIZES]);
+      p->AddByteTag (tag);
+      p->AddPacketTag (tag);
+      p->AddHeader (header);
+      p->AddHeader (header);
+      // the copy a broadcast or a retransmission keeps
+      Ptr<Packet> copy = p->Copy ();
+      copy->RemoveHeader (header);
+      copy->RemovePacketTag (tag);
+      inFlight[i % window] = copy;
+    }
+}
+
+static void
+ChurnBlocks (uint32_t n, uint32_t window, bool slab)
+{
+  std::vector<void *> inFlight (window, (void *)0);
+  std::vector<uint32_t> sizes (window, 0);
+  for (uint32_t i = 0; i < n; i++)
+    {
+      uint32_t j = i % window;
+      if (inFlight[j] != 0)
+        {
+          if (slab)
+            {
+              SlabAllocator::Deallocate (inFlight[j], sizes[j]);
+            }
+          else
+            {
+              ::operator delete (inFlight[j]);
+            }
+        }
+      sizes[j] = g_sizes[i % N_SIZES] + 64;
+      inFlight[j] = slab ? SlabAllocator::Allocate (sizes[j]) : ::operator new (sizes[j]);
+    }
+  for (uint32_t j = 0; j < window; j++)
+    {
+      if (inFlight[j] == 0)
+        {
+          continue;
+        }
+      if (slab)
+        {
+          SlabAllocator::Deallocate (inFlight[j], sizes[j]);
+        }
+      else
+        {
+          ::operator delete (inFlight[j]);
+        }
+    }
+}
+
+static void
+Report (char const *name, uint32_t n, uint64_t deltaMs)
+{
+  double ps = n;
+  ps *= 1000;
+  ps /= deltaMs == 0 ? 1 : deltaMs;
+  std::cout << ps << " packets/s"
+            << " (" << deltaMs << " ms elapsed)\t"
+            << name << std::endl;
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t n = 1000000;
+  uint32_t window = 1000;
+  bool metadata = false;
+
+  CommandLine cmd;
+  cmd.AddValue ("n", "Number of packets to create", n);
+  cmd.AddValue ("window", "Number of packets alive at any time", window);
+  cmd.AddValue ("metadata", "Enable the packet metadata", metadata);
+  cmd.Parse (argc, argv);
+
+  if (metadata)
+    {
+      PacketMetadata::Enable ();
+    }
+
+  SystemWallClockMs time;
+  time.Start ();
+  ChurnPackets (n, window);
+  Report ("packets with 2 headers and 2 tags", n, time.End ());
+
+  time.Start ();
+  ChurnBlocks (n, window, true);
+  Report ("blocks of the slabs", n, time.End ());
+
+  time.Start ();
+  ChurnBlocks (n, window, false);
+  Report ("blocks of the global allocator", n, time.End ());
+
+  std::cout << std::endl;
+  SlabAllocator::PrintStats (std::cout);
+
+  return 0;
+}
@@ -6,10 +6,13 @@
  */
 
 #include "contiki-node-container.h"
+#include "ns3/log.h"
+
+NS_LOG_COMPONENT_DEFINE ("ContikiNodeContainer");
 
 namespace ns3 {
 ContikiNodeContainer::ContikiNodeContainer(){
-		std::cout << "Contiki & NS3";
+		NS_LOG_FUNCTION (this);
 	}
 }
 
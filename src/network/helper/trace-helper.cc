@@ -45,6 +45,30 @@ PcapHelper::~PcapHelper ()
   NS_LOG_FUNCTION_NOARGS ();
 }
 
+Ptr<PcapNgFile> &
+PcapHelper::GetPcapNgFile (void)
+{
+  static Ptr<PcapNgFile> file;
+  return file;
+}
+
+void
+PcapHelper::EnablePcapNg (std::string filename)
+{
+  NS_LOG_FUNCTION (filename);
+  Ptr<PcapNgFile> file = Create<PcapNgFile> ();
+  file->Open (filename);
+  NS_ABORT_MSG_IF (file->Fail (), "Unable to Open " << filename);
+  GetPcapNgFile () = file;
+}
+
+void
+PcapHelper::DisablePcapNg (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  GetPcapNgFile () = 0;
+}
+
 Ptr<PcapFileWrapper>
 PcapHelper::CreateFile (
   std::string filename, 
@@ -56,7 +80,14 @@ PcapHelper::CreateFile (
   NS_LOG_FUNCTION (filename << filemode << dataLinkType << snapLen << tzCorrection);
 
   Ptr<PcapFileWrapper> file = CreateObject<PcapFileWrapper> ();
-  file->Open (filename, filemode);
+  if (GetPcapNgFile () != 0)
+    {
+      file->Open (GetPcapNgFile (), filename);
+    }
+  else
+    {
+      file->Open (filename, filemode);
+    }
   NS_ABORT_MSG_IF (file->Fail (), "Unable to Open " << filename << " for mode " << filemode);
 
   file->Init (dataLinkType, snapLen, tzCorrection);
@@ -82,12 +82,30 @@ public:
    */
   Ptr<PcapFileWrapper> CreateFile (std::string filename, std::ios::openmode filemode,
                                    uint32_t dataLinkType,  uint32_t snapLen = 65535, int32_t tzCorrection = 0);
+
+  /**
+   * @brief Capture to one pcapng file from now on
+   *
+   * The files created afterwards by CreateFile are interfaces of the given
+   * pcapng file, named after the filename they are created with, instead
+   * of pcap files of their own: a simulation with thousands of devices
+   * keeps a single file open.  The pcapng file is closed once the last of
+   * its interfaces is.
+   *
+   * \param filename the name of the pcapng file
+   */
+  static void EnablePcapNg (std::string filename);
+  /**
+   * @brief Create pcap files of their own again in CreateFile
+   */
+  static void DisablePcapNg (void);
   /**
    * @brief Hook a trace source to the default trace sink
    */
   template <typename T> void HookDefaultSink (Ptr<T> object, std::string traceName, Ptr<PcapFileWrapper> file);
 
 private:
+  static Ptr<PcapNgFile> &GetPcapNgFile (void);
   static void DefaultSink (Ptr<PcapFileWrapper> file, Ptr<const Packet> p);
 };
 
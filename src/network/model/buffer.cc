@@ -18,6 +18,7 @@
  * Author: Mathieu Lacage <mathieu.lacage@sophia.inria.fr>
  */
 #include "buffer.h"
+#include "ns3/slab-allocator.h"
 #include "ns3/assert.h"
 #include "ns3/log.h"
 
@@ -164,10 +165,11 @@ Buffer::Allocate (uint32_t reqSize)
       reqSize = 1;
     }
   NS_ASSERT (reqSize >= 1);
-  uint32_t size = reqSize - 1 + sizeof (struct Buffer::Data);
-  uint8_t *b = new uint8_t [size];
+  // use the whole block of the slab
+  uint32_t size = SlabAllocator::GetBlockSize (reqSize - 1 + sizeof (struct Buffer::Data));
+  uint8_t *b = static_cast<uint8_t *> (SlabAllocator::Allocate (size));
   struct Buffer::Data *data = reinterpret_cast<struct Buffer::Data*>(b);
-  data->m_size = reqSize;
+  data->m_size = size + 1 - sizeof (struct Buffer::Data);
   data->m_count = 1;
   return data;
 }
@@ -177,8 +179,7 @@ Buffer::Deallocate (struct Buffer::Data *data)
 {
   NS_LOG_FUNCTION (data);
   NS_ASSERT (data->m_count == 0);
-  uint8_t *buf = reinterpret_cast<uint8_t *> (data);
-  delete [] buf;
+  SlabAllocator::Deallocate (data, data->m_size - 1 + sizeof (struct Buffer::Data));
 }
 
 Buffer::Buffer ()
@@ -258,13 +259,12 @@ Buffer::operator = (Buffer const&o)
   if (m_data != o.m_data) 
     {
       // not assignment to self.
-      m_data->m_count--;
-      if (m_data->m_count == 0) 
+      if (RefCountDecrement (m_data->m_count) == 0) 
         {
           Recycle (m_data);
         }
       m_data = o.m_data;
-      m_data->m_count++;
+      RefCountIncrement (m_data->m_count);
     }
   g_recommendedStart = std::max (g_recommendedStart, m_maxZeroAreaStart);
   m_maxZeroAreaStart = o.m_maxZeroAreaStart;
@@ -281,8 +281,7 @@ Buffer::~Buffer ()
   NS_LOG_FUNCTION (this);
   NS_ASSERT (CheckInternalState ());
   g_recommendedStart = std::max (g_recommendedStart, m_maxZeroAreaStart);
-  m_data->m_count--;
-  if (m_data->m_count == 0) 
+  if (RefCountDecrement (m_data->m_count) == 0) 
     {
       Recycle (m_data);
     }
@@ -326,8 +325,7 @@ Buffer::AddAtStart (uint32_t start)
       uint32_t newSize = GetInternalSize () + start;
       struct Buffer::Data *newData = Buffer::Create (newSize);
       memcpy (newData->m_data + start, m_data->m_data + m_start, GetInternalSize ());
-      m_data->m_count--;
-      if (m_data->m_count == 0)
+      if (RefCountDecrement (m_data->m_count) == 0)
         {
           Buffer::Recycle (m_data);
         }
@@ -379,8 +377,7 @@ Buffer::AddAtEnd (uint32_t end)
       uint32_t newSize = GetInternalSize () + end;
       struct Buffer::Data *newData = Buffer::Create (newSize);
       memcpy (newData->m_data, m_data->m_data + m_start, GetInternalSize ());
-      m_data->m_count--;
-      if (m_data->m_count == 0) 
+      if (RefCountDecrement (m_data->m_count) == 0) 
         {
           Buffer::Recycle (m_data);
         }
@@ -24,6 +24,7 @@
 #include <vector>
 #include <ostream>
 #include "ns3/assert.h"
+#include "ns3/simple-ref-count.h"
 
 #define noBUFFER_FREE_LIST 1
 
@@ -861,7 +862,7 @@ Buffer::Buffer (Buffer const&o)
     m_start (o.m_start),
     m_end (o.m_end)
 {
-  m_data->m_count++;
+  RefCountIncrement (m_data->m_count);
   NS_ASSERT (CheckInternalState ());
 }
 
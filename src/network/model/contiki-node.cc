@@ -1,8 +1,11 @@
 #include "contiki-node.h"
+#include "ns3/log.h"
+
+NS_LOG_COMPONENT_DEFINE ("ContikiNode");
 
 namespace ns3 {
 ContikiNode::ContikiNode(){
 
-	std::cout << "Contiki Node";
+	NS_LOG_FUNCTION (this);
 }
 }
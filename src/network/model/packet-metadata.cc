@@ -19,6 +19,7 @@
  */
 #include <utility>
 #include <list>
+#include <algorithm>
 #include "ns3/assert.h"
 #include "ns3/fatal-error.h"
 #include "ns3/log.h"
@@ -26,6 +27,7 @@
 #include "buffer.h"
 #include "header.h"
 #include "trailer.h"
+#include "ns3/slab-allocator.h"
 
 NS_LOG_COMPONENT_DEFINE ("PacketMetadata");
 
@@ -36,17 +38,6 @@ bool PacketMetadata::m_enableChecking = false;
 bool PacketMetadata::m_metadataSkipped = false;
 uint32_t PacketMetadata::m_maxSize = 0;
 uint16_t PacketMetadata::m_chunkUid = 0;
-PacketMetadata::DataFreeList PacketMetadata::m_freeList;
-
-PacketMetadata::DataFreeList::~DataFreeList ()
-{
-  NS_LOG_FUNCTION (this);
-  for (iterator i = begin (); i != end (); i++)
-    {
-      PacketMetadata::Deallocate (*i);
-    }
-  PacketMetadata::m_enable = false;
-}
 
 void 
 PacketMetadata::Enable (void)
@@ -77,8 +68,7 @@ PacketMetadata::ReserveCopy (uint32_t size)
   struct PacketMetadata::Data *newData = PacketMetadata::Create (m_used + size);
   memcpy (newData->m_data, m_data->m_data, m_used);
   newData->m_dirtyEnd = m_used;
-  m_data->m_count--;
-  if (m_data->m_count == 0) 
+  if (RefCountDecrement (m_data->m_count) == 0) 
     {
       PacketMetadata::Recycle (m_data);
     }
@@ -133,6 +123,10 @@ bool
 PacketMetadata::IsStateOk (void) const
 {
   NS_LOG_FUNCTION (this);
+  if (m_data == 0)
+    {
+      return m_log == 0 ? m_logUsed == 0 : m_logUsed <= m_log->m_dirtyEnd;
+    }
   bool ok = m_used <= m_data->m_size;
   ok &= IsPointerOk (m_head);
   ok &= IsPointerOk (m_tail);
@@ -587,19 +581,6 @@ PacketMetadata::Create (uint32_t size)
     {
       m_maxSize = size;
     }
-  while (!m_freeList.empty ()) 
-    {
-      struct PacketMetadata::Data *data = m_freeList.back ();
-      m_freeList.pop_back ();
-      if (data->m_size >= size) 
-        {
-          NS_LOG_LOGIC ("create found size="<<data->m_size);
-          data->m_count = 1;
-          return data;
-        }
-      PacketMetadata::Deallocate (data);
-      NS_LOG_LOGIC ("create dealloc size="<<data->m_size);
-    }
   NS_LOG_LOGIC ("create alloc size="<<m_maxSize);
   return PacketMetadata::Allocate (m_maxSize);
 }
@@ -608,22 +589,8 @@ void
 PacketMetadata::Recycle (struct PacketMetadata::Data *data)
 {
   NS_LOG_FUNCTION (data);
-  if (!m_enable)
-    {
-      PacketMetadata::Deallocate (data);
-      return;
-    } 
-  NS_LOG_LOGIC ("recycle size="<<data->m_size<<", list="<<m_freeList.size ());
   NS_ASSERT (data->m_count == 0);
-  if (m_freeList.size () > 1000 ||
-      data->m_size < m_maxSize) 
-    {
-      PacketMetadata::Deallocate (data);
-    } 
-  else 
-    {
-      m_freeList.push_back (data);
-    }
+  PacketMetadata::Deallocate (data);
 }
 
 struct PacketMetadata::Data *
@@ -636,9 +603,11 @@ PacketMetadata::Allocate (uint32_t n)
       n = PACKET_METADATA_DATA_M_DATA_SIZE;
     }
   size += n - PACKET_METADATA_DATA_M_DATA_SIZE;
-  uint8_t *buf = new uint8_t [size];
+  // use the whole block of the slab
+  size = SlabAllocator::GetBlockSize (size);
+  uint8_t *buf = static_cast<uint8_t *> (SlabAllocator::Allocate (size));
   struct PacketMetadata::Data *data = (struct PacketMetadata::Data *)buf;
-  data->m_size = n;
+  data->m_size = size - sizeof (struct Data) + PACKET_METADATA_DATA_M_DATA_SIZE;
   data->m_count = 1;
   data->m_dirtyEnd = 0;
   return data;
@@ -647,10 +616,170 @@ void
 PacketMetadata::Deallocate (struct PacketMetadata::Data *data)
 {
   NS_LOG_FUNCTION (data);
-  uint8_t *buf = (uint8_t *)data;
-  delete [] buf;
+  SlabAllocator::Deallocate (data, data->m_size + sizeof (struct Data)
+                             - PACKET_METADATA_DATA_M_DATA_SIZE);
+}
+
+struct PacketMetadata::Log *
+PacketMetadata::AllocateLog (uint32_t n)
+{
+  NS_LOG_FUNCTION (n);
+  uint32_t size = sizeof (struct Log) + (n - 1) * sizeof (struct LogRecord);
+  // use the whole block of the slab
+  size = SlabAllocator::GetBlockSize (size);
+  struct PacketMetadata::Log *log =
+    static_cast<struct PacketMetadata::Log *> (SlabAllocator::Allocate (size));
+  log->m_size = (size - sizeof (struct Log)) / sizeof (struct LogRecord) + 1;
+  log->m_count = 1;
+  log->m_dirtyEnd = 0;
+  return log;
+}
+void
+PacketMetadata::DeallocateLog (struct PacketMetadata::Log *log)
+{
+  NS_LOG_FUNCTION (log);
+  NS_ASSERT (log->m_count == 0);
+  ReleaseRecords (log, 0);
+  SlabAllocator::Deallocate (log, sizeof (struct Log)
+                             + (log->m_size - 1) * sizeof (struct LogRecord));
+}
+void
+PacketMetadata::ReleaseRecords (struct PacketMetadata::Log *log, uint32_t end)
+{
+  NS_LOG_FUNCTION (log << end);
+  for (uint32_t i = end; i < log->m_dirtyEnd; i++)
+    {
+      if (log->m_records[i].type == LOG_ADD_AT_END)
+        {
+          delete log->m_records[i].other;
+        }
+    }
+  log->m_dirtyEnd = end;
+}
+
+struct PacketMetadata::LogRecord *
+PacketMetadata::LogAppend (uint16_t type)
+{
+  NS_LOG_FUNCTION (this << type);
+  NS_ASSERT (m_data == 0);
+  if (m_log != 0 && m_log->m_count == 1)
+    {
+      // the records past ours are no longer used by anybody
+      ReleaseRecords (m_log, m_logUsed);
+    }
+  if (m_log == 0 ||
+      m_logUsed == m_log->m_size ||
+      m_log->m_dirtyEnd != m_logUsed)
+    {
+      // (not enough room) or (dirty): copy our records
+      struct PacketMetadata::Log *log = AllocateLog (std::max (8U, 2 * m_logUsed));
+      if (m_log != 0)
+        {
+          memcpy (log->m_records, m_log->m_records,
+                  m_logUsed * sizeof (struct LogRecord));
+          for (uint32_t i = 0; i < m_logUsed; i++)
+            {
+              if (log->m_records[i].type == LOG_ADD_AT_END)
+                {
+                  log->m_records[i].other = new PacketMetadata (*log->m_records[i].other);
+                }
+            }
+          if (RefCountDecrement (m_log->m_count) == 0)
+            {
+              DeallocateLog (m_log);
+            }
+        }
+      m_log = log;
+    }
+  struct PacketMetadata::LogRecord *record = &m_log->m_records[m_logUsed];
+  record->type = type;
+  m_logUsed++;
+  m_log->m_dirtyEnd = m_logUsed;
+  return record;
+}
+void
+PacketMetadata::LogRemove (uint16_t addType, uint16_t removeType,
+                           uint32_t uid, uint32_t size)
+{
+  NS_LOG_FUNCTION (this << addType << removeType << uid << size);
+  if (m_logUsed > 0)
+    {
+      const struct PacketMetadata::LogRecord *last = &m_log->m_records[m_logUsed - 1];
+      if (last->type == addType && last->typeUid == uid && last->size == size)
+        {
+          // removing what was just added
+          m_logUsed--;
+          return;
+        }
+    }
+  struct PacketMetadata::LogRecord *record = LogAppend (removeType);
+  record->typeUid = uid;
+  record->size = size;
 }
 
+void
+PacketMetadata::CreateList (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (m_logUsed == 0);
+  if (m_data != 0)
+    {
+      return;
+    }
+  if (m_log != 0)
+    {
+      if (RefCountDecrement (m_log->m_count) == 0)
+        {
+          DeallocateLog (m_log);
+        }
+      m_log = 0;
+    }
+  m_data = PacketMetadata::Create (10);
+  memset (m_data->m_data, 0xff, 4);
+}
+
+PacketMetadata
+PacketMetadata::Decode (void) const
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (m_data == 0);
+  PacketMetadata list (m_packetUid, 0);
+  list.CreateList ();
+  for (uint32_t i = 0; i < m_logUsed; i++)
+    {
+      const struct PacketMetadata::LogRecord *record = &m_log->m_records[i];
+      switch (record->type)
+        {
+        case LOG_ADD_HEADER:
+          list.DoAddHeader (record->typeUid, record->size, record->chunkUid);
+          break;
+        case LOG_REMOVE_HEADER:
+          list.DoRemoveHeader (record->typeUid, record->size);
+          break;
+        case LOG_ADD_TRAILER:
+          list.DoAddTrailer (record->typeUid, record->size, record->chunkUid);
+          break;
+        case LOG_REMOVE_TRAILER:
+          list.DoRemoveTrailer (record->typeUid, record->size);
+          break;
+        case LOG_ADD_AT_END:
+          list.AddAtEnd (*record->other);
+          break;
+        case LOG_REMOVE_AT_START:
+          list.RemoveAtStart (record->size);
+          break;
+        case LOG_REMOVE_AT_END:
+          list.RemoveAtEnd (record->size);
+          break;
+        default:
+          NS_ASSERT (false);
+          break;
+        }
+    }
+  // an AddAtEnd to the empty list replaced its uid
+  list.m_packetUid = m_packetUid;
+  return list;
+}
 
 PacketMetadata 
 PacketMetadata::CreateFragment (uint32_t start, uint32_t end) const
@@ -681,13 +810,28 @@ PacketMetadata::DoAddHeader (uint32_t uid, uint32_t size)
       return;
     }
 
+  uint16_t chunkUid = m_chunkUid;
+  m_chunkUid++;
+  if (m_data == 0)
+    {
+      struct PacketMetadata::LogRecord *record = LogAppend (LOG_ADD_HEADER);
+      record->chunkUid = chunkUid;
+      record->size = size;
+      record->typeUid = uid;
+      return;
+    }
+  DoAddHeader (uid, size, chunkUid);
+}
+void
+PacketMetadata::DoAddHeader (uint32_t uid, uint32_t size, uint16_t chunkUid)
+{
+  NS_LOG_FUNCTION (this << uid << size << chunkUid);
   struct PacketMetadata::SmallItem item;
   item.next = m_head;
   item.prev = 0xffff;
   item.typeUid = uid;
   item.size = size;
-  item.chunkUid = m_chunkUid;
-  m_chunkUid++;
+  item.chunkUid = chunkUid;
   uint16_t written = AddSmall (&item);
   UpdateHead (written);
 }
@@ -702,6 +846,18 @@ PacketMetadata::RemoveHeader (const Header &header, uint32_t size)
       m_metadataSkipped = true;
       return;
     }
+  DoRemoveHeader (uid, size);
+  NS_ASSERT (IsStateOk ());
+}
+void
+PacketMetadata::DoRemoveHeader (uint32_t uid, uint32_t size)
+{
+  NS_LOG_FUNCTION (this << uid << size);
+  if (m_data == 0)
+    {
+      LogRemove (LOG_ADD_HEADER, LOG_REMOVE_HEADER, uid, size);
+      return;
+    }
   struct PacketMetadata::SmallItem item;
   struct PacketMetadata::ExtraItem extraItem;
   uint32_t read = ReadItems (m_head, &item, &extraItem);
@@ -737,7 +893,6 @@ PacketMetadata::RemoveHeader (const Header &header, uint32_t size)
     {
       m_head = item.next;
     }
-  NS_ASSERT (IsStateOk ());
 }
 void 
 PacketMetadata::AddTrailer (const Trailer &trailer, uint32_t size)
@@ -745,21 +900,42 @@ PacketMetadata::AddTrailer (const Trailer &trailer, uint32_t size)
   uint32_t uid = trailer.GetInstanceTypeId ().GetUid () << 1;
   NS_LOG_FUNCTION (this << &trailer << size);
   NS_ASSERT (IsStateOk ());
+  DoAddTrailer (uid, size);
+  NS_ASSERT (IsStateOk ());
+}
+void
+PacketMetadata::DoAddTrailer (uint32_t uid, uint32_t size)
+{
+  NS_LOG_FUNCTION (this << uid << size);
   if (!m_enable)
     {
       m_metadataSkipped = true;
       return;
     }
+  uint16_t chunkUid = m_chunkUid;
+  m_chunkUid++;
+  if (m_data == 0)
+    {
+      struct PacketMetadata::LogRecord *record = LogAppend (LOG_ADD_TRAILER);
+      record->chunkUid = chunkUid;
+      record->size = size;
+      record->typeUid = uid;
+      return;
+    }
+  DoAddTrailer (uid, size, chunkUid);
+}
+void
+PacketMetadata::DoAddTrailer (uint32_t uid, uint32_t size, uint16_t chunkUid)
+{
+  NS_LOG_FUNCTION (this << uid << size << chunkUid);
   struct PacketMetadata::SmallItem item;
   item.next = 0xffff;
   item.prev = m_tail;
   item.typeUid = uid;
   item.size = size;
-  item.chunkUid = m_chunkUid;
-  m_chunkUid++;
+  item.chunkUid = chunkUid;
   uint16_t written = AddSmall (&item);
   UpdateTail (written);
-  NS_ASSERT (IsStateOk ());
 }
 void 
 PacketMetadata::RemoveTrailer (const Trailer &trailer, uint32_t size)
@@ -772,6 +948,18 @@ PacketMetadata::RemoveTrailer (const Trailer &trailer, uint32_t size)
       m_metadataSkipped = true;
       return;
     }
+  DoRemoveTrailer (uid, size);
+  NS_ASSERT (IsStateOk ());
+}
+void
+PacketMetadata::DoRemoveTrailer (uint32_t uid, uint32_t size)
+{
+  NS_LOG_FUNCTION (this << uid << size);
+  if (m_data == 0)
+    {
+      LogRemove (LOG_ADD_TRAILER, LOG_REMOVE_TRAILER, uid, size);
+      return;
+    }
   struct PacketMetadata::SmallItem item;
   struct PacketMetadata::ExtraItem extraItem;
   uint32_t read = ReadItems (m_tail, &item, &extraItem);
@@ -807,7 +995,6 @@ PacketMetadata::RemoveTrailer (const Trailer &trailer, uint32_t size)
     {
       m_tail = item.prev;
     }
-  NS_ASSERT (IsStateOk ());
 }
 void
 PacketMetadata::AddAtEnd (PacketMetadata const&o)
@@ -819,6 +1006,30 @@ PacketMetadata::AddAtEnd (PacketMetadata const&o)
       m_metadataSkipped = true;
       return;
     }
+  if (m_data == 0)
+    {
+      if (m_logUsed == 0)
+        {
+          // We have no records so 'AddAtEnd' is
+          // equivalent to self-assignment.
+          *this = o;
+          return;
+        }
+      if (o.m_data == 0 && o.m_logUsed == 0)
+        {
+          // we have nothing to append.
+          return;
+        }
+      struct PacketMetadata::LogRecord *record = LogAppend (LOG_ADD_AT_END);
+      record->other = new PacketMetadata (o);
+      return;
+    }
+  if (o.m_data == 0)
+    {
+      // the items of the other packet are still recorded in its log
+      AddAtEnd (o.Decode ());
+      return;
+    }
   if (m_tail == 0xffff)
     {
       // We have no items so 'AddAtEnd' is 
@@ -907,7 +1118,11 @@ PacketMetadata::RemoveAtStart (uint32_t start)
       m_metadataSkipped = true;
       return;
     }
-  NS_ASSERT (m_data != 0);
+  if (m_data == 0)
+    {
+      LogAppend (LOG_REMOVE_AT_START)->size = start;
+      return;
+    }
   uint32_t leftToRemove = start;
   uint16_t current = m_head;
   while (current != 0xffff && leftToRemove > 0)
@@ -934,6 +1149,7 @@ PacketMetadata::RemoveAtStart (uint32_t start)
         {
           // fragment the list item.
           PacketMetadata fragment (m_packetUid, 0);
+          fragment.CreateList ();
           extraItem.fragmentStart += leftToRemove;
           leftToRemove = 0;
           uint16_t written = fragment.AddBig (0xffff, fragment.m_tail,
@@ -970,7 +1186,11 @@ PacketMetadata::RemoveAtEnd (uint32_t end)
       m_metadataSkipped = true;
       return;
     }
-  NS_ASSERT (m_data != 0);
+  if (m_data == 0)
+    {
+      LogAppend (LOG_REMOVE_AT_END)->size = end;
+      return;
+    }
 
   uint32_t leftToRemove = end;
   uint16_t current = m_tail;
@@ -998,6 +1218,7 @@ PacketMetadata::RemoveAtEnd (uint32_t end)
         {
           // fragment the list item.
           PacketMetadata fragment (m_packetUid, 0);
+          fragment.CreateList ();
           NS_ASSERT (extraItem.fragmentEnd > leftToRemove);
           extraItem.fragmentEnd -= leftToRemove;
           leftToRemove = 0;
@@ -1058,6 +1279,10 @@ PacketMetadata::ItemIterator
 PacketMetadata::BeginItem (Buffer buffer) const
 {
   NS_LOG_FUNCTION (this << &buffer);
+  if (m_data == 0)
+    {
+      return ItemIterator (ns3::Create<DecodedList> (Decode ()), buffer);
+    }
   return ItemIterator (this, buffer);
 }
 PacketMetadata::ItemIterator::ItemIterator (const PacketMetadata *metadata, Buffer buffer)
@@ -1069,6 +1294,16 @@ PacketMetadata::ItemIterator::ItemIterator (const PacketMetadata *metadata, Buff
 {
   NS_LOG_FUNCTION (this << metadata << &buffer);
 }
+PacketMetadata::ItemIterator::ItemIterator (Ptr<const DecodedList> list, Buffer buffer)
+  : m_metadata (&list->list),
+    m_list (list),
+    m_buffer (buffer),
+    m_current (list->list.m_head),
+    m_offset (0),
+    m_hasReadTail (false)
+{
+  NS_LOG_FUNCTION (this << list << &buffer);
+}
 bool
 PacketMetadata::ItemIterator::HasNext (void) const
 {
@@ -1161,6 +1396,10 @@ PacketMetadata::GetSerializedSize (void) const
     {
       return totalSize;
     }
+  if (m_data == 0)
+    {
+      return Decode ().GetSerializedSize ();
+    }
 
   struct PacketMetadata::SmallItem item;
   struct PacketMetadata::ExtraItem extraItem;
@@ -1194,6 +1433,10 @@ uint32_t
 PacketMetadata::Serialize (uint8_t* buffer, uint32_t maxSize) const
 {
   NS_LOG_FUNCTION (this << &buffer << maxSize);
+  if (m_data == 0)
+    {
+      return Decode ().Serialize (buffer, maxSize);
+    }
   uint8_t* start = buffer;
 
   buffer = AddToRawU64 (m_packetUid, start, buffer, maxSize);
@@ -1295,6 +1538,11 @@ uint32_t
 PacketMetadata::Deserialize (const uint8_t* buffer, uint32_t size)
 {
   NS_LOG_FUNCTION (this << &buffer << size);
+  if (m_data == 0)
+    {
+      // the items are appended to our list
+      *this = Decode ();
+    }
   const uint8_t* start = buffer;
   uint32_t desSize = size - 4;
 
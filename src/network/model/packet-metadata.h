@@ -26,6 +26,8 @@
 #include "ns3/callback.h"
 #include "ns3/assert.h"
 #include "ns3/type-id.h"
+#include "ns3/simple-ref-count.h"
+#include "ns3/ptr.h"
 #include "buffer.h"
 
 namespace ns3 {
@@ -75,10 +77,24 @@ class Trailer;
  * integers, and some others as variable-size 32-bit integers.
  * The variable-size 32 bit integers are stored using the uleb128
  * encoding.
+ *
+ * Maintaining this list on every operation costs about as much as the
+ * operation itself, while most simulations only print a few packets.
+ * So, unless EnableChecking was called, the operations are first
+ * recorded in a log of fixed-size records, struct
+ * PacketMetadata::LogRecord, appended to a buffer shared by the copies
+ * of the packet the same way the list is. The list is only built by
+ * replaying the log, when the items are iterated with BeginItem or the
+ * metadata is serialized. Removing a header or trailer just added
+ * drops its record instead of appending another one, and adding
+ * another packet at the end records a reference to a copy of its
+ * metadata. With checking enabled the list is maintained on every
+ * operation, which checks each removed header and trailer against it.
  */
 class PacketMetadata 
 {
 public:
+  struct DecodedList;
   struct Item 
   {
     enum {
@@ -115,10 +131,17 @@ public:
   {
 public:
     ItemIterator (const PacketMetadata *metadata, Buffer buffer);
+    /**
+     * \param list the items decoded from the log of a packet
+     * \param buffer the buffer of the packet
+     */
+    ItemIterator (Ptr<const DecodedList> list, Buffer buffer);
     bool HasNext (void) const;
     Item Next (void);
 private:
     const PacketMetadata *m_metadata;
+    // keeps the decoded items alive, if m_metadata points to them
+    Ptr<const DecodedList> m_list;
     Buffer m_buffer;
     uint16_t m_current;
     uint32_t m_offset;
@@ -292,13 +315,45 @@ private:
     uint64_t packetUid;
   };
 
-  class DataFreeList : public std::vector<struct Data *>
-  {
-public:
-    ~DataFreeList ();
+  /* The operations recorded in the log. */
+  enum LogType {
+    LOG_ADD_HEADER,
+    LOG_REMOVE_HEADER,
+    LOG_ADD_TRAILER,
+    LOG_REMOVE_TRAILER,
+    LOG_ADD_AT_END,
+    LOG_REMOVE_AT_START,
+    LOG_REMOVE_AT_END
+  };
+  struct LogRecord {
+    /* a LogType */
+    uint16_t type;
+    /* the chunkUid of the header or trailer added */
+    uint16_t chunkUid;
+    /* the size of the header or trailer added or removed, or the
+       number of bytes removed at the start or at the end */
+    uint32_t size;
+    union {
+      /* the typeUid of the header or trailer added or removed:
+         zero for payload */
+      uint32_t typeUid;
+      /* the metadata of the packet added at the end, owned by the
+         log */
+      PacketMetadata *other;
+    };
+  };
+  struct Log {
+    /* number of references to this struct Log instance. */
+    uint32_t m_count;
+    /* number of records which fit in m_records */
+    uint32_t m_size;
+    /* max of the m_logUsed field over all objects which
+       reference this struct Log instance */
+    uint32_t m_dirtyEnd;
+    /* variable-sized array of records */
+    struct LogRecord m_records[1];
   };
 
-  friend DataFreeList::~DataFreeList ();
   friend class ItemIterator;
 
   PacketMetadata ();
@@ -325,17 +380,54 @@ public:
                       struct PacketMetadata::SmallItem *item,
                       struct PacketMetadata::ExtraItem *extraItem) const;
   void DoAddHeader (uint32_t uid, uint32_t size);
+  void DoAddHeader (uint32_t uid, uint32_t size, uint16_t chunkUid);
+  void DoRemoveHeader (uint32_t uid, uint32_t size);
+  void DoAddTrailer (uint32_t uid, uint32_t size);
+  void DoAddTrailer (uint32_t uid, uint32_t size, uint16_t chunkUid);
+  void DoRemoveTrailer (uint32_t uid, uint32_t size);
   bool IsStateOk (void) const;
   bool IsPointerOk (uint16_t pointer) const;
   bool IsSharedPointerOk (uint16_t pointer) const;
 
+  /**
+   * Builds the linked list of items, if the operations are still to be
+   * recorded in the log: only valid while nothing has been recorded.
+   */
+  void CreateList (void);
+  /**
+   * \returns the metadata of this packet with the operations recorded
+   *          in the log replayed into a linked list of items
+   */
+  PacketMetadata Decode (void) const;
+  /**
+   * \param type the LogType of the record
+   * \returns the record appended to the log, to be filled
+   */
+  struct PacketMetadata::LogRecord *LogAppend (uint16_t type);
+  /**
+   * Records the removal of a header or a trailer
+   *
+   * \param addType the LogType of the record which added it
+   * \param removeType the LogType of the record of its removal
+   * \param uid the typeUid of the header or trailer
+   * \param size its size
+   */
+  void LogRemove (uint16_t addType, uint16_t removeType,
+                  uint32_t uid, uint32_t size);
+  static struct PacketMetadata::Log *AllocateLog (uint32_t n);
+  static void DeallocateLog (struct PacketMetadata::Log *log);
+  /**
+   * Frees the records of a log past the given end, which are no longer
+   * referenced
+   */
+  static void ReleaseRecords (struct PacketMetadata::Log *log, uint32_t end);
+
 
   static struct PacketMetadata::Data *Create (uint32_t size);
   static void Recycle (struct PacketMetadata::Data *data);
   static struct PacketMetadata::Data *Allocate (uint32_t n);
   static void Deallocate (struct PacketMetadata::Data *data);
 
-  static DataFreeList m_freeList;
   static bool m_enable;
   static bool m_enableChecking;
 
@@ -356,21 +448,44 @@ public:
   uint16_t m_head;
   uint16_t m_tail;
   uint16_t m_used;
+  /* the log of the operations, zero once the list is used instead */
+  struct Log *m_log;
+  /* the number of records of m_log describing this packet */
+  uint32_t m_logUsed;
   uint64_t m_packetUid;
 };
 
+/**
+ * \internal
+ * The items decoded from the log of a packet, kept alive by the
+ * iterators over them
+ */
+struct PacketMetadata::DecodedList : public SimpleRefCount<PacketMetadata::DecodedList>
+{
+  DecodedList (PacketMetadata const &o)
+    : list (o)
+  {
+  }
+  PacketMetadata list;
+};
+
 } // namespace ns3
 
 namespace ns3 {
 
 PacketMetadata::PacketMetadata (uint64_t uid, uint32_t size)
-  : m_data (PacketMetadata::Create (10)),
+  : m_data (0),
     m_head (0xffff),
     m_tail (0xffff),
     m_used (0),
+    m_log (0),
+    m_logUsed (0),
     m_packetUid (uid)
 {
-  memset (m_data->m_data, 0xff, 4);
+  if (m_enableChecking)
+    {
+      CreateList ();
+    }
   if (size > 0)
     {
       DoAddHeader (0, size);
@@ -381,11 +496,19 @@ PacketMetadata::PacketMetadata (PacketMetadata const &o)
     m_head (o.m_head),
     m_tail (o.m_tail),
     m_used (o.m_used),
+    m_log (o.m_log),
+    m_logUsed (o.m_logUsed),
     m_packetUid (o.m_packetUid)
 {
-  NS_ASSERT (m_data != 0);
-  NS_ASSERT (m_data->m_count < std::numeric_limits<uint32_t>::max());
-  m_data->m_count++;
+  if (m_data != 0)
+    {
+      NS_ASSERT (m_data->m_count < std::numeric_limits<uint32_t>::max());
+      RefCountIncrement (m_data->m_count);
+    }
+  if (m_log != 0)
+    {
+      RefCountIncrement (m_log->m_count);
+    }
 }
 PacketMetadata &
 PacketMetadata::operator = (PacketMetadata const& o)
@@ -393,30 +516,45 @@ PacketMetadata::operator = (PacketMetadata const& o)
   if (m_data != o.m_data) 
     {
       // not self assignment
-      NS_ASSERT (m_data != 0);
-      m_data->m_count--;
-      if (m_data->m_count == 0) 
+      if (m_data != 0 && RefCountDecrement (m_data->m_count) == 0) 
         {
           PacketMetadata::Recycle (m_data);
         }
       m_data = o.m_data;
-      NS_ASSERT (m_data != 0);
-      m_data->m_count++;
+      if (m_data != 0)
+        {
+          RefCountIncrement (m_data->m_count);
+        }
+    }
+  if (m_log != o.m_log)
+    {
+      if (m_log != 0 && RefCountDecrement (m_log->m_count) == 0)
+        {
+          PacketMetadata::DeallocateLog (m_log);
+        }
+      m_log = o.m_log;
+      if (m_log != 0)
+        {
+          RefCountIncrement (m_log->m_count);
+        }
     }
   m_head = o.m_head;
   m_tail = o.m_tail;
   m_used = o.m_used;
+  m_logUsed = o.m_logUsed;
   m_packetUid = o.m_packetUid;
   return *this;
 }
 PacketMetadata::~PacketMetadata ()
 {
-  NS_ASSERT (m_data != 0);
-  m_data->m_count--;
-  if (m_data->m_count == 0) 
+  if (m_data != 0 && RefCountDecrement (m_data->m_count) == 0) 
     {
       PacketMetadata::Recycle (m_data);
     }
+  if (m_log != 0 && RefCountDecrement (m_log->m_count) == 0)
+    {
+      PacketMetadata::DeallocateLog (m_log);
+    }
 }
 
 } // namespace ns3
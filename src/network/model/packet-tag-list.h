@@ -28,6 +28,7 @@
 #include <stdint.h>
 #include <ostream>
 #include "ns3/type-id.h"
+#include "ns3/simple-ref-count.h"
 
 namespace ns3 {
 
@@ -165,6 +166,19 @@ public:
     struct TagData * next;   /**< Pointer to next in list */
     TypeId tid;               /**< Type of the tag serialized into #data */
     uint32_t count;           /**< Number of incoming links */
+
+    /**
+     * Allocates the node from the slabs of the packets
+     *
+     * \param size the size of a TagData
+     * \returns the storage of the node
+     */
+    static void *operator new (size_t size);
+    /**
+     * \param p the storage of the node
+     * \param size the size of a TagData
+     */
+    static void operator delete (void *p, size_t size);
   };  /* struct TagData */
 
   /**
@@ -310,7 +324,7 @@ PacketTagList::PacketTagList (PacketTagList const &o)
 {
   if (m_next != 0)
     {
-      m_next->count++;
+      RefCountIncrement (m_next->count);
     }
 }
 
@@ -326,7 +340,7 @@ PacketTagList::operator = (PacketTagList const &o)
   m_next = o.m_next;
   if (m_next != 0) 
     {
-      m_next->count++;
+      RefCountIncrement (m_next->count);
     }
   return *this;
 }
@@ -342,8 +356,7 @@ PacketTagList::RemoveAll (void)
   struct TagData *prev = 0;
   for (struct TagData *cur = m_next; cur != 0; cur = cur->next)
     {
-      cur->count--;
-      if (cur->count > 0) 
+      if (RefCountDecrement (cur->count) > 0) 
         {
           break;
         }
@@ -28,7 +28,11 @@ NS_LOG_COMPONENT_DEFINE ("Packet");
 
 namespace ns3 {
 
+#ifdef NS3_MTP
+__thread uint32_t Packet::m_globalUid = 0;
+#else
 uint32_t Packet::m_globalUid = 0;
+#endif
 
 TypeId 
 ByteTagIterator::Item::GetTypeId (void) const
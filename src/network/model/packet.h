@@ -168,10 +168,12 @@ private:
  * were serialized in the byte buffer. The maintenance of metadata is
  * optional and disabled by default. To enable it, you must call
  * Packet::EnablePrinting and this will allow you to get non-empty
- * output from Packet::Print. If you wish to only enable
- * checking of metadata, and do not need any printing capability, you can
- * call Packet::EnableChecking: its runtime cost is lower than
- * Packet::EnablePrinting.
+ * output from Packet::Print. The operations on the packets are then only
+ * recorded, and replayed when a packet is printed, so that tracing
+ * costs little more than the packets themselves. If you wish to also
+ * check the metadata, you can call Packet::EnableChecking: the metadata
+ * is then maintained on every operation, at about twice the cost of
+ * the packets without metadata.
  *
  * - The set of tags contain simulation-specific information which cannot
  * be stored in the packet byte buffer because the protocol headers or trailers
@@ -592,7 +594,12 @@ private:
   /* Please see comments above about nix-vector */
   Ptr<NixVector> m_nixVector;
 
+#ifdef NS3_MTP
+  // the upper bits of the uid are the partition of the thread
+  static __thread uint32_t m_globalUid;
+#else
   static uint32_t m_globalUid;
+#endif
 };
 
 std::ostream& operator<< (std::ostream& os, const Packet &packet);
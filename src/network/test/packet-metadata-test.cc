@@ -780,6 +780,32 @@ PacketMetadataTest::DoRun (void)
   p2 = p->CreateFragment (6,535-6);
   p1->AddAtEnd (p2);
 
+  // copies which share their records diverge
+  p = Create<Packet> (10);
+  ADD_HEADER (p, 1);
+  ADD_HEADER (p, 2);
+  p1 = p->Copy ();
+  REM_HEADER (p, 2);
+  ADD_HEADER (p, 3);
+  ADD_HEADER (p1, 4);
+  CHECK_HISTORY (p, 3, 3, 1, 10);
+  CHECK_HISTORY (p1, 4, 4, 2, 1, 10);
+  p2 = p1->Copy ();
+  REM_HEADER (p1, 4);
+  REM_HEADER (p1, 2);
+  ADD_TRAILER (p1, 5);
+  CHECK_HISTORY (p1, 3, 1, 10, 5);
+  CHECK_HISTORY (p2, 4, 4, 2, 1, 10);
+
+  // the packet added at the end is not changed by its later operations
+  p->AddAtEnd (p1);
+  REM_TRAILER (p1, 5);
+  ADD_HEADER (p1, 6);
+  CHECK_HISTORY (p, 6, 3, 1, 10, 1, 10, 5);
+  CHECK_HISTORY (p1, 3, 6, 1, 10);
+  p->RemoveAtEnd (15);
+  CHECK_HISTORY (p, 4, 3, 1, 10, 1);
+
   /// \internal
   /// See \bugid{1072}
   p = Create<Packet> (reinterpret_cast<const uint8_t*> ("hello world"), 11);
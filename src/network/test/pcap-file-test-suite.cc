@@ -21,9 +21,17 @@
 #include <cstdlib>
 #include <sstream>
 #include <cstring>
+#include <vector>
+#include <unistd.h>
+#include <fcntl.h>
+#include <csignal>
+#include <sys/resource.h>
+#include <sys/wait.h>
 
 #include "ns3/log.h"
 #include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/simulator-fork.h"
 #include "ns3/pcap-file.h"
 
 using namespace ns3;
@@ -1120,6 +1128,348 @@ DiffTestCase::DoRun (void)
   NS_TEST_EXPECT_MSG_EQ (usec, 3696, "Files are different from 2.3696 seconds");
 }
 
+// ===========================================================================
+// Test case to make sure that the records buffered by the Pcap File Object
+// all reach the file, in the order they were written.
+// ===========================================================================
+class ManyRecordsTestCase : public TestCase
+{
+public:
+  ManyRecordsTestCase ();
+  virtual ~ManyRecordsTestCase ();
+
+private:
+  virtual void DoSetup (void);
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+
+  std::string m_testFilename;
+};
+
+ManyRecordsTestCase::ManyRecordsTestCase ()
+  : TestCase ("Check to see that PcapFile writes out many buffered records in order")
+{
+}
+
+ManyRecordsTestCase::~ManyRecordsTestCase ()
+{
+}
+
+void
+ManyRecordsTestCase::DoSetup (void)
+{
+  std::stringstream filename;
+  uint32_t n = rand ();
+  filename << n;
+  m_testFilename = CreateTempDirFilename (filename.str () + ".pcap");
+}
+
+void
+ManyRecordsTestCase::DoTeardown (void)
+{
+  if (remove (m_testFilename.c_str ()))
+    {
+      NS_LOG_ERROR ("Failed to delete file " << m_testFilename);
+    }
+}
+
+void
+ManyRecordsTestCase::DoRun (void)
+{
+  PcapFile f;
+
+  //
+  // Write enough records, of varying sizes, to fill many chunks of the
+  // writer, some larger than a chunk.
+  //
+  const uint32_t N_RECORDS = 5000;
+  uint8_t buffer[70000];
+  f.Open (m_testFilename, std::ios::out);
+  NS_TEST_ASSERT_MSG_EQ (f.Fail (), false, "Open (" << m_testFilename << ", \"std::ios::out\") returns error");
+  f.Init (1, sizeof (buffer));
+  NS_TEST_ASSERT_MSG_EQ (f.Fail (), false, "Init (1, " << sizeof (buffer) << ") returns error");
+
+  for (uint32_t i = 0; i < N_RECORDS; ++i)
+    {
+      uint32_t len = (i % 1000 == 999) ? sizeof (buffer) : (i * 7) % 1500;
+      memset (buffer, i & 0xff, len);
+      f.Write (i, 0, buffer, len);
+    }
+  NS_TEST_ASSERT_MSG_EQ (f.Fail (), false, "Write() of many records returns error");
+  f.Close ();
+
+  f.Open (m_testFilename, std::ios::in);
+  NS_TEST_ASSERT_MSG_EQ (f.Fail (), false, "Open (" << m_testFilename << ", \"std::ios::in\") returns error");
+
+  uint32_t tsSec, tsUsec, inclLen, origLen, readLen;
+  for (uint32_t i = 0; i < N_RECORDS; ++i)
+    {
+      uint32_t len = (i % 1000 == 999) ? sizeof (buffer) : (i * 7) % 1500;
+      f.Read (buffer, sizeof (buffer), tsSec, tsUsec, inclLen, origLen, readLen);
+      NS_TEST_ASSERT_MSG_EQ (f.Fail (), false, "Read() of record " << i << " returns error");
+      NS_TEST_ASSERT_MSG_EQ (tsSec, i, "Record " << i << " read out of order");
+      NS_TEST_ASSERT_MSG_EQ (inclLen, len, "Incorrect included length of record " << i);
+      NS_TEST_ASSERT_MSG_EQ (readLen, len, "Incorrect read length of record " << i);
+      if (len != 0)
+        {
+          NS_TEST_ASSERT_MSG_EQ ((uint32_t)buffer[len - 1], (i & 0xff), "Incorrect data in record " << i);
+        }
+    }
+
+  f.Read (buffer, 1, tsSec, tsUsec, inclLen, origLen, readLen);
+  NS_TEST_ASSERT_MSG_EQ (f.Eof (), true, "Read() past the last record does not return error");
+
+  f.Close ();
+}
+
+// ===========================================================================
+// Test case to make sure that the records written before a fork() reach the
+// file of the parent only, and that the records written by the branches
+// reach their own files.
+// ===========================================================================
+class ForkTestCase : public TestCase
+{
+public:
+  ForkTestCase ();
+  virtual ~ForkTestCase ();
+
+private:
+  virtual void DoSetup (void);
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+  void WriteRecord (uint32_t i);
+  void StartBranch (void);
+  std::string GetFilename (uint32_t branch);
+  bool CheckRecords (std::string filename, uint32_t first, uint32_t n);
+
+  std::string m_testFilename;
+  SimulatorFork *m_fork;
+  PcapFile m_file;
+  PcapFile m_branchFile;
+  PcapFile *m_current;
+};
+
+ForkTestCase::ForkTestCase ()
+  : TestCase ("Check to see that PcapFile writes out the records of the branches of a SimulatorFork")
+{
+}
+
+ForkTestCase::~ForkTestCase ()
+{
+}
+
+void
+ForkTestCase::DoSetup (void)
+{
+  std::stringstream filename;
+  uint32_t n = rand ();
+  filename << n;
+  m_testFilename = CreateTempDirFilename (filename.str ());
+}
+
+void
+ForkTestCase::DoTeardown (void)
+{
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      if (remove (GetFilename (i).c_str ()))
+        {
+          NS_LOG_ERROR ("Failed to delete file " << GetFilename (i));
+        }
+    }
+}
+
+std::string
+ForkTestCase::GetFilename (uint32_t branch)
+{
+  std::stringstream filename;
+  filename << m_testFilename << "-" << branch << ".pcap";
+  return filename.str ();
+}
+
+void
+ForkTestCase::WriteRecord (uint32_t i)
+{
+  // large enough for the chunks to go to the writer thread
+  uint8_t buffer[3000];
+  memset (buffer, i & 0xff, sizeof (buffer));
+  m_current->Write (i, 0, buffer, sizeof (buffer));
+}
+
+void
+ForkTestCase::StartBranch (void)
+{
+  if (!m_fork->IsBranch ())
+    {
+      return;
+    }
+  // a branch stuck waiting for its records fails instead of hanging
+  alarm (10);
+  m_branchFile.Open (GetFilename (m_fork->GetBranch () + 1), std::ios::out);
+  m_branchFile.Init (1, 3000);
+  m_current = &m_branchFile;
+}
+
+bool
+ForkTestCase::CheckRecords (std::string filename, uint32_t first, uint32_t n)
+{
+  PcapFile f;
+  f.Open (filename, std::ios::in);
+  if (f.Fail ())
+    {
+      return false;
+    }
+  uint8_t buffer[3000];
+  uint32_t tsSec, tsUsec, inclLen, origLen, readLen;
+  for (uint32_t i = first; i < first + n; ++i)
+    {
+      f.Read (buffer, sizeof (buffer), tsSec, tsUsec, inclLen, origLen, readLen);
+      if (f.Fail () || tsSec != i || readLen != sizeof (buffer) || buffer[readLen - 1] != (i & 0xff))
+        {
+          return false;
+        }
+    }
+  f.Read (buffer, 1, tsSec, tsUsec, inclLen, origLen, readLen);
+  return f.Eof ();
+}
+
+void
+ForkTestCase::DoRun (void)
+{
+  m_file.Open (GetFilename (0), std::ios::out);
+  NS_TEST_ASSERT_MSG_EQ (m_file.Fail (), false, "Open (" << GetFilename (0) << ", \"std::ios::out\") returns error");
+  m_file.Init (1, 3000);
+  m_current = &m_file;
+  for (uint32_t i = 0; i < 20; i++)
+    {
+      Simulator::Schedule (Seconds (i), &ForkTestCase::WriteRecord, this, i);
+    }
+  Simulator::Schedule (Seconds (9.75), &ForkTestCase::StartBranch, this);
+
+  SimulatorFork fork;
+  m_fork = &fork;
+  fork.AddBranch (1);
+  fork.AddBranch (2);
+  fork.ForkAt (Seconds (9.5));
+  Simulator::Run ();
+
+  if (fork.IsBranch ())
+    {
+      m_branchFile.Close ();
+      // leave the rest of the test suite to the parent
+      _exit (m_branchFile.Fail () ? 1 : 0);
+    }
+
+  m_file.Close ();
+  Simulator::Destroy ();
+  for (uint32_t i = 0; i < fork.GetNBranches (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (WIFEXITED (fork.GetStatus (i)) && WEXITSTATUS (fork.GetStatus (i)) == 0,
+                             true, "branch " << i << " failed");
+      NS_TEST_EXPECT_MSG_EQ (CheckRecords (GetFilename (i + 1), 10, 10), true,
+                             "Incorrect records written by branch " << i);
+    }
+  NS_TEST_EXPECT_MSG_EQ (CheckRecords (GetFilename (0), 0, 10), true,
+                         "Incorrect records written before the fork");
+}
+
+// ===========================================================================
+// Test case to make sure that the records still buffered or queued for the
+// writer thread reach the file when the process dies of a fatal error.
+// ===========================================================================
+class FatalErrorTestCase : public TestCase
+{
+public:
+  FatalErrorTestCase ();
+  virtual ~FatalErrorTestCase ();
+
+private:
+  virtual void DoSetup (void);
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+
+  std::string m_testFilename;
+};
+
+FatalErrorTestCase::FatalErrorTestCase ()
+  : TestCase ("Check to see that PcapFile writes out the records pending on a fatal error")
+{
+}
+
+FatalErrorTestCase::~FatalErrorTestCase ()
+{
+}
+
+void
+FatalErrorTestCase::DoSetup (void)
+{
+  std::stringstream filename;
+  uint32_t n = rand ();
+  filename << n;
+  m_testFilename = CreateTempDirFilename (filename.str () + ".pcap");
+}
+
+void
+FatalErrorTestCase::DoTeardown (void)
+{
+  if (remove (m_testFilename.c_str ()))
+    {
+      NS_LOG_ERROR ("Failed to delete file " << m_testFilename);
+    }
+}
+
+void
+FatalErrorTestCase::DoRun (void)
+{
+  const uint32_t N_RECORDS = 30;
+  uint8_t buffer[3000];
+
+  pid_t pid = fork ();
+  if (pid == 0)
+    {
+      // the error is expected, neither its message nor a core file are
+      int null = open ("/dev/null", O_WRONLY);
+      dup2 (null, 2);
+      struct rlimit core = { 0, 0 };
+      setrlimit (RLIMIT_CORE, &core);
+      alarm (10);
+
+      PcapFile f;
+      f.Open (m_testFilename, std::ios::out);
+      f.Init (1, sizeof (buffer));
+      for (uint32_t i = 0; i < N_RECORDS; i++)
+        {
+          memset (buffer, i & 0xff, sizeof (buffer));
+          f.Write (i, 0, buffer, sizeof (buffer));
+        }
+      NS_FATAL_ERROR ("fatal error with records pending");
+    }
+
+  int status = 0;
+  waitpid (pid, &status, 0);
+  NS_TEST_EXPECT_MSG_EQ ((WIFSIGNALED (status) && WTERMSIG (status) == SIGABRT), true,
+                         "the process did not die of the fatal error");
+
+  PcapFile f;
+  f.Open (m_testFilename, std::ios::in);
+  NS_TEST_EXPECT_MSG_EQ (f.Fail (), false, "Open (" << m_testFilename << ", \"std::ios::in\") returns error");
+  uint32_t tsSec, tsUsec, inclLen, origLen, readLen;
+  uint32_t i;
+  for (i = 0; i < N_RECORDS; i++)
+    {
+      f.Read (buffer, sizeof (buffer), tsSec, tsUsec, inclLen, origLen, readLen);
+      if (f.Fail ())
+        {
+          break;
+        }
+      NS_TEST_EXPECT_MSG_EQ (tsSec, i, "wrong record " << i);
+      NS_TEST_EXPECT_MSG_EQ (readLen, sizeof (buffer), "record " << i << " truncated");
+      NS_TEST_EXPECT_MSG_EQ ((uint32_t) buffer[sizeof (buffer) - 1], (i & 0xff), "wrong data in record " << i);
+    }
+  NS_TEST_EXPECT_MSG_EQ (i, N_RECORDS, "records lost");
+  f.Close ();
+}
+
 class PcapFileTestSuite : public TestSuite
 {
 public:
@@ -1137,6 +1487,9 @@ PcapFileTestSuite::PcapFileTestSuite ()
   AddTestCase (new RecordHeaderTestCase, TestCase::QUICK);
   AddTestCase (new ReadFileTestCase, TestCase::QUICK);
   AddTestCase (new DiffTestCase, TestCase::QUICK);
+  AddTestCase (new ManyRecordsTestCase, TestCase::QUICK);
+  AddTestCase (new ForkTestCase, TestCase::QUICK);
+  AddTestCase (new FatalErrorTestCase, TestCase::QUICK);
 }
 
 static PcapFileTestSuite pcapFileTestSuite;
@@ -0,0 +1,285 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+#include "ns3/log.h"
+#include "ns3/test.h"
+#include "ns3/packet.h"
+#include "ns3/pcap-file.h"
+#include "ns3/pcapng-file.h"
+#include "ns3/pcap-reader.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("pcap-reader-test-suite");
+
+// ===========================================================================
+// Test case to make sure that the Pcap Reader reads a known good pcap file
+// as the Pcap File Object does.
+// ===========================================================================
+class KnownFileTestCase : public TestCase
+{
+public:
+  KnownFileTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+KnownFileTestCase::KnownFileTestCase ()
+  : TestCase ("Check to see that PcapReader reads a known good pcap file as PcapFile does")
+{
+}
+
+void
+KnownFileTestCase::DoRun (void)
+{
+  std::string filename = CreateDataDirFilename ("known.pcap");
+  PcapFile f;
+  f.Open (filename, std::ios::in);
+  NS_TEST_ASSERT_MSG_EQ (f.Fail (), false, "Open (" << filename << ", \"std::ios::in\") returns error");
+  Ptr<PcapReader> r = Create<PcapReader> ();
+  r->Open (filename);
+  NS_TEST_ASSERT_MSG_EQ (r->Fail (), false, "Open (" << filename << ") returns error");
+  NS_TEST_ASSERT_MSG_EQ (r->IsPcapNg (), false, "A pcap file read as a pcapng file");
+  NS_TEST_ASSERT_MSG_EQ (r->GetNInterfaces (), 1, "A pcap file has one interface");
+  NS_TEST_ASSERT_MSG_EQ (r->GetDataLinkType (0), f.GetDataLinkType (), "Incorrect data link type");
+  NS_TEST_ASSERT_MSG_EQ (r->GetSnapLen (0), f.GetSnapLen (), "Incorrect snap length");
+
+  uint8_t data[2000];
+  uint32_t tsSec, tsUsec, inclLen, origLen, readLen;
+  struct PcapReader::Record record;
+  uint32_t n = 0;
+  while (r->Next (record))
+    {
+      f.Read (data, sizeof (data), tsSec, tsUsec, inclLen, origLen, readLen);
+      NS_TEST_ASSERT_MSG_EQ (f.Fail (), false, "More records read than PcapFile reads");
+      NS_TEST_ASSERT_MSG_EQ (record.ns, tsSec * 1000000000ULL + tsUsec * 1000ULL, "Incorrect timestamp of record " << n);
+      NS_TEST_ASSERT_MSG_EQ (record.interface, 0, "Incorrect interface of record " << n);
+      NS_TEST_ASSERT_MSG_EQ (record.inclLen, inclLen, "Incorrect included length of record " << n);
+      NS_TEST_ASSERT_MSG_EQ (record.origLen, origLen, "Incorrect original length of record " << n);
+      NS_TEST_ASSERT_MSG_EQ (memcmp (record.data, data, readLen), 0, "Incorrect data of record " << n);
+      n++;
+    }
+  NS_TEST_ASSERT_MSG_EQ (r->Fail (), false, "Reading known good pcap file returns error");
+  NS_TEST_ASSERT_MSG_EQ (n, 6, "Incorrect number of records");
+
+  r->Seek (2 * 1000000000ULL + 3811 * 1000ULL);
+  NS_TEST_ASSERT_MSG_EQ (r->Next (record), true, "No record after seek");
+  NS_TEST_ASSERT_MSG_EQ (record.ns, 2 * 1000000000ULL + 3811 * 1000ULL, "Seek to the timestamp of a record does not read it");
+
+  r->Close ();
+  f.Close ();
+}
+
+// ===========================================================================
+// Test case to make sure that the Pcap Reader reads a pcap file in the
+// other byte order, with nanosecond timestamps.
+// ===========================================================================
+class ForeignByteOrderTestCase : public TestCase
+{
+public:
+  ForeignByteOrderTestCase ();
+
+private:
+  virtual void DoSetup (void);
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+
+  std::string m_testFilename;
+};
+
+ForeignByteOrderTestCase::ForeignByteOrderTestCase ()
+  : TestCase ("Check to see that PcapReader reads a foreign byte order pcap file")
+{
+}
+
+void
+ForeignByteOrderTestCase::DoSetup (void)
+{
+  std::stringstream filename;
+  uint32_t n = rand ();
+  filename << n;
+  m_testFilename = CreateTempDirFilename (filename.str () + ".pcap");
+}
+
+void
+ForeignByteOrderTestCase::DoTeardown (void)
+{
+  if (remove (m_testFilename.c_str ()))
+    {
+      NS_LOG_ERROR ("Failed to delete file " << m_testFilename);
+    }
+}
+
+void
+ForeignByteOrderTestCase::DoRun (void)
+{
+  //
+  // A big endian file header with the nanosecond magic of libpcap and the
+  // Ethernet data link type, and one record of 3 bytes at 7.000000005 s.
+  //
+  const uint8_t bytes[] = {
+    0xa1, 0xb2, 0x3c, 0x4d, 0x00, 0x02, 0x00, 0x04,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0xff, 0xff, 0x00, 0x00, 0x00, 0x01,
+    0x00, 0x00, 0x00, 0x07, 0x00, 0x00, 0x00, 0x05,
+    0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00, 0x40,
+    0x0a, 0x0b, 0x0c
+  };
+  FILE *p = std::fopen (m_testFilename.c_str (), "wb");
+  NS_TEST_ASSERT_MSG_NE (p, 0, "Unable to create " << m_testFilename);
+  std::fwrite (bytes, sizeof (bytes), 1, p);
+  std::fclose (p);
+
+  Ptr<PcapReader> r = Create<PcapReader> ();
+  r->Open (m_testFilename);
+  NS_TEST_ASSERT_MSG_EQ (r->Fail (), false, "Open (" << m_testFilename << ") returns error");
+  NS_TEST_ASSERT_MSG_EQ (r->GetDataLinkType (0), 1, "Incorrect data link type");
+  NS_TEST_ASSERT_MSG_EQ (r->GetSnapLen (0), 65535, "Incorrect snap length");
+
+  struct PcapReader::Record record;
+  NS_TEST_ASSERT_MSG_EQ (r->Next (record), true, "The record is not read");
+  NS_TEST_ASSERT_MSG_EQ (record.ns, 7000000005ULL, "Incorrect timestamp");
+  NS_TEST_ASSERT_MSG_EQ (record.inclLen, 3, "Incorrect included length");
+  NS_TEST_ASSERT_MSG_EQ (record.origLen, 64, "Incorrect original length");
+  NS_TEST_ASSERT_MSG_EQ ((uint32_t)record.data[2], 0x0c, "Incorrect data");
+  NS_TEST_ASSERT_MSG_EQ (r->Next (record), false, "A record past the end is read");
+  NS_TEST_ASSERT_MSG_EQ (r->Fail (), false, "The end of the file is an error");
+}
+
+// ===========================================================================
+// Test case to make sure that the Pcap Reader seeks through a large pcapng
+// file by timestamp.
+// ===========================================================================
+class SeekTestCase : public TestCase
+{
+public:
+  SeekTestCase ();
+
+private:
+  virtual void DoSetup (void);
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+
+  std::string m_testFilename;
+};
+
+SeekTestCase::SeekTestCase ()
+  : TestCase ("Check to see that PcapReader seeks through a pcapng file by timestamp")
+{
+}
+
+void
+SeekTestCase::DoSetup (void)
+{
+  std::stringstream filename;
+  uint32_t n = rand ();
+  filename << n;
+  m_testFilename = CreateTempDirFilename (filename.str () + ".pcapng");
+}
+
+void
+SeekTestCase::DoTeardown (void)
+{
+  if (remove (m_testFilename.c_str ()))
+    {
+      NS_LOG_ERROR ("Failed to delete file " << m_testFilename);
+    }
+}
+
+void
+SeekTestCase::DoRun (void)
+{
+  //
+  // Many more records than indexed, the second interface described in the
+  // middle of the file.
+  //
+  const uint32_t N_RECORDS = 10000;
+  Ptr<PcapNgFile> f = Create<PcapNgFile> ();
+  f->Open (m_testFilename);
+  f->AddInterface ("a", 1, 65535);
+  for (uint32_t i = 0; i < N_RECORDS; ++i)
+    {
+      if (i == N_RECORDS / 2)
+        {
+          f->AddInterface ("b", 101, 20);
+        }
+      uint8_t data[40];
+      memset (data, i & 0xff, sizeof (data));
+      f->Write (i < N_RECORDS / 2 ? 0 : i % 2, 1000ULL * i, data, 10 + i % 30);
+    }
+  f->Close ();
+
+  Ptr<PcapReader> r = Create<PcapReader> ();
+  r->Open (m_testFilename);
+  NS_TEST_ASSERT_MSG_EQ (r->Fail (), false, "Open (" << m_testFilename << ") returns error");
+  NS_TEST_ASSERT_MSG_EQ (r->IsPcapNg (), true, "A pcapng file read as a pcap file");
+
+  //
+  // Seeking before reading on indexes the records on the way.
+  //
+  struct PcapReader::Record record;
+  r->Seek (1000ULL * 7000 - 1);
+  NS_TEST_ASSERT_MSG_EQ (r->Next (record), true, "No record after seek");
+  NS_TEST_ASSERT_MSG_EQ (record.ns, 1000ULL * 7000, "Seek forward reads the wrong record");
+  NS_TEST_ASSERT_MSG_EQ (r->GetNInterfaces (), 2, "The interface in the middle of the file is not read");
+  NS_TEST_ASSERT_MSG_EQ (r->GetDataLinkType (1), 101, "Incorrect data link type of the second interface");
+
+  r->Seek (1000ULL * 1234);
+  NS_TEST_ASSERT_MSG_EQ (r->Next (record), true, "No record after seek");
+  NS_TEST_ASSERT_MSG_EQ (record.ns, 1000ULL * 1234, "Seek backward reads the wrong record");
+  NS_TEST_ASSERT_MSG_EQ ((uint32_t)record.data[0], (1234 & 0xff), "Incorrect data after seek");
+
+  r->Rewind ();
+  for (uint32_t i = 0; i < N_RECORDS; ++i)
+    {
+      NS_TEST_ASSERT_MSG_EQ (r->Next (record), true, "Record " << i << " not read");
+      NS_TEST_ASSERT_MSG_EQ (record.ns, 1000ULL * i, "Incorrect timestamp of record " << i);
+      uint32_t interface = i < N_RECORDS / 2 ? 0 : i % 2;
+      uint32_t len = 10 + i % 30;
+      NS_TEST_ASSERT_MSG_EQ (record.interface, interface, "Incorrect interface of record " << i);
+      NS_TEST_ASSERT_MSG_EQ (record.origLen, len, "Incorrect original length of record " << i);
+      NS_TEST_ASSERT_MSG_EQ (record.inclLen, (interface == 1 ? std::min (len, 20U) : len), "Incorrect included length of record " << i);
+    }
+  NS_TEST_ASSERT_MSG_EQ (r->Next (record), false, "A record past the end is read");
+  NS_TEST_ASSERT_MSG_EQ (r->GetNInterfaces (), 2, "An interface is read twice");
+
+  r->Seek (1000ULL * N_RECORDS);
+  NS_TEST_ASSERT_MSG_EQ (r->Next (record), false, "A record is read after seeking past the end");
+  NS_TEST_ASSERT_MSG_EQ (r->Fail (), false, "Reading the pcapng file returns error");
+}
+
+class PcapReaderTestSuite : public TestSuite
+{
+public:
+  PcapReaderTestSuite ();
+};
+
+PcapReaderTestSuite::PcapReaderTestSuite ()
+  : TestSuite ("pcap-reader", UNIT)
+{
+  SetDataDir (NS_TEST_SOURCEDIR);
+  AddTestCase (new KnownFileTestCase, TestCase::QUICK);
+  AddTestCase (new ForeignByteOrderTestCase, TestCase::QUICK);
+  AddTestCase (new SeekTestCase, TestCase::QUICK);
+}
+
+static PcapReaderTestSuite pcapReaderTestSuite;
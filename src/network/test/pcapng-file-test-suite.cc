@@ -0,0 +1,279 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <vector>
+
+#include "ns3/log.h"
+#include "ns3/test.h"
+#include "ns3/packet.h"
+#include "ns3/pcapng-file.h"
+#include "ns3/trace-helper.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("pcapng-file-test-suite");
+
+namespace {
+
+struct Block
+{
+  uint32_t type;
+  std::vector<uint8_t> body;
+};
+
+uint32_t
+Get32 (std::vector<uint8_t> const &body, uint32_t offset)
+{
+  uint32_t value;
+  memcpy (&value, &body[offset], sizeof (value));
+  return value;
+}
+
+uint16_t
+Get16 (std::vector<uint8_t> const &body, uint32_t offset)
+{
+  uint16_t value;
+  memcpy (&value, &body[offset], sizeof (value));
+  return value;
+}
+
+//
+// Read the blocks of a pcapng file written in the byte order of the host,
+// checking that the trailing length of each matches the leading one.
+//
+bool
+ReadBlocks (std::string filename, std::vector<struct Block> &blocks)
+{
+  FILE *p = std::fopen (filename.c_str (), "rb");
+  if (p == 0)
+    {
+      return false;
+    }
+  bool ok = true;
+  uint32_t header[2];
+  while (std::fread (header, sizeof (header), 1, p) == 1)
+    {
+      if (header[1] < 12 || header[1] % 4 != 0)
+        {
+          ok = false;
+          break;
+        }
+      struct Block block;
+      block.type = header[0];
+      block.body.resize (header[1] - 8);
+      uint32_t trailer;
+      if (std::fread (&block.body[0], block.body.size (), 1, p) != 1
+          || (trailer = Get32 (block.body, block.body.size () - 4)) != header[1])
+        {
+          ok = false;
+          break;
+        }
+      blocks.push_back (block);
+    }
+  std::fclose (p);
+  return ok;
+}
+
+} // anonymous namespace
+
+// ===========================================================================
+// Test case to make sure that the packets of several interfaces go to one
+// pcapng file, in well formed blocks.
+// ===========================================================================
+class InterfacesTestCase : public TestCase
+{
+public:
+  InterfacesTestCase ();
+
+private:
+  virtual void DoSetup (void);
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+
+  std::string m_testFilename;
+};
+
+InterfacesTestCase::InterfacesTestCase ()
+  : TestCase ("Check to see that PcapNgFile multiplexes the packets of its interfaces")
+{
+}
+
+void
+InterfacesTestCase::DoSetup (void)
+{
+  std::stringstream filename;
+  uint32_t n = rand ();
+  filename << n;
+  m_testFilename = CreateTempDirFilename (filename.str () + ".pcapng");
+}
+
+void
+InterfacesTestCase::DoTeardown (void)
+{
+  if (remove (m_testFilename.c_str ()))
+    {
+      NS_LOG_ERROR ("Failed to delete file " << m_testFilename);
+    }
+}
+
+void
+InterfacesTestCase::DoRun (void)
+{
+  Ptr<PcapNgFile> f = Create<PcapNgFile> ();
+  f->Open (m_testFilename);
+  NS_TEST_ASSERT_MSG_EQ (f->Fail (), false, "Open (" << m_testFilename << ") returns error");
+
+  uint32_t eth = f->AddInterface ("eth", 1, 65535);
+  uint32_t wifi = f->AddInterface ("wifi0", 105, 100);
+  NS_TEST_ASSERT_MSG_EQ (eth, 0, "Incorrect id of the first interface");
+  NS_TEST_ASSERT_MSG_EQ (wifi, 1, "Incorrect id of the second interface");
+  NS_TEST_ASSERT_MSG_EQ (f->GetNInterfaces (), 2, "Incorrect number of interfaces");
+  NS_TEST_ASSERT_MSG_EQ (f->GetDataLinkType (wifi), 105, "Incorrect data link type of an interface");
+  NS_TEST_ASSERT_MSG_EQ (f->GetSnapLen (wifi), 100, "Incorrect snap length of an interface");
+
+  //
+  // The second interface truncates its packets to 100 bytes.
+  //
+  const uint32_t N_PACKETS = 1000;
+  for (uint32_t i = 0; i < N_PACKETS; ++i)
+    {
+      f->Write (i % 2, 1000000000ULL * 5000 + i, Create<Packet> (i % 2 ? 150 : 61));
+    }
+  NS_TEST_ASSERT_MSG_EQ (f->Fail (), false, "Write() returns error");
+  f->Close ();
+
+  std::vector<struct Block> blocks;
+  NS_TEST_ASSERT_MSG_EQ (ReadBlocks (m_testFilename, blocks), true, "Malformed blocks in " << m_testFilename);
+  NS_TEST_ASSERT_MSG_EQ (blocks.size (), 3 + N_PACKETS, "Incorrect number of blocks");
+
+  NS_TEST_ASSERT_MSG_EQ (blocks[0].type, 0x0a0d0d0a, "The file does not start with a Section Header Block");
+  NS_TEST_ASSERT_MSG_EQ (Get32 (blocks[0].body, 0), 0x1a2b3c4d, "Incorrect byte order magic");
+  NS_TEST_ASSERT_MSG_EQ (Get16 (blocks[0].body, 4), 1, "Incorrect major version");
+
+  NS_TEST_ASSERT_MSG_EQ (blocks[2].type, 1, "No Interface Description Block");
+  NS_TEST_ASSERT_MSG_EQ (Get16 (blocks[2].body, 0), 105, "Incorrect data link type of the second interface");
+  NS_TEST_ASSERT_MSG_EQ (Get32 (blocks[2].body, 4), 100, "Incorrect snap length of the second interface");
+  NS_TEST_ASSERT_MSG_EQ (Get16 (blocks[2].body, 8), 2, "The first option is not if_name");
+  NS_TEST_ASSERT_MSG_EQ (Get16 (blocks[2].body, 10), 5, "Incorrect length of the name");
+  NS_TEST_ASSERT_MSG_EQ (std::string ((char const *)&blocks[2].body[12], 5), "wifi0", "Incorrect name");
+  NS_TEST_ASSERT_MSG_EQ (Get16 (blocks[2].body, 20), 9, "The second option is not if_tsresol");
+  NS_TEST_ASSERT_MSG_EQ ((uint32_t)blocks[2].body[24], 9, "The timestamps are not in nanoseconds");
+
+  for (uint32_t i = 0; i < N_PACKETS; ++i)
+    {
+      struct Block const &block = blocks[3 + i];
+      NS_TEST_ASSERT_MSG_EQ (block.type, 6, "Packet " << i << " not in an Enhanced Packet Block");
+      NS_TEST_ASSERT_MSG_EQ (Get32 (block.body, 0), i % 2, "Incorrect interface of packet " << i);
+      uint64_t ns = ((uint64_t)Get32 (block.body, 4) << 32) | Get32 (block.body, 8);
+      NS_TEST_ASSERT_MSG_EQ (ns, 1000000000ULL * 5000 + i, "Incorrect timestamp of packet " << i);
+      NS_TEST_ASSERT_MSG_EQ (Get32 (block.body, 12), (i % 2 ? 100 : 61), "Incorrect captured length of packet " << i);
+      NS_TEST_ASSERT_MSG_EQ (Get32 (block.body, 16), (i % 2 ? 150 : 61), "Incorrect original length of packet " << i);
+      NS_TEST_ASSERT_MSG_EQ (block.body.size (), (i % 2 ? 124 : 88), "Incorrect padding of packet " << i);
+    }
+}
+
+// ===========================================================================
+// Test case to make sure that the pcap helper creates the files of the
+// devices as interfaces of the pcapng file once asked to.
+// ===========================================================================
+class HelperTestCase : public TestCase
+{
+public:
+  HelperTestCase ();
+
+private:
+  virtual void DoSetup (void);
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+
+  std::string m_testFilename;
+};
+
+HelperTestCase::HelperTestCase ()
+  : TestCase ("Check to see that PcapHelper creates interfaces of a pcapng file")
+{
+}
+
+void
+HelperTestCase::DoSetup (void)
+{
+  std::stringstream filename;
+  uint32_t n = rand ();
+  filename << n;
+  m_testFilename = CreateTempDirFilename (filename.str () + ".pcapng");
+}
+
+void
+HelperTestCase::DoTeardown (void)
+{
+  if (remove (m_testFilename.c_str ()))
+    {
+      NS_LOG_ERROR ("Failed to delete file " << m_testFilename);
+    }
+}
+
+void
+HelperTestCase::DoRun (void)
+{
+  PcapHelper helper;
+  PcapHelper::EnablePcapNg (m_testFilename);
+  Ptr<PcapFileWrapper> a = helper.CreateFile ("a-0-0.pcap", std::ios::out, PcapHelper::DLT_EN10MB);
+  Ptr<PcapFileWrapper> b = helper.CreateFile ("b-1-0.pcap", std::ios::out, PcapHelper::DLT_PPP, 64);
+  PcapHelper::DisablePcapNg ();
+  NS_TEST_ASSERT_MSG_EQ (b->GetDataLinkType (), PcapHelper::DLT_PPP, "Incorrect data link type of an interface");
+  NS_TEST_ASSERT_MSG_EQ (b->GetSnapLen (), 64, "Incorrect snap length of an interface");
+
+  a->Write (Seconds (1.0), Create<Packet> (10));
+  b->Write (Seconds (2.0), Create<Packet> (100));
+  a->Write (Seconds (3.0), Create<Packet> (20));
+  NS_TEST_ASSERT_MSG_EQ (a->Fail (), false, "Write() returns error");
+
+  //
+  // The file is closed with the last of its interfaces.
+  //
+  a = 0;
+  b = 0;
+
+  std::vector<struct Block> blocks;
+  NS_TEST_ASSERT_MSG_EQ (ReadBlocks (m_testFilename, blocks), true, "Malformed blocks in " << m_testFilename);
+  NS_TEST_ASSERT_MSG_EQ (blocks.size (), 6, "Incorrect number of blocks");
+  NS_TEST_ASSERT_MSG_EQ (blocks[1].type, 1, "No Interface Description Block for the first file");
+  NS_TEST_ASSERT_MSG_EQ (std::string ((char const *)&blocks[1].body[12], 10), "a-0-0.pcap", "Incorrect name of the first interface");
+  NS_TEST_ASSERT_MSG_EQ (blocks[2].type, 1, "No Interface Description Block for the second file");
+  NS_TEST_ASSERT_MSG_EQ (Get32 (blocks[4].body, 0), 1, "Incorrect interface of the second packet");
+  NS_TEST_ASSERT_MSG_EQ (Get32 (blocks[4].body, 12), 64, "Incorrect captured length of the second packet");
+  NS_TEST_ASSERT_MSG_EQ (Get32 (blocks[5].body, 0), 0, "Incorrect interface of the third packet");
+  NS_TEST_ASSERT_MSG_EQ (Get32 (blocks[5].body, 8), 3000000000U, "Incorrect timestamp of the third packet");
+}
+
+class PcapNgFileTestSuite : public TestSuite
+{
+public:
+  PcapNgFileTestSuite ();
+};
+
+PcapNgFileTestSuite::PcapNgFileTestSuite ()
+  : TestSuite ("pcapng-file", UNIT)
+{
+  AddTestCase (new InterfacesTestCase, TestCase::QUICK);
+  AddTestCase (new HelperTestCase, TestCase::QUICK);
+}
+
+static PcapNgFileTestSuite pcapNgFileTestSuite;
@@ -0,0 +1,170 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/simple-channel.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/node.h"
+#include "ns3/packet.h"
+#include "ns3/simulator.h"
+#include "ns3/error-model.h"
+#include "ns3/test.h"
+#include <list>
+#include <vector>
+
+using namespace ns3;
+
+class SimpleChannelBroadcastTestCase : public TestCase
+{
+public:
+  SimpleChannelBroadcastTestCase ();
+private:
+  virtual void DoRun (void);
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> packet,
+                uint16_t protocol, const Address &from);
+
+  std::vector<Ptr<const Packet> > m_received;
+};
+
+SimpleChannelBroadcastTestCase::SimpleChannelBroadcastTestCase ()
+  : TestCase ("Check that the receivers of a broadcast get their own packet")
+{
+}
+
+bool
+SimpleChannelBroadcastTestCase::Receive (Ptr<NetDevice> device, Ptr<const Packet> packet,
+                                         uint16_t protocol, const Address &from)
+{
+  m_received.push_back (packet);
+  // what a receiver does to its packet must not be seen by the others
+  ConstCast<Packet> (packet)->RemoveAtStart (10);
+  return true;
+}
+
+void
+SimpleChannelBroadcastTestCase::DoRun (void)
+{
+  const uint32_t n = 5;
+  Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+  std::vector<Ptr<SimpleNetDevice> > devices;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Ptr<Node> node = CreateObject<Node> ();
+      Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+      device->SetAddress (Mac48Address::Allocate ());
+      device->SetChannel (channel);
+      node->AddDevice (device);
+      device->SetReceiveCallback (MakeCallback (&SimpleChannelBroadcastTestCase::Receive, this));
+      devices.push_back (device);
+    }
+
+  Ptr<Packet> packet = Create<Packet> (100);
+  devices[0]->Send (packet, devices[0]->GetBroadcast (), 0x800);
+  // nor what the sender does after sending
+  packet->RemoveAtEnd (50);
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_received.size (), n - 1, "not received by all the other devices");
+  for (uint32_t i = 0; i < m_received.size (); i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (m_received[i]->GetSize (), 90, "packet shared by the receivers");
+      for (uint32_t j = 0; j < i; j++)
+        {
+          NS_TEST_ASSERT_MSG_NE (m_received[i], m_received[j], "same packet given to two receivers");
+        }
+    }
+  m_received.clear ();
+  Simulator::Destroy ();
+}
+
+class SimpleChannelErrorModelTestCase : public TestCase
+{
+public:
+  SimpleChannelErrorModelTestCase ();
+private:
+  virtual void DoRun (void);
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> packet,
+                uint16_t protocol, const Address &from);
+  void Drop (Ptr<const Packet> packet);
+
+  uint32_t m_received;
+  std::vector<Ptr<const Packet> > m_dropped;
+};
+
+SimpleChannelErrorModelTestCase::SimpleChannelErrorModelTestCase ()
+  : TestCase ("Check that a receiver drops a corrupted broadcast alone"),
+    m_received (0)
+{
+}
+
+bool
+SimpleChannelErrorModelTestCase::Receive (Ptr<NetDevice> device, Ptr<const Packet> packet,
+                                          uint16_t protocol, const Address &from)
+{
+  m_received++;
+  return true;
+}
+
+void
+SimpleChannelErrorModelTestCase::Drop (Ptr<const Packet> packet)
+{
+  m_dropped.push_back (packet);
+}
+
+void
+SimpleChannelErrorModelTestCase::DoRun (void)
+{
+  const uint32_t n = 4;
+  Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+  std::vector<Ptr<SimpleNetDevice> > devices;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Ptr<Node> node = CreateObject<Node> ();
+      Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+      device->SetAddress (Mac48Address::Allocate ());
+      device->SetChannel (channel);
+      node->AddDevice (device);
+      device->SetReceiveCallback (MakeCallback (&SimpleChannelErrorModelTestCase::Receive, this));
+      device->TraceConnectWithoutContext ("PhyRxDrop", MakeCallback (&SimpleChannelErrorModelTestCase::Drop, this));
+      devices.push_back (device);
+    }
+
+  Ptr<Packet> packet = Create<Packet> (100);
+  std::list<uint32_t> uids;
+  uids.push_back (packet->GetUid ());
+  Ptr<ListErrorModel> em = CreateObject<ListErrorModel> ();
+  em->SetList (uids);
+  devices[1]->SetReceiveErrorModel (em);
+
+  devices[0]->Send (packet, devices[0]->GetBroadcast (), 0x800);
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_received, n - 2, "not received by the other devices");
+  NS_TEST_ASSERT_MSG_EQ (m_dropped.size (), 1, "corrupted packet not dropped");
+  NS_TEST_ASSERT_MSG_EQ (m_dropped[0]->GetSize (), 100, "wrong packet dropped");
+  m_dropped.clear ();
+  Simulator::Destroy ();
+}
+
+static class SimpleChannelTestSuite : public TestSuite
+{
+public:
+  SimpleChannelTestSuite ()
+    : TestSuite ("simple-channel", UNIT)
+  {
+    AddTestCase (new SimpleChannelBroadcastTestCase (), TestCase::QUICK);
+    AddTestCase (new SimpleChannelErrorModelTestCase (), TestCase::QUICK);
+  }
+} g_simpleChannelTestSuite;
@@ -0,0 +1,214 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/slab-allocator.h"
+#include "ns3/packet.h"
+#include "ns3/tag.h"
+#include "ns3/test.h"
+#include <vector>
+#include <cstring>
+
+using namespace ns3;
+
+namespace {
+
+uint64_t
+GetInUse (void)
+{
+  uint64_t inUse = 0;
+  for (uint32_t i = 0; i < SlabAllocator::GetNClasses (); i++)
+    {
+      SlabAllocator::Stats stats = SlabAllocator::GetStats (i);
+      inUse += stats.allocations - stats.deallocations;
+    }
+  return inUse;
+}
+
+uint64_t
+GetChunks (void)
+{
+  uint64_t chunks = 0;
+  for (uint32_t i = 0; i < SlabAllocator::GetNClasses (); i++)
+    {
+      chunks += SlabAllocator::GetStats (i).chunks;
+    }
+  return chunks;
+}
+
+class SlabTestTag : public Tag
+{
+public:
+  static TypeId GetTypeId (void)
+  {
+    static TypeId tid = TypeId ("ns3::SlabTestTag")
+      .SetParent<Tag> ()
+      .AddConstructor<SlabTestTag> ()
+    ;
+    return tid;
+  }
+  virtual TypeId GetInstanceTypeId (void) const
+  {
+    return GetTypeId ();
+  }
+  virtual uint32_t GetSerializedSize (void) const
+  {
+    return 4;
+  }
+  virtual void Serialize (TagBuffer i) const
+  {
+    i.WriteU32 (0x12345678);
+  }
+  virtual void Deserialize (TagBuffer i)
+  {
+    i.ReadU32 ();
+  }
+  virtual void Print (std::ostream &os) const
+  {
+  }
+};
+
+} // anonymous namespace
+
+class SlabAllocatorSizeTestCase : public TestCase
+{
+public:
+  SlabAllocatorSizeTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+SlabAllocatorSizeTestCase::SlabAllocatorSizeTestCase ()
+  : TestCase ("Check the rounding of the sizes to the size classes")
+{
+}
+
+void
+SlabAllocatorSizeTestCase::DoRun (void)
+{
+  NS_TEST_ASSERT_MSG_EQ (SlabAllocator::GetBlockSize (1), 16, "smallest class");
+  NS_TEST_ASSERT_MSG_EQ (SlabAllocator::GetBlockSize (16), 16, "exact size");
+  NS_TEST_ASSERT_MSG_EQ (SlabAllocator::GetBlockSize (17), 32, "next class");
+  NS_TEST_ASSERT_MSG_EQ (SlabAllocator::GetBlockSize (64), 64, "last class of 16 bytes");
+  NS_TEST_ASSERT_MSG_EQ (SlabAllocator::GetBlockSize (65), 96, "first half power of two");
+  NS_TEST_ASSERT_MSG_EQ (SlabAllocator::GetBlockSize (97), 128, "power of two");
+  NS_TEST_ASSERT_MSG_EQ (SlabAllocator::GetBlockSize (129), 192, "half power of two");
+  NS_TEST_ASSERT_MSG_EQ (SlabAllocator::GetBlockSize (1500), 1536, "ethernet frame");
+  NS_TEST_ASSERT_MSG_EQ (SlabAllocator::GetBlockSize (8192), 8192, "largest class");
+  NS_TEST_ASSERT_MSG_EQ (SlabAllocator::GetBlockSize (8193), 8193, "large request");
+  for (uint32_t size = 1; size <= 8192; size++)
+    {
+      uint32_t blockSize = SlabAllocator::GetBlockSize (size);
+      NS_TEST_ASSERT_MSG_EQ ((blockSize >= size && blockSize % 16 == 0), true,
+                             "bad block size " << blockSize << " for " << size);
+      NS_TEST_ASSERT_MSG_EQ (SlabAllocator::GetBlockSize (blockSize), blockSize,
+                             "a block size is its own class");
+    }
+}
+
+class SlabAllocatorReuseTestCase : public TestCase
+{
+public:
+  SlabAllocatorReuseTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+SlabAllocatorReuseTestCase::SlabAllocatorReuseTestCase ()
+  : TestCase ("Check that the freed blocks are reused and counted")
+{
+}
+
+void
+SlabAllocatorReuseTestCase::DoRun (void)
+{
+  const uint32_t n = 5000;
+  uint64_t inUse = GetInUse ();
+  std::vector<void *> blocks;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      uint32_t size = 1 + (i * 37) % 2000;
+      uint8_t *p = static_cast<uint8_t *> (SlabAllocator::Allocate (size));
+      NS_TEST_ASSERT_MSG_EQ ((reinterpret_cast<uintptr_t> (p) % 8), 0, "misaligned block");
+      std::memset (p, i & 0xff, size);
+      blocks.push_back (p);
+    }
+  NS_TEST_ASSERT_MSG_EQ (GetInUse (), inUse + n, "allocations not counted");
+  for (uint32_t i = 0; i < n; i++)
+    {
+      uint32_t size = 1 + (i * 37) % 2000;
+      uint8_t *p = static_cast<uint8_t *> (blocks[i]);
+      NS_TEST_ASSERT_MSG_EQ ((p[0] == (i & 0xff) && p[size - 1] == (i & 0xff)), true,
+                             "overlapping blocks");
+      SlabAllocator::Deallocate (p, size);
+    }
+  NS_TEST_ASSERT_MSG_EQ (GetInUse (), inUse, "deallocations not counted");
+
+  // the same allocations again are served by the freed blocks
+  uint64_t chunks = GetChunks ();
+  for (uint32_t i = 0; i < n; i++)
+    {
+      blocks[i] = SlabAllocator::Allocate (1 + (i * 37) % 2000);
+    }
+  NS_TEST_ASSERT_MSG_EQ (GetChunks (), chunks, "freed blocks not reused");
+  for (uint32_t i = 0; i < n; i++)
+    {
+      SlabAllocator::Deallocate (blocks[i], 1 + (i * 37) % 2000);
+    }
+  NS_TEST_ASSERT_MSG_EQ (GetInUse (), inUse, "deallocations not counted");
+}
+
+class SlabAllocatorPacketTestCase : public TestCase
+{
+public:
+  SlabAllocatorPacketTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+SlabAllocatorPacketTestCase::SlabAllocatorPacketTestCase ()
+  : TestCase ("Check that the packets give back their storage")
+{
+}
+
+void
+SlabAllocatorPacketTestCase::DoRun (void)
+{
+  uint64_t inUse = GetInUse ();
+  {
+    Ptr<Packet> p = Create<Packet> (1000);
+    SlabTestTag tag;
+    p->AddByteTag (tag);
+    p->AddPacketTag (tag);
+    Ptr<Packet> fragment = p->CreateFragment (100, 500);
+    p->AddAtEnd (fragment);
+    p->AddPaddingAtEnd (2000);
+    NS_TEST_ASSERT_MSG_EQ (p->GetSize (), 3500, "bad packet size");
+    NS_TEST_ASSERT_MSG_GT (GetInUse (), inUse, "packet storage not allocated from the slabs");
+  }
+  NS_TEST_ASSERT_MSG_EQ (GetInUse (), inUse, "packet storage leaked");
+}
+
+static class SlabAllocatorTestSuite : public TestSuite
+{
+public:
+  SlabAllocatorTestSuite ()
+    : TestSuite ("slab-allocator", UNIT)
+  {
+    AddTestCase (new SlabAllocatorSizeTestCase (), TestCase::QUICK);
+    AddTestCase (new SlabAllocatorReuseTestCase (), TestCase::QUICK);
+    AddTestCase (new SlabAllocatorPacketTestCase (), TestCase::QUICK);
+  }
+} g_slabAllocatorTestSuite;
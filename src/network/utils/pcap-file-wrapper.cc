@@ -45,6 +45,7 @@ PcapFileWrapper::GetTypeId (void)
 
 
 PcapFileWrapper::PcapFileWrapper ()
+  : m_interface (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -60,6 +61,10 @@ bool
 PcapFileWrapper::Fail (void) const
 {
   NS_LOG_FUNCTION (this);
+  if (m_ngFile != 0)
+    {
+      return m_ngFile->Fail ();
+    }
   return m_file.Fail ();
 }
 bool 
@@ -79,6 +84,8 @@ void
 PcapFileWrapper::Close (void)
 {
   NS_LOG_FUNCTION (this);
+  // the pcapng file is closed by the last of its users
+  m_ngFile = 0;
   m_file.Close ();
 }
 
@@ -89,6 +96,14 @@ PcapFileWrapper::Open (std::string const &filename, std::ios::openmode mode)
   m_file.Open (filename, mode);
 }
 
+void
+PcapFileWrapper::Open (Ptr<PcapNgFile> file, std::string const &name)
+{
+  NS_LOG_FUNCTION (this << file << name);
+  m_ngFile = file;
+  m_name = name;
+}
+
 void
 PcapFileWrapper::Init (uint32_t dataLinkType, uint32_t snapLen, int32_t tzCorrection)
 {
@@ -98,20 +113,29 @@ PcapFileWrapper::Init (uint32_t dataLinkType, uint32_t snapLen, int32_t tzCorrec
   // a snaplen, we use the one provided.
   //
   NS_LOG_FUNCTION (this << dataLinkType << snapLen << tzCorrection);
-  if (snapLen != std::numeric_limits<uint32_t>::max ())
+  if (snapLen == std::numeric_limits<uint32_t>::max ())
     {
-      m_file.Init (dataLinkType, snapLen, tzCorrection);
-    } 
+      snapLen = m_snapLen;
+    }
+  if (m_ngFile != 0)
+    {
+      m_interface = m_ngFile->AddInterface (m_name, dataLinkType, snapLen);
+    }
   else
     {
-      m_file.Init (dataLinkType, m_snapLen, tzCorrection);
-    } 
+      m_file.Init (dataLinkType, snapLen, tzCorrection);
+    }
 }
 
 void
 PcapFileWrapper::Write (Time t, Ptr<const Packet> p)
 {
   NS_LOG_FUNCTION (this << t << p);
+  if (m_ngFile != 0)
+    {
+      m_ngFile->Write (m_interface, t.GetNanoSeconds (), p);
+      return;
+    }
   uint64_t current = t.GetMicroSeconds ();
   uint64_t s = current / 1000000;
   uint64_t us = current % 1000000;
@@ -123,6 +147,11 @@ void
 PcapFileWrapper::Write (Time t, Header &header, Ptr<const Packet> p)
 {
   NS_LOG_FUNCTION (this << t << &header << p);
+  if (m_ngFile != 0)
+    {
+      m_ngFile->Write (m_interface, t.GetNanoSeconds (), header, p);
+      return;
+    }
   uint64_t current = t.GetMicroSeconds ();
   uint64_t s = current / 1000000;
   uint64_t us = current % 1000000;
@@ -134,6 +163,11 @@ void
 PcapFileWrapper::Write (Time t, uint8_t const *buffer, uint32_t length)
 {
   NS_LOG_FUNCTION (this << t << &buffer << length);
+  if (m_ngFile != 0)
+    {
+      m_ngFile->Write (m_interface, t.GetNanoSeconds (), buffer, length);
+      return;
+    }
   uint64_t current = t.GetMicroSeconds ();
   uint64_t s = current / 1000000;
   uint64_t us = current % 1000000;
@@ -180,6 +214,10 @@ uint32_t
 PcapFileWrapper::GetSnapLen (void)
 {
   NS_LOG_FUNCTION (this);
+  if (m_ngFile != 0)
+    {
+      return m_ngFile->GetSnapLen (m_interface);
+    }
   return m_file.GetSnapLen ();
 }
 
@@ -187,6 +225,10 @@ uint32_t
 PcapFileWrapper::GetDataLinkType (void)
 {
   NS_LOG_FUNCTION (this);
+  if (m_ngFile != 0)
+    {
+      return m_ngFile->GetDataLinkType (m_interface);
+    }
   return m_file.GetDataLinkType ();
 }
 
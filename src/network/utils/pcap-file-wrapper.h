@@ -27,6 +27,7 @@
 #include "ns3/object.h"
 #include "ns3/nstime.h"
 #include "pcap-file.h"
+#include "pcapng-file.h"
 
 namespace ns3 {
 
@@ -73,6 +74,17 @@ public:
    */
   void Open (std::string const &filename, std::ios::openmode mode);
 
+  /**
+   * Write the packets to an interface of a shared pcapng file instead of
+   * a pcap file of their own.  The interface is described in the file by
+   * Init.  The pcap header getters are then meaningless, except for
+   * GetSnapLen and GetDataLinkType, which return those of the interface.
+   *
+   * \param file the pcapng file, already opened
+   * \param name the name of the interface in the file
+   */
+  void Open (Ptr<PcapNgFile> file, std::string const &name);
+
   /**
    * Close the underlying pcap file.
    */
@@ -197,6 +209,9 @@ public:
 private:
   PcapFile m_file;
   uint32_t m_snapLen;
+  Ptr<PcapNgFile> m_ngFile;
+  std::string m_name;
+  uint32_t m_interface;
 };
 
 } // namespace ns3
@@ -49,7 +49,8 @@ const int32_t  SIGFIGS_DEFAULT = 0;           /**< Significant figures for times
 
 PcapFile::PcapFile ()
   : m_file (),
-    m_swapMode (false)
+    m_swapMode (false),
+    m_buffered (false)
 {
   NS_LOG_FUNCTION (this);
   FatalImpl::RegisterStream (&m_file);
@@ -67,18 +68,21 @@ bool
 PcapFile::Fail (void) const
 {
   NS_LOG_FUNCTION (this);
+  m_writer.Sync ();
   return m_file.fail ();
 }
 bool 
 PcapFile::Eof (void) const
 {
   NS_LOG_FUNCTION (this);
+  m_writer.Sync ();
   return m_file.eof ();
 }
 void 
 PcapFile::Clear (void)
 {
   NS_LOG_FUNCTION (this);
+  m_writer.Sync ();
   m_file.clear ();
 }
 
@@ -87,6 +91,8 @@ void
 PcapFile::Close (void)
 {
   NS_LOG_FUNCTION (this);
+  m_writer.Sync ();
+  m_buffered = false;
   m_file.close ();
 }
 
@@ -198,6 +204,7 @@ PcapFile::WriteFileHeader (void)
   // If we're initializing the file, we need to write the pcap file header
   // at the start of the file.
   //
+  m_writer.Sync ();
   m_file.seekp (0, std::ios::beg);
  
   //
@@ -324,6 +331,11 @@ PcapFile::Open (std::string const &filename, std::ios::openmode mode)
       // will set the fail bit if file header is invalid.
       ReadAndVerifyFileHeader ();
     }
+  else
+    {
+      m_writer.SetStream (&m_file);
+      m_buffered = true;
+    }
 }
 
 void
@@ -378,6 +390,7 @@ PcapFile::WritePacketHeader (uint32_t tsSec, uint32_t tsUsec, uint32_t totalLen)
   NS_ASSERT (m_file.good ());
 
   uint32_t inclLen = totalLen > m_fileHeader.m_snapLen ? m_fileHeader.m_snapLen : totalLen;
+  NS_ASSERT (!m_buffered);
 
   PcapRecordHeader header;
   header.m_tsSec = tsSec;
@@ -401,10 +414,49 @@ PcapFile::WritePacketHeader (uint32_t tsSec, uint32_t tsUsec, uint32_t totalLen)
   return inclLen;
 }
 
+uint8_t *
+PcapFile::AppendPacketHeader (uint32_t tsSec, uint32_t tsUsec, uint32_t totalLen,
+                              uint32_t *inclLen)
+{
+  NS_LOG_FUNCTION (this << tsSec << tsUsec << totalLen);
+  NS_ASSERT (m_buffered);
+
+  *inclLen = totalLen > m_fileHeader.m_snapLen ? m_fileHeader.m_snapLen : totalLen;
+
+  PcapRecordHeader header;
+  header.m_tsSec = tsSec;
+  header.m_tsUsec = tsUsec;
+  header.m_inclLen = *inclLen;
+  header.m_origLen = totalLen;
+
+  if (m_swapMode)
+    {
+      Swap (&header, &header);
+    }
+
+  //
+  // The whole record goes to the chunk of the writer at once, the data
+  // right after the header.
+  //
+  uint8_t *record = m_writer.Append (16 + *inclLen);
+  memcpy (record, &header.m_tsSec, sizeof(header.m_tsSec));
+  memcpy (record + 4, &header.m_tsUsec, sizeof(header.m_tsUsec));
+  memcpy (record + 8, &header.m_inclLen, sizeof(header.m_inclLen));
+  memcpy (record + 12, &header.m_origLen, sizeof(header.m_origLen));
+  return record + 16;
+}
+
 void
 PcapFile::Write (uint32_t tsSec, uint32_t tsUsec, uint8_t const * const data, uint32_t totalLen)
 {
   NS_LOG_FUNCTION (this << tsSec << tsUsec << &data << totalLen);
+  if (m_buffered)
+    {
+      uint32_t inclLen;
+      uint8_t *record = AppendPacketHeader (tsSec, tsUsec, totalLen, &inclLen);
+      memcpy (record, data, inclLen);
+      return;
+    }
   uint32_t inclLen = WritePacketHeader (tsSec, tsUsec, totalLen);
   m_file.write ((const char *)data, inclLen);
 }
@@ -413,6 +465,13 @@ void
 PcapFile::Write (uint32_t tsSec, uint32_t tsUsec, Ptr<const Packet> p)
 {
   NS_LOG_FUNCTION (this << tsSec << tsUsec << p);
+  if (m_buffered)
+    {
+      uint32_t inclLen;
+      uint8_t *record = AppendPacketHeader (tsSec, tsUsec, p->GetSize (), &inclLen);
+      p->CopyData (record, inclLen);
+      return;
+    }
   uint32_t inclLen = WritePacketHeader (tsSec, tsUsec, p->GetSize ());
   p->CopyData (&m_file, inclLen);
 }
@@ -423,11 +482,20 @@ PcapFile::Write (uint32_t tsSec, uint32_t tsUsec, Header &header, Ptr<const Pack
   NS_LOG_FUNCTION (this << tsSec << tsUsec << &header << p);
   uint32_t headerSize = header.GetSerializedSize ();
   uint32_t totalSize = headerSize + p->GetSize ();
-  uint32_t inclLen = WritePacketHeader (tsSec, tsUsec, totalSize);
 
   Buffer headerBuffer;
   headerBuffer.AddAtStart (headerSize);
   header.Serialize (headerBuffer.Begin ());
+  if (m_buffered)
+    {
+      uint32_t inclLen;
+      uint8_t *record = AppendPacketHeader (tsSec, tsUsec, totalSize, &inclLen);
+      uint32_t toCopy = std::min (headerSize, inclLen);
+      headerBuffer.CopyData (record, toCopy);
+      p->CopyData (record + toCopy, inclLen - toCopy);
+      return;
+    }
+  uint32_t inclLen = WritePacketHeader (tsSec, tsUsec, totalSize);
   uint32_t toCopy = std::min (headerSize, inclLen);
   headerBuffer.CopyData (&m_file, toCopy);
   inclLen -= toCopy;
@@ -25,6 +25,7 @@
 #include <fstream>
 #include <stdint.h>
 #include "ns3/ptr.h"
+#include "pcap-writer.h"
 
 namespace ns3 {
 
@@ -35,6 +36,10 @@ class Header;
  * A class representing a pcap file.  This allows easy creation, writing and 
  * reading of files composed of stored packets; which may be viewed using
  * standard tools.
+ *
+ * The records written to a file opened in std::ios::out mode only are
+ * buffered by a PcapWriter, which appends them to the file from a
+ * background thread: they are all in the file once it is closed.
  */
 
 class PcapFile
@@ -284,12 +289,17 @@ private:
 
   void WriteFileHeader (void);
   uint32_t WritePacketHeader (uint32_t tsSec, uint32_t tsUsec, uint32_t totalLen);
+  uint8_t *AppendPacketHeader (uint32_t tsSec, uint32_t tsUsec, uint32_t totalLen,
+                               uint32_t *inclLen);
   void ReadAndVerifyFileHeader (void);
 
   std::string    m_filename;
   std::fstream   m_file;
   PcapFileHeader m_fileHeader;
   bool m_swapMode;
+  // buffers the records of a file opened for writing only
+  mutable PcapWriter m_writer;
+  bool m_buffered;
 };
 
 } // namespace ns3
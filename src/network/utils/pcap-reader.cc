@@ -0,0 +1,496 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <cstring>
+#include <algorithm>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "ns3/assert.h"
+#include "ns3/log.h"
+#include "pcap-reader.h"
+
+NS_LOG_COMPONENT_DEFINE ("PcapReader");
+
+namespace ns3 {
+
+namespace {
+
+const uint32_t MAGIC = 0xa1b2c3d4;
+const uint32_t SWAPPED_MAGIC = 0xd4c3b2a1;
+// the nanosecond magic of PcapFile, and the one of libpcap
+const uint32_t NS_MAGIC = 0xa1b23cd4;
+const uint32_t NS_SWAPPED_MAGIC = 0xd43cb2a1;
+const uint32_t LIBPCAP_NS_MAGIC = 0xa1b23c4d;
+const uint32_t LIBPCAP_NS_SWAPPED_MAGIC = 0x4d3cb2a1;
+
+const uint32_t SECTION_HEADER_BLOCK = 0x0a0d0d0a;
+const uint32_t INTERFACE_DESCRIPTION_BLOCK = 0x00000001;
+const uint32_t PACKET_BLOCK = 0x00000002;
+const uint32_t ENHANCED_PACKET_BLOCK = 0x00000006;
+const uint32_t BYTE_ORDER_MAGIC = 0x1a2b3c4d;
+const uint32_t SWAPPED_BYTE_ORDER_MAGIC = 0x4d3c2b1a;
+
+const uint16_t OPT_ENDOFOPT = 0;
+const uint16_t IF_TSRESOL = 9;
+
+const uint64_t NS_PER_SEC = 1000000000ULL;
+const uint64_t US_PER_SEC = 1000000ULL;
+
+// one record in INDEX_INTERVAL is indexed
+const uint64_t INDEX_INTERVAL = 1024;
+
+} // anonymous namespace
+
+PcapReader::PcapReader ()
+  : m_data (0),
+    m_size (0),
+    m_fail (false),
+    m_ng (false),
+    m_swap (false),
+    m_nsResolution (false),
+    m_begin (0),
+    m_offset (0),
+    m_indexedEnd (0),
+    m_nIndexed (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+PcapReader::~PcapReader ()
+{
+  NS_LOG_FUNCTION (this);
+  Close ();
+}
+
+bool
+PcapReader::Fail (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_fail;
+}
+
+void
+PcapReader::Open (std::string const &filename)
+{
+  NS_LOG_FUNCTION (this << filename);
+  Close ();
+  m_fail = true;
+
+  int fd = open (filename.c_str (), O_RDONLY);
+  if (fd < 0)
+    {
+      NS_LOG_LOGIC ("Unable to open " << filename);
+      return;
+    }
+  struct stat st;
+  if (fstat (fd, &st) != 0 || st.st_size == 0)
+    {
+      close (fd);
+      return;
+    }
+  void *data = mmap (0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  // the mapping holds its own reference to the file
+  close (fd);
+  if (data == MAP_FAILED)
+    {
+      NS_LOG_LOGIC ("Unable to map " << filename);
+      return;
+    }
+  // the records are mostly read in order, the pages behind can go
+  madvise (data, st.st_size, MADV_SEQUENTIAL);
+  m_data = static_cast<uint8_t const *> (data);
+  m_size = st.st_size;
+
+  m_swap = false;
+  uint32_t magic = m_size >= 4 ? Get32 (0) : 0;
+  if (magic == SECTION_HEADER_BLOCK)
+    {
+      m_ng = true;
+      m_fail = !ReadPcapNgSection ();
+    }
+  else
+    {
+      m_ng = false;
+      m_fail = !ReadPcapHeader ();
+    }
+  m_offset = m_begin;
+  m_indexedEnd = m_begin;
+}
+
+void
+PcapReader::Close (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_data != 0)
+    {
+      munmap (const_cast<uint8_t *> (m_data), m_size);
+    }
+  m_data = 0;
+  m_size = 0;
+  m_fail = false;
+  m_interfaces.clear ();
+  m_begin = 0;
+  m_offset = 0;
+  m_indexedEnd = 0;
+  m_nIndexed = 0;
+  m_index.clear ();
+}
+
+bool
+PcapReader::IsPcapNg (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_ng;
+}
+
+uint32_t
+PcapReader::GetNInterfaces (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_interfaces.size ();
+}
+
+uint32_t
+PcapReader::GetDataLinkType (uint32_t interface) const
+{
+  NS_LOG_FUNCTION (this << interface);
+  NS_ASSERT (interface < m_interfaces.size ());
+  return m_interfaces[interface].m_dataLinkType;
+}
+
+uint32_t
+PcapReader::GetSnapLen (uint32_t interface) const
+{
+  NS_LOG_FUNCTION (this << interface);
+  NS_ASSERT (interface < m_interfaces.size ());
+  return m_interfaces[interface].m_snapLen;
+}
+
+uint16_t
+PcapReader::Get16 (uint64_t offset) const
+{
+  uint16_t value;
+  memcpy (&value, m_data + offset, sizeof (value));
+  if (m_swap)
+    {
+      value = ((value >> 8) & 0x00ff) | ((value << 8) & 0xff00);
+    }
+  return value;
+}
+
+uint32_t
+PcapReader::Get32 (uint64_t offset) const
+{
+  uint32_t value;
+  memcpy (&value, m_data + offset, sizeof (value));
+  if (m_swap)
+    {
+      value = ((value >> 24) & 0x000000ff) | ((value >> 8) & 0x0000ff00)
+        | ((value << 8) & 0x00ff0000) | ((value << 24) & 0xff000000);
+    }
+  return value;
+}
+
+bool
+PcapReader::ReadPcapHeader (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_size < 24)
+    {
+      return false;
+    }
+  uint32_t magic = Get32 (0);
+  m_swap = magic == SWAPPED_MAGIC || magic == NS_SWAPPED_MAGIC || magic == LIBPCAP_NS_SWAPPED_MAGIC;
+  m_nsResolution = magic == NS_MAGIC || magic == NS_SWAPPED_MAGIC
+    || magic == LIBPCAP_NS_MAGIC || magic == LIBPCAP_NS_SWAPPED_MAGIC;
+  if (!m_swap && !m_nsResolution && magic != MAGIC)
+    {
+      NS_LOG_LOGIC ("Not a pcap file, magic " << std::hex << magic);
+      return false;
+    }
+  struct Interface interface;
+  interface.m_snapLen = Get32 (16);
+  interface.m_dataLinkType = Get32 (20);
+  interface.m_unitsPerSec = m_nsResolution ? NS_PER_SEC : US_PER_SEC;
+  m_interfaces.push_back (interface);
+  m_begin = 24;
+  return true;
+}
+
+bool
+PcapReader::ReadPcapNgSection (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_size < 28)
+    {
+      return false;
+    }
+  uint32_t byteOrder = Get32 (8);
+  if (byteOrder != BYTE_ORDER_MAGIC && byteOrder != SWAPPED_BYTE_ORDER_MAGIC)
+    {
+      return false;
+    }
+  m_swap = byteOrder == SWAPPED_BYTE_ORDER_MAGIC;
+  uint32_t length = Get32 (4);
+  if (length < 28 || length % 4 != 0 || length > m_size)
+    {
+      return false;
+    }
+  m_begin = length;
+  return true;
+}
+
+void
+PcapReader::ReadInterface (uint64_t offset, uint32_t length)
+{
+  NS_LOG_FUNCTION (this << offset << length);
+  struct Interface interface;
+  interface.m_dataLinkType = Get16 (offset + 8);
+  interface.m_snapLen = Get32 (offset + 12);
+  interface.m_unitsPerSec = US_PER_SEC;
+
+  //
+  // Of the options, only the resolution of the timestamps matters: a
+  // power of 10, or of 2 when its high bit is set.
+  //
+  uint64_t option = offset + 16;
+  uint64_t end = offset + length - 4;
+  while (option + 4 <= end)
+    {
+      uint16_t code = Get16 (option);
+      uint16_t optionLength = Get16 (option + 2);
+      if (code == OPT_ENDOFOPT || option + 4 + optionLength > end)
+        {
+          break;
+        }
+      if (code == IF_TSRESOL && optionLength >= 1)
+        {
+          uint8_t resolution = m_data[option + 4];
+          if (resolution & 0x80)
+            {
+              interface.m_unitsPerSec = 1ULL << std::min (resolution & 0x7f, 63);
+            }
+          else
+            {
+              interface.m_unitsPerSec = 1;
+              for (uint8_t i = 0; i < std::min (resolution, (uint8_t)19); i++)
+                {
+                  interface.m_unitsPerSec *= 10;
+                }
+            }
+        }
+      option += 4 + ((optionLength + 3) & ~3U);
+    }
+  m_interfaces.push_back (interface);
+}
+
+uint64_t
+PcapReader::ToNanoSeconds (uint32_t interface, uint64_t ts) const
+{
+  uint64_t unitsPerSec = m_interfaces[interface].m_unitsPerSec;
+  if (unitsPerSec == NS_PER_SEC)
+    {
+      return ts;
+    }
+  uint64_t s = ts / unitsPerSec;
+  uint64_t units = ts % unitsPerSec;
+  if (unitsPerSec < NS_PER_SEC)
+    {
+      return s * NS_PER_SEC + units * NS_PER_SEC / unitsPerSec;
+    }
+  // units * NS_PER_SEC could overflow
+  return s * NS_PER_SEC + (uint64_t)((double)units * NS_PER_SEC / unitsPerSec);
+}
+
+bool
+PcapReader::ReadRecord (uint64_t offset, struct Record &record, uint64_t *next)
+{
+  NS_LOG_FUNCTION (this << offset);
+  uint64_t recordOffset = 0;
+  if (!m_ng)
+    {
+      if (offset == m_size)
+        {
+          return false;
+        }
+      if (offset + 16 > m_size
+          || offset + 16 + Get32 (offset + 8) > m_size)
+        {
+          m_fail = true;
+          return false;
+        }
+      uint64_t units = Get32 (offset + 4);
+      record.ns = Get32 (offset) * NS_PER_SEC
+        + (m_nsResolution ? units : units * (NS_PER_SEC / US_PER_SEC));
+      record.interface = 0;
+      record.inclLen = Get32 (offset + 8);
+      record.origLen = Get32 (offset + 12);
+      record.data = m_data + offset + 16;
+      recordOffset = offset;
+      *next = offset + 16 + record.inclLen;
+    }
+  else
+    {
+      for (;;)
+        {
+          if (offset == m_size)
+            {
+              return false;
+            }
+          if (offset + 12 > m_size)
+            {
+              m_fail = true;
+              return false;
+            }
+          uint32_t type = Get32 (offset);
+          uint32_t length = Get32 (offset + 4);
+          if (length < 12 || length % 4 != 0 || offset + length > m_size)
+            {
+              m_fail = true;
+              return false;
+            }
+          if (type == SECTION_HEADER_BLOCK)
+            {
+              NS_LOG_WARN ("Only the first section of a pcapng file is read");
+              return false;
+            }
+          if (type == INTERFACE_DESCRIPTION_BLOCK)
+            {
+              if (length < 20)
+                {
+                  m_fail = true;
+                  return false;
+                }
+              // the interfaces seen before, while indexing, are known
+              if (offset >= m_indexedEnd)
+                {
+                  ReadInterface (offset, length);
+                  m_indexedEnd = offset + length;
+                }
+            }
+          else if (type == ENHANCED_PACKET_BLOCK || type == PACKET_BLOCK)
+            {
+              if (length < 32)
+                {
+                  m_fail = true;
+                  return false;
+                }
+              record.interface = type == ENHANCED_PACKET_BLOCK ? Get32 (offset + 8) : Get16 (offset + 8);
+              record.inclLen = Get32 (offset + 20);
+              record.origLen = Get32 (offset + 24);
+              if (record.interface >= m_interfaces.size ()
+                  || 28 + (uint64_t)record.inclLen > length - 4)
+                {
+                  m_fail = true;
+                  return false;
+                }
+              uint64_t ts = ((uint64_t)Get32 (offset + 12) << 32) | Get32 (offset + 16);
+              record.ns = ToNanoSeconds (record.interface, ts);
+              record.data = m_data + offset + 28;
+              recordOffset = offset;
+              *next = offset + length;
+              break;
+            }
+          offset += length;
+        }
+    }
+
+  if (recordOffset >= m_indexedEnd)
+    {
+      if (m_nIndexed % INDEX_INTERVAL == 0)
+        {
+          struct IndexEntry entry;
+          entry.m_ns = record.ns;
+          entry.m_offset = recordOffset;
+          m_index.push_back (entry);
+        }
+      m_nIndexed++;
+      m_indexedEnd = *next;
+    }
+  return true;
+}
+
+bool
+PcapReader::Next (struct Record &record)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_fail || m_data == 0)
+    {
+      return false;
+    }
+  uint64_t next;
+  if (!ReadRecord (m_offset, record, &next))
+    {
+      return false;
+    }
+  m_offset = next;
+  return true;
+}
+
+void
+PcapReader::Seek (uint64_t ns)
+{
+  NS_LOG_FUNCTION (this << ns);
+  if (m_fail || m_data == 0)
+    {
+      return;
+    }
+
+  //
+  // Start from the last indexed record before the time, and read on.  The
+  // records read past the end of the index extend it.
+  //
+  uint32_t lo = 0;
+  uint32_t hi = m_index.size ();
+  while (lo < hi)
+    {
+      uint32_t mid = lo + (hi - lo) / 2;
+      if (m_index[mid].m_ns < ns)
+        {
+          lo = mid + 1;
+        }
+      else
+        {
+          hi = mid;
+        }
+    }
+  m_offset = lo == 0 ? m_begin : m_index[lo - 1].m_offset;
+
+  struct Record record;
+  uint64_t next;
+  for (;;)
+    {
+      uint64_t offset = m_offset;
+      if (!ReadRecord (offset, record, &next) || record.ns >= ns)
+        {
+          m_offset = offset;
+          return;
+        }
+      m_offset = next;
+    }
+}
+
+void
+PcapReader::Rewind (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_offset = m_begin;
+}
+
+} // namespace ns3
@@ -0,0 +1,165 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef PCAP_READER_H
+#define PCAP_READER_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "ns3/simple-ref-count.h"
+
+namespace ns3 {
+
+/**
+ * \brief Reads the packets of a pcap or pcapng file, mapped in memory
+ *
+ * The file is mapped rather than read: a record costs the parsing of its
+ * header, and the packet data is handed out in place, however large the
+ * capture. Both byte orders are read, and the timestamps are converted
+ * to nanoseconds whatever their resolution in the file.
+ *
+ * As the records are read, one record in every 1024 is added to a
+ * sparse index of the timestamps, which Seek searches before reading on
+ * from the closest record. The index assumes the timestamps do not
+ * decrease through the file, as in a capture.
+ *
+ * Of a pcapng file, the Interface Description Blocks and the Enhanced
+ * and obsolete Packet Blocks of the first section are read, the other
+ * blocks are skipped. The packets of a pcap file are all on interface 0.
+ */
+class PcapReader : public SimpleRefCount<PcapReader>
+{
+public:
+  /**
+   * A packet of the file
+   */
+  struct Record
+  {
+    uint64_t ns;            /**< Timestamp of the packet, nanoseconds */
+    uint32_t interface;     /**< Id of the interface the packet was captured on */
+    uint32_t inclLen;       /**< Number of bytes of the packet in the file */
+    uint32_t origLen;       /**< Length of the packet when it was captured */
+    uint8_t const *data;    /**< The inclLen bytes, valid until the file is closed */
+  };
+
+  PcapReader ();
+  ~PcapReader ();
+
+  /**
+   * \return true if the file could not be mapped, is not a pcap or pcapng
+   * file, or a malformed record was found in it, false otherwise.
+   */
+  bool Fail (void) const;
+
+  /**
+   * Map a pcap or pcapng file in memory and read its headers.
+   *
+   * \param filename String containing the name of the file.
+   */
+  void Open (std::string const &filename);
+
+  /**
+   * Unmap the file.
+   */
+  void Close (void);
+
+  /**
+   * \returns true if the file is a pcapng file, false if it is a pcap file
+   */
+  bool IsPcapNg (void) const;
+  /**
+   * \returns the number of interfaces described in the file so far, 1 for
+   * a pcap file
+   */
+  uint32_t GetNInterfaces (void) const;
+  /**
+   * \param interface the id of an interface
+   * \returns the data link type of the interface
+   */
+  uint32_t GetDataLinkType (uint32_t interface) const;
+  /**
+   * \param interface the id of an interface
+   * \returns the snap length of the interface
+   */
+  uint32_t GetSnapLen (uint32_t interface) const;
+
+  /**
+   * \brief Read the next packet of the file
+   *
+   * \param record the packet read
+   * \returns false once all the packets have been read or a malformed
+   *          record is found, true otherwise
+   */
+  bool Next (struct Record &record);
+
+  /**
+   * \brief Read the packets from the first one timestamped at or after
+   * the given time
+   *
+   * \param ns a timestamp, nanoseconds
+   */
+  void Seek (uint64_t ns);
+
+  /**
+   * \brief Read the packets from the first one again
+   */
+  void Rewind (void);
+
+private:
+  struct Interface
+  {
+    uint32_t m_dataLinkType;  /**< Data link type of the packets of the interface */
+    uint32_t m_snapLen;       /**< Maximum length of packet data stored in blocks */
+    uint64_t m_unitsPerSec;   /**< Resolution of the timestamps of the interface */
+  };
+  struct IndexEntry
+  {
+    uint64_t m_ns;            /**< Timestamp of the record */
+    uint64_t m_offset;        /**< Offset of the record in the file */
+  };
+
+  PcapReader (PcapReader const &);
+  PcapReader &operator = (PcapReader const &);
+
+  uint16_t Get16 (uint64_t offset) const;
+  uint32_t Get32 (uint64_t offset) const;
+  bool ReadPcapHeader (void);
+  bool ReadPcapNgSection (void);
+  void ReadInterface (uint64_t offset, uint32_t length);
+  uint64_t ToNanoSeconds (uint32_t interface, uint64_t ts) const;
+  bool ReadRecord (uint64_t offset, struct Record &record, uint64_t *next);
+
+  uint8_t const *m_data;
+  uint64_t m_size;
+  bool m_fail;
+  bool m_ng;
+  bool m_swap;
+  // timestamps of a pcap file in nanoseconds rather than microseconds
+  bool m_nsResolution;
+  std::vector<struct Interface> m_interfaces;
+  // offset of the first record, after the headers
+  uint64_t m_begin;
+  // offset of the next record read
+  uint64_t m_offset;
+  // the records before this offset have been indexed
+  uint64_t m_indexedEnd;
+  uint64_t m_nIndexed;
+  std::vector<struct IndexEntry> m_index;
+};
+
+} // namespace ns3
+
+#endif /* PCAP_READER_H */
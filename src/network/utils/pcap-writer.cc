@@ -0,0 +1,413 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "pcap-writer.h"
+#include "ns3/core-config.h"
+#include "ns3/assert.h"
+#include "ns3/log.h"
+#include "ns3/fatal-impl.h"
+#include <algorithm>
+#ifdef HAVE_PTHREAD_H
+#include "ns3/system-thread.h"
+#include <pthread.h>
+#endif /* HAVE_PTHREAD_H */
+
+NS_LOG_COMPONENT_DEFINE ("PcapWriter");
+
+namespace ns3 {
+
+namespace {
+
+const uint32_t MIN_CHUNK_SIZE = 4 * 1024;
+const uint32_t MAX_CHUNK_SIZE = 64 * 1024;
+// bytes waiting for the thread before the simulation waits for it
+const uint32_t MAX_QUEUED_SIZE = 64 * 1024 * 1024;
+
+#ifdef HAVE_PTHREAD_H
+// guards the list of the writers
+pthread_mutex_t g_writersLock = PTHREAD_MUTEX_INITIALIZER;
+#endif /* HAVE_PTHREAD_H */
+
+void
+LockWriters (void)
+{
+#ifdef HAVE_PTHREAD_H
+  pthread_mutex_lock (&g_writersLock);
+#endif /* HAVE_PTHREAD_H */
+}
+
+void
+UnlockWriters (void)
+{
+#ifdef HAVE_PTHREAD_H
+  pthread_mutex_unlock (&g_writersLock);
+#endif /* HAVE_PTHREAD_H */
+}
+
+} // anonymous namespace
+
+struct PcapWriter::Chunk
+{
+  PcapWriter *writer;
+  std::ostream *os;
+  uint8_t *data;
+  uint32_t size;
+  uint32_t used;
+  struct Chunk *next;
+};
+
+#ifdef HAVE_PTHREAD_H
+
+/**
+ * \internal
+ * The thread which appends the chunks of all the writers to their
+ * streams
+ *
+ * A forked process only keeps the thread which called fork(): before
+ * it forks, every chunk queued is written, and the child starts a
+ * thread of its own the first time it needs one.
+ */
+class PcapWriterThread
+{
+public:
+  static PcapWriterThread *Get (void);
+  /**
+   * Waits until the chunks queued so far have been written, if the
+   * thread was started
+   */
+  static void DrainAll (void);
+  void Push (struct PcapWriter::Chunk *chunk);
+  void Wait (PcapWriter *writer);
+private:
+  PcapWriterThread ();
+  void Run (void);
+  void Drain (void);
+  static void PrepareFork (void);
+  static void ParentFork (void);
+  static void ChildFork (void);
+
+  // held from the start of a fork to its end in both processes
+  static pthread_mutex_t g_lock;
+  static PcapWriterThread *g_thread;
+
+  // guards the queue and the pending counts of the writers, the
+  // conditions are signaled with it held
+  pthread_mutex_t m_mutex;
+  // signaled when chunks are queued
+  pthread_cond_t m_queued;
+  // broadcast when chunks have been written
+  pthread_cond_t m_written;
+  struct PcapWriter::Chunk *m_head;
+  struct PcapWriter::Chunk *m_tail;
+  uint32_t m_queuedSize;
+  Ptr<SystemThread> m_thread;
+};
+
+pthread_mutex_t PcapWriterThread::g_lock = PTHREAD_MUTEX_INITIALIZER;
+PcapWriterThread *PcapWriterThread::g_thread = 0;
+
+PcapWriterThread *
+PcapWriterThread::Get (void)
+{
+  pthread_mutex_lock (&g_lock);
+  if (g_thread == 0)
+    {
+      static bool registered = false;
+      if (!registered)
+        {
+          pthread_atfork (&PcapWriterThread::PrepareFork,
+                          &PcapWriterThread::ParentFork,
+                          &PcapWriterThread::ChildFork);
+          registered = true;
+        }
+      // never deleted: the files closed after the static destructors
+      // still need it
+      g_thread = new PcapWriterThread ();
+    }
+  PcapWriterThread *thread = g_thread;
+  pthread_mutex_unlock (&g_lock);
+  return thread;
+}
+
+void
+PcapWriterThread::DrainAll (void)
+{
+  pthread_mutex_lock (&g_lock);
+  if (g_thread != 0)
+    {
+      g_thread->Drain ();
+    }
+  pthread_mutex_unlock (&g_lock);
+}
+
+void
+PcapWriterThread::PrepareFork (void)
+{
+  // no new thread and no chunk queued by Get until the fork is over
+  pthread_mutex_lock (&g_lock);
+  if (g_thread != 0)
+    {
+      g_thread->Drain ();
+    }
+}
+
+void
+PcapWriterThread::ParentFork (void)
+{
+  pthread_mutex_unlock (&g_lock);
+}
+
+void
+PcapWriterThread::ChildFork (void)
+{
+  // the thread is left behind in the parent, and its mutexes may have
+  // been held by it: the child drops the whole object. The writers have
+  // nothing pending since Drain.
+  g_thread = 0;
+  pthread_mutex_unlock (&g_lock);
+}
+
+PcapWriterThread::PcapWriterThread ()
+  : m_head (0),
+    m_tail (0),
+    m_queuedSize (0)
+{
+  NS_LOG_FUNCTION (this);
+  pthread_mutex_init (&m_mutex, 0);
+  pthread_cond_init (&m_queued, 0);
+  pthread_cond_init (&m_written, 0);
+  m_thread = Create<SystemThread> (MakeCallback (&PcapWriterThread::Run, this));
+  m_thread->Start ();
+}
+
+void
+PcapWriterThread::Push (struct PcapWriter::Chunk *chunk)
+{
+  NS_LOG_FUNCTION (this << chunk);
+  pthread_mutex_lock (&m_mutex);
+  chunk->writer->m_pending++;
+  chunk->next = 0;
+  if (m_tail == 0)
+    {
+      m_head = chunk;
+    }
+  else
+    {
+      m_tail->next = chunk;
+    }
+  m_tail = chunk;
+  m_queuedSize += chunk->used;
+  pthread_cond_signal (&m_queued);
+  while (m_queuedSize > MAX_QUEUED_SIZE)
+    {
+      pthread_cond_wait (&m_written, &m_mutex);
+    }
+  pthread_mutex_unlock (&m_mutex);
+}
+
+void
+PcapWriterThread::Wait (PcapWriter *writer)
+{
+  NS_LOG_FUNCTION (this << writer);
+  pthread_mutex_lock (&m_mutex);
+  while (writer->m_pending != 0)
+    {
+      pthread_cond_wait (&m_written, &m_mutex);
+    }
+  pthread_mutex_unlock (&m_mutex);
+}
+
+void
+PcapWriterThread::Drain (void)
+{
+  NS_LOG_FUNCTION (this);
+  pthread_mutex_lock (&m_mutex);
+  // a chunk is only taken off the size once written
+  while (m_head != 0 || m_queuedSize != 0)
+    {
+      pthread_cond_wait (&m_written, &m_mutex);
+    }
+  pthread_mutex_unlock (&m_mutex);
+}
+
+void
+PcapWriterThread::Run (void)
+{
+  // no logging on this thread: the prefixes read the simulation time
+  for (;;)
+    {
+      pthread_mutex_lock (&m_mutex);
+      while (m_head == 0)
+        {
+          pthread_cond_wait (&m_queued, &m_mutex);
+        }
+      struct PcapWriter::Chunk *chunk = m_head;
+      m_head = chunk->next;
+      if (m_head == 0)
+        {
+          m_tail = 0;
+        }
+      pthread_mutex_unlock (&m_mutex);
+
+      PcapWriter::WriteChunk (chunk);
+
+      pthread_mutex_lock (&m_mutex);
+      // the written chunk is seen by Sync when it sees the count
+      __atomic_sub_fetch (&chunk->writer->m_pending, 1, __ATOMIC_RELEASE);
+      m_queuedSize -= chunk->used;
+      pthread_cond_broadcast (&m_written);
+      pthread_mutex_unlock (&m_mutex);
+      delete [] chunk->data;
+      delete chunk;
+    }
+}
+
+#endif /* HAVE_PTHREAD_H */
+
+PcapWriter *PcapWriter::g_writers = 0;
+
+PcapWriter::PcapWriter ()
+  : m_os (0),
+    m_chunk (0),
+    m_chunkSize (MIN_CHUNK_SIZE),
+    m_pending (0)
+{
+  NS_LOG_FUNCTION (this);
+  LockWriters ();
+  static bool registered = false;
+  if (!registered)
+    {
+      FatalImpl::RegisterFlush (&PcapWriter::FlushAll);
+      registered = true;
+    }
+  m_prev = 0;
+  m_next = g_writers;
+  if (g_writers != 0)
+    {
+      g_writers->m_prev = this;
+    }
+  g_writers = this;
+  UnlockWriters ();
+}
+
+PcapWriter::~PcapWriter ()
+{
+  NS_LOG_FUNCTION (this);
+  Sync ();
+  LockWriters ();
+  if (m_prev != 0)
+    {
+      m_prev->m_next = m_next;
+    }
+  else
+    {
+      g_writers = m_next;
+    }
+  if (m_next != 0)
+    {
+      m_next->m_prev = m_prev;
+    }
+  UnlockWriters ();
+}
+
+void
+PcapWriter::SetStream (std::ostream *os)
+{
+  NS_LOG_FUNCTION (this << os);
+  Sync ();
+  m_os = os;
+  m_chunkSize = MIN_CHUNK_SIZE;
+}
+
+uint8_t *
+PcapWriter::Append (uint32_t n)
+{
+  NS_LOG_FUNCTION (this << n);
+  NS_ASSERT (m_os != 0);
+  if (m_chunk != 0 && m_chunk->used + n > m_chunk->size)
+    {
+      Flush ();
+    }
+  if (m_chunk == 0)
+    {
+      m_chunk = new Chunk ();
+      m_chunk->writer = this;
+      m_chunk->os = m_os;
+      m_chunk->size = std::max (n, m_chunkSize);
+      m_chunk->used = 0;
+      m_chunk->data = new uint8_t[m_chunk->size];
+      // the files which capture a lot get the large chunks
+      m_chunkSize = std::min (2 * m_chunkSize, MAX_CHUNK_SIZE);
+    }
+  uint8_t *record = m_chunk->data + m_chunk->used;
+  m_chunk->used += n;
+  return record;
+}
+
+void
+PcapWriter::Flush (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_chunk == 0)
+    {
+      return;
+    }
+  struct Chunk *chunk = m_chunk;
+  m_chunk = 0;
+#ifdef HAVE_PTHREAD_H
+  PcapWriterThread::Get ()->Push (chunk);
+#else /* HAVE_PTHREAD_H */
+  WriteChunk (chunk);
+  delete [] chunk->data;
+  delete chunk;
+#endif /* HAVE_PTHREAD_H */
+}
+
+void
+PcapWriter::Sync (void)
+{
+  NS_LOG_FUNCTION (this);
+  Flush ();
+#ifdef HAVE_PTHREAD_H
+  if (__atomic_load_n (&m_pending, __ATOMIC_ACQUIRE) != 0)
+    {
+      PcapWriterThread::Get ()->Wait (this);
+    }
+#endif /* HAVE_PTHREAD_H */
+}
+
+void
+PcapWriter::FlushAll (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  LockWriters ();
+  for (PcapWriter *writer = g_writers; writer != 0; writer = writer->m_next)
+    {
+      writer->Flush ();
+    }
+  UnlockWriters ();
+#ifdef HAVE_PTHREAD_H
+  PcapWriterThread::DrainAll ();
+#endif /* HAVE_PTHREAD_H */
+}
+
+void
+PcapWriter::WriteChunk (struct Chunk *chunk)
+{
+  chunk->os->write (reinterpret_cast<const char *> (chunk->data), chunk->used);
+}
+
+} // namespace ns3
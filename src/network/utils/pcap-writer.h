@@ -0,0 +1,109 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef PCAP_WRITER_H
+#define PCAP_WRITER_H
+
+#include <stdint.h>
+#include <ostream>
+
+namespace ns3 {
+
+/**
+ * \brief Buffers the records of a capture file and appends them to its
+ * stream from a background thread
+ *
+ * Writing a record straight to the stream of its file takes several
+ * calls into the stream library on the simulation thread, and a system
+ * call whenever the small buffer of the stream fills up. A PcapWriter
+ * copies the records into chunks instead, growing from 4 KiB to 64 KiB,
+ * and hands the full chunks to a thread shared by all the writers of
+ * the process, which appends them to their streams in the order they
+ * were handed over. Once 64 MiB of chunks are waiting, the simulation
+ * waits for the thread to catch up.
+ *
+ * The stream must not be used directly while chunks are pending: Sync
+ * first waits until they have all been written, before the stream is
+ * seeked, closed or checked for errors.
+ *
+ * A fork() first waits for every chunk queued to be written, so that
+ * the child has nothing pending; the child starts its own thread.
+ *
+ * On a fatal error, the records of every writer are written before
+ * ns3::FatalImpl flushes the streams.
+ *
+ * Without threading support, Flush writes the chunk itself.
+ */
+class PcapWriter
+{
+public:
+  PcapWriter ();
+  /**
+   * Writes the pending records to the stream
+   */
+  ~PcapWriter ();
+
+  /**
+   * \param os the stream the records are appended to, or 0 once the
+   *        stream is closed
+   */
+  void SetStream (std::ostream *os);
+  /**
+   * \param n the number of bytes of the record
+   * \returns where to copy the n bytes of the record, valid until the
+   *          next call to the writer
+   */
+  uint8_t *Append (uint32_t n);
+  /**
+   * Hands the records appended so far to the background thread
+   */
+  void Flush (void);
+  /**
+   * Flushes the records and waits until they have all been written
+   */
+  void Sync (void);
+
+  /**
+   * \internal
+   * A chunk of records on its way to the stream
+   */
+  struct Chunk;
+
+private:
+  friend class PcapWriterThread;
+
+  PcapWriter (PcapWriter const &);
+  PcapWriter &operator = (PcapWriter const &);
+
+  static void WriteChunk (struct Chunk *chunk);
+  // registered with FatalImpl::RegisterFlush
+  static void FlushAll (void);
+
+  // the writers of the process, to flush them on a fatal error
+  static PcapWriter *g_writers;
+  PcapWriter *m_prev;
+  PcapWriter *m_next;
+
+  std::ostream *m_os;
+  struct Chunk *m_chunk;
+  // capacity of the next chunk allocated
+  uint32_t m_chunkSize;
+  // number of chunks handed over but not written yet
+  uint32_t m_pending;
+};
+
+} // namespace ns3
+
+#endif /* PCAP_WRITER_H */
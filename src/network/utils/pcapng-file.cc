@@ -0,0 +1,251 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <cstring>
+#include <algorithm>
+#include "ns3/assert.h"
+#include "ns3/log.h"
+#include "ns3/packet.h"
+#include "ns3/header.h"
+#include "ns3/buffer.h"
+#include "pcapng-file.h"
+
+NS_LOG_COMPONENT_DEFINE ("PcapNgFile");
+
+namespace ns3 {
+
+namespace {
+
+const uint32_t SECTION_HEADER_BLOCK = 0x0a0d0d0a;
+const uint32_t INTERFACE_DESCRIPTION_BLOCK = 0x00000001;
+const uint32_t ENHANCED_PACKET_BLOCK = 0x00000006;
+const uint32_t BYTE_ORDER_MAGIC = 0x1a2b3c4d;
+const uint16_t VERSION_MAJOR = 1;
+const uint16_t VERSION_MINOR = 0;
+
+const uint16_t OPT_ENDOFOPT = 0;
+const uint16_t IF_NAME = 2;
+const uint16_t IF_TSRESOL = 9;
+// the timestamps are in units of 10^-9 s
+const uint8_t TSRESOL_NS = 9;
+
+inline uint32_t
+Pad (uint32_t n)
+{
+  return (n + 3) & ~3U;
+}
+
+inline uint8_t *
+Put16 (uint8_t *buffer, uint16_t value)
+{
+  memcpy (buffer, &value, sizeof (value));
+  return buffer + sizeof (value);
+}
+
+inline uint8_t *
+Put32 (uint8_t *buffer, uint32_t value)
+{
+  memcpy (buffer, &value, sizeof (value));
+  return buffer + sizeof (value);
+}
+
+} // anonymous namespace
+
+PcapNgFile::PcapNgFile ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+PcapNgFile::~PcapNgFile ()
+{
+  NS_LOG_FUNCTION (this);
+  Close ();
+}
+
+bool
+PcapNgFile::Fail (void) const
+{
+  NS_LOG_FUNCTION (this);
+  m_writer.Sync ();
+  return m_file.fail ();
+}
+
+void
+PcapNgFile::Open (std::string const &filename)
+{
+  NS_LOG_FUNCTION (this << filename);
+  NS_ASSERT (!m_file.is_open ());
+  m_filename = filename;
+  m_interfaces.clear ();
+  m_file.open (filename.c_str (), std::ios::out | std::ios::binary);
+  m_writer.SetStream (&m_file);
+
+  //
+  // A single section, of unspecified length.
+  //
+  uint8_t *block = m_writer.Append (28);
+  block = Put32 (block, SECTION_HEADER_BLOCK);
+  block = Put32 (block, 28);
+  block = Put32 (block, BYTE_ORDER_MAGIC);
+  block = Put16 (block, VERSION_MAJOR);
+  block = Put16 (block, VERSION_MINOR);
+  block = Put32 (block, 0xffffffff);
+  block = Put32 (block, 0xffffffff);
+  Put32 (block, 28);
+}
+
+void
+PcapNgFile::Close (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_writer.Sync ();
+  m_writer.SetStream (0);
+  m_file.close ();
+}
+
+uint32_t
+PcapNgFile::AddInterface (std::string const &name, uint32_t dataLinkType, uint32_t snapLen)
+{
+  NS_LOG_FUNCTION (this << name << dataLinkType << snapLen);
+#ifdef NS3_MTP
+  CriticalSection cs (m_mutex);
+#endif /* NS3_MTP */
+  struct Interface interface;
+  interface.m_dataLinkType = dataLinkType;
+  interface.m_snapLen = snapLen;
+  m_interfaces.push_back (interface);
+
+  //
+  // The name of the interface and the resolution of its timestamps go
+  // in the options, each padded to 32 bits.
+  //
+  uint32_t nameLen = std::min (name.size (), (size_t)0xffff);
+  uint32_t blockLen = 16 + (4 + Pad (nameLen)) + (4 + 4) + 4 + 4;
+  uint8_t *block = m_writer.Append (blockLen);
+  memset (block, 0, blockLen);
+  block = Put32 (block, INTERFACE_DESCRIPTION_BLOCK);
+  block = Put32 (block, blockLen);
+  block = Put16 (block, dataLinkType);
+  block = Put16 (block, 0);
+  block = Put32 (block, snapLen);
+  block = Put16 (block, IF_NAME);
+  block = Put16 (block, nameLen);
+  memcpy (block, name.c_str (), nameLen);
+  block += Pad (nameLen);
+  block = Put16 (block, IF_TSRESOL);
+  block = Put16 (block, 1);
+  *block = TSRESOL_NS;
+  block += 4;
+  block = Put16 (block, OPT_ENDOFOPT);
+  block = Put16 (block, 0);
+  Put32 (block, blockLen);
+  return m_interfaces.size () - 1;
+}
+
+uint32_t
+PcapNgFile::GetNInterfaces (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_interfaces.size ();
+}
+
+uint32_t
+PcapNgFile::GetDataLinkType (uint32_t interface) const
+{
+  NS_LOG_FUNCTION (this << interface);
+  NS_ASSERT (interface < m_interfaces.size ());
+  return m_interfaces[interface].m_dataLinkType;
+}
+
+uint32_t
+PcapNgFile::GetSnapLen (uint32_t interface) const
+{
+  NS_LOG_FUNCTION (this << interface);
+  NS_ASSERT (interface < m_interfaces.size ());
+  return m_interfaces[interface].m_snapLen;
+}
+
+uint8_t *
+PcapNgFile::AppendPacketBlock (uint32_t interface, uint64_t ns, uint32_t totalLen,
+                               uint32_t *inclLen)
+{
+  NS_LOG_FUNCTION (this << interface << ns << totalLen);
+  NS_ASSERT (interface < m_interfaces.size ());
+  uint32_t snapLen = m_interfaces[interface].m_snapLen;
+  *inclLen = totalLen > snapLen ? snapLen : totalLen;
+
+  //
+  // The whole block goes to the chunk of the writer at once, the data
+  // padded to 32 bits between the fixed fields and the trailing length.
+  //
+  uint32_t blockLen = 28 + Pad (*inclLen) + 4;
+  uint8_t *block = m_writer.Append (blockLen);
+  block = Put32 (block, ENHANCED_PACKET_BLOCK);
+  block = Put32 (block, blockLen);
+  block = Put32 (block, interface);
+  block = Put32 (block, ns >> 32);
+  block = Put32 (block, ns & 0xffffffff);
+  block = Put32 (block, *inclLen);
+  block = Put32 (block, totalLen);
+  memset (block + *inclLen, 0, Pad (*inclLen) - *inclLen);
+  Put32 (block + Pad (*inclLen), blockLen);
+  return block;
+}
+
+void
+PcapNgFile::Write (uint32_t interface, uint64_t ns, uint8_t const *data, uint32_t totalLen)
+{
+  NS_LOG_FUNCTION (this << interface << ns << &data << totalLen);
+#ifdef NS3_MTP
+  CriticalSection cs (m_mutex);
+#endif /* NS3_MTP */
+  uint32_t inclLen;
+  uint8_t *block = AppendPacketBlock (interface, ns, totalLen, &inclLen);
+  memcpy (block, data, inclLen);
+}
+
+void
+PcapNgFile::Write (uint32_t interface, uint64_t ns, Ptr<const Packet> p)
+{
+  NS_LOG_FUNCTION (this << interface << ns << p);
+#ifdef NS3_MTP
+  CriticalSection cs (m_mutex);
+#endif /* NS3_MTP */
+  uint32_t inclLen;
+  uint8_t *block = AppendPacketBlock (interface, ns, p->GetSize (), &inclLen);
+  p->CopyData (block, inclLen);
+}
+
+void
+PcapNgFile::Write (uint32_t interface, uint64_t ns, Header &header, Ptr<const Packet> p)
+{
+  NS_LOG_FUNCTION (this << interface << ns << &header << p);
+  uint32_t headerSize = header.GetSerializedSize ();
+  Buffer headerBuffer;
+  headerBuffer.AddAtStart (headerSize);
+  header.Serialize (headerBuffer.Begin ());
+
+#ifdef NS3_MTP
+  CriticalSection cs (m_mutex);
+#endif /* NS3_MTP */
+  uint32_t inclLen;
+  uint8_t *block = AppendPacketBlock (interface, ns, headerSize + p->GetSize (), &inclLen);
+  uint32_t toCopy = std::min (headerSize, inclLen);
+  headerBuffer.CopyData (block, toCopy);
+  p->CopyData (block + toCopy, inclLen - toCopy);
+}
+
+} // namespace ns3
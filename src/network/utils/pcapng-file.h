@@ -0,0 +1,154 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef PCAPNG_FILE_H
+#define PCAPNG_FILE_H
+
+#include <string>
+#include <fstream>
+#include <vector>
+#include <stdint.h>
+#include "ns3/core-config.h"
+#include "ns3/ptr.h"
+#include "ns3/simple-ref-count.h"
+#ifdef NS3_MTP
+#include "ns3/system-mutex.h"
+#endif /* NS3_MTP */
+#include "pcap-writer.h"
+
+namespace ns3 {
+
+class Packet;
+class Header;
+
+/**
+ * \brief A pcapng file in which the packets of many interfaces are
+ * multiplexed
+ *
+ * Unlike a pcap file, which holds the packets of a single link, a
+ * pcapng file describes each interface in an Interface Description
+ * Block, with its own data link type, snap length and name, and tags
+ * each packet, in an Enhanced Packet Block, with the interface it was
+ * captured on. Capturing all the devices of a simulation to one pcapng
+ * file keeps a single file open, whatever the number of devices.
+ *
+ * The blocks are written in the byte order of the host, with the
+ * timestamps in nanoseconds, and go through a PcapWriter: they are all
+ * in the file once it is closed.
+ *
+ * See http://www.winpcap.org/ntar/draft/PCAP-DumpFileFormat.html
+ */
+class PcapNgFile : public SimpleRefCount<PcapNgFile>
+{
+public:
+  PcapNgFile ();
+  ~PcapNgFile ();
+
+  /**
+   * \return true if the 'fail' bit is set in the underlying stream, false
+   * otherwise.
+   */
+  bool Fail (void) const;
+
+  /**
+   * Create a new pcapng file and write its Section Header Block
+   *
+   * \param filename String containing the name of the file.
+   */
+  void Open (std::string const &filename);
+
+  /**
+   * Close the underlying file.
+   */
+  void Close (void);
+
+  /**
+   * Describe a new interface in the file
+   *
+   * \param name the name of the interface, as shown by the tools
+   * \param dataLinkType A data link type as defined in the pcap library
+   * \param snapLen the maximum number of bytes of the packets saved
+   * \returns the id of the interface, to give to Write
+   */
+  uint32_t AddInterface (std::string const &name, uint32_t dataLinkType, uint32_t snapLen);
+
+  /**
+   * \returns the number of interfaces described in the file
+   */
+  uint32_t GetNInterfaces (void) const;
+  /**
+   * \param interface the id of an interface
+   * \returns the data link type of the interface
+   */
+  uint32_t GetDataLinkType (uint32_t interface) const;
+  /**
+   * \param interface the id of an interface
+   * \returns the snap length of the interface
+   */
+  uint32_t GetSnapLen (uint32_t interface) const;
+
+  /**
+   * \brief Write next packet to file
+   *
+   * \param interface   Id of the interface the packet was captured on
+   * \param ns          Packet timestamp, nanoseconds
+   * \param data        Data buffer
+   * \param totalLen    Total packet length
+   */
+  void Write (uint32_t interface, uint64_t ns, uint8_t const *data, uint32_t totalLen);
+  /**
+   * \brief Write next packet to file
+   *
+   * \param interface   Id of the interface the packet was captured on
+   * \param ns          Packet timestamp, nanoseconds
+   * \param p           Packet to write
+   */
+  void Write (uint32_t interface, uint64_t ns, Ptr<const Packet> p);
+  /**
+   * \brief Write next packet to file
+   *
+   * \param interface   Id of the interface the packet was captured on
+   * \param ns          Packet timestamp, nanoseconds
+   * \param header      Header to write, in front of packet
+   * \param p           Packet to write
+   */
+  void Write (uint32_t interface, uint64_t ns, Header &header, Ptr<const Packet> p);
+
+private:
+  struct Interface
+  {
+    uint32_t m_dataLinkType;  /**< Data link type of the packets of the interface */
+    uint32_t m_snapLen;       /**< Maximum length of packet data stored in blocks */
+  };
+
+  PcapNgFile (PcapNgFile const &);
+  PcapNgFile &operator = (PcapNgFile const &);
+
+  uint8_t *AppendPacketBlock (uint32_t interface, uint64_t ns, uint32_t totalLen,
+                              uint32_t *inclLen);
+
+  std::string m_filename;
+  std::ofstream m_file;
+  std::vector<struct Interface> m_interfaces;
+  mutable PcapWriter m_writer;
+#ifdef NS3_MTP
+  // the devices of a multithreaded simulation capture concurrently
+  SystemMutex m_mutex;
+#endif /* NS3_MTP */
+};
+
+} // namespace ns3
+
+#endif /* PCAPNG_FILE_H */
@@ -51,6 +51,9 @@ SimpleChannel::Send (Ptr<Packet> p, uint16_t protocol,
                      Ptr<SimpleNetDevice> sender)
 {
   NS_LOG_FUNCTION (this << p << protocol << to << from << sender);
+  // a single copy of the packet is shared by all the devices, each
+  // copies it again once it accepts it
+  Ptr<const Packet> frame = p->Copy ();
   for (std::vector<Ptr<SimpleNetDevice> >::const_iterator i = m_devices.begin (); i != m_devices.end (); ++i)
     {
       Ptr<SimpleNetDevice> tmp = *i;
@@ -59,7 +62,7 @@ SimpleChannel::Send (Ptr<Packet> p, uint16_t protocol,
           continue;
         }
       Simulator::ScheduleWithContext (tmp->GetNode ()->GetId (), Seconds (0),
-                                      &SimpleNetDevice::Receive, tmp, p->Copy (), protocol, to, from);
+                                      &SimpleNetDevice::Receive, tmp, frame, protocol, to, from);
     }
 }
 
@@ -60,15 +60,17 @@ SimpleNetDevice::SimpleNetDevice ()
 }
 
 void
-SimpleNetDevice::Receive (Ptr<Packet> packet, uint16_t protocol,
+SimpleNetDevice::Receive (Ptr<const Packet> frame, uint16_t protocol,
                           Mac48Address to, Mac48Address from)
 {
-  NS_LOG_FUNCTION (this << packet << protocol << to << from);
+  NS_LOG_FUNCTION (this << frame << protocol << to << from);
   NetDevice::PacketType packetType;
 
-  if (m_receiveErrorModel && m_receiveErrorModel->IsCorrupt (packet) )
+  // error models only read the frame, the shared frame is only copied
+  // once the device accepts it
+  if (m_receiveErrorModel && m_receiveErrorModel->IsCorrupt (ConstCast<Packet> (frame)))
     {
-      m_phyRxDropTrace (packet);
+      m_phyRxDropTrace (frame);
       return;
     }
 
@@ -88,6 +90,7 @@ SimpleNetDevice::Receive (Ptr<Packet> packet, uint16_t protocol,
     {
       packetType = NetDevice::PACKET_OTHERHOST;
     }
+  Ptr<Packet> packet = frame->Copy ();
   m_rxCallback (this, packet, protocol, from);
   if (!m_promiscCallback.IsNull ())
     {
@@ -48,7 +48,18 @@ public:
   static TypeId GetTypeId (void);
   SimpleNetDevice ();
 
-  void Receive (Ptr<Packet> packet, uint16_t protocol, Mac48Address to, Mac48Address from);
+  /**
+   * Receive a packet from the channel, shared by all the devices: the
+   * device copies it once it accepts it. The PhyRxDrop trace gets the
+   * shared packet, its sinks must not add tags to it (AddPacketTag and
+   * AddByteTag are const) since the other devices would see them.
+   *
+   * \param packet the packet
+   * \param protocol the protocol number
+   * \param to the destination address
+   * \param from the source address
+   */
+  void Receive (Ptr<const Packet> packet, uint16_t protocol, Mac48Address to, Mac48Address from);
   void SetChannel (Ptr<SimpleChannel> channel);
 
   /**
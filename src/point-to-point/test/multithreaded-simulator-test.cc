@@ -0,0 +1,192 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/default-simulator-impl.h"
+#include "ns3/multithreaded-simulator-impl.h"
+#include "ns3/uinteger.h"
+#include "ns3/drop-tail-queue.h"
+#include "ns3/node.h"
+#include "ns3/node-list.h"
+#include "ns3/point-to-point-net-device.h"
+#include "ns3/point-to-point-channel.h"
+
+#include <sstream>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * Runs packets hopping around a ring of nodes, and records what every
+ * node sees, in the order it sees it
+ */
+class MultithreadedSimulatorTestCase : public TestCase
+{
+public:
+  MultithreadedSimulatorTestCase (uint32_t partitions);
+
+  virtual void DoRun (void);
+
+private:
+  std::vector<std::string> RunRing (Ptr<SimulatorImpl> impl);
+  void Start (Ptr<Node> node, uint32_t n);
+  void Receive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol,
+                const Address &from, const Address &to, NetDevice::PacketType type);
+  void Send (Ptr<Node> node, uint8_t origin, uint8_t hops, uint32_t size);
+  void MacTx (uint32_t node, Ptr<const Packet> packet);
+
+  uint32_t m_partitions;
+  // only written by the partition of the node
+  std::vector<std::ostringstream *> m_traces;
+};
+
+MultithreadedSimulatorTestCase::MultithreadedSimulatorTestCase (uint32_t partitions)
+  : TestCase ("Check the events of a ring of nodes against the default simulator"),
+    m_partitions (partitions)
+{
+}
+
+void
+MultithreadedSimulatorTestCase::Send (Ptr<Node> node, uint8_t origin, uint8_t hops, uint32_t size)
+{
+  uint8_t data[2] = { origin, hops };
+  Ptr<Packet> packet = Create<Packet> (data, 2);
+  packet->AddPaddingAtEnd (size);
+  // around the ring both ways, depending on the origin and the hop
+  Ptr<NetDevice> device = node->GetDevice ((origin + hops) % node->GetNDevices ());
+  device->Send (packet, device->GetBroadcast (), 0x800);
+}
+
+void
+MultithreadedSimulatorTestCase::Start (Ptr<Node> node, uint32_t n)
+{
+  *m_traces[node->GetId ()] << Simulator::Now ().GetTimeStep () << " start " << n << std::endl;
+  Send (node, node->GetId (), 10 + n % 5, 100 + 10 * node->GetId () + n);
+  if (n > 0)
+    {
+      Simulator::Schedule (MicroSeconds (1100 + 97 * node->GetId ()),
+                           &MultithreadedSimulatorTestCase::Start, this, node, n - 1);
+    }
+}
+
+void
+MultithreadedSimulatorTestCase::Receive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol,
+                                         const Address &from, const Address &to, NetDevice::PacketType type)
+{
+  uint8_t data[2];
+  packet->CopyData (data, 2);
+  Ptr<Node> node = device->GetNode ();
+  *m_traces[node->GetId ()] << Simulator::Now ().GetTimeStep () << " rx " << device->GetIfIndex () <<
+    " from " << (uint32_t) data[0] << " hops " << (uint32_t) data[1] <<
+    " size " << packet->GetSize () << " context " << Simulator::GetContext () << std::endl;
+  if (data[1] > 0)
+    {
+      Send (node, data[0], data[1] - 1, packet->GetSize () - 2);
+    }
+}
+
+void
+MultithreadedSimulatorTestCase::MacTx (uint32_t node, Ptr<const Packet> packet)
+{
+  *m_traces[node] << Simulator::Now ().GetTimeStep () << " tx size " << packet->GetSize () << std::endl;
+}
+
+std::vector<std::string>
+MultithreadedSimulatorTestCase::RunRing (Ptr<SimulatorImpl> impl)
+{
+  Simulator::SetImplementation (impl);
+
+  // a ring of pairs of nodes: the links within a pair have no delay and
+  // keep the pair in one partition, the links between pairs have
+  // different delays
+  const uint32_t N_NODES = 12;
+  std::vector<Ptr<Node> > nodes;
+  for (uint32_t i = 0; i < N_NODES; i++)
+    {
+      nodes.push_back (CreateObject<Node> ());
+      m_traces.push_back (new std::ostringstream ());
+    }
+  for (uint32_t i = 0; i < N_NODES; i++)
+    {
+      Ptr<PointToPointChannel> channel = CreateObject<PointToPointChannel> ();
+      channel->SetAttribute ("Delay", TimeValue (i % 2 == 0 ? Seconds (0) : NanoSeconds (1000000 + 7919 * i)));
+      for (uint32_t j = 0; j < 2; j++)
+        {
+          Ptr<PointToPointNetDevice> device = CreateObject<PointToPointNetDevice> ();
+          device->SetAddress (Mac48Address::Allocate ());
+          device->SetQueue (CreateObject<DropTailQueue> ());
+          device->SetAttribute ("DataRate", DataRateValue (DataRate (1000000 + 1000 * i)));
+          nodes[(i + j) % N_NODES]->AddDevice (device);
+          device->Attach (channel);
+          device->TraceConnectWithoutContext ("MacTx", MakeCallback (&MultithreadedSimulatorTestCase::MacTx, this)
+                                              .Bind (nodes[(i + j) % N_NODES]->GetId ()));
+        }
+    }
+  for (uint32_t i = 0; i < N_NODES; i++)
+    {
+      nodes[i]->RegisterProtocolHandler (MakeCallback (&MultithreadedSimulatorTestCase::Receive, this),
+                                         0x800, 0);
+      Simulator::ScheduleWithContext (nodes[i]->GetId (), MicroSeconds (104 * i),
+                                      &MultithreadedSimulatorTestCase::Start, this, nodes[i], 20);
+    }
+  // no Stop: the partitions only stop at the end of a window
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  std::vector<std::string> traces;
+  for (uint32_t i = 0; i < N_NODES; i++)
+    {
+      traces.push_back (m_traces[i]->str ());
+      delete m_traces[i];
+    }
+  m_traces.clear ();
+  return traces;
+}
+
+void
+MultithreadedSimulatorTestCase::DoRun (void)
+{
+  std::vector<std::string> reference = RunRing (CreateObject<DefaultSimulatorImpl> ());
+
+  Ptr<MultithreadedSimulatorImpl> impl = CreateObject<MultithreadedSimulatorImpl> ();
+  impl->SetAttribute ("PartitionCount", UintegerValue (m_partitions));
+  std::vector<std::string> traces = RunRing (impl);
+
+  NS_TEST_EXPECT_MSG_EQ (impl->GetPartitionCount (), m_partitions, "wrong number of partitions");
+  NS_TEST_ASSERT_MSG_EQ (traces.size (), reference.size (), "wrong number of nodes");
+  for (uint32_t i = 0; i < traces.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_NE (reference[i].size (), 0, "nothing happened on node " << i);
+      NS_TEST_EXPECT_MSG_EQ (traces[i], reference[i], "different events on node " << i);
+    }
+}
+
+class MultithreadedSimulatorTestSuite : public TestSuite
+{
+public:
+  MultithreadedSimulatorTestSuite ();
+};
+
+MultithreadedSimulatorTestSuite::MultithreadedSimulatorTestSuite ()
+  : TestSuite ("multithreaded-simulator", SYSTEM)
+{
+  AddTestCase (new MultithreadedSimulatorTestCase (1), TestCase::QUICK);
+  AddTestCase (new MultithreadedSimulatorTestCase (3), TestCase::QUICK);
+  AddTestCase (new MultithreadedSimulatorTestCase (6), TestCase::QUICK);
+}
+
+static MultithreadedSimulatorTestSuite multithreadedSimulatorTestSuite;
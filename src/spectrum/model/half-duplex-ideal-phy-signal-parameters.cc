@@ -36,7 +36,8 @@ HalfDuplexIdealPhySignalParameters::HalfDuplexIdealPhySignalParameters (const Ha
   : SpectrumSignalParameters (p)
 {
   NS_LOG_FUNCTION (this << &p);
-  data = p.data->Copy ();
+  // the receivers share the packet, they copy it once they receive it
+  data = p.data;
 }
 
 Ptr<SpectrumSignalParameters>
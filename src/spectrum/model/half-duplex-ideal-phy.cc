@@ -287,7 +287,8 @@ HalfDuplexIdealPhy::StartTx (Ptr<Packet> p)
         txParams->txPhy = GetObject<SpectrumPhy> ();
         txParams->txAntenna = m_antenna;
         txParams->psd = m_txPsd;
-        txParams->data = m_txPacket;
+        // the receivers share a single copy of the packet
+        txParams->data = m_txPacket->Copy ();
 
         NS_LOG_LOGIC (this << " tx power: " << 10 * std::log10 (Integral (*(txParams->psd))) + 30 << " dBm");
         m_channel->StartTx (txParams);
@@ -420,7 +421,8 @@ HalfDuplexIdealPhy::EndRx ()
       if (!m_phyMacRxEndOkCallback.IsNull ())
         {
           NS_LOG_LOGIC (this << " calling m_phyMacRxEndOkCallback");
-          m_phyMacRxEndOkCallback (m_rxPacket);
+          // the packet is shared by all the receivers of the signal
+          m_phyMacRxEndOkCallback (m_rxPacket->Copy ());
         }
       else
         {
@@ -100,7 +100,7 @@ private:
   YansWifiChannel (const YansWifiChannel &);
 
   typedef std::vector<Ptr<YansWifiPhy> > PhyList;
-  void Receive (uint32_t i, Ptr<Packet> packet, double rxPowerDbm,
+  void Receive (uint32_t i, Ptr<const Packet> packet, double rxPowerDbm,
                 WifiTxVector txVector, WifiPreamble preamble) const;
 
 
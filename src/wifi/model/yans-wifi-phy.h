@@ -92,7 +92,19 @@ public:
   /// Return current center channel frequency in MHz, see SetChannelNumber()
   double GetChannelFrequencyMhz () const;
 
-  void StartReceivePacket (Ptr<Packet> packet,
+  /**
+   * Start receiving a packet, shared by all the PHYs of the channel:
+   * it is only copied once it is received successfully. The sinks of the
+   * PhyRxBegin, PhyRxEnd, PhyRxDrop and MonitorSnifferRx traces get the
+   * shared packet: they must not add tags to it (AddPacketTag and
+   * AddByteTag are const), the other PHYs would see them.
+   *
+   * \param packet the arriving packet
+   * \param rxPowerDbm the receive power in dBm
+   * \param txVector the TXVECTOR of the arriving packet
+   * \param preamble the preamble of the arriving packet
+   */
+  void StartReceivePacket (Ptr<const Packet> packet,
                            double rxPowerDbm,
                            WifiTxVector txVector,
                            WifiPreamble preamble);
@@ -254,7 +266,7 @@ private:
   double WToDbm (double w) const;
   double RatioToDb (double ratio) const;
   double GetPowerDbm (uint8_t power) const;
-  void EndReceive (Ptr<Packet> packet, Ptr<InterferenceHelper::Event> event);
+  void EndReceive (Ptr<const Packet> packet, Ptr<InterferenceHelper::Event> event);
 
 private:
   double   m_edThresholdW;
@@ -0,0 +1,204 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/object.h"
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string.h>
+#include <stdlib.h> // for exit ()
+
+using namespace ns3;
+
+template <int N>
+class BenchObject : public Object
+{
+public:
+  static TypeId GetTypeId (void);
+private:
+  static std::string GetTypeName (void);
+};
+
+template <int N>
+std::string
+BenchObject<N>::GetTypeName (void)
+{
+  std::ostringstream oss;
+  oss << "ns3::BenchObject<" << N << ">";
+  return oss.str ();
+}
+
+template <int N>
+TypeId
+BenchObject<N>::GetTypeId (void)
+{
+  static TypeId tid = TypeId (GetTypeName ().c_str ())
+    .SetParent<Object> ()
+    .AddConstructor<BenchObject<N> > ()
+    ;
+  return tid;
+}
+
+// the size of the aggregates, like a node with its stack and mobility
+static const uint32_t N_AGGREGATES = 10;
+static Ptr<Object> g_aggregate;
+
+static void
+Aggregate (void)
+{
+  g_aggregate = CreateObject<BenchObject<0> > ();
+  g_aggregate->AggregateObject (CreateObject<BenchObject<1> > ());
+  g_aggregate->AggregateObject (CreateObject<BenchObject<2> > ());
+  g_aggregate->AggregateObject (CreateObject<BenchObject<3> > ());
+  g_aggregate->AggregateObject (CreateObject<BenchObject<4> > ());
+  g_aggregate->AggregateObject (CreateObject<BenchObject<5> > ());
+  g_aggregate->AggregateObject (CreateObject<BenchObject<6> > ());
+  g_aggregate->AggregateObject (CreateObject<BenchObject<7> > ());
+  g_aggregate->AggregateObject (CreateObject<BenchObject<8> > ());
+  g_aggregate->AggregateObject (CreateObject<BenchObject<9> > ());
+}
+
+/**
+ * The search GetObject used to do: walk the aggregates and the parents
+ * of their TypeId until one matches.
+ */
+static Ptr<const Object>
+Scan (Ptr<const Object> object, TypeId tid)
+{
+  TypeId objectTid = Object::GetTypeId ();
+  Object::AggregateIterator i = object->GetAggregateIterator ();
+  while (i.HasNext ())
+    {
+      Ptr<const Object> current = i.Next ();
+      TypeId cur = current->GetInstanceTypeId ();
+      while (cur != tid && cur != objectTid)
+        {
+          cur = cur.GetParent ();
+        }
+      if (cur == tid)
+        {
+          return current;
+        }
+    }
+  return 0;
+}
+
+static void
+benchGetObject (uint32_t n)
+{
+  uint32_t found = 0;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      found += g_aggregate->GetObject<BenchObject<3> > () != 0;
+      found += g_aggregate->GetObject<BenchObject<6> > () != 0;
+      found += g_aggregate->GetObject<BenchObject<9> > () != 0;
+      found += g_aggregate->GetObject<BenchObject<2> > () != 0;
+    }
+  NS_ASSERT (found == 4 * n);
+}
+
+static void
+benchGetObjectMissing (uint32_t n)
+{
+  uint32_t found = 0;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      found += g_aggregate->GetObject<BenchObject<10> > () != 0;
+      found += g_aggregate->GetObject<BenchObject<11> > () != 0;
+      found += g_aggregate->GetObject<BenchObject<12> > () != 0;
+      found += g_aggregate->GetObject<BenchObject<13> > () != 0;
+    }
+  NS_ASSERT (found == 0);
+}
+
+static void
+benchScan (uint32_t n)
+{
+  uint32_t found = 0;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      found += Scan (g_aggregate, BenchObject<3>::GetTypeId ()) != 0;
+      found += Scan (g_aggregate, BenchObject<6>::GetTypeId ()) != 0;
+      found += Scan (g_aggregate, BenchObject<9>::GetTypeId ()) != 0;
+      found += Scan (g_aggregate, BenchObject<2>::GetTypeId ()) != 0;
+    }
+  NS_ASSERT (found == 4 * n);
+}
+
+static void
+benchScanMissing (uint32_t n)
+{
+  uint32_t found = 0;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      found += Scan (g_aggregate, BenchObject<10>::GetTypeId ()) != 0;
+      found += Scan (g_aggregate, BenchObject<11>::GetTypeId ()) != 0;
+      found += Scan (g_aggregate, BenchObject<12>::GetTypeId ()) != 0;
+      found += Scan (g_aggregate, BenchObject<13>::GetTypeId ()) != 0;
+    }
+  NS_ASSERT (found == 0);
+}
+
+static void
+runBench (void (*bench) (uint32_t), uint32_t n, char const *name)
+{
+  SystemWallClockMs time;
+  time.Start ();
+  (*bench) (n);
+  uint64_t deltaMs = time.End ();
+  double ls = 4.0 * n;
+  ls *= 1000;
+  ls /= deltaMs == 0 ? 1 : deltaMs;
+  std::cout << ls << " lookups/s"
+            << " (" << deltaMs << " ms elapsed)\t"
+            << name
+            << std::endl;
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t n = 0;
+  while (argc > 0) {
+      if (strncmp ("--n=", argv[0],strlen ("--n=")) == 0)
+        {
+          char const *nAscii = argv[0] + strlen ("--n=");
+          std::istringstream iss;
+          iss.str (nAscii);
+          iss >> n;
+        }
+      argc--;
+      argv++;
+  }
+  if (n == 0)
+    {
+      std::cerr << "Error-- number of lookups must be specified " <<
+        "by command-line argument --n=(number of lookups)" << std::endl;
+      exit (1);
+    }
+  std::cout << "Running bench-object with n=" << n << std::endl;
+  std::cout << "All tests look up 4 types in an aggregate of "
+            << N_AGGREGATES << " objects." << std::endl;
+
+  Aggregate ();
+  runBench (&benchGetObject, n, "GetObject");
+  runBench (&benchScan, n, "Linear scan of the aggregates");
+  runBench (&benchGetObjectMissing, n, "GetObject, missing types");
+  runBench (&benchScanMissing, n, "Linear scan of the aggregates, missing types");
+  g_aggregate->Dispose ();
+  g_aggregate = 0;
+
+  return 0;
+}
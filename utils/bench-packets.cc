@@ -72,6 +72,7 @@ BenchHeader<N>::GetTypeId (void)
 {
   static TypeId tid = TypeId (GetTypeName ().c_str ())
     .SetParent<Header> ()
+    .AddConstructor<BenchHeader<N> > ()
     ;
   return tid;
 }
@@ -86,7 +87,7 @@ template <int N>
 void 
 BenchHeader<N>::Print (std::ostream &os) const
 {
-  NS_ASSERT (false);
+  os << "N=" << N;
 }
 template <int N>
 uint32_t 
@@ -240,7 +241,22 @@ benchC (uint32_t n)
     C1 (p);
   }
 }
+static void
+benchE (uint32_t n)
+{
+  BenchHeader<25> ipv4;
+  BenchHeader<8> udp;
+  std::ostringstream oss;
 
+  for (uint32_t i = 0; i < n; i++) {
+    Ptr<Packet> p = Create<Packet> (2000);
+    p->AddHeader (udp);
+    p->AddHeader (ipv4);
+    Ptr<Packet> o = p->Copy ();
+    o->Print (oss);
+    oss.str ("");
+  }
+}
 
 static void
 runBench (void (*bench) (uint32_t), uint32_t n, char const *name)
@@ -273,6 +289,12 @@ int main (int argc, char *argv[])
         {
           Packet::EnablePrinting ();
         }
+      // maintain the list of items of the metadata on every operation
+      // instead of recording them in a log decoded by Print
+      if (strncmp ("--enable-checking", argv[0], strlen ("--enable-checking")) == 0)
+        {
+          Packet::EnableChecking ();
+        }
       argc--;
       argv++;
   }
@@ -289,6 +311,7 @@ int main (int argc, char *argv[])
   runBench (&benchB, n, "Just add headers");
   runBench (&benchC, n, "Remove by func call");
   runBench (&benchD, n, "Intermixed add/remove headers and tags");
+  runBench (&benchE, n, "Copy packet, print it");
 
   return 0;
 }
@@ -45,6 +45,7 @@ public:
   Bench (const uint32_t population, const uint32_t total)
   : m_population (population),
     m_total (total),
+    m_quantum (1),
     m_count (0)
   { };
   
@@ -62,14 +63,21 @@ public:
   {
     m_total = total;
   }
+
+  void SetQuantum (const uint64_t quantum)
+  {
+    m_quantum = quantum;
+  }
     
   void RunBench (void);
 private:
   void Cb (void);
+  Time GetDelay (void);
   
   Ptr<RandomVariableStream> m_rand;
   uint32_t m_population;
   uint32_t m_total;
+  uint64_t m_quantum;
   uint32_t m_count;
 };
 
@@ -79,12 +87,13 @@ Bench::RunBench (void)
   SystemWallClockMs time;
   double init, simu;
 
+  m_count = 0;
   DEB ("initializing");
 
   time.Start ();
   for (uint32_t i = 0; i < m_population; ++i)
     {
-      Time at = NanoSeconds (m_rand->GetValue ());
+      Time at = GetDelay ();
       Simulator::Schedule (at, &Bench::Cb, this);
     }
   init = time.End ();
@@ -118,11 +127,24 @@ Bench::Cb (void)
     }
   DEB ("event at " << Simulator::Now ().GetSeconds () << "s");
 
-  Time after = NanoSeconds (m_rand->GetValue ());
+  Time after = GetDelay ();
   Simulator::Schedule (after, &Bench::Cb, this);
   ++m_count;
 }
 
+Time
+Bench::GetDelay (void)
+{
+  uint64_t ns = (uint64_t) m_rand->GetValue ();
+  if (m_quantum > 1)
+    {
+      // fire at the next slot boundary, as slotted MACs do
+      uint64_t now = Simulator::Now ().GetNanoSeconds ();
+      ns = ((now + ns) / m_quantum + 1) * m_quantum - now;
+    }
+  return NanoSeconds (ns);
+}
+
 
 Ptr<RandomVariableStream>
 GetRandomStream (std::string filename)
@@ -186,11 +208,13 @@ int main (int argc, char *argv[])
   bool schedHeap = false;
   bool schedList = false;
   bool schedMap  = true;
+  bool schedLadder = false;
 
   uint32_t pop   =  100000;
   uint32_t total = 1000000;
   uint32_t runs  =       1;
   std::string filename = "";
+  uint64_t quantum = 1;
   
   CommandLine cmd;
   cmd.Usage ("Benchmark the simulator scheduler.\n"
@@ -200,16 +224,24 @@ int main (int argc, char *argv[])
              "  an ascii file, given by the --file=\"<filename>\" argument,\n"
              "  or standard input, by the argument --file=\"-\"\n"
              "In the case of either --file form, the input is expected\n"
-             "to be ascii, giving the relative event times in ns.");
+             "to be ascii, giving the relative event times in ns.\n"
+             "\n"
+             "Each event schedules a new one, which keeps the population\n"
+             "constant (the hold model).  With --quantum, event times are\n"
+             "rounded up to a multiple of the quantum, which produces the\n"
+             "bursts of simultaneous events of slotted MACs (wifi slots,\n"
+             "LTE subframes).");
   cmd.AddValue ("cal",   "use CalendarSheduler",          schedCal);
   cmd.AddValue ("heap",  "use HeapScheduler",             schedHeap);
   cmd.AddValue ("list",  "use ListSheduler",              schedList);
   cmd.AddValue ("map",   "use MapScheduler (default)",    schedMap);
+  cmd.AddValue ("ladder", "use LadderScheduler",          schedLadder);
   cmd.AddValue ("debug", "enable debugging output",       g_debug);
   cmd.AddValue ("pop",   "event population size (default 1E5)",         pop);
   cmd.AddValue ("total", "total number of events to run (default 1E6)", total);
   cmd.AddValue ("runs",  "number of runs (default 1)",    runs);
   cmd.AddValue ("file",  "file of relative event times",  filename);
+  cmd.AddValue ("quantum", "round event times to this many ns (default 1)", quantum);
   cmd.AddValue ("prec",  "printed output precision",      g_fwidth);
   cmd.Parse (argc, argv);
   g_me = cmd.GetName () + ": ";
@@ -219,6 +251,7 @@ int main (int argc, char *argv[])
   if (schedCal)  { factory.SetTypeId ("ns3::CalendarScheduler"); }
   if (schedHeap) { factory.SetTypeId ("ns3::HeapScheduler");     }
   if (schedList) { factory.SetTypeId ("ns3::ListScheduler");     }  
+  if (schedLadder) { factory.SetTypeId ("ns3::LadderScheduler"); }
   Simulator::SetScheduler (factory);
 
   LOGME (std::setprecision (g_fwidth - 6));
@@ -228,9 +261,11 @@ int main (int argc, char *argv[])
   LOGME ("population: " << pop);
   LOGME ("total events: " << total);
   LOGME ("runs: " << runs);
+  LOGME ("quantum: " << quantum);
   
   Bench *bench = new Bench (pop, total);
   bench->SetRandomStream (GetRandomStream (filename));
+  bench->SetQuantum (quantum);
 
   // table header
   LOG ("");
@@ -0,0 +1,186 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/nstime.h"
+#include "ns3/simulator.h"
+#include "ns3/core-config.h"
+#include <iostream>
+#include <sstream>
+#include <string.h>
+#include <stdlib.h> // for exit ()
+
+using namespace ns3;
+
+// defeats the optimizer
+static volatile int64_t g_sink;
+static volatile double g_doubleSink;
+
+/**
+ * The backend of int64x64_t is chosen when configuring: run this
+ * program in a build configured with each backend to compare them.
+ */
+static char const *
+GetBackend (void)
+{
+#if defined (INT64X64_USE_DOUBLE)
+  return "double";
+#elif defined (INT64X64_USE_CAIRO)
+  return "cairo";
+#elif defined (INT64X64_USE_128)
+  return "128";
+#else
+  return "unknown";
+#endif
+}
+
+static void
+benchFromDouble (uint32_t n)
+{
+  int64_t sum = 0;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      sum += Seconds ((i & 0xff) * 0.25).GetTimeStep ();
+    }
+  g_sink = sum;
+}
+
+static void
+benchFromDoubleInt64x64 (uint32_t n)
+{
+  int64_t sum = 0;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      sum += Time::From (int64x64_t ((i & 0xff) * 0.25), Time::S).GetTimeStep ();
+    }
+  g_sink = sum;
+}
+
+static void
+benchGetSeconds (uint32_t n)
+{
+  double sum = 0;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      sum += NanoSeconds (i * 1000003ULL).GetSeconds ();
+    }
+  g_doubleSink = sum;
+}
+
+static void
+benchGetSecondsInt64x64 (uint32_t n)
+{
+  double sum = 0;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      sum += NanoSeconds (i * 1000003ULL).To (Time::S).GetDouble ();
+    }
+  g_doubleSink = sum;
+}
+
+static void
+benchFromSameUnit (uint32_t n)
+{
+  int64_t sum = 0;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      sum += NanoSeconds (int64x64_t (i)).GetTimeStep ();
+    }
+  g_sink = sum;
+}
+
+static void
+benchMultiply (uint32_t n)
+{
+  Time slot = MicroSeconds (9);
+  int64_t sum = 0;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      sum += (slot * (i & 0xff)).GetTimeStep ();
+    }
+  g_sink = sum;
+}
+
+static void
+benchMultiplyInt64x64 (uint32_t n)
+{
+  Time slot = MicroSeconds (9);
+  int64_t sum = 0;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      sum += Time (int64x64_t (slot) * int64x64_t (i & 0xff)).GetTimeStep ();
+    }
+  g_sink = sum;
+}
+
+static void
+runBench (void (*bench) (uint32_t), uint32_t n, char const *name)
+{
+  SystemWallClockMs time;
+  time.Start ();
+  (*bench) (n);
+  uint64_t deltaMs = time.End ();
+  double ops = n;
+  ops *= 1000;
+  ops /= deltaMs == 0 ? 1 : deltaMs;
+  std::cout << ops << " ops/s"
+            << " (" << deltaMs << " ms elapsed)\t"
+            << name
+            << std::endl;
+}
+
+static void
+runBenches (uint32_t n)
+{
+  runBench (&benchFromDouble, n, "Seconds (double)");
+  runBench (&benchFromDoubleInt64x64, n, "Seconds (double) through int64x64_t");
+  runBench (&benchGetSeconds, n, "GetSeconds");
+  runBench (&benchGetSecondsInt64x64, n, "GetSeconds through int64x64_t");
+  runBench (&benchFromSameUnit, n, "NanoSeconds (int64x64_t), same unit as the resolution");
+  runBench (&benchMultiply, n, "Time * integer");
+  runBench (&benchMultiplyInt64x64, n, "Time * integer through int64x64_t");
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t n = 0;
+  while (argc > 0) {
+      if (strncmp ("--n=", argv[0],strlen ("--n=")) == 0)
+        {
+          char const *nAscii = argv[0] + strlen ("--n=");
+          std::istringstream iss;
+          iss.str (nAscii);
+          iss >> n;
+        }
+      argc--;
+      argv++;
+  }
+  if (n == 0)
+    {
+      std::cerr << "Error-- number of operations must be specified " <<
+        "by command-line argument --n=(number of operations)" << std::endl;
+      exit (1);
+    }
+  std::cout << "Running bench-time with n=" << n
+            << ", int64x64_t backend " << GetBackend () << std::endl;
+
+  // the Time objects are not recorded for SetResolution once the
+  // simulation runs
+  Simulator::Schedule (Seconds (0), &runBenches, n);
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  return 0;
+}